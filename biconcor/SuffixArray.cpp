@@ -1,14 +1,171 @@
 #include "SuffixArray.h"
 
+#include <algorithm>
 #include <fstream>
 #include <string>
+#include <stdint.h>
 #include <stdlib.h>
 #include <cstring>
 
+#include "util/file.hh"
+
 namespace {
 
 const int LINE_MAX_LENGTH = 10000;
 
+typedef SuffixArray::INDEX INDEX;
+
+// Saved index: the header, then the corpus, suffix array and sentence
+// index (INDEX each), then word in sentence and sentence length (char).
+const char kMagic[8] = {'b', 'i', 'c', 'o', 'n', 'c', 'S', 'A'};
+
+struct Header {
+  char magic[8];
+  uint64_t size;
+  uint64_t sentenceCount;
+};
+
+const INDEX EMPTY = (INDEX) -1;
+
+// Suffix array construction by induced sorting (SA-IS), after G. Nong,
+// S. Zhang and W. H. Chan (2009), Linear Suffix Array Construction by
+// Almost Pure Induced-Sorting.  The text s[0..n) is over 0..K and ends
+// with its only 0.  Besides s and SA it needs a bit per position and a
+// bucket per symbol; the reduced problem is solved within SA.
+
+inline bool IsLMS(const std::vector<bool> &stype, INDEX i)
+{
+  return i > 0 && i != EMPTY && stype[i] && !stype[i-1];
+}
+
+void GetBuckets(const INDEX *s, INDEX n, INDEX K, std::vector<INDEX> &bucket, bool end)
+{
+  bucket.assign(K+1, 0);
+  for(INDEX i=0; i<n; i++) {
+    bucket[ s[i] ]++;
+  }
+  INDEX sum = 0;
+  for(INDEX c=0; c<=K; c++) {
+    sum += bucket[c];
+    bucket[c] = end ? sum : sum - bucket[c];
+  }
+}
+
+void InduceL(const std::vector<bool> &stype, INDEX *SA, const INDEX *s, INDEX n, INDEX K, std::vector<INDEX> &bucket)
+{
+  GetBuckets(s, n, K, bucket, false);
+  for(INDEX i=0; i<n; i++) {
+    INDEX j = SA[i];
+    if (j != EMPTY && j > 0 && !stype[j-1])
+      SA[ bucket[ s[j-1] ]++ ] = j-1;
+  }
+}
+
+void InduceS(const std::vector<bool> &stype, INDEX *SA, const INDEX *s, INDEX n, INDEX K, std::vector<INDEX> &bucket)
+{
+  GetBuckets(s, n, K, bucket, true);
+  for(INDEX i=n; i-- > 0; ) {
+    INDEX j = SA[i];
+    if (j != EMPTY && j > 0 && stype[j-1])
+      SA[ --bucket[ s[j-1] ] ] = j-1;
+  }
+}
+
+void InducedSort(const INDEX *s, INDEX *SA, INDEX n, INDEX K)
+{
+  if (n == 1) {
+    SA[0] = 0;
+    return;
+  }
+
+  // S-type (smaller than the following suffix) or L-type positions
+  std::vector<bool> stype(n);
+  stype[n-1] = true;
+  stype[n-2] = false;
+  for(INDEX i=n-2; i-- > 0; ) {
+    stype[i] = s[i] < s[i+1] || (s[i] == s[i+1] && stype[i+1]);
+  }
+
+  // sort the LMS substrings
+  std::vector<INDEX> bucket;
+  GetBuckets(s, n, K, bucket, true);
+  std::fill(SA, SA+n, EMPTY);
+  for(INDEX i=1; i<n; i++) {
+    if (IsLMS(stype, i))
+      SA[ --bucket[ s[i] ] ] = i;
+  }
+  InduceL(stype, SA, s, n, K, bucket);
+  InduceS(stype, SA, s, n, K, bucket);
+
+  // name them, equal substrings alike, into a string of at most n/2
+  INDEX n1 = 0;
+  for(INDEX i=0; i<n; i++) {
+    if (IsLMS(stype, SA[i]))
+      SA[ n1++ ] = SA[i];
+  }
+  std::fill(SA+n1, SA+n, EMPTY);
+  INDEX name = 0;
+  INDEX prev = EMPTY;
+  for(INDEX i=0; i<n1; i++) {
+    INDEX pos = SA[i];
+    bool diff = false;
+    for(INDEX d=0; d<n; d++) {
+      if (prev == EMPTY || s[pos+d] != s[prev+d] || stype[pos+d] != stype[prev+d]) {
+        diff = true;
+        break;
+      }
+      if (d > 0 && (IsLMS(stype, pos+d) || IsLMS(stype, prev+d)))
+        break;
+    }
+    if (diff) {
+      name++;
+      prev = pos;
+    }
+    SA[ n1 + pos/2 ] = name-1;
+  }
+  for(INDEX i=n, j=n; i-- > n1; ) {
+    if (SA[i] != EMPTY)
+      SA[ --j ] = SA[i];
+  }
+
+  // sort the suffixes of the reduced string, recursively if names repeat
+  INDEX *SA1 = SA;
+  INDEX *s1 = SA + n - n1;
+  if (name < n1) {
+    InducedSort(s1, SA1, n1, name-1);
+  } else {
+    for(INDEX i=0; i<n1; i++)
+      SA1[ s1[i] ] = i;
+  }
+
+  // induce the order of all suffixes from the sorted LMS suffixes
+  for(INDEX i=1, j=0; i<n; i++) {
+    if (IsLMS(stype, i))
+      s1[ j++ ] = i;
+  }
+  for(INDEX i=0; i<n1; i++) {
+    SA1[i] = s1[ SA1[i] ];
+  }
+  std::fill(SA+n1, SA+n, EMPTY);
+  GetBuckets(s, n, K, bucket, true);
+  for(INDEX i=n1; i-- > 0; ) {
+    INDEX j = SA[i];
+    SA[i] = EMPTY;
+    SA[ --bucket[ s[j] ] ] = j;
+  }
+  InduceL(stype, SA, s, n, K, bucket);
+  InduceS(stype, SA, s, n, K, bucket);
+}
+
+// orders word ids by their string, as CompareWord does
+struct WordLess {
+  WordLess(const Vocabulary &vcb) : m_vcb(vcb) {}
+  bool operator()(WORD_ID a, WORD_ID b) const {
+    return m_vcb.GetWord(a) < m_vcb.GetWord(b);
+  }
+  const Vocabulary &m_vcb;
+};
+
 } // namespace
 
 using namespace std;
@@ -16,7 +173,6 @@ using namespace std;
 SuffixArray::SuffixArray()
     : m_array(NULL),
       m_index(NULL),
-      m_buffer(NULL),
       m_wordInSentence(NULL),
       m_sentence(NULL),
       m_sentenceLength(NULL),
@@ -26,6 +182,7 @@ SuffixArray::SuffixArray()
 
 SuffixArray::~SuffixArray()
 {
+  if (m_memory.get() != NULL) return;
   free(m_array);
   free(m_index);
   free(m_wordInSentence);
@@ -62,9 +219,9 @@ void SuffixArray::Create(const string& fileName )
   textFile.close();
   cerr << m_size << " words (incl. sentence boundaries)" << endl;
 
-  // allocate memory
-  m_array = (WORD_ID*) calloc( sizeof( WORD_ID ), m_size );
-  m_index = (INDEX*) calloc( sizeof( INDEX ), m_size );
+  // allocate memory, with room for the end of the corpus while sorting
+  m_array = (WORD_ID*) calloc( sizeof( WORD_ID ), m_size+1 );
+  m_index = (INDEX*) calloc( sizeof( INDEX ), m_size+1 );
   m_wordInSentence = (char*) calloc( sizeof( char ), m_size );
   m_sentence = (INDEX*) calloc( sizeof( INDEX ), m_size );
   m_sentenceLength = (char*) calloc( sizeof( char ), m_sentenceCount );
@@ -100,48 +257,31 @@ void SuffixArray::Create(const string& fileName )
   cerr << "done reading " << wordIndex << " words, " << sentenceId << " sentences." << endl;
   // List(0,9);
 
-  // sort
-  m_buffer = (INDEX*) calloc( sizeof( INDEX ), m_size );
-
-  if (m_buffer == NULL) {
-    cerr << "cannot allocate memory to m_buffer" << endl;
-    exit(1);
+  // sort: suffixes compare word by word in the lexical order of the
+  // words, and a suffix is smaller than the longer ones it starts.  So
+  // number the words by rank from 1 and end the corpus with 0.
+  vector< WORD_ID > byRank( m_vcb.vocab.size() );
+  for(WORD_ID id=0; id<byRank.size(); id++) {
+    byRank[ id ] = id;
+  }
+  sort( byRank.begin(), byRank.end(), WordLess( m_vcb ) );
+  vector< WORD_ID > rank( byRank.size() );
+  for(WORD_ID r=0; r<byRank.size(); r++) {
+    rank[ byRank[r] ] = r+1;
   }
+  for(INDEX i=0; i<m_size; i++) {
+    m_array[i] = rank[ m_array[i] ];
+  }
+  m_array[ m_size ] = 0;
 
-  Sort( 0, m_size-1 );
-  free( m_buffer );
-  cerr << "done sorting" << endl;
-}
+  InducedSort( m_array, m_index, m_size+1, byRank.size() );
 
-// good ol' quick sort
-void SuffixArray::Sort(INDEX start, INDEX end)
-{
-  if (start == end) return;
-  INDEX mid = (start+end+1)/2;
-  Sort( start, mid-1 );
-  Sort( mid, end );
-
-  // merge
-  INDEX i = start;
-  INDEX j = mid;
-  INDEX k = 0;
-  INDEX length = end-start+1;
-  while( k<length ) {
-    if (i == mid ) {
-      m_buffer[ k++ ] = m_index[ j++ ];
-    } else if (j > end ) {
-      m_buffer[ k++ ] = m_index[ i++ ];
-    } else {
-      if (CompareIndex( m_index[i], m_index[j] ) < 0) {
-        m_buffer[ k++ ] = m_index[ i++ ];
-      } else {
-        m_buffer[ k++ ] = m_index[ j++ ];
-      }
-    }
+  // drop the end of the corpus, which sorts first
+  memmove( m_index, m_index+1, sizeof( INDEX ) * m_size );
+  for(INDEX i=0; i<m_size; i++) {
+    m_array[i] = byRank[ m_array[i]-1 ];
   }
-
-  memcpy( ((char*)m_index) + sizeof( INDEX ) * start,
-          ((char*)m_buffer), sizeof( INDEX ) * (end-start+1) );
+  cerr << "done sorting" << endl;
 }
 
 int SuffixArray::CompareIndex( INDEX a, INDEX b ) const
@@ -279,13 +419,15 @@ void SuffixArray::Save(const string& fileName ) const
     exit(1);
   }
 
-  fwrite( &m_size, sizeof(INDEX), 1, pFile );
+  Header header;
+  memcpy( header.magic, kMagic, sizeof(kMagic) );
+  header.size = m_size;
+  header.sentenceCount = m_sentenceCount;
+  fwrite( &header, sizeof(Header), 1, pFile );
   fwrite( m_array, sizeof(WORD_ID), m_size, pFile ); // corpus
   fwrite( m_index, sizeof(INDEX), m_size, pFile );   // suffix array
-  fwrite( m_wordInSentence, sizeof(char), m_size, pFile); // word index
   fwrite( m_sentence, sizeof(INDEX), m_size, pFile); // sentence index
-
-  fwrite( &m_sentenceCount, sizeof(INDEX), 1, pFile );
+  fwrite( m_wordInSentence, sizeof(char), m_size, pFile); // word index
   fwrite( m_sentenceLength, sizeof(char), m_sentenceCount, pFile); // sentence length
   fclose( pFile );
 
@@ -302,6 +444,17 @@ void SuffixArray::Load(const string& fileName )
 
   cerr << "loading from " << fileName << endl;
 
+  // indexes saved in this layout are mapped, older ones read
+  char magic[ sizeof(kMagic) ];
+  if (fread( magic, 1, sizeof(kMagic), pFile ) == sizeof(kMagic) &&
+      memcmp( magic, kMagic, sizeof(kMagic) ) == 0) {
+    fclose( pFile );
+    LoadMapped( fileName );
+    m_vcb.Load( fileName + ".src-vcb" );
+    return;
+  }
+  rewind( pFile );
+
   fread( &m_size, sizeof(INDEX), 1, pFile );
   cerr << "words in corpus: " << m_size << endl;
   m_array = (WORD_ID*) calloc( sizeof( WORD_ID ), m_size );
@@ -348,3 +501,37 @@ void SuffixArray::Load(const string& fileName )
 
   m_vcb.Load( fileName + ".src-vcb" );
 }
+
+void SuffixArray::LoadMapped(const string& fileName )
+{
+  util::scoped_fd file( util::OpenReadOrThrow( fileName.c_str() ) );
+  uint64_t fileSize = util::SizeFile( file.get() );
+  if (fileSize < sizeof(Header)) {
+    cerr << "Error: " << fileName << " is truncated" << endl;
+    exit(1);
+  }
+  util::MapRead( util::LAZY, file.get(), 0, fileSize, m_memory );
+
+  const char *base = m_memory.begin();
+  const Header *header = reinterpret_cast<const Header*>( base );
+  m_size = header->size;
+  m_sentenceCount = header->sentenceCount;
+  cerr << "words in corpus: " << m_size << endl;
+  cerr << "sentences in corpus: " << m_sentenceCount << endl;
+  if (fileSize != sizeof(Header) + (uint64_t)m_size * (sizeof(WORD_ID) + 2*sizeof(INDEX) + 1) + m_sentenceCount) {
+    cerr << "Error: " << fileName << " is truncated" << endl;
+    exit(1);
+  }
+
+  // the arrays are read only
+  char *p = const_cast<char*>( base ) + sizeof(Header);
+  m_array = reinterpret_cast<WORD_ID*>( p );
+  p += sizeof(WORD_ID) * m_size;
+  m_index = reinterpret_cast<INDEX*>( p );
+  p += sizeof(INDEX) * m_size;
+  m_sentence = reinterpret_cast<INDEX*>( p );
+  p += sizeof(INDEX) * m_size;
+  m_wordInSentence = p;
+  p += m_size;
+  m_sentenceLength = p;
+}
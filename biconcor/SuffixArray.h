@@ -2,6 +2,8 @@
 
 #include "Vocabulary.h"
 
+#include "util/mmap.hh"
+
 class SuffixArray
 {
 public:
@@ -10,7 +12,6 @@ public:
 private:
   WORD_ID *m_array;
   INDEX *m_index;
-  INDEX *m_buffer;
   char *m_wordInSentence;
   INDEX *m_sentence;
   char *m_sentenceLength;
@@ -18,6 +19,10 @@ private:
   Vocabulary m_vcb;
   INDEX m_size;
   INDEX m_sentenceCount;
+  // the saved index, when loaded from one; the arrays then point into it
+  util::scoped_memory m_memory;
+
+  void LoadMapped(const std::string& fileName );
 
   // No copying allowed.
   SuffixArray(const SuffixArray&);
@@ -28,7 +33,6 @@ public:
   ~SuffixArray();
 
   void Create(const std::string& fileName );
-  void Sort(INDEX start, INDEX end);
   int CompareIndex( INDEX a, INDEX b ) const;
   inline int CompareWord( WORD_ID a, WORD_ID b ) const;
   int Count( const std::vector< WORD > &phrase );
@@ -905,6 +905,64 @@ static inline void process_srilm_command(conn *c, token_t *tokens, size_t ntoken
     c->write_and_go = conn_read;
 }
 
+/*
+ * "probs\tw1 c1 c2\tw2 c1 c2..." scores a batch of n-grams, each given as the
+ * predicted word followed by its context, most recent word first.  The answer
+ * is one float per n-gram followed by "\r\n".
+ */
+static float srilm_ngram_prob(char *ngram) {
+    int context[MAX_TOKENS];
+    int n = 0;
+    char *save = NULL;
+    char *word = strtok_r(ngram, " ", &save);
+    while (word != NULL && n < MAX_TOKENS - 1) {
+        context[n++] = srilm_getvoc(word);
+        word = strtok_r(NULL, " ", &save);
+    }
+    if (n == 0 || context[0] == -1)
+        return -999.0f;
+    context[n] = -1;
+    return srilm_wordprob(context[0], &context[1]);
+}
+
+static void process_srilm_batch_command(conn *c, char *ngrams) {
+    int count = 1;
+    int size;
+    char *ngram, *next, *out;
+    float p;
+
+    for (ngram = ngrams; *ngram; ++ngram) {
+        if (*ngram == '\t')
+            ++count;
+    }
+    size = count * sizeof(float) + 2;
+    if (size > c->wsize) {
+        char *newbuf = (char *)realloc(c->wbuf, size);
+        if (newbuf == NULL) {
+            out_string(c, "SERVER_ERROR out of memory writing probs response");
+            return;
+        }
+        c->wbuf = newbuf;
+        c->wsize = size;
+    }
+
+    out = c->wbuf;
+    for (ngram = ngrams; ngram != NULL; ngram = next) {
+        next = strchr(ngram, '\t');
+        if (next != NULL)
+            *next++ = '\0';
+        p = srilm_ngram_prob(ngram);
+        memcpy(out, &p, sizeof(float));
+        out += sizeof(float);
+    }
+    memcpy(out, "\r\n", 2);
+    c->wbytes = size;
+    c->wcurr = c->wbuf;
+
+    conn_set_state(c, conn_write);
+    c->write_and_go = conn_read;
+}
+
 static void process_command(conn *c, char *command) {
 
     token_t tokens[MAX_TOKENS];
@@ -929,6 +987,11 @@ static void process_command(conn *c, char *command) {
         return;
     }
 
+    if (strncmp(command, "probs\t", 6) == 0) {
+        process_srilm_batch_command(c, command + 6);
+        return;
+    }
+
     ntokens = tokenize_command(command, tokens, MAX_TOKENS);
     if (ntokens >1 &&
       strcmp(tokens[COMMAND_TOKEN].value, "prob") == 0) {
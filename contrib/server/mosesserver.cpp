@@ -97,14 +97,10 @@ public:
         //cerr << endl;
       }
     }
-    // insert into LM in order from 1grams up (for LM well-formedness)
+    // insert into LM in one update (applied from 1grams up for LM well-formedness)
     cerr << "Inserting " << ngSet.size() << " ngrams into ORLM...\n";
-    for(int i=1; i <= ngOrder; ++i) {
-      iterate(ngSet, it) {
-        if(it->first.size() == i)
-          orlm->UpdateORLM(it->first, it->second);
-      }
-    }
+    vector<pair<vector<string>, int> > ngrams(ngSet.begin(), ngSet.end());
+    orlm->UpdateORLM(ngrams);
   }
   void breakOutParams(const params_t& params) {
     params_t::const_iterator si = params.find("source");
@@ -0,0 +1,300 @@
+#include "SuffixArray.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <sstream>
+
+#ifdef WIN32
+#include <cstdio>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+
+const char kMagic[8] = {'S', 'I', 'G', 'T', 'E', 'S', 'T', 'A'};
+const uint64_t kVersion = 1;
+
+// orders suffixes of the corpus, each ending at its sentence's 0
+struct SuffixLess {
+  SuffixLess(const std::vector<uint32_t>& tokens) : t(tokens) {}
+  const std::vector<uint32_t>& t;
+  bool operator()(uint32_t a, uint32_t b) const {
+    for (size_t i = a, j = b; ; ++i, ++j) {
+      if (t[i] != t[j]) return t[i] < t[j];
+      if (t[i] == 0) return a < b;
+    }
+  }
+};
+
+uint64_t Align(uint64_t offset)
+{
+  return (offset + 7) & ~uint64_t(7);
+}
+
+void WriteSection(std::ofstream& out, const void* data, size_t size, uint64_t offset)
+{
+  while ((uint64_t)out.tellp() < offset) out.put(0);
+  out.write(static_cast<const char*>(data), size);
+}
+
+}
+
+SuffixArray::SuffixArray()
+  : m_data(NULL), m_size(0), m_header(NULL)
+{
+}
+
+SuffixArray::~SuffixArray()
+{
+  if (m_data == NULL) return;
+#ifdef WIN32
+  delete [] static_cast<char*>(m_data);
+#else
+  munmap(m_data, m_size);
+#endif
+}
+
+void SuffixArray::Create(const std::string& corpus, const std::string& filename)
+{
+  std::ifstream in(corpus.c_str());
+  if (!in) {
+    std::cerr << "Cannot open corpus " << corpus << "\n";
+    exit(1);
+  }
+
+  // read the corpus with ids in order of first occurrence
+  std::map<std::string, uint32_t> vocab;
+  std::vector<uint32_t> tokens;
+  std::vector<uint32_t> sentences;
+  uint32_t num_sentences = 0;
+  std::string line, word;
+  while (getline(in, line)) {
+    std::istringstream words(line);
+    while (words >> word) {
+      uint32_t id = vocab.size() + 1;
+      tokens.push_back(vocab.insert(std::make_pair(word, id)).first->second);
+      sentences.push_back(num_sentences);
+    }
+    tokens.push_back(0);
+    sentences.push_back(num_sentences);
+    ++num_sentences;
+  }
+  if (tokens.size() >= 0xFFFFFFFFul) {
+    std::cerr << "Corpus " << corpus << " is too large to index\n";
+    exit(1);
+  }
+
+  // renumber the words in lexical order
+  std::vector<uint32_t> lexical(vocab.size() + 1, 0);
+  std::vector<uint64_t> word_offsets(1, 0);
+  std::string words;
+  uint32_t id = 0;
+  for (std::map<std::string, uint32_t>::const_iterator i = vocab.begin(); i != vocab.end(); ++i) {
+    lexical[i->second] = ++id;
+    words += i->first;
+    word_offsets.push_back(words.size());
+  }
+  std::vector<uint32_t> suffixes;
+  for (size_t pos = 0; pos < tokens.size(); ++pos) {
+    tokens[pos] = lexical[tokens[pos]];
+    if (tokens[pos] != 0) suffixes.push_back(pos);
+  }
+  std::sort(suffixes.begin(), suffixes.end(), SuffixLess(tokens));
+
+  Header header;
+  memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  header.num_sentences = num_sentences;
+  header.vocab_size = vocab.size();
+  header.num_positions = tokens.size();
+  header.num_suffixes = suffixes.size();
+  header.word_offsets = Align(sizeof(Header));
+  header.words = Align(header.word_offsets + word_offsets.size() * sizeof(uint64_t));
+  header.tokens = Align(header.words + words.size());
+  header.sentences = Align(header.tokens + tokens.size() * sizeof(uint32_t));
+  header.suffixes = Align(header.sentences + sentences.size() * sizeof(uint32_t));
+
+  std::ofstream out(filename.c_str(), std::ios::out | std::ios::binary);
+  if (!out) {
+    std::cerr << "Cannot write " << filename << "\n";
+    exit(1);
+  }
+  WriteSection(out, &header, sizeof(Header), 0);
+  WriteSection(out, &word_offsets[0], word_offsets.size() * sizeof(uint64_t), header.word_offsets);
+  WriteSection(out, words.data(), words.size(), header.words);
+  WriteSection(out, &tokens[0], tokens.size() * sizeof(uint32_t), header.tokens);
+  WriteSection(out, &sentences[0], sentences.size() * sizeof(uint32_t), header.sentences);
+  if (!suffixes.empty()) {
+    WriteSection(out, &suffixes[0], suffixes.size() * sizeof(uint32_t), header.suffixes);
+  }
+  if (!out) {
+    std::cerr << "Error writing " << filename << "\n";
+    exit(1);
+  }
+}
+
+void SuffixArray::Open(const std::string& filename)
+{
+#ifdef WIN32
+  FILE* file = fopen(filename.c_str(), "rb");
+  if (file == NULL) {
+    std::cerr << "Cannot open suffix array " << filename << "\n";
+    exit(1);
+  }
+  fseek(file, 0, SEEK_END);
+  m_size = ftell(file);
+  fseek(file, 0, SEEK_SET);
+  m_data = new char[m_size];
+  if (fread(m_data, 1, m_size, file) != m_size) {
+    std::cerr << "Error reading suffix array " << filename << "\n";
+    exit(1);
+  }
+  fclose(file);
+#else
+  int fd = open(filename.c_str(), O_RDONLY);
+  struct stat st;
+  if (fd < 0 || fstat(fd, &st) != 0) {
+    std::cerr << "Cannot open suffix array " << filename << "\n";
+    exit(1);
+  }
+  m_size = st.st_size;
+  m_data = mmap(NULL, m_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (m_data == MAP_FAILED) {
+    m_data = NULL;
+    std::cerr << "Cannot map suffix array " << filename << "\n";
+    exit(1);
+  }
+#endif
+
+  const char* base = static_cast<const char*>(m_data);
+  m_header = reinterpret_cast<const Header*>(base);
+  if (m_size < sizeof(Header) ||
+      memcmp(m_header->magic, kMagic, sizeof(kMagic)) != 0 ||
+      m_header->version != kVersion ||
+      m_size < m_header->suffixes + m_header->num_suffixes * sizeof(uint32_t)) {
+    std::cerr << filename << " is not a suffix array built by build-sa\n";
+    exit(1);
+  }
+  m_word_offsets = reinterpret_cast<const uint64_t*>(base + m_header->word_offsets);
+  m_words = base + m_header->words;
+  m_tokens = reinterpret_cast<const uint32_t*>(base + m_header->tokens);
+  m_sentences = reinterpret_cast<const uint32_t*>(base + m_header->sentences);
+  m_suffixes = reinterpret_cast<const uint32_t*>(base + m_header->suffixes);
+}
+
+uint32_t SuffixArray::WordId(const std::string& word) const
+{
+  size_t lo = 0, hi = m_header->vocab_size;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    int c = word.compare(0, std::string::npos, m_words + m_word_offsets[mid],
+                         m_word_offsets[mid+1] - m_word_offsets[mid]);
+    if (c == 0) return mid + 1;
+    if (c < 0) hi = mid;
+    else lo = mid + 1;
+  }
+  return 0;
+}
+
+int SuffixArray::Compare(uint32_t pos, const std::vector<uint32_t>& phrase) const
+{
+  // the 0 ending the sentence is smaller than any word
+  for (size_t k = 0; k < phrase.size(); ++k) {
+    uint32_t t = m_tokens[pos + k];
+    if (t != phrase[k]) return t < phrase[k] ? -1 : 1;
+  }
+  return 0;
+}
+
+void SuffixArray::FindSentences(const std::string& phrase, SentIdSet& out) const
+{
+  out.clear();
+  std::vector<uint32_t> ids;
+  std::istringstream words(phrase);
+  std::string word;
+  while (words >> word) {
+    uint32_t id = WordId(word);
+    if (id == 0) return;
+    ids.push_back(id);
+  }
+  if (ids.empty()) return;
+
+  size_t lo = 0, hi = m_header->num_suffixes;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (Compare(m_suffixes[mid], ids) < 0) lo = mid + 1;
+    else hi = mid;
+  }
+  size_t begin = lo;
+  hi = m_header->num_suffixes;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (Compare(m_suffixes[mid], ids) <= 0) lo = mid + 1;
+    else hi = mid;
+  }
+
+  out.reserve(lo - begin);
+  for (size_t i = begin; i < lo; ++i) {
+    out.push_back(m_sentences[m_suffixes[i]]);
+  }
+  std::sort(out.begin(), out.end());
+  out.erase(std::unique(out.begin(), out.end()), out.end());
+}
+
+// When one set is much smaller, its ids are looked up in the other by
+// binary search, starting after the previous match, instead of merging.
+size_t CountIntersection(const SentIdSet& a, const SentIdSet& b)
+{
+  const SentIdSet& small = a.size() < b.size() ? a : b;
+  const SentIdSet& large = a.size() < b.size() ? b : a;
+  size_t count = 0;
+  SentIdSet::const_iterator l = large.begin();
+  if (small.size() * 16 < large.size()) {
+    for (SentIdSet::const_iterator s = small.begin(); s != small.end(); ++s) {
+      l = std::lower_bound(l, large.end(), *s);
+      if (l == large.end()) break;
+      if (*l == *s) ++count;
+    }
+  } else {
+    SentIdSet::const_iterator s = small.begin();
+    while (s != small.end() && l != large.end()) {
+      if (*s < *l) ++s;
+      else if (*l < *s) ++l;
+      else {
+        ++count;
+        ++s;
+        ++l;
+      }
+    }
+  }
+  return count;
+}
+
+void Intersect(const SentIdSet& a, const SentIdSet& b, SentIdSet& out)
+{
+  const SentIdSet& small = a.size() < b.size() ? a : b;
+  const SentIdSet& large = a.size() < b.size() ? b : a;
+  out.clear();
+  if (small.size() * 16 < large.size()) {
+    SentIdSet::const_iterator l = large.begin();
+    for (SentIdSet::const_iterator s = small.begin(); s != small.end(); ++s) {
+      l = std::lower_bound(l, large.end(), *s);
+      if (l == large.end()) break;
+      if (*l == *s) out.push_back(*s);
+    }
+  } else {
+    std::set_intersection(small.begin(), small.end(), large.begin(), large.end(),
+                          std::back_inserter(out));
+  }
+}
@@ -0,0 +1,82 @@
+#ifndef SIGTEST_FILTER_SUFFIX_ARRAY_H_
+#define SIGTEST_FILTER_SUFFIX_ARRAY_H_
+
+#include <stdint.h>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// sentence ids, sorted and without duplicates
+typedef std::vector<uint32_t> SentIdSet;
+
+/**
+ * Suffix array over one side of a sentence aligned corpus, kept in a
+ * single file that is memory-mapped for searching.  Words are numbered
+ * from 1 in lexical order and 0 ends every sentence, so no suffix runs
+ * into the next sentence.
+ *
+ * File layout; each section starts at an 8-byte aligned offset given in
+ * the header:
+ *   uint64_t word_offsets[vocab_size+1]  into words
+ *   char     words[]                     sorted, not terminated
+ *   uint32_t tokens[num_positions]       word ids, 0 after each sentence
+ *   uint32_t sentences[num_positions]    sentence of each position
+ *   uint32_t suffixes[num_suffixes]      positions of the words, sorted
+ */
+class SuffixArray
+{
+public:
+  SuffixArray();
+  ~SuffixArray();
+
+  /** Index a tokenised corpus, one sentence per line, into filename. */
+  static void Create(const std::string& corpus, const std::string& filename);
+
+  void Open(const std::string& filename);
+
+  size_t NumberOfSentences() const { return m_header->num_sentences; }
+
+  /** Sentences in which the space separated phrase occurs. */
+  void FindSentences(const std::string& phrase, SentIdSet& out) const;
+
+private:
+  struct Header {
+    char magic[8];
+    uint64_t version;
+    uint64_t num_sentences;
+    uint64_t vocab_size;
+    uint64_t num_positions;
+    uint64_t num_suffixes;
+    uint64_t word_offsets;
+    uint64_t words;
+    uint64_t tokens;
+    uint64_t sentences;
+    uint64_t suffixes;
+  };
+
+  // id of word, 0 if it is not in the corpus
+  uint32_t WordId(const std::string& word) const;
+  // compares the suffix at pos with the phrase, over the phrase's length
+  int Compare(uint32_t pos, const std::vector<uint32_t>& phrase) const;
+
+  void* m_data;
+  size_t m_size;
+  const Header* m_header;
+  const uint64_t* m_word_offsets;
+  const char* m_words;
+  const uint32_t* m_tokens;
+  const uint32_t* m_sentences;
+  const uint32_t* m_suffixes;
+
+  // no copying allowed
+  SuffixArray(const SuffixArray&);
+  SuffixArray& operator=(const SuffixArray&);
+};
+
+/** Number of sentences in both sets. */
+size_t CountIntersection(const SentIdSet& a, const SentIdSet& b);
+
+/** Sentences in both sets. */
+void Intersect(const SentIdSet& a, const SentIdSet& b, SentIdSet& out);
+
+#endif  // SIGTEST_FILTER_SUFFIX_ARRAY_H_
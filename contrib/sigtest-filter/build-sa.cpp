@@ -0,0 +1,17 @@
+#include <cstdlib>
+#include <iostream>
+
+#include "SuffixArray.h"
+
+int main(int argc, char * argv[])
+{
+  if (argc != 3) {
+    std::cerr << "\nIndex one side of a training corpus for filter-pt.\n"
+              << "\nUsage:\n"
+              << "\n  build-sa CORPUS SUFFIX-ARRAY\n\n"
+              << "   CORPUS is tokenised, one sentence per line, as for the phrase table\n";
+    exit(1);
+  }
+  SuffixArray::Create(argv[1], argv[2]);
+  return 0;
+}
@@ -1,15 +1,22 @@
-
 #include <cstring> 
 #include <cassert>
 #include <cstdio>
 #include <cstdlib>
+#include <cmath>
 #include <algorithm>
 
-#include "_SuffixArraySearchApplicationBase.h"
+#include "SuffixArray.h"
 
 #include <vector>
 #include <iostream>
-#include <set>
+#include <map>
+#include <string>
+
+#include <boost/shared_ptr.hpp>
+
+#ifdef WITH_THREADS
+#include <boost/thread.hpp>
+#endif
 
 #ifdef WIN32
 #include "WIN32_functions.h"
@@ -17,15 +24,14 @@
 #include <unistd.h>
 #endif
 
-typedef std::set<TextLenType> SentIdSet;
-typedef std::map<std::string, SentIdSet> PhraseSetMap;
-
 #undef min
 
 // constants
 const size_t MINIMUM_SIZE_TO_KEEP = 10000;     // reduce this to improve memory usage,
 // increase for speed
 const std::string SEPARATOR       = " ||| ";
+const size_t BLOCK_SIZE = 100000;              // phrase pairs read, and filtered
+// by all threads, at a time
 
 const double ALPHA_PLUS_EPS  = -1000.0;        // dummy value
 const double ALPHA_MINUS_EPS = -2000.0;        // dummy value
@@ -38,16 +44,54 @@ double sig_filter_limit = 0;            // keep phrase pairs with -log(sig) > si
 //    higher = filter-more
 bool pef_filter_only = false;           // only filter based on pef
 bool hierarchical = false;
+size_t num_threads = 1;
+
+// Sentence sets of phrases, shared by all threads.  Only the sets of
+// frequent phrases are kept; the others are quick to look up again.
+class PhraseSetCache
+{
+public:
+  typedef boost::shared_ptr<const SentIdSet> SetPtr;
+
+  PhraseSetCache(const SuffixArray& sa) : m_sa(sa) {}
+
+  SetPtr get(const std::string& phrase) {
+    {
+#ifdef WITH_THREADS
+      boost::mutex::scoped_lock lock(m_mutex);
+#endif
+      std::map<std::string, SetPtr>::const_iterator i = m_sets.find(phrase);
+      if (i != m_sets.end()) return i->second;
+    }
+    SentIdSet* set = new SentIdSet;
+    SetPtr result(set);
+    m_sa.FindSentences(phrase, *set);
+    if (set->size() >= MINIMUM_SIZE_TO_KEEP) {
+#ifdef WITH_THREADS
+      boost::mutex::scoped_lock lock(m_mutex);
+#endif
+      m_sets.insert(std::make_pair(phrase, result));
+    }
+    return result;
+  }
+
+private:
+  const SuffixArray& m_sa;
+  std::map<std::string, SetPtr> m_sets;
+#ifdef WITH_THREADS
+  boost::mutex m_mutex;
+#endif
+};
 
 // globals
-PhraseSetMap esets;
-PhraseSetMap fsets;
+SuffixArray e_sa;
+SuffixArray f_sa;
+PhraseSetCache esets(e_sa);
+PhraseSetCache fsets(f_sa);
 double p_111 = 0.0;                     // alpha
 size_t nremoved_sigfilter = 0;
 size_t nremoved_pfefilter = 0;
 
-C_SuffixArraySearchApplicationBase e_sa;
-C_SuffixArraySearchApplicationBase f_sa;
 int num_lines;
 
 void usage()
@@ -62,7 +106,11 @@ void usage()
             << "   [-n num      ] 0, 1...: 0=no filtering, >0 sort by P(e|f) and keep the top num elements\n"
             << "   [-c          ] add the cooccurence counts to the phrase table\n"
             << "   [-p          ] add -log(significance) to the phrasetable\n"
-            << "   [-h          ] filter hierarchical rule table\n";
+            << "   [-h          ] filter hierarchical rule table\n"
+#ifdef WITH_THREADS
+            << "   [-t num      ] number of threads (default 1)\n"
+#endif
+            ;
   exit(1);
 }
 
@@ -168,6 +216,17 @@ void print(int a, int b, int c, int d, float p)
             << c << "\t" << d << "\t xf=" << (double)(b)*(double)(c)/(double)(a+1)/(double)(d+1) << "\n\n";
 }
 
+// lgamma sets the global signgam, so threads use the reentrant version
+double log_gamma(int x)
+{
+#ifdef __GLIBC__
+  int sign;
+  return lgamma_r(x, &sign);
+#else
+  return lgamma(x);
+#endif
+}
+
 // 2x2 (one-sided) Fisher's exact test
 // see B. Moore. (2004) On Log Likelihood and the Significance of Rare Events
 double fisher_exact(int cfe, int ce, int cf)
@@ -181,7 +240,7 @@ double fisher_exact(int cfe, int ce, int cf)
   int d = (num_lines - ce - cf + cfe);
   int n = a + b + c + d;
 
-  double cp = exp(lgamma(1+a+c) + lgamma(1+b+d) + lgamma(1+a+b) + lgamma(1+c+d) - lgamma(1+n) - lgamma(1+a) - lgamma(1+b) - lgamma(1+c) - lgamma(1+d));
+  double cp = exp(log_gamma(1+a+c) + log_gamma(1+b+d) + log_gamma(1+a+b) + log_gamma(1+c+d) - log_gamma(1+n) - log_gamma(1+a) - log_gamma(1+b) - log_gamma(1+c) - log_gamma(1+d));
   double total_p = 0.0;
   int tc = std::min(b,c);
   for (int i=0; i<=tc; i++) {
@@ -198,93 +257,32 @@ double fisher_exact(int cfe, int ce, int cf)
   return total_p;
 }
 
-template <class setType>
-setType unordered_set_intersect(setType & set_1, setType & set_2)
-{
-    setType set_out;
-
-    if (set_1.size() < set_2.size()) {
-        for (SentIdSet::iterator i=set_1.begin(); i != set_1.end(); ++i) {
-            if (set_2.find(*i) != set_2.end()) set_out.insert(*i);
-    }
-    }
-    else {
-        for (SentIdSet::iterator i=set_2.begin(); i != set_2.end(); ++i) {
-            if (set_1.find(*i) != set_1.end()) set_out.insert(*i);
-        }
-    }
-    return set_out;
-}
-
-
-SentIdSet lookup_phrase(const std::string & phrase, C_SuffixArraySearchApplicationBase & my_sa)
-{
-    SentIdSet occur_set;
-    vector<S_SimplePhraseLocationElement> locations;
-
-    locations = my_sa.locateExactPhraseInCorpus(phrase.c_str());
-    if(locations.size()==0) {
-        cerr<<"No occurrences found!!\n";
-    }
-    for (vector<S_SimplePhraseLocationElement>::iterator i=locations.begin(); i != locations.end(); ++i) {
-        occur_set.insert(i->sentIdInCorpus);
-    }
-    return occur_set;
-}
-
-
 // slight simplicifaction: we consider all sentences in which "a" and "b" occur to be instances of the rule "a [X][X] b".
-SentIdSet lookup_multiple_phrases(vector<std::string> & phrases, C_SuffixArraySearchApplicationBase & my_sa, const std::string & rule, PhraseSetMap & cache) 
+PhraseSetCache::SetPtr lookup_multiple_phrases(const std::vector<std::string> & phrases, PhraseSetCache & cache)
 {
-
-    if (phrases.size() == 1) {
-        return lookup_phrase(phrases.front(), my_sa);
+    if (phrases.empty()) {
+        return PhraseSetCache::SetPtr(new SentIdSet);
     }
-
-    else {
-        SentIdSet main_set;
-        SentIdSet & first_set = cache[phrases.front()];
-        bool first = true;
-        if (first_set.empty()) {
-            first_set = lookup_phrase(phrases.front(), my_sa);
-        }
-        for (vector<std::string>::iterator phrase=phrases.begin()+1; phrase != phrases.end(); ++phrase) {
-            SentIdSet & temp_set = cache[*phrase];
-            if (temp_set.empty()) {
-                temp_set = lookup_phrase(*phrase, my_sa);
-            }
-            if (first) {
-                main_set = unordered_set_intersect(first_set,temp_set);
-                first = false;
-            }
-            else {
-                main_set = unordered_set_intersect(main_set,temp_set);
-            }
-            if (temp_set.size() < MINIMUM_SIZE_TO_KEEP) {
-                cache.erase(*phrase);
-            }
-        }
-
-        if (first_set.size() < MINIMUM_SIZE_TO_KEEP) {
-            cache.erase(phrases.front());
-        }
-
-        return main_set;
+    PhraseSetCache::SetPtr main_set = cache.get(phrases.front());
+    for (std::vector<std::string>::const_iterator phrase=phrases.begin()+1; phrase != phrases.end(); ++phrase) {
+        PhraseSetCache::SetPtr temp_set = cache.get(*phrase);
+        SentIdSet* both = new SentIdSet;
+        Intersect(*main_set, *temp_set, *both);
+        main_set.reset(both);
     }
+    return main_set;
 }
 
 
-SentIdSet find_occurrences(const std::string& rule, C_SuffixArraySearchApplicationBase & my_sa, PhraseSetMap & cache)
+PhraseSetCache::SetPtr find_occurrences(const std::string& rule, PhraseSetCache & cache)
 {
-    SentIdSet sa_set;
-
     // we search for hierarchical rules by stripping away NT and looking for terminals sequences
     // if a rule contains multiple sequences of terminals, we intersect their occurrences.
     if (hierarchical) {
         //   std::cerr << "splitting up phrase: " << phrase << "\n";
         int pos = 0;
         int endPos = 0;
-        vector<std::string> phrases;
+        std::vector<std::string> phrases;
 
         while (rule.find("[X][X] ", pos) < rule.size()) {
             endPos = rule.find("[X][X] ",pos) - 1; // -1 to cut space before NT
@@ -301,20 +299,18 @@ SentIdSet find_occurrences(const std::string& rule, C_SuffixArraySearchApplicati
         if (endPos > pos) {
             phrases.push_back(rule.substr(pos,endPos-pos));
         }
-        sa_set = lookup_multiple_phrases(phrases, my_sa, rule, cache);
-    }
-    else {
-        sa_set = lookup_phrase(rule, my_sa);
+        return lookup_multiple_phrases(phrases, cache);
     }
-  return sa_set;
+    return cache.get(rule);
 }
 
 
 // input: unordered list of translation options for a single source phrase
-void compute_cooc_stats_and_filter(std::vector<PTEntry*>& options)
+void compute_cooc_stats_and_filter(std::vector<PTEntry*>& options,
+                                   size_t& nremoved_pfe, size_t& nremoved_sig)
 {
   if (pfe_filter_limit>0 && options.size() > pfe_filter_limit) {
-    nremoved_pfefilter += (options.size() - pfe_filter_limit);
+    nremoved_pfe += (options.size() - pfe_filter_limit);
     std::nth_element(options.begin(), options.begin()+pfe_filter_limit, options.end(), PfeComparer());
     for (std::vector<PTEntry*>::iterator i=options.begin()+pfe_filter_limit; i != options.end(); ++i)
       delete *i;
@@ -322,47 +318,88 @@ void compute_cooc_stats_and_filter(std::vector<PTEntry*>& options)
   }
   if (pef_filter_only) return;
 //   std::cerr << "f phrase: " << options.front()->f_phrase << "\n";
-  SentIdSet fset;
-  fset = find_occurrences(options.front()->f_phrase, f_sa, fsets);
-  size_t cf = fset.size();
+  PhraseSetCache::SetPtr fset = find_occurrences(options.front()->f_phrase, fsets);
+  size_t cf = fset->size();
   for (std::vector<PTEntry*>::iterator i=options.begin(); i != options.end(); ++i) {
-    const std::string& e_phrase = (*i)->e_phrase;
-    size_t cef=0;
-    SentIdSet& eset = esets[e_phrase];
-    if (eset.empty()) {
-        eset = find_occurrences(e_phrase, e_sa, esets);
-        //std::cerr << "Looking up e-phrase: " << e_phrase << "\n";
-    }
-    size_t ce=eset.size();
-    if (ce < cf) {
-      for (SentIdSet::iterator i=eset.begin(); i != eset.end(); ++i) {
-        if (fset.find(*i) != fset.end()) cef++;
-      }
-    } else {
-      for (SentIdSet::iterator i=fset.begin(); i != fset.end(); ++i) {
-        if (eset.find(*i) != eset.end()) cef++;
-      }
-    }
+    PhraseSetCache::SetPtr eset = find_occurrences((*i)->e_phrase, esets);
+    size_t ce = eset->size();
+    size_t cef = CountIntersection(*eset, *fset);
     double nlp = -log(fisher_exact(cef, cf, ce));
     (*i)->set_cooc_stats(cef, cf, ce, nlp);
-    if (ce < MINIMUM_SIZE_TO_KEEP) {
-      esets.erase(e_phrase);
-    }
-
   }
   std::vector<PTEntry*>::iterator new_end =
     std::remove_if(options.begin(), options.end(), NlogSigThresholder(sig_filter_limit));
-  nremoved_sigfilter += (options.end() - new_end);
+  nremoved_sig += (options.end() - new_end);
   options.erase(new_end,options.end());
 }
 
+// translation options of each source phrase in a block of the phrase table
+typedef std::vector<std::vector<PTEntry*> > PTBlock;
+
+#ifdef WITH_THREADS
+// Filters a block with several threads, each taking the next source phrase.
+class BlockFilter
+{
+public:
+  BlockFilter(PTBlock& block) : m_block(block), m_next(0) {}
+
+  void operator()() {
+    size_t nremoved_pfe = 0;
+    size_t nremoved_sig = 0;
+    for (;;) {
+      size_t i;
+      {
+        boost::mutex::scoped_lock lock(m_mutex);
+        if (m_next == m_block.size()) break;
+        i = m_next++;
+      }
+      compute_cooc_stats_and_filter(m_block[i], nremoved_pfe, nremoved_sig);
+    }
+    boost::mutex::scoped_lock lock(m_mutex);
+    nremoved_pfefilter += nremoved_pfe;
+    nremoved_sigfilter += nremoved_sig;
+  }
+
+private:
+  PTBlock& m_block;
+  size_t m_next;
+  boost::mutex m_mutex;
+};
+#endif
+
+void filter_and_print(PTBlock& block)
+{
+#ifdef WITH_THREADS
+  if (num_threads > 1) {
+    BlockFilter filter(block);
+    boost::thread_group threads;
+    for (size_t t = 0; t < num_threads; ++t) {
+      threads.create_thread(boost::ref(filter));
+    }
+    threads.join_all();
+  } else
+#endif
+  {
+    for (PTBlock::iterator options = block.begin(); options != block.end(); ++options) {
+      compute_cooc_stats_and_filter(*options, nremoved_pfefilter, nremoved_sigfilter);
+    }
+  }
+  for (PTBlock::iterator options = block.begin(); options != block.end(); ++options) {
+    for (std::vector<PTEntry*>::iterator i=options->begin(); i != options->end(); ++i) {
+      std::cout << **i << "\n";
+      delete *i;
+    }
+  }
+  block.clear();
+}
+
 int main(int argc, char * argv[])
 {
   int c;
   const char* efile=0;
   const char* ffile=0;
   int pfe_index = 2;
-  while ((c = getopt(argc, argv, "cpf:e:i:n:l:h")) != -1) {
+  while ((c = getopt(argc, argv, "cpf:e:i:n:l:ht:")) != -1) {
     switch (c) {
     case 'e':
       efile = optarg;
@@ -386,6 +423,12 @@ int main(int argc, char * argv[])
     case 'h':
       hierarchical = true;
       break;
+#ifdef WITH_THREADS
+    case 't':
+      num_threads = atoi(optarg);
+      if (num_threads < 1) num_threads = 1;
+      break;
+#endif
     case 'l':
       std::cerr << "-l = " << optarg << "\n";
       if (strcmp(optarg,"a+e") == 0) {
@@ -411,12 +454,12 @@ int main(int argc, char * argv[])
     usage();
   }
 
-  //load the indexed corpus with vocabulary(noVoc=false) and with offset(noOffset=false)
+  //map the suffix arrays of the corpus built by build-sa
   if (!pef_filter_only) {
-    e_sa.loadData_forSearch(efile, false, false);
-    f_sa.loadData_forSearch(ffile, false, false);
-    size_t elines = e_sa.returnTotalSentNumber();
-    size_t flines = f_sa.returnTotalSentNumber();
+    e_sa.Open(efile);
+    f_sa.Open(ffile);
+    size_t elines = e_sa.NumberOfSentences();
+    size_t flines = f_sa.NumberOfSentences();
     if (elines != flines) {
       std::cerr << "Number of lines in e-corpus != number of lines in f-corpus!\n";
       usage();
@@ -436,45 +479,31 @@ int main(int argc, char * argv[])
     std::cerr << "Filtering using P(e|f) only. n=" << pfe_filter_limit << std::endl;
   }
 
-  char tmpString[10000];
-  std::string prev = "";
-  std::vector<PTEntry*> options;
+  std::string line;
+  PTBlock block;
+  size_t block_lines = 0;
   size_t pt_lines = 0;
-  while(!cin.eof()) {
-    cin.getline(tmpString,10000,'\n');
+  while(getline(std::cin, line)) {
     if(++pt_lines%10000==0) {
       std::cerr << ".";
       if(pt_lines%500000==0) std::cerr << "[n:"<<pt_lines<<"]\n";
     }
 
-    if(strlen(tmpString)>0) {
-      PTEntry* pp = new PTEntry(tmpString, pfe_index);
-      if (prev != pp->f_phrase) {
-        prev = pp->f_phrase;
-
-        if (!options.empty()) {  // always true after first line
-          compute_cooc_stats_and_filter(options);
+    if(!line.empty()) {
+      PTEntry* pp = new PTEntry(line, pfe_index);
+      if (block.empty() || block.back().front()->f_phrase != pp->f_phrase) {
+        // blocks end between source phrases
+        if (block_lines >= BLOCK_SIZE) {
+          filter_and_print(block);
+          block_lines = 0;
         }
-        for (std::vector<PTEntry*>::iterator i=options.begin(); i != options.end(); ++i) {
-          std::cout << **i << std::endl;
-          delete *i;
-        }
-        options.clear();
-        options.push_back(pp);
-
-      } else {
-        options.push_back(pp);
+        block.push_back(std::vector<PTEntry*>());
       }
-      //			  for(int i=0;i<locations.size(); i++){
-      //				  cout<<"SentId="<<locations[i].sentIdInCorpus<<" Pos="<<(int)locations[i].posInSentInCorpus<<endl;
-      //			  }
+      block.back().push_back(pp);
+      ++block_lines;
     }
   }
-  compute_cooc_stats_and_filter(options);
-  for (std::vector<PTEntry*>::iterator i=options.begin(); i != options.end(); ++i) {
-    std::cout << **i << std::endl;
-    delete *i;
-  }
+  filter_and_print(block);
   float pfefper = (100.0*(float)nremoved_pfefilter)/(float)pt_lines;
   float sigfper = (100.0*(float)nremoved_sigfilter)/(float)pt_lines;
   std::cerr << "\n\n------------------------------------------------------\n"
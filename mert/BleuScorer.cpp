@@ -53,16 +53,14 @@ size_t BleuScorer::CountNgrams(const string& line, NgramCounts& counts,
   assert(n > 0);
   vector<int> encoded_tokens;
   TokenizeAndEncode(line, encoded_tokens);
+  NgramCounts::Key ngram;
   for (size_t k = 1; k <= n; ++k) {
     //ngram order longer than sentence - no point
     if (k > encoded_tokens.size()) {
       continue;
     }
     for (size_t i = 0; i < encoded_tokens.size()-k+1; ++i) {
-      vector<int> ngram;
-      for (size_t j = i; j < i+k && j < encoded_tokens.size(); ++j) {
-        ngram.push_back(encoded_tokens[j]);
-      }
+      ngram.assign(encoded_tokens.begin() + i, encoded_tokens.begin() + i + k);
       counts.Add(ngram);
     }
   }
@@ -140,7 +138,7 @@ void BleuScorer::prepareStats(size_t sid, const string& text, ScoreStats& entry)
     msg << "Sentence id (" << sid << ") not found in reference set";
     throw runtime_error(msg.str());
   }
-  NgramCounts testcounts;
+  NgramCounts& testcounts = scratchCounts();
   // stats for this line
   vector<ScoreStatsType> stats(kBleuNgramOrder * 2);
   string sentence = preprocessSentence(text);
@@ -166,6 +164,21 @@ void BleuScorer::prepareStats(size_t sid, const string& text, ScoreStats& entry)
   entry.set(stats);
 }
 
+NgramCounts& BleuScorer::scratchCounts()
+{
+#ifdef WITH_THREADS
+  NgramCounts* counts = m_scratch_counts.get();
+  if (counts == NULL) {
+    counts = new NgramCounts;
+    m_scratch_counts.reset(counts);
+  }
+#else
+  NgramCounts* counts = &m_scratch_counts;
+#endif
+  counts->clear();
+  return *counts;
+}
+
 statscore_t BleuScorer::calculateScore(const vector<int>& comps) const
 {
   CHECK(comps.size() == kBleuNgramOrder * 2 + 1);
@@ -5,6 +5,11 @@
 #include <string>
 #include <vector>
 
+#ifdef WITH_THREADS
+#include <boost/thread/tss.hpp>
+#endif
+
+#include "Ngram.h"
 #include "Types.h"
 #include "ScoreData.h"
 #include "StatisticsBasedScorer.h"
@@ -15,8 +20,7 @@ namespace MosesTuning
 
 const int kBleuNgramOrder = 4;
 
-class NgramCounts;
-class Reference;  
+class Reference;
 
 /**
  * Bleu scoring
@@ -35,6 +39,7 @@ public:
 
   virtual void setReferenceFiles(const std::vector<std::string>& referenceFiles);
   virtual void prepareStats(std::size_t sid, const std::string& text, ScoreStats& entry);
+  virtual bool isThreadSafe() const { return true; }
   virtual statscore_t calculateScore(const std::vector<int>& comps) const;
   virtual std::size_t NumberOfScores() const { return 2 * kBleuNgramOrder + 1; }
 
@@ -63,6 +68,14 @@ private:
   // reference translations.
   ScopedVector<Reference> m_references;
 
+  // n-gram counts of the sentence being scored, reused by each thread
+  NgramCounts& scratchCounts();
+#ifdef WITH_THREADS
+  boost::thread_specific_ptr<NgramCounts> m_scratch_counts;
+#else
+  NgramCounts m_scratch_counts;
+#endif
+
   // no copying allowed
   BleuScorer(const BleuScorer&);
   BleuScorer& operator=(const BleuScorer&);
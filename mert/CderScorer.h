@@ -21,6 +21,7 @@ class CderScorer: public StatisticsBasedScorer {
   virtual void setReferenceFiles(const std::vector<std::string>& referenceFiles);
 
   virtual void prepareStats(std::size_t sid, const std::string& text, ScoreStats& entry);
+  virtual bool isThreadSafe() const { return true; }
 
   virtual void prepareStatsVector(std::size_t sid, const std::string& text, std::vector<int>& stats);
 
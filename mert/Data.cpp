@@ -12,16 +12,68 @@
 
 #include "Data.h"
 #include "FileStream.h"
+#include "HypothesisStore.h"
 #include "Scorer.h"
 #include "ScorerFactory.h"
 #include "Util.h"
 #include "util/check.hh"
+#include "../moses/src/ThreadPool.h"
 
 using namespace std;
 
 namespace MosesTuning
 {
-  
+
+namespace {
+
+// number of n-best lines read and scored at a time
+const size_t kNBestBlockSize = 10000;
+
+struct NBestEntry {
+  string sentence_index;
+  string sentence;
+  string feature_str;
+  ScoreStats stats;
+};
+
+#ifdef WITH_THREADS
+/**
+ * Prepares the statistics of a range of n-best entries.  The first error
+ * is kept in the shared string and rethrown once the pool has finished.
+ */
+class PrepareStatsTask : public Moses::Task
+{
+public:
+  PrepareStatsTask(Scorer* scorer, vector<NBestEntry>& entries,
+                   size_t begin, size_t end,
+                   boost::mutex& mutex, string& error)
+    : m_scorer(scorer), m_entries(entries), m_begin(begin), m_end(end),
+      m_mutex(mutex), m_error(error) {}
+
+  virtual void Run() {
+    try {
+      for (size_t i = m_begin; i < m_end; ++i) {
+        NBestEntry& entry = m_entries[i];
+        m_scorer->prepareStats(entry.sentence_index, entry.sentence, entry.stats);
+      }
+    } catch (const exception& e) {
+      boost::mutex::scoped_lock lock(m_mutex);
+      if (m_error.empty()) m_error = e.what();
+    }
+  }
+
+private:
+  Scorer* m_scorer;
+  vector<NBestEntry>& m_entries;
+  size_t m_begin;
+  size_t m_end;
+  boost::mutex& m_mutex;
+  string& m_error;
+};
+#endif
+
+} // namespace
+
 
 Data::Data()
   : m_scorer(NULL),
@@ -132,47 +184,130 @@ void Data::load(const std::string &featfile, const std::string &scorefile) {
     m_sparse_flag = true;
 }
 
-void Data::loadNBest(const string &file)
+void Data::loadStore(const string &storefile) {
+  TRACE_ERR("loading hypothesis store " << storefile << endl);
+  HypothesisStore store(storefile);
+  if (m_feature_data->size() == 0)
+    m_feature_data->setFeatureMap(store.FeatureNames());
+
+  FeatureStats feature_entry(store.NumberOfDense());
+  ScoreStats score_entry(store.NumberOfScores());
+  for (size_t s = 0; s < store.NumberOfSentences(); ++s) {
+    stringstream sentence_index;
+    sentence_index << s;
+    FeatureArray feature_array;
+    feature_array.NumberOfFeatures(store.NumberOfDense());
+    feature_array.Features(store.FeatureNames());
+    feature_array.setIndex(sentence_index.str());
+    ScoreArray score_array;
+    score_array.NumberOfScores(store.NumberOfScores());
+    score_array.setIndex(sentence_index.str());
+
+    for (size_t h = store.begin(s); h < store.end(s); ++h) {
+      feature_entry.reset();
+      const float* dense = store.dense(h);
+      for (size_t i = 0; i < store.NumberOfDense(); ++i)
+        feature_entry.add(dense[i]);
+      for (size_t i = store.sparseBegin(h); i < store.sparseEnd(h); ++i) {
+        feature_entry.addSparse(store.SparseName(store.sparseId(i)),
+                                store.sparseValue(i));
+        m_sparse_flag = true;
+      }
+      feature_array.add(feature_entry);
+
+      score_entry.reset();
+      const float* scores = store.scores(h);
+      for (size_t i = 0; i < store.NumberOfScores(); ++i)
+        score_entry.add(static_cast<ScoreStatsType>(scores[i]));
+      score_array.add(score_entry);
+    }
+    m_feature_data->add(feature_array);
+    m_score_data->add(score_array);
+  }
+}
+
+void Data::loadNBest(const string &file, size_t threads)
 {
   TRACE_ERR("loading nbest from " << file << endl);
   inputfilestream inp(file); // matches a stream with a file. Opens the file
   if (!inp.good())
     throw runtime_error("Unable to open: " + file);
 
-  ScoreStats scoreentry;
-  string line, sentence_index, sentence, feature_str, alignment;
-
-  while (getline(inp, line, '\n')) {
-    if (line.empty()) continue;
-    // adding statistics for error measures
-    scoreentry.clear();
-
-    getNextPound(line, sentence_index, "|||"); // first field
-    getNextPound(line, sentence, "|||");       // second field
-    getNextPound(line, feature_str, "|||");    // third field
+#ifdef WITH_THREADS
+  if (threads > 1 && !m_scorer->isThreadSafe()) {
+    TRACE_ERR("Scorer " << m_scorer->getName()
+              << " cannot prepare statistics in parallel, using one thread" << endl);
+    threads = 1;
+  }
+#else
+  threads = 1;
+#endif
+
+  // Read a block of entries, prepare their statistics (in parallel if
+  // asked to), then add them in file order.
+  vector<NBestEntry> entries;
+  entries.reserve(kNBestBlockSize);
+  string line, alignment;
+  bool more = true;
+  while (more) {
+    entries.clear();
+    while (entries.size() < kNBestBlockSize && (more = !getline(inp, line, '\n').fail())) {
+      if (line.empty()) continue;
+      entries.resize(entries.size() + 1);
+      NBestEntry& entry = entries.back();
+
+      getNextPound(line, entry.sentence_index, "|||"); // first field
+      getNextPound(line, entry.sentence, "|||");       // second field
+      getNextPound(line, entry.feature_str, "|||");    // third field
 
-    if (line.length() > 0) {
-      string temp;
-      getNextPound(line, temp, "|||"); //fourth field sentence score
       if (line.length() > 0) {
-        getNextPound(line, alignment, "|||"); //fourth field only there if alignment scorer
+        string temp;
+        getNextPound(line, temp, "|||"); //fourth field sentence score
+        if (line.length() > 0) {
+          getNextPound(line, alignment, "|||"); //fourth field only there if alignment scorer
+        }
+      }
+      //TODO check alignment exists if scorers need it
+
+      if (m_scorer->useAlignment()) {
+        entry.sentence += "|||";
+        entry.sentence += alignment;
       }
     }
-    //TODO check alignment exists if scorers need it
 
-    if (m_scorer->useAlignment()) {
-      sentence += "|||";
-      sentence += alignment;
+#ifdef WITH_THREADS
+    if (threads > 1) {
+      boost::mutex mutex;
+      string error;
+      Moses::ThreadPool pool(threads);
+      const size_t chunk = entries.size() / (4 * threads) + 1;
+      for (size_t begin = 0; begin < entries.size(); begin += chunk) {
+        pool.Submit(new PrepareStatsTask(m_scorer, entries, begin,
+                                         min(begin + chunk, entries.size()),
+                                         mutex, error));
+      }
+      pool.Stop(true);
+      if (!error.empty()) throw runtime_error(error);
+    } else
+#endif
+    {
+      for (size_t i = 0; i < entries.size(); ++i) {
+        // adding statistics for error measures
+        m_scorer->prepareStats(entries[i].sentence_index, entries[i].sentence,
+                               entries[i].stats);
+      }
     }
-    m_scorer->prepareStats(sentence_index, sentence, scoreentry);
-    
-    m_score_data->add(scoreentry, sentence_index);
 
-    // examine first line for name of features
-    if (!existsFeatureNames()) {
-      InitFeatureMap(feature_str);
+    for (size_t i = 0; i < entries.size(); ++i) {
+      const NBestEntry& entry = entries[i];
+      m_score_data->add(entry.stats, entry.sentence_index);
+
+      // examine first line for name of features
+      if (!existsFeatureNames()) {
+        InitFeatureMap(entry.feature_str);
+      }
+      AddFeatures(entry.feature_str, entry.sentence_index);
     }
-    AddFeatures(feature_str, sentence_index);
   }
   inp.close();
 }
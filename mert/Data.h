@@ -63,10 +63,18 @@ public:
   bool hasSparseFeatures() const { return m_sparse_flag; }
   void mergeSparseFeatures();
 
-  void loadNBest(const std::string &file);
+  /**
+   * Add the hypotheses of an n-best list.  With several threads, the
+   * statistics of a block of sentences are prepared in parallel if the
+   * scorer allows it; the result does not depend on the thread count.
+   */
+  void loadNBest(const std::string &file, std::size_t threads = 1);
 
   void load(const std::string &featfile, const std::string &scorefile);
 
+  /** Load all hypotheses from a hypothesis store (see HypothesisStore.h). */
+  void loadStore(const std::string &storefile);
+
   void save(const std::string &featfile, const std::string &scorefile, bool bin=false);
 
   //ADDED BY TS
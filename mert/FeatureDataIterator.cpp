@@ -53,7 +53,7 @@ float ParseFloat(const StringPiece& str) {
 }
 
 bool operator==(FeatureDataItem const& item1, FeatureDataItem const& item2) {
-  return item1.dense==item1.dense && item1.sparse==item1.sparse;
+  return item1.dense==item2.dense && item1.sparse==item2.sparse;
 }
 
 size_t hash_value(FeatureDataItem const& item) {
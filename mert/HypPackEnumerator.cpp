@@ -194,6 +194,101 @@ const ScoreDataItem& RandomAccessHypPackEnumerator::scoresAt(size_t i) {
 size_t RandomAccessHypPackEnumerator::cur_id() {
   return m_indexes[m_cur_index];
 }  
+
+/* --------- StoreHypPackEnumerator ------------- */
+
+StoreHypPackEnumerator::StoreHypPackEnumerator(string const& storeFile,
+                                               bool no_shuffle)
+  : m_store(storeFile),
+    m_no_shuffle(no_shuffle),
+    m_cur_index(0)
+{
+  if (m_store.NumberOfSentences() == 0) {
+    cerr << "No data to process" << endl;
+    exit(0);
+  }
+  for (size_t i = 0; i < m_store.NumberOfSentences(); ++i) {
+    m_indexes.push_back(i);
+  }
+}
+
+size_t StoreHypPackEnumerator::num_dense() const {
+  return m_store.NumberOfDense();
+}
+
+// Decode the current sentence's hypotheses.  As in the other enumerators,
+// hypotheses with the same features as an earlier one are skipped.
+void StoreHypPackEnumerator::prime() {
+  m_current_featureVectors.clear();
+  m_current_scores.clear();
+  if (finished()) return;
+
+  const size_t sentence = m_indexes[m_cur_index];
+  const size_t numDense = m_store.NumberOfDense();
+  const vector<size_t>& sparseIds = m_store.SparseVectorIds();
+  boost::unordered_set<string> seen;
+  vector<ValType> dense;
+  vector<pair<size_t,ValType> > sparse;
+  vector<size_t> sparseFeats;
+  vector<ValType> sparseVals;
+  for (size_t h = m_store.begin(sentence); h < m_store.end(sentence); ++h) {
+    const float* values = m_store.dense(h);
+    string key(reinterpret_cast<const char*>(values), numDense * sizeof(float));
+    const size_t sparseBegin = m_store.sparseBegin(h);
+    const size_t sparseEnd = m_store.sparseEnd(h);
+    for (size_t i = sparseBegin; i < sparseEnd; ++i) {
+      const uint32_t id = m_store.sparseId(i);
+      const float value = m_store.sparseValue(i);
+      key.append(reinterpret_cast<const char*>(&id), sizeof(id));
+      key.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+    if (!seen.insert(key).second) continue;
+
+    dense.assign(values, values + numDense);
+    sparse.clear();
+    for (size_t i = sparseBegin; i < sparseEnd; ++i) {
+      sparse.push_back(make_pair(numDense + sparseIds[m_store.sparseId(i)],
+                                 m_store.sparseValue(i)));
+    }
+    sort(sparse.begin(), sparse.end());
+    sparseFeats.clear();
+    sparseVals.clear();
+    for (size_t i = 0; i < sparse.size(); ++i) {
+      sparseFeats.push_back(sparse[i].first);
+      sparseVals.push_back(sparse[i].second);
+    }
+    m_current_featureVectors.push_back(MiraFeatureVector(dense, sparseFeats, sparseVals));
+    m_current_scores.push_back(ScoreDataItem());
+    m_store.getScoreDataItem(h, m_current_scores.back());
+  }
+}
+
+void StoreHypPackEnumerator::reset() {
+  m_cur_index = 0;
+  if(!m_no_shuffle) random_shuffle(m_indexes.begin(),m_indexes.end());
+  prime();
+}
+bool StoreHypPackEnumerator::finished() {
+  return m_cur_index >= m_indexes.size();
+}
+void StoreHypPackEnumerator::next() {
+  m_cur_index++;
+  prime();
+}
+
+size_t StoreHypPackEnumerator::cur_size() {
+  return m_current_featureVectors.size();
+}
+const MiraFeatureVector& StoreHypPackEnumerator::featuresAt(size_t i) {
+  return m_current_featureVectors[i];
+}
+const ScoreDataItem& StoreHypPackEnumerator::scoresAt(size_t i) {
+  return m_current_scores[i];
+}
+
+size_t StoreHypPackEnumerator::cur_id() {
+  return m_indexes[m_cur_index];
+}
 // --Emacs trickery--
 // Local Variables:
 // mode:c++
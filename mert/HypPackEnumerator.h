@@ -15,6 +15,7 @@
 #include <stddef.h>
 
 #include "FeatureDataIterator.h"
+#include "HypothesisStore.h"
 #include "ScoreDataIterator.h"
 #include "MiraFeatureVector.h"
 
@@ -101,6 +102,34 @@ private:
   std::vector<std::vector<ScoreDataItem> > m_scores;
 };
 
+// Instantiation that reads a memory-mapped hypothesis store in place
+// Low-memory, high-speed, random access
+// (Randomizes with each call to reset, like RandomAccessHypPackEnumerator)
+class StoreHypPackEnumerator : public HypPackEnumerator {
+public:
+  StoreHypPackEnumerator(std::string const& storeFile, bool no_shuffle);
+
+  virtual std::size_t num_dense() const;
+
+  virtual void reset();
+  virtual bool finished();
+  virtual void next();
+
+  virtual std::size_t cur_id();
+  virtual std::size_t cur_size();
+  virtual const MiraFeatureVector& featuresAt(std::size_t i);
+  virtual const ScoreDataItem& scoresAt(std::size_t i);
+
+private:
+  void prime();
+  HypothesisStore m_store;
+  bool m_no_shuffle;
+  std::size_t m_cur_index;
+  std::vector<std::size_t> m_indexes;
+  std::vector<MiraFeatureVector> m_current_featureVectors;
+  std::vector<ScoreDataItem> m_current_scores;
+};
+
 }
 
 #endif // MERT_HYP_PACK_COLLECTION_H
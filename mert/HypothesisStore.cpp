@@ -0,0 +1,391 @@
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2012- University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+#include "util/file.hh"
+
+#include "FeatureData.h"
+#include "HypothesisStore.h"
+#include "ScoreData.h"
+
+using namespace std;
+
+namespace MosesTuning
+{
+
+using namespace HypothesisStoreFormat;
+
+namespace
+{
+
+struct NameLess {
+  bool operator()(const pair<string, float>& a,
+                  const pair<string, float>& b) const {
+    return a.first < b.first;
+  }
+};
+
+bool FileExists(const string& filename)
+{
+  ifstream in(filename.c_str());
+  return in.good();
+}
+
+void Pad(ofstream& out)
+{
+  static const char padding[8] = {0};
+  const uint64_t pos = out.tellp();
+  out.write(padding, (8 - pos % 8) % 8);
+}
+
+// Append the contents of a file, returning the offset it starts at.
+uint64_t CopySection(ofstream& out, const string& filename)
+{
+  Pad(out);
+  const uint64_t offset = out.tellp();
+  ifstream in(filename.c_str(), ios::in | ios::binary);
+  if (in.peek() != EOF) {
+    out << in.rdbuf();
+  }
+  return offset;
+}
+
+template <class T> uint64_t WriteSection(ofstream& out, const vector<T>& vec)
+{
+  Pad(out);
+  const uint64_t offset = out.tellp();
+  if (!vec.empty()) {
+    out.write(reinterpret_cast<const char*>(&vec[0]), vec.size() * sizeof(T));
+  }
+  return offset;
+}
+
+}  // namespace
+
+HypothesisStore::HypothesisStore(const string& filename)
+  : m_header(NULL)
+{
+  open(filename);
+}
+
+void HypothesisStore::open(const string& filename)
+{
+  util::scoped_fd file(util::OpenReadOrThrow(filename.c_str()));
+  const uint64_t size = util::SizeFile(file.get());
+  if (size < sizeof(Header)) {
+    throw runtime_error("Hypothesis store is truncated: " + filename);
+  }
+  util::MapRead(util::LAZY, file.get(), 0, size, m_memory);
+  m_header = section<Header>(0);
+  if (memcmp(m_header->magic, kMagic, sizeof(kMagic)) != 0) {
+    m_header = NULL;
+    throw runtime_error("Not a hypothesis store: " + filename);
+  }
+  if (m_header->version != kVersion) {
+    m_header = NULL;
+    throw runtime_error("Unsupported hypothesis store version: " + filename);
+  }
+
+  m_sentences = section<uint64_t>(m_header->sentenceOffset);
+  m_dense = section<float>(m_header->denseOffset);
+  m_scores = section<float>(m_header->scoreOffset);
+  m_sparseIndex = section<uint64_t>(m_header->sparseIndexOffset);
+  m_sparseIds = section<uint32_t>(m_header->sparseIdOffset);
+  m_sparseValues = section<float>(m_header->sparseValueOffset);
+  m_nameIndex = section<uint64_t>(m_header->nameIndexOffset);
+  m_nameStrings = section<char>(m_header->nameStringOffset);
+
+  m_sparseVectorIds.resize(m_header->numSparseNames);
+  for (size_t i = 0; i < m_sparseVectorIds.size(); ++i) {
+    m_sparseVectorIds[i] = SparseVector::encode(SparseName(i));
+  }
+}
+
+void HypothesisStore::close()
+{
+  m_memory.reset();
+  m_header = NULL;
+  m_sparseVectorIds.clear();
+}
+
+string HypothesisStore::FeatureNames() const
+{
+  return string(section<char>(m_header->featureNamesOffset),
+                m_header->featureNamesSize);
+}
+
+string HypothesisStore::SparseName(uint32_t id) const
+{
+  return string(m_nameStrings + m_nameIndex[id],
+                m_nameIndex[id+1] - m_nameIndex[id]);
+}
+
+void HypothesisStore::getFeatureDataItem(size_t hypo, FeatureDataItem& item) const
+{
+  const float* values = dense(hypo);
+  item.dense.assign(values, values + m_header->numDense);
+  item.sparse.clear();
+  for (size_t i = sparseBegin(hypo); i < sparseEnd(hypo); ++i) {
+    item.sparse.set(SparseName(sparseId(i)), sparseValue(i));
+  }
+}
+
+void HypothesisStore::getScoreDataItem(size_t hypo, ScoreDataItem& item) const
+{
+  const float* values = scores(hypo);
+  item.assign(values, values + m_header->numScores);
+}
+
+size_t HypothesisStore::Append(const string& filename,
+                               const FeatureData& features,
+                               const ScoreData& scores)
+{
+  if (features.size() != scores.size()) {
+    throw runtime_error("Feature and score data have a different number of sentences");
+  }
+  size_t numScores = scores.NumberOfScores();
+  if (scores.size() > 0 && scores.get(0).size() > 0) {
+    numScores = scores.get(0, 0).size();
+  }
+
+  HypothesisStore old;
+  if (FileExists(filename)) {
+    old.open(filename);
+    if (old.NumberOfDense() != features.NumberOfFeatures() ||
+        old.NumberOfScores() != numScores) {
+      throw runtime_error("Hypothesis store " + filename +
+                          " has a different number of features or scores");
+    }
+  }
+
+  const string tmp = filename + ".tmp";
+  HypothesisStoreWriter writer(tmp, features.NumberOfFeatures(), numScores,
+                               old.isOpen() ? old.FeatureNames() : features.Features());
+  const size_t numSentences = max(features.size(),
+                                  old.isOpen() ? old.NumberOfSentences() : 0);
+  vector<float> dense(features.NumberOfFeatures());
+  vector<float> stats(numScores);
+  vector<pair<string, float> > sparse;
+  size_t added = 0;
+  for (size_t s = 0; s < numSentences; ++s) {
+    writer.startSentence();
+    if (old.isOpen() && s < old.NumberOfSentences()) {
+      for (size_t h = old.begin(s); h < old.end(s); ++h) {
+        sparse.clear();
+        for (size_t i = old.sparseBegin(h); i < old.sparseEnd(h); ++i) {
+          sparse.push_back(make_pair(old.SparseName(old.sparseId(i)),
+                                     old.sparseValue(i)));
+        }
+        writer.add(old.dense(h), old.scores(h), sparse);
+      }
+    }
+    if (s >= features.size()) continue;
+
+    const FeatureArray& featureArray = features.get(s);
+    const ScoreArray& scoreArray = scores.get(s);
+    if (featureArray.size() != scoreArray.size()) {
+      throw runtime_error("Feature and score data have a different number of hypotheses");
+    }
+    for (size_t h = 0; h < featureArray.size(); ++h) {
+      const FeatureStats& featureStats = featureArray.get(h);
+      const ScoreStats& scoreStats = scoreArray.get(h);
+      if (featureStats.size() != dense.size() || scoreStats.size() != stats.size()) {
+        throw runtime_error("Inconsistent number of features or scores in sentence " +
+                            featureArray.getIndex());
+      }
+      for (size_t i = 0; i < dense.size(); ++i) {
+        dense[i] = featureStats.get(i);
+      }
+      for (size_t i = 0; i < stats.size(); ++i) {
+        stats[i] = scoreStats.get(i);
+      }
+      sparse.clear();
+      const SparseVector& sparseVector = featureStats.getSparse();
+      const vector<size_t> feats = sparseVector.feats();
+      for (size_t i = 0; i < feats.size(); ++i) {
+        sparse.push_back(make_pair(SparseVector::decode(feats[i]),
+                                   sparseVector.get(feats[i])));
+      }
+      if (writer.add(dense.empty() ? NULL : &dense[0],
+                     stats.empty() ? NULL : &stats[0], sparse)) {
+        ++added;
+      }
+    }
+  }
+  writer.finish();
+
+  // Unmap the old store before replacing it.
+  old.close();
+  if (rename(tmp.c_str(), filename.c_str()) != 0) {
+    throw runtime_error("Unable to rename " + tmp + " to " + filename);
+  }
+  return added;
+}
+
+HypothesisStoreWriter::HypothesisStoreWriter(const string& filename,
+                                             size_t numDense,
+                                             size_t numScores,
+                                             const string& featureNames)
+  : m_filename(filename),
+    m_numDense(numDense),
+    m_numScores(numScores),
+    m_featureNames(featureNames),
+    m_numHypotheses(0),
+    m_numSparse(0),
+    m_finished(false)
+{
+  for (int i = 0; i < kNumColumns; ++i) {
+    m_columns[i].open(columnFile(i).c_str(), ios::out | ios::binary | ios::trunc);
+    if (!m_columns[i]) {
+      throw runtime_error("Unable to open " + columnFile(i));
+    }
+  }
+  const uint64_t zero = 0;
+  write(kSparseIndex, &zero, 1);
+}
+
+HypothesisStoreWriter::~HypothesisStoreWriter()
+{
+  if (!m_finished) {
+    for (int i = 0; i < kNumColumns; ++i) {
+      m_columns[i].close();
+      remove(columnFile(i).c_str());
+    }
+  }
+}
+
+string HypothesisStoreWriter::columnFile(int column) const
+{
+  stringstream name;
+  name << m_filename << ".column" << column;
+  return name.str();
+}
+
+template <class T> void HypothesisStoreWriter::write(int column, const T* data, size_t n)
+{
+  if (n > 0) {
+    m_columns[column].write(reinterpret_cast<const char*>(data), n * sizeof(T));
+  }
+}
+
+void HypothesisStoreWriter::startSentence()
+{
+  m_sentences.push_back(m_numHypotheses);
+  m_seen.clear();
+}
+
+bool HypothesisStoreWriter::add(const float* dense, const float* scores,
+                                const vector<pair<string, float> >& sparse)
+{
+  vector<pair<string, float> > sorted(sparse);
+  sort(sorted.begin(), sorted.end(), NameLess());
+
+  // Identical hypotheses have identical keys.
+  string key(reinterpret_cast<const char*>(dense), m_numDense * sizeof(float));
+  key.append(reinterpret_cast<const char*>(scores), m_numScores * sizeof(float));
+  for (size_t i = 0; i < sorted.size(); ++i) {
+    key.append(sorted[i].first);
+    key.push_back('\0');
+    key.append(reinterpret_cast<const char*>(&sorted[i].second), sizeof(float));
+  }
+  if (!m_seen.insert(key).second) {
+    return false;
+  }
+
+  write(kDense, dense, m_numDense);
+  write(kScores, scores, m_numScores);
+  for (size_t i = 0; i < sorted.size(); ++i) {
+    boost::unordered_map<string, uint32_t>::const_iterator found =
+      m_nameIds.find(sorted[i].first);
+    uint32_t id;
+    if (found == m_nameIds.end()) {
+      id = m_names.size();
+      m_nameIds[sorted[i].first] = id;
+      m_names.push_back(sorted[i].first);
+    } else {
+      id = found->second;
+    }
+    write(kSparseIds, &id, 1);
+    write(kSparseValues, &sorted[i].second, 1);
+  }
+  m_numSparse += sorted.size();
+  write(kSparseIndex, &m_numSparse, 1);
+  ++m_numHypotheses;
+  return true;
+}
+
+void HypothesisStoreWriter::finish()
+{
+  m_sentences.push_back(m_numHypotheses);
+  for (int i = 0; i < kNumColumns; ++i) {
+    m_columns[i].close();
+  }
+
+  vector<uint64_t> nameIndex;
+  vector<char> nameStrings;
+  for (size_t i = 0; i < m_names.size(); ++i) {
+    nameIndex.push_back(nameStrings.size());
+    nameStrings.insert(nameStrings.end(), m_names[i].begin(), m_names[i].end());
+  }
+  nameIndex.push_back(nameStrings.size());
+
+  Header header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, kMagic, sizeof(header.magic));
+  header.version = kVersion;
+  header.numDense = m_numDense;
+  header.numScores = m_numScores;
+  header.numSentences = m_sentences.size() - 1;
+  header.numHypotheses = m_numHypotheses;
+  header.numSparse = m_numSparse;
+  header.numSparseNames = m_names.size();
+  header.featureNamesSize = m_featureNames.size();
+
+  ofstream out(m_filename.c_str(), ios::out | ios::binary | ios::trunc);
+  out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  header.sentenceOffset = WriteSection(out, m_sentences);
+  header.denseOffset = CopySection(out, columnFile(kDense));
+  header.scoreOffset = CopySection(out, columnFile(kScores));
+  header.sparseIndexOffset = CopySection(out, columnFile(kSparseIndex));
+  header.sparseIdOffset = CopySection(out, columnFile(kSparseIds));
+  header.sparseValueOffset = CopySection(out, columnFile(kSparseValues));
+  header.nameIndexOffset = WriteSection(out, nameIndex);
+  header.nameStringOffset = WriteSection(out, nameStrings);
+  header.featureNamesOffset = WriteSection(
+    out, vector<char>(m_featureNames.begin(), m_featureNames.end()));
+  out.seekp(0);
+  out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  out.close();
+  if (!out) {
+    throw runtime_error("Failed writing " + m_filename);
+  }
+
+  for (int i = 0; i < kNumColumns; ++i) {
+    remove(columnFile(i).c_str());
+  }
+  m_finished = true;
+}
+
+}
@@ -0,0 +1,205 @@
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2012- University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#ifndef MERT_HYPOTHESIS_STORE_H_
+#define MERT_HYPOTHESIS_STORE_H_
+
+/**
+  * Binary, memory-mapped store of the n-best hypotheses of all tuning
+  * iterations: dense features, sparse features and sufficient statistics,
+  * grouped by sentence.  Each column is a flat array, so mert, pro and
+  * kbmira can read it in place without parsing.
+  *
+  * The extractor appends each iteration's hypotheses to the store (see
+  * HypothesisStore::Append), dropping any hypothesis whose features and
+  * statistics are identical to one already stored for the same sentence.
+**/
+
+#include <fstream>
+#include <stdint.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <boost/unordered_map.hpp>
+#include <boost/unordered_set.hpp>
+
+#include "util/mmap.hh"
+
+#include "FeatureDataIterator.h"
+#include "ScoreDataIterator.h"
+
+namespace MosesTuning
+{
+
+class FeatureData;
+class ScoreData;
+
+namespace HypothesisStoreFormat
+{
+
+const char kMagic[8] = {'M', 'E', 'R', 'T', 'H', 'Y', 'P', 'S'};
+const uint64_t kVersion = 1;
+
+// Every offset is in bytes from the start of the file and 8-byte aligned.
+struct Header {
+  char magic[8];
+  uint64_t version;
+  uint64_t numDense;
+  uint64_t numScores;
+  uint64_t numSentences;
+  uint64_t numHypotheses;
+  uint64_t numSparse;           // total number of sparse feature values
+  uint64_t numSparseNames;
+  uint64_t sentenceOffset;      // uint64_t[numSentences+1], first hypothesis
+  uint64_t denseOffset;         // float[numHypotheses*numDense]
+  uint64_t scoreOffset;         // float[numHypotheses*numScores]
+  uint64_t sparseIndexOffset;   // uint64_t[numHypotheses+1], first sparse value
+  uint64_t sparseIdOffset;      // uint32_t[numSparse], index into names
+  uint64_t sparseValueOffset;   // float[numSparse]
+  uint64_t nameIndexOffset;     // uint64_t[numSparseNames+1]
+  uint64_t nameStringOffset;    // char[], sparse feature names
+  uint64_t featureNamesOffset;  // char[], dense feature names, space separated
+  uint64_t featureNamesSize;
+};
+
+}  // namespace HypothesisStoreFormat
+
+/** Read-only view of a store file. */
+class HypothesisStore
+{
+public:
+  HypothesisStore() : m_header(NULL) {}
+  explicit HypothesisStore(const std::string& filename);
+
+  void open(const std::string& filename);
+  void close();
+  bool isOpen() const { return m_header != NULL; }
+
+  std::size_t NumberOfSentences() const { return m_header->numSentences; }
+  std::size_t NumberOfHypotheses() const { return m_header->numHypotheses; }
+  std::size_t NumberOfDense() const { return m_header->numDense; }
+  std::size_t NumberOfScores() const { return m_header->numScores; }
+  std::size_t NumberOfSparseNames() const { return m_header->numSparseNames; }
+
+  //! dense feature names as in the header of a feature data file
+  std::string FeatureNames() const;
+
+  //! hypotheses of sentence s are [begin(s), end(s))
+  std::size_t begin(std::size_t sentence) const { return m_sentences[sentence]; }
+  std::size_t end(std::size_t sentence) const { return m_sentences[sentence+1]; }
+
+  const float* dense(std::size_t hypo) const {
+    return m_dense + hypo * m_header->numDense;
+  }
+  const float* scores(std::size_t hypo) const {
+    return m_scores + hypo * m_header->numScores;
+  }
+
+  //! sparse values of hypothesis h are [sparseBegin(h), sparseEnd(h))
+  std::size_t sparseBegin(std::size_t hypo) const { return m_sparseIndex[hypo]; }
+  std::size_t sparseEnd(std::size_t hypo) const { return m_sparseIndex[hypo+1]; }
+  uint32_t sparseId(std::size_t i) const { return m_sparseIds[i]; }
+  float sparseValue(std::size_t i) const { return m_sparseValues[i]; }
+  std::string SparseName(uint32_t id) const;
+
+  /** Sparse feature ids as used by SparseVector::encode(), by store id. */
+  const std::vector<std::size_t>& SparseVectorIds() const { return m_sparseVectorIds; }
+
+  void getFeatureDataItem(std::size_t hypo, FeatureDataItem& item) const;
+  void getScoreDataItem(std::size_t hypo, ScoreDataItem& item) const;
+
+  /**
+    * Append the hypotheses of feature and score data to the store in
+    * filename, creating it if it does not exist.  Returns the number of
+    * hypotheses added.
+    */
+  static std::size_t Append(const std::string& filename,
+                            const FeatureData& features,
+                            const ScoreData& scores);
+
+private:
+  template <class T> const T* section(uint64_t offset) const {
+    return reinterpret_cast<const T*>(
+             static_cast<const char*>(m_memory.get()) + offset);
+  }
+
+  util::scoped_memory m_memory;
+  const HypothesisStoreFormat::Header* m_header;
+  const uint64_t* m_sentences;
+  const float* m_dense;
+  const float* m_scores;
+  const uint64_t* m_sparseIndex;
+  const uint32_t* m_sparseIds;
+  const float* m_sparseValues;
+  const uint64_t* m_nameIndex;
+  const char* m_nameStrings;
+  std::vector<std::size_t> m_sparseVectorIds;
+};
+
+/**
+  * Writes a store file.  Columns are streamed to temporary files next to
+  * the output and concatenated by finish(), so memory use is bounded by
+  * one sentence.
+  */
+class HypothesisStoreWriter
+{
+public:
+  HypothesisStoreWriter(const std::string& filename,
+                        std::size_t numDense,
+                        std::size_t numScores,
+                        const std::string& featureNames);
+  ~HypothesisStoreWriter();
+
+  void startSentence();
+
+  /**
+    * Add a hypothesis to the current sentence; sparse features are given
+    * as (name, value) pairs.  Returns false, and stores nothing, if the
+    * sentence already has an identical hypothesis.
+    */
+  bool add(const float* dense, const float* scores,
+           const std::vector<std::pair<std::string, float> >& sparse);
+
+  void finish();
+
+private:
+  enum Column { kDense, kScores, kSparseIndex, kSparseIds, kSparseValues,
+                kNumColumns };
+
+  std::string columnFile(int column) const;
+  template <class T> void write(int column, const T* data, std::size_t n);
+
+  std::string m_filename;
+  std::size_t m_numDense;
+  std::size_t m_numScores;
+  std::string m_featureNames;
+  std::ofstream m_columns[kNumColumns];
+  std::vector<uint64_t> m_sentences;
+  uint64_t m_numHypotheses;
+  uint64_t m_numSparse;
+  boost::unordered_map<std::string, uint32_t> m_nameIds;
+  std::vector<std::string> m_names;
+  boost::unordered_set<std::string> m_seen;  // hypotheses of this sentence
+  bool m_finished;
+};
+
+}
+
+#endif  // MERT_HYPOTHESIS_STORE_H_
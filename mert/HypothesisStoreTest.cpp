@@ -0,0 +1,93 @@
+#include "Data.h"
+#include "HypothesisStore.h"
+#include "Scorer.h"
+#include "ScorerFactory.h"
+
+#define BOOST_TEST_MODULE MertHypothesisStore
+#include <boost/test/unit_test.hpp>
+
+#include <boost/scoped_ptr.hpp>
+
+#include <cstdio>
+#include <unistd.h>
+
+using namespace MosesTuning;
+
+namespace {
+
+// Two sentences: sentence 0 gets hypotheses v = base, base+1 and
+// sentence 1 gets v = base+2.  Features and scores depend only on v.
+void AddIteration(Data& data, int base) {
+  for (int h = 0; h < 3; ++h) {
+    const int v = base + h;
+    FeatureStats features;
+    features.add(v);
+    features.add(-1.0);
+    features.addSparse("sp_1", 0.5 * v);
+    ScoreStats scores;
+    for (int i = 0; i < 9; ++i) scores.add(v + i);
+    const std::string sentence = h < 2 ? "0" : "1";
+    data.getFeatureData()->add(features, sentence);
+    data.getScoreData()->add(scores, sentence);
+  }
+}
+
+std::string TempFile() {
+  char name[] = "/tmp/hypothesis_store_test_XXXXXX";
+  int fd = mkstemp(name);
+  close(fd);
+  remove(name);
+  return name;
+}
+
+}  // namespace
+
+BOOST_AUTO_TEST_CASE(append_and_read) {
+  const std::string file = TempFile();
+  boost::scoped_ptr<Scorer> scorer(ScorerFactory::getScorer("BLEU", ""));
+
+  Data first(scorer.get());
+  first.getFeatureData()->setFeatureMap("d_0 d_1");
+  AddIteration(first, 1);
+  BOOST_CHECK_EQUAL((std::size_t)3, HypothesisStore::Append(
+                      file, *first.getFeatureData(), *first.getScoreData()));
+
+  // The second iteration repeats hypothesis v = 1 of sentence 0.
+  Data second(scorer.get());
+  second.getFeatureData()->setFeatureMap("d_0 d_1");
+  AddIteration(second, 0);
+  BOOST_CHECK_EQUAL((std::size_t)2, HypothesisStore::Append(
+                      file, *second.getFeatureData(), *second.getScoreData()));
+
+  HypothesisStore store(file);
+  BOOST_CHECK_EQUAL((std::size_t)2, store.NumberOfSentences());
+  BOOST_CHECK_EQUAL((std::size_t)5, store.NumberOfHypotheses());
+  BOOST_CHECK_EQUAL((std::size_t)2, store.NumberOfDense());
+  BOOST_CHECK_EQUAL((std::size_t)9, store.NumberOfScores());
+  BOOST_CHECK_EQUAL("d_0 d_1", store.FeatureNames());
+
+  // Sentence 0: v = 1, 2 from the first iteration, then 0 from the second.
+  BOOST_CHECK_EQUAL((std::size_t)0, store.begin(0));
+  BOOST_CHECK_EQUAL((std::size_t)3, store.end(0));
+  BOOST_CHECK_EQUAL(1.0f, store.dense(0)[0]);
+  BOOST_CHECK_EQUAL(2.0f, store.dense(1)[0]);
+  BOOST_CHECK_EQUAL(0.0f, store.dense(2)[0]);
+  BOOST_CHECK_EQUAL(-1.0f, store.dense(2)[1]);
+  BOOST_CHECK_EQUAL(5.0f, store.scores(4)[3]);
+
+  FeatureDataItem item;
+  store.getFeatureDataItem(1, item);
+  BOOST_CHECK_EQUAL((std::size_t)2, item.dense.size());
+  BOOST_CHECK_EQUAL(1.0f, item.sparse.get("sp_1"));
+
+  // Loading into Data gives the same hypotheses.
+  Data loaded(scorer.get());
+  loaded.loadStore(file);
+  BOOST_CHECK_EQUAL((std::size_t)2, loaded.getFeatureData()->size());
+  BOOST_CHECK_EQUAL((std::size_t)3, loaded.getFeatureData()->get(0).size());
+  BOOST_CHECK_EQUAL(2.0f, loaded.getFeatureData()->get(0, 1).get(0));
+  BOOST_CHECK_EQUAL(5, loaded.getScoreData()->get(1, 1).get(3));
+  BOOST_CHECK(loaded.hasSparseFeatures());
+
+  remove(file.c_str());
+}
@@ -28,6 +28,14 @@ public:
   virtual void setReferenceFiles(const std::vector<std::string>& referenceFiles);
   virtual void prepareStats(std::size_t sid, const std::string& text, ScoreStats& entry);
 
+  virtual bool isThreadSafe() const {
+    for (ScopedVector<Scorer>::const_iterator itsc = m_scorers.begin();
+         itsc != m_scorers.end(); ++itsc) {
+      if (!(*itsc)->isThreadSafe()) return false;
+    }
+    return true;
+  }
+
   virtual std::size_t NumberOfScores() const {
     std::size_t sz = 0;
     for (ScopedVector<Scorer>::const_iterator itsc = m_scorers.begin();
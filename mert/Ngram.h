@@ -1,55 +1,43 @@
 #ifndef MERT_NGRAM_H_
 #define MERT_NGRAM_H_
 
+#include <algorithm>
 #include <vector>
-#include <map>
 #include <string>
+#include <utility>
+
+#include <boost/functional/hash.hpp>
 
 namespace MosesTuning
 {
-  
-/** A simple STL-std::map based n-gram counts. Basically, we provide
- * typical accessors and mutaors, but we intentionally does not allow
- * erasing elements.
+
+/** Flat hashed n-gram counts. Basically, we provide typical accessors
+ * and mutators, but we intentionally does not allow erasing elements.
+ *
+ * Entries are kept in insertion order in one vector, with an
+ * open-addressing table of indices into it. clear() keeps the entries'
+ * storage, so counting sentence after sentence in the same object does
+ * not allocate once it has seen the longest one.
  */
 class NgramCounts {
  public:
-  // Used to construct the ngram map
-  struct NgramComparator {
-    bool operator()(const std::vector<int>& a, const std::vector<int>& b) const {
-      std::size_t i;
-      const std::size_t as = a.size();
-      const std::size_t bs = b.size();
-      for (i = 0; i < as && i < bs; ++i) {
-        if (a[i] < b[i]) {
-          return true;
-        }
-        if (a[i] > b[i]) {
-          return false;
-        }
-      }
-      // entries are equal, shortest wins
-      return as < bs;
-    }
-  };
-
   typedef std::vector<int> Key;
   typedef int Value;
-  typedef std::map<Key, Value, NgramComparator>::iterator iterator;
-  typedef std::map<Key, Value, NgramComparator>::const_iterator const_iterator;
+  typedef std::vector<std::pair<Key, Value> >::iterator iterator;
+  typedef std::vector<std::pair<Key, Value> >::const_iterator const_iterator;
 
-  NgramCounts() : kDefaultCount(1) { }
+  NgramCounts() : kDefaultCount(1), m_size(0), m_slots(kMinSlots, 0) { }
   virtual ~NgramCounts() { }
 
   /**
    * If the specified "ngram" is found, we add counts.
    * If not, we insert the default count in the container. */
   void Add(const Key& ngram) {
-    const_iterator it = find(ngram);
-    if (it != end()) {
-      m_counts[ngram] = it->second + 1;
+    std::size_t slot;
+    if (FindSlot(ngram, &slot)) {
+      ++m_entries[m_slots[slot] - 1].second;
     } else {
-      m_counts[ngram] = kDefaultCount;
+      Insert(ngram, kDefaultCount, slot);
     }
   }
 
@@ -57,45 +45,111 @@ class NgramCounts {
    * Return true iff the specified "ngram" is found in the container.
    */
   bool Lookup(const Key& ngram, Value* v) const {
-    const_iterator it = m_counts.find(ngram);
-    if (it == m_counts.end()) return false;
-    *v = it->second;
+    std::size_t slot;
+    if (!FindSlot(ngram, &slot)) return false;
+    *v = m_entries[m_slots[slot] - 1].second;
     return true;
   }
 
   /**
    * Clear all elments in the container.
    */
-  void clear() { m_counts.clear(); }
+  void clear() {
+    m_size = 0;
+    std::fill(m_slots.begin(), m_slots.end(), 0);
+  }
 
   /**
    * Return true iff the container is empty.
    */
-  bool empty() const { return m_counts.empty(); }
+  bool empty() const { return m_size == 0; }
 
   /**
    * Return the the number of elements in the container.
    */
-  std::size_t size() const { return m_counts.size(); }
+  std::size_t size() const { return m_size; }
 
-  std::size_t max_size() const { return m_counts.max_size(); }
+  std::size_t max_size() const { return m_entries.max_size(); }
 
   // Note: This is mainly used by unit tests.
   int get_default_count() const { return kDefaultCount; }
 
-  iterator find(const Key& ngram) { return m_counts.find(ngram); }
-  const_iterator find(const Key& ngram) const { return m_counts.find(ngram); }
+  iterator find(const Key& ngram) {
+    std::size_t slot;
+    return FindSlot(ngram, &slot) ? m_entries.begin() + (m_slots[slot] - 1) : end();
+  }
+  const_iterator find(const Key& ngram) const {
+    std::size_t slot;
+    return FindSlot(ngram, &slot) ? m_entries.begin() + (m_slots[slot] - 1) : end();
+  }
 
-  Value& operator[](const Key& ngram) { return m_counts[ngram]; }
+  Value& operator[](const Key& ngram) {
+    std::size_t slot;
+    if (!FindSlot(ngram, &slot)) {
+      Insert(ngram, 0, slot);
+    }
+    return m_entries[m_slots[slot] - 1].second;
+  }
 
-  iterator begin() { return m_counts.begin(); }
-  const_iterator begin() const { return m_counts.begin(); }
-  iterator end() { return m_counts.end(); }
-  const_iterator end() const { return m_counts.end(); }
+  iterator begin() { return m_entries.begin(); }
+  const_iterator begin() const { return m_entries.begin(); }
+  iterator end() { return m_entries.begin() + m_size; }
+  const_iterator end() const { return m_entries.begin() + m_size; }
 
  private:
+  static const std::size_t kMinSlots = 64;
+
+  // Find the slot of "ngram", or the empty slot where it would go.
+  bool FindSlot(const Key& ngram, std::size_t* slot) const {
+    const std::size_t mask = m_slots.size() - 1;
+    std::size_t i = boost::hash_range(ngram.begin(), ngram.end()) & mask;
+    while (m_slots[i] != 0) {
+      if (m_entries[m_slots[i] - 1].first == ngram) {
+        *slot = i;
+        return true;
+      }
+      i = (i + 1) & mask;
+    }
+    *slot = i;
+    return false;
+  }
+
+  void Insert(const Key& ngram, Value value, std::size_t& slot) {
+    if (m_size < m_entries.size()) {
+      m_entries[m_size].first.assign(ngram.begin(), ngram.end());
+      m_entries[m_size].second = value;
+    } else {
+      m_entries.push_back(std::make_pair(ngram, value));
+    }
+    ++m_size;
+    m_slots[slot] = m_size;
+    // keep the table at most half full
+    if (2 * m_size > m_slots.size()) {
+      Rehash();
+      FindSlot(ngram, &slot);
+    }
+  }
+
+  void Rehash() {
+    std::vector<std::size_t> slots(2 * m_slots.size(), 0);
+    m_slots.swap(slots);
+    const std::size_t mask = m_slots.size() - 1;
+    for (std::size_t e = 0; e < m_size; ++e) {
+      std::size_t i = boost::hash_range(m_entries[e].first.begin(),
+                                        m_entries[e].first.end()) & mask;
+      while (m_slots[i] != 0) {
+        i = (i + 1) & mask;
+      }
+      m_slots[i] = e + 1;
+    }
+  }
+
   const int kDefaultCount;
-  std::map<Key, Value, NgramComparator> m_counts;
+  // m_entries[0, m_size) are in use; the rest are kept for reuse.
+  std::vector<std::pair<Key, Value> > m_entries;
+  std::size_t m_size;
+  // index + 1 into m_entries, 0 for an empty slot
+  std::vector<std::size_t> m_slots;
 };
 
 }
@@ -27,6 +27,7 @@ public:
 
   virtual void setReferenceFiles(const std::vector<std::string>& referenceFiles);
   virtual void prepareStats(std::size_t sid, const std::string& text, ScoreStats& entry);
+  virtual bool isThreadSafe() const { return true; }
   virtual std::size_t NumberOfScores() const { return 3; }
   virtual float calculateScore(const std::vector<int>& comps) const;
 
@@ -10,7 +10,14 @@ using namespace std;
 
 namespace MosesTuning
 {
-  
+
+#ifdef WITH_THREADS
+namespace {
+// The vocabulary is shared by all scorers.
+boost::mutex vocabulary_mutex;
+}
+#endif
+
 
 Scorer::Scorer(const string& name, const string& config)
     : m_name(name),
@@ -49,6 +56,7 @@ void Scorer::InitConfig(const string& config) {
 
 void Scorer::TokenizeAndEncode(const string& line, vector<int>& encoded) {
   std::istringstream in(line);
+  std::vector<std::string> tokens;
   std::string token;
   while (in >> token) {
     if (!m_enable_preserve_case) {
@@ -57,7 +65,13 @@ void Scorer::TokenizeAndEncode(const string& line, vector<int>& encoded) {
         *it = tolower(*it);
       }
     }
-    encoded.push_back(m_vocab->Encode(token));
+    tokens.push_back(token);
+  }
+#ifdef WITH_THREADS
+  boost::mutex::scoped_lock lock(vocabulary_mutex);
+#endif
+  for (std::size_t i = 0; i < tokens.size(); ++i) {
+    encoded.push_back(m_vocab->Encode(tokens[i]));
   }
 }
 
@@ -126,6 +140,9 @@ string Scorer::applyFilter(const string& sentence) const
 {
   if (m_filter)
   {
+#ifdef WITH_THREADS
+    boost::mutex::scoped_lock lock(m_filter_mutex);
+#endif
     return m_filter->ProcessSentence(sentence);
   }
   else
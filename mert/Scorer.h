@@ -7,6 +7,11 @@
 #include <string>
 #include <vector>
 #include <limits>
+
+#ifdef WITH_THREADS
+#include <boost/thread/mutex.hpp>
+#endif
+
 #include "Types.h"
 #include "ScoreData.h"
 
@@ -60,6 +65,16 @@ class Scorer
     this->prepareStats(static_cast<std::size_t>(atoi(sindex.c_str())), text, entry);
   }
 
+  /**
+   * Return true if prepareStats() may be called from several threads at
+   * once, e.g. for different sentences. Preprocessing and
+   * TokenizeAndEncode() are serialised by this class; a scorer that
+   * keeps no other mutable state while scoring can return true.
+   */
+  virtual bool isThreadSafe() const {
+    return false;
+  }
+
   /**
    * Score using each of the candidate index, then go through the diffs
    * applying each in turn, and calculating a new score each time.
@@ -142,6 +157,9 @@ class Scorer
   std::map<std::string, std::string> m_config;
   std::vector<int> m_factors;
   PreProcessFilter* m_filter;
+#ifdef WITH_THREADS
+  mutable boost::mutex m_filter_mutex;
+#endif
 
  protected:
   ScoreData* m_score_data;
@@ -0,0 +1,482 @@
+#include "fastTerCalc.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+
+#include <boost/unordered_map.hpp>
+
+using namespace std;
+
+namespace TERCpp
+{
+
+fastTerCalc::fastTerCalc()
+{
+  shift_cost = 1;
+  insert_cost = 1;
+  delete_cost = 1;
+  substitute_cost = 1;
+  match_cost = 0;
+  MAX_SHIFT_SIZE = 50;
+  MAX_SHIFT_DIST = 50;
+  BEAM_WIDTH = 20;
+  INF = 999999;
+  m_blocks = 0;
+}
+
+terAlignment fastTerCalc::TER ( const vector<int>& hyp, const vector<int>& ref )
+{
+  vector<int> cur;
+  Prepare ( hyp, ref, cur );
+
+  Alignment cur_align;
+  MinEditDist ( cur, cur_align );
+
+  terAlignment to_return;
+  int edits = 0;
+  terShift best_shift;
+  Alignment best_align;
+  vector<int> best_words;
+  while ( CalcBestShift ( cur, cur_align, best_shift, best_align, best_words ) ) {
+    edits += ( int ) best_shift.cost;
+    to_return.allshifts.push_back ( best_shift );
+    cur_align.numEdits = best_align.numEdits;
+    cur_align.path.swap ( best_align.path );
+    cur.swap ( best_words );
+  }
+  to_return.numWords = ref.size();
+  to_return.numEdits = cur_align.numEdits + edits;
+  to_return.alignment.swap ( cur_align.path );
+  return to_return;
+}
+
+void fastTerCalc::Prepare ( const vector<int>& hyp, const vector<int>& ref,
+                            vector<int>& cur )
+{
+  boost::unordered_map<int, int> ids;
+  m_ref.resize ( ref.size() );
+  for ( size_t i = 0; i < ref.size(); ++i ) {
+    boost::unordered_map<int, int>::const_iterator found = ids.find ( ref[i] );
+    if ( found == ids.end() ) {
+      const int id = ids.size();
+      ids[ref[i]] = id;
+      m_ref[i] = id;
+    } else {
+      m_ref[i] = found->second;
+    }
+  }
+  cur.resize ( hyp.size() );
+  for ( size_t j = 0; j < hyp.size(); ++j ) {
+    boost::unordered_map<int, int>::const_iterator found = ids.find ( hyp[j] );
+    if ( found == ids.end() ) {
+      const int id = ids.size();
+      ids[hyp[j]] = id;
+      cur[j] = id;
+    } else {
+      cur[j] = found->second;
+    }
+  }
+
+  const size_t vocab = ids.size();
+  m_refPositions.resize ( vocab );
+  for ( size_t v = 0; v < vocab; ++v ) {
+    m_refPositions[v].clear();
+  }
+  m_blocks = ( m_ref.size() + 63 ) / 64;
+  m_peq.assign ( vocab * m_blocks, 0 );
+  for ( size_t i = 0; i < m_ref.size(); ++i ) {
+    m_refPositions[m_ref[i]].push_back ( i );
+    m_peq[m_ref[i] * m_blocks + i / 64] |= ( uint64_t ) 1 << ( i % 64 );
+  }
+  m_pv.resize ( m_blocks );
+  m_mv.resize ( m_blocks );
+}
+
+// Levenshtein distance between hyp and the reference, one column of the
+// dynamic programming matrix per hyp word, 64 reference words per machine
+// word (Hyyro, "A bit-vector algorithm for computing Levenshtein and
+// Damerau edit distances", 2003).
+int fastTerCalc::EditDistance ( const vector<int>& hyp )
+{
+  const size_t ref_size = m_ref.size();
+  if ( ref_size == 0 ) {
+    return hyp.size();
+  }
+  const size_t last = m_blocks - 1;
+  const size_t last_bit = ( ref_size - 1 ) % 64;
+  fill ( m_pv.begin(), m_pv.end(), ~( uint64_t ) 0 );
+  fill ( m_mv.begin(), m_mv.end(), 0 );
+
+  int score = ref_size;
+  for ( size_t j = 0; j < hyp.size(); ++j ) {
+    const uint64_t* peq = &m_peq[hyp[j] * m_blocks];
+    // horizontal delta entering the block from above; +1 in the first row
+    int hin = 1;
+    for ( size_t b = 0; b < m_blocks; ++b ) {
+      const uint64_t pv = m_pv[b];
+      const uint64_t mv = m_mv[b];
+      const uint64_t hin_neg = hin < 0 ? 1 : 0;
+      uint64_t eq = peq[b];
+      const uint64_t xv = eq | mv;
+      eq |= hin_neg;
+      const uint64_t xh = ( ( ( eq & pv ) + pv ) ^ pv ) | eq;
+      uint64_t ph = mv | ~ ( xh | pv );
+      uint64_t mh = pv & xh;
+      int hout = 0;
+      if ( b == last ) {
+        score += ( int ) ( ( ph >> last_bit ) & 1 ) - ( int ) ( ( mh >> last_bit ) & 1 );
+      } else {
+        hout = ( int ) ( ph >> 63 ) - ( int ) ( mh >> 63 );
+      }
+      ph <<= 1;
+      mh <<= 1;
+      mh |= hin_neg;
+      if ( hin > 0 ) {
+        ph |= 1;
+      }
+      m_pv[b] = mh | ~ ( xv | ph );
+      m_mv[b] = ph & xv;
+      hin = hout;
+    }
+  }
+  return score;
+}
+
+// Beam-search edit distance with backtrace, as terCalc::MinEditDist
+// without hyp/ref spans (which terCalc never sets).
+void fastTerCalc::MinEditDist ( const vector<int>& hyp, Alignment& out )
+{
+  const vector<int>& ref = m_ref;
+  const int ref_size = ref.size();
+  const int hyp_size = hyp.size();
+  const int stride = hyp_size + 1;
+  m_S.assign ( ( ref_size + 1 ) * stride, -1 );
+  m_P.assign ( ( ref_size + 1 ) * stride, '0' );
+  int* S = &m_S[0];
+  char* P = &m_P[0];
+
+  int current_best = INF;
+  int last_best = INF;
+  int first_good = 0;
+  int current_first_good = 0;
+  int last_good = -1;
+  int cur_last_good = 0;
+
+  S[0] = 0;
+  for ( int j = 0; j <= hyp_size; j++ ) {
+    last_best = current_best;
+    current_best = INF;
+    first_good = current_first_good;
+    current_first_good = -1;
+    last_good = cur_last_good;
+    cur_last_good = -1;
+    for ( int i = max ( first_good, 0 ); i <= ref_size; i++ ) {
+      if ( i > last_good ) {
+        break;
+      }
+      const int here = i * stride + j;
+      if ( S[here] < 0 ) {
+        continue;
+      }
+      const int score = S[here];
+      if ( ( j < hyp_size ) && ( score > last_best + BEAM_WIDTH ) ) {
+        continue;
+      }
+      if ( current_first_good == -1 ) {
+        current_first_good = i;
+      }
+      if ( ( i < ref_size ) && ( j < hyp_size ) ) {
+        const int diag = here + stride + 1;
+        if ( ref[i] == hyp[j] ) {
+          const int cost = match_cost + score;
+          if ( ( S[diag] == -1 ) || ( cost < S[diag] ) ) {
+            S[diag] = cost;
+            P[diag] = ' ';
+          }
+          if ( cost < current_best ) {
+            current_best = cost;
+          }
+        } else {
+          const int cost = substitute_cost + score;
+          if ( ( S[diag] < 0 ) || ( cost < S[diag] ) ) {
+            S[diag] = cost;
+            P[diag] = 'S';
+            if ( cost < current_best ) {
+              current_best = cost;
+            }
+          }
+        }
+      }
+      cur_last_good = i + 1;
+      if ( j < hyp_size ) {
+        const int icost = score + insert_cost;
+        if ( ( S[here+1] < 0 ) || ( S[here+1] > icost ) ) {
+          S[here+1] = icost;
+          P[here+1] = 'I';
+        }
+      }
+      if ( i < ref_size ) {
+        const int dcost = score + delete_cost;
+        if ( ( S[here+stride] < 0 ) || ( S[here+stride] > dcost ) ) {
+          S[here+stride] = dcost;
+          P[here+stride] = 'D';
+          if ( i >= last_good ) {
+            last_good = i + 1;
+          }
+        }
+      }
+    }
+  }
+
+  int tracelength = 0;
+  int i = ref_size;
+  int j = hyp_size;
+  while ( ( i > 0 ) || ( j > 0 ) ) {
+    tracelength++;
+    const char p = P[i * stride + j];
+    if ( p == ' ' || p == 'S' ) {
+      i--;
+      j--;
+    } else if ( p == 'D' ) {
+      i--;
+    } else if ( p == 'I' ) {
+      j--;
+    } else {
+      cerr << "ERROR : fastTerCalc::MinEditDist : Invalid path : " << p << endl;
+      exit ( -1 );
+    }
+  }
+  out.path.resize ( tracelength );
+  i = ref_size;
+  j = hyp_size;
+  while ( ( i > 0 ) || ( j > 0 ) ) {
+    const char p = P[i * stride + j];
+    out.path[--tracelength] = p;
+    if ( p == ' ' || p == 'S' ) {
+      i--;
+      j--;
+    } else if ( p == 'D' ) {
+      i--;
+    } else {
+      j--;
+    }
+  }
+  out.numEdits = S[ref_size * stride + hyp_size];
+}
+
+bool fastTerCalc::CalcBestShift ( const vector<int>& cur, const Alignment& med_align,
+                                  terShift& best_shift, Alignment& best_align,
+                                  vector<int>& best_words )
+{
+  FindAlignErr ( med_align );
+  GatherAllPossShifts ( cur );
+
+  const int curerr = med_align.numEdits;
+  int cur_best_shift_cost = 0;
+  int cur_best_edits = med_align.numEdits;
+  bool anygain = false;
+  Alignment curalign;
+
+  for ( int i = ( int ) m_shifts.size() - 1; i >= 0; i-- ) {
+    /* Consider shifts of length i+1 */
+    const int maxfix = 2 * ( 1 + i );
+    int curfix = curerr - ( cur_best_shift_cost + cur_best_edits );
+    if ( ( curfix > maxfix ) || ( ( cur_best_shift_cost != 0 ) && ( curfix == maxfix ) ) ) {
+      break;
+    }
+    const vector<terShift>& shifts = m_shifts[i];
+    for ( size_t s = 0; s < shifts.size(); s++ ) {
+      curfix = curerr - ( cur_best_shift_cost + cur_best_edits );
+      if ( ( curfix > maxfix ) || ( ( cur_best_shift_cost != 0 ) && ( curfix == maxfix ) ) ) {
+        break;
+      }
+      PerformShift ( cur, shifts[s], m_shifted );
+
+      // terCalc takes the shift if it gains, or on a tie while no shift has
+      // been taken.  Skip the alignment when even the exact distance can't.
+      const int best = cur_best_edits + cur_best_shift_cost;
+      const int bound = EditDistance ( m_shifted ) + shift_cost;
+      if ( ( bound > best ) || ( ( bound == best ) && ( cur_best_shift_cost != 0 ) ) ) {
+        continue;
+      }
+
+      MinEditDist ( m_shifted, curalign );
+      const int gain = best - ( curalign.numEdits + shift_cost );
+      if ( ( gain > 0 ) || ( ( cur_best_shift_cost == 0 ) && ( gain == 0 ) ) ) {
+        anygain = true;
+        best_shift = shifts[s];
+        cur_best_shift_cost = shift_cost;
+        cur_best_edits = curalign.numEdits;
+        best_align = curalign;
+        best_words = m_shifted;
+      }
+    }
+  }
+  return anygain;
+}
+
+void fastTerCalc::FindAlignErr ( const Alignment& align )
+{
+  m_herr.resize ( align.path.size() );
+  m_rerr.resize ( m_ref.size() );
+  m_ralign.resize ( m_ref.size() );
+  int hpos = -1;
+  int rpos = -1;
+  for ( size_t i = 0; i < align.path.size(); i++ ) {
+    const char sym = align.path[i];
+    if ( sym == ' ' ) {
+      hpos++;
+      rpos++;
+      m_herr[hpos] = false;
+      m_rerr[rpos] = false;
+      m_ralign[rpos] = hpos;
+    } else if ( sym == 'S' ) {
+      hpos++;
+      rpos++;
+      m_herr[hpos] = true;
+      m_rerr[rpos] = true;
+      m_ralign[rpos] = hpos;
+    } else if ( sym == 'I' ) {
+      hpos++;
+      m_herr[hpos] = true;
+    } else if ( sym == 'D' ) {
+      rpos++;
+      m_rerr[rpos] = true;
+      m_ralign[rpos] = hpos;
+    } else {
+      cerr << "ERROR : fastTerCalc::FindAlignErr : Invalid mini align sequence " << sym << " at pos " << i << endl;
+      exit ( -1 );
+    }
+  }
+}
+
+// Same candidates, in the same order, as terCalc::GatherAllPossShifts.
+// terCalc looks each hyp n-gram up in a map of all reference n-grams;
+// here the reference positions of hyp[start] are narrowed down as the
+// n-gram grows, which leaves the same ascending position lists.
+void fastTerCalc::GatherAllPossShifts ( const vector<int>& cur )
+{
+  m_shifts.clear();
+  if ( ( MAX_SHIFT_SIZE <= 0 ) || ( MAX_SHIFT_DIST <= 0 ) ) {
+    return;
+  }
+  m_shifts.resize ( MAX_SHIFT_SIZE + 1 );
+
+  const int hyp_size = cur.size();
+  const int ref_size = m_ref.size();
+  for ( int start = 0; start < hyp_size; start++ ) {
+    const vector<int>& positions = m_refPositions[cur[start]];
+    if ( positions.empty() ) {
+      continue;
+    }
+
+    bool ok = false;
+    for ( size_t m = 0; ( m < positions.size() ) && ( ! ok ); m++ ) {
+      const int ra = m_ralign[positions[m]];
+      if ( ( start != ra ) && ( ( ra - start ) <= MAX_SHIFT_DIST ) && ( ( start - ra - 1 ) <= MAX_SHIFT_DIST ) ) {
+        ok = true;
+      }
+    }
+    if ( ! ok ) {
+      continue;
+    }
+
+    m_matches = positions;
+    ok = true;
+    for ( int end = start; ( ok && ( end < hyp_size ) && ( end < start + MAX_SHIFT_SIZE ) ); end++ ) {
+      /* keep the reference positions where cur[start..end] occurs */
+      const int len = end - start;
+      if ( len > 0 ) {
+        size_t kept = 0;
+        for ( size_t m = 0; m < m_matches.size(); m++ ) {
+          const int p = m_matches[m];
+          if ( ( p + len < ref_size ) && ( m_ref[p+len] == cur[end] ) ) {
+            m_matches[kept++] = p;
+          }
+        }
+        m_matches.resize ( kept );
+      }
+      ok = false;
+      if ( m_matches.empty() ) {
+        continue;
+      }
+
+      bool any_herr = false;
+      for ( int i = 0; ( ( i <= len ) && ( ! any_herr ) ); i++ ) {
+        if ( m_herr[start+i] ) {
+          any_herr = true;
+        }
+      }
+      if ( any_herr == false ) {
+        ok = true;
+        continue;
+      }
+
+      for ( size_t m = 0; m < m_matches.size(); m++ ) {
+        const int moveto = m_matches[m];
+        const int ra = m_ralign[moveto];
+        if ( ! ( ( ra != start ) && ( ( ra < start ) || ( ra > end ) ) && ( ( ra - start ) <= MAX_SHIFT_DIST ) && ( ( start - ra ) <= MAX_SHIFT_DIST ) ) ) {
+          continue;
+        }
+        ok = true;
+
+        /* only move if either string has errors */
+        bool any_rerr = false;
+        for ( int i = 0; ( i <= len ) && ( ! any_rerr ); i++ ) {
+          if ( m_rerr[moveto+i] ) {
+            any_rerr = true;
+          }
+        }
+        if ( ! any_rerr ) {
+          continue;
+        }
+        for ( int roff = -1; roff <= len; roff++ ) {
+          if ( ( roff == -1 ) && ( moveto == 0 ) ) {
+            terShift topush ( start, end, -1, -1 );
+            topush.cost = shift_cost;
+            m_shifts[len].push_back ( topush );
+          } else if ( ( start != m_ralign[moveto+roff] ) && ( ( roff == 0 ) || ( m_ralign[moveto+roff] != ra ) ) ) {
+            terShift topush ( start, end, moveto + roff, m_ralign[moveto+roff] );
+            topush.cost = shift_cost;
+            m_shifts[len].push_back ( topush );
+          }
+        }
+      }
+    }
+  }
+}
+
+void fastTerCalc::PerformShift ( const vector<int>& words, const terShift& s,
+                                 vector<int>& nwords ) const
+{
+  const int start = s.start;
+  const int end = s.end;
+  const int newloc = s.newloc;
+  const int size = words.size();
+  nwords = words;
+  int c = 0;
+  if ( newloc == -1 ) {
+    for ( int i = start; i <= end; i++ ) nwords[c++] = words[i];
+    for ( int i = 0; i <= start - 1; i++ ) nwords[c++] = words[i];
+    for ( int i = end + 1; i < size; i++ ) nwords[c++] = words[i];
+  } else if ( newloc < start ) {
+    for ( int i = 0; i <= newloc; i++ ) nwords[c++] = words[i];
+    for ( int i = start; i <= end; i++ ) nwords[c++] = words[i];
+    for ( int i = newloc + 1; i <= start - 1; i++ ) nwords[c++] = words[i];
+    for ( int i = end + 1; i < size; i++ ) nwords[c++] = words[i];
+  } else if ( newloc > end ) {
+    for ( int i = 0; i <= start - 1; i++ ) nwords[c++] = words[i];
+    for ( int i = end + 1; i <= newloc; i++ ) nwords[c++] = words[i];
+    for ( int i = start; i <= end; i++ ) nwords[c++] = words[i];
+    for ( int i = newloc + 1; i < size; i++ ) nwords[c++] = words[i];
+  } else {
+    // we are moving inside of ourselves
+    for ( int i = 0; i <= start - 1; i++ ) nwords[c++] = words[i];
+    for ( int i = end + 1; ( i < size ) && ( i <= ( end + ( newloc - start ) ) ); i++ ) nwords[c++] = words[i];
+    for ( int i = start; i <= end; i++ ) nwords[c++] = words[i];
+    for ( int i = ( end + ( newloc - start ) + 1 ); i < size; i++ ) nwords[c++] = words[i];
+  }
+}
+
+}
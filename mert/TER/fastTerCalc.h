@@ -0,0 +1,94 @@
+#ifndef MERT_TER_FAST_TER_CALC_H_
+#define MERT_TER_FAST_TER_CALC_H_
+
+#include <vector>
+#include <stdint.h>
+
+#include "terAlignment.h"
+#include "terShift.h"
+
+namespace TERCpp
+{
+
+/**
+ * TER on integer tokens.  It computes the same edit counts and alignments
+ * as terCalc::TER, which works on strings and finds words and n-grams with
+ * a linear scan of its hash maps:
+ *  - tokens are renumbered once per sentence, so words are compared as ints
+ *    and the reference positions of a word are found by index;
+ *  - shift candidates are grown from those positions word by word instead
+ *    of looking every n-gram up;
+ *  - each candidate shift is first bounded from below by the exact edit
+ *    distance, computed bit-parallel (Myers, with Hyyro's blocks), and the
+ *    beam-search alignment is only run when the shift can still beat the
+ *    best one found so far.
+ * The beam search never finds fewer edits than the exact distance, so
+ * skipped shifts are exactly those terCalc would have rejected.
+ *
+ * An instance keeps its scratch space between calls; use one per thread.
+ */
+class fastTerCalc
+{
+public:
+  fastTerCalc();
+
+  /**
+   * TER of hyp against ref.  Fills numEdits, numWords (the reference
+   * length), alignment and the positions and costs of allshifts; the word
+   * vectors of the result are left empty.
+   */
+  terAlignment TER ( const vector<int>& hyp, const vector<int>& ref );
+
+private:
+  struct Alignment {
+    int numEdits;
+    vector<char> path;
+  };
+
+  void Prepare ( const vector<int>& hyp, const vector<int>& ref,
+                 vector<int>& cur );
+  int EditDistance ( const vector<int>& hyp );
+  void MinEditDist ( const vector<int>& hyp, Alignment& out );
+  bool CalcBestShift ( const vector<int>& cur, const Alignment& med_align,
+                       terShift& best_shift, Alignment& best_align,
+                       vector<int>& best_words );
+  void FindAlignErr ( const Alignment& align );
+  void GatherAllPossShifts ( const vector<int>& cur );
+  void PerformShift ( const vector<int>& words, const terShift& s,
+                      vector<int>& nwords ) const;
+
+  // The edit distance bound assumes unit costs, as used by terCalc.
+  int shift_cost;
+  int insert_cost;
+  int delete_cost;
+  int substitute_cost;
+  int match_cost;
+  int MAX_SHIFT_SIZE;
+  int MAX_SHIFT_DIST;
+  int BEAM_WIDTH;
+  int INF;
+
+  // reference in sentence-local ids, and where each id occurs in it
+  vector<int> m_ref;
+  vector<vector<int> > m_refPositions;
+  // match bit vectors of the reference, m_blocks words per local id
+  vector<uint64_t> m_peq;
+  size_t m_blocks;
+  vector<uint64_t> m_pv;
+  vector<uint64_t> m_mv;
+
+  // beam search matrices, (ref.size()+1) x (hyp.size()+1)
+  vector<int> m_S;
+  vector<char> m_P;
+
+  vector<char> m_herr;
+  vector<char> m_rerr;
+  vector<int> m_ralign;
+  vector<vector<terShift> > m_shifts;
+  vector<int> m_matches;
+  vector<int> m_shifted;
+};
+
+}
+
+#endif  // MERT_TER_FAST_TER_CALC_H_
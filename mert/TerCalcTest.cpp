@@ -0,0 +1,117 @@
+#include "TER/fastTerCalc.h"
+#include "TER/tercalc.h"
+
+#define BOOST_TEST_MODULE MertTerCalc
+#include <boost/test/unit_test.hpp>
+
+#include <cstdlib>
+#include <vector>
+
+using namespace TERCpp;
+
+namespace {
+
+// token id TerScorer gives the empty word of an empty sentence
+const int kEmptyWord = -1;
+
+// TER as TerScorer computed it with terCalc, which swaps its int arguments
+// back and reads an empty sentence as a single empty word
+terAlignment OldTer(const std::vector<int>& hyp, const std::vector<int>& ref) {
+  terCalc* calc = new terCalc;  // too large for the stack
+  terAlignment result = calc->TER(ref, hyp);
+  delete calc;
+  return result;
+}
+
+terAlignment FastTer(std::vector<int> hyp, std::vector<int> ref) {
+  if (hyp.empty()) hyp.push_back(kEmptyWord);
+  if (ref.empty()) ref.push_back(kEmptyWord);
+  fastTerCalc calc;
+  return calc.TER(hyp, ref);
+}
+
+std::vector<int> Tokens(const char* str) {
+  std::vector<int> ret;
+  char* end;
+  for (long token = std::strtol(str, &end, 10); end != str;
+       token = std::strtol(str, &end, 10)) {
+    ret.push_back(token);
+    str = end;
+  }
+  return ret;
+}
+
+std::vector<int> RandomTokens(size_t size, int vocabSize) {
+  std::vector<int> ret(size);
+  for (size_t i = 0; i < size; ++i) {
+    ret[i] = std::rand() % vocabSize;
+  }
+  return ret;
+}
+
+void CheckSameTer(const std::vector<int>& hyp, const std::vector<int>& ref) {
+  const terAlignment expected = OldTer(hyp, ref);
+  const terAlignment actual = FastTer(hyp, ref);
+  BOOST_CHECK_EQUAL(expected.numEdits, actual.numEdits);
+  BOOST_CHECK_EQUAL(expected.numWords, actual.numWords);
+  BOOST_CHECK(expected.alignment == actual.alignment);
+  BOOST_REQUIRE_EQUAL(expected.allshifts.size(), actual.allshifts.size());
+  for (size_t i = 0; i < expected.allshifts.size(); ++i) {
+    const terShift& e = expected.allshifts[i];
+    const terShift& a = actual.allshifts[i];
+    BOOST_CHECK_EQUAL(e.start, a.start);
+    BOOST_CHECK_EQUAL(e.end, a.end);
+    BOOST_CHECK_EQUAL(e.moveto, a.moveto);
+    BOOST_CHECK_EQUAL(e.newloc, a.newloc);
+    BOOST_CHECK_EQUAL(e.cost, a.cost);
+  }
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(ter_empty) {
+  CheckSameTer(Tokens(""), Tokens("1 2 3"));
+  CheckSameTer(Tokens("1 2 3"), Tokens(""));
+  CheckSameTer(Tokens(""), Tokens(""));
+}
+
+BOOST_AUTO_TEST_CASE(ter_identical) {
+  CheckSameTer(Tokens("1"), Tokens("1"));
+  CheckSameTer(Tokens("1 2 3 4 5 6"), Tokens("1 2 3 4 5 6"));
+  const terAlignment result = FastTer(Tokens("1 2 3 4 5 6"), Tokens("1 2 3 4 5 6"));
+  BOOST_CHECK_EQUAL(0, result.numEdits);
+  BOOST_CHECK(result.allshifts.empty());
+}
+
+BOOST_AUTO_TEST_CASE(ter_shifts) {
+  CheckSameTer(Tokens("4 5 6 1 2 3"), Tokens("1 2 3 4 5 6"));
+  CheckSameTer(Tokens("1 2 7 3 4 8 5 6"), Tokens("5 6 1 2 3 4"));
+  CheckSameTer(Tokens("1 1 2 2 1 1 2"), Tokens("2 1 1 2 1 2 2 1"));
+  CheckSameTer(Tokens("9 3 4 5 1 2 8 6 7"), Tokens("1 2 3 4 5 6 7 8 9"));
+  const terAlignment result = FastTer(Tokens("4 5 6 1 2 3"), Tokens("1 2 3 4 5 6"));
+  BOOST_CHECK_EQUAL(1, result.numEdits);
+  BOOST_CHECK_EQUAL(1, result.allshifts.size());
+}
+
+BOOST_AUTO_TEST_CASE(ter_long) {
+  // more than one 64-bit block of the bit-parallel edit distance
+  std::srand(1234);
+  std::vector<int> ref = RandomTokens(100, 1000);
+  std::vector<int> hyp(ref.begin() + 30, ref.end());
+  hyp.insert(hyp.end(), ref.begin(), ref.begin() + 30);
+  CheckSameTer(hyp, ref);
+  CheckSameTer(ref, ref);
+  for (size_t i = 0; i < 10; ++i) {
+    CheckSameTer(RandomTokens(60 + std::rand() % 80, 20),
+                 RandomTokens(60 + std::rand() % 80, 20));
+  }
+  CheckSameTer(RandomTokens(200, 50), RandomTokens(130, 50));
+}
+
+BOOST_AUTO_TEST_CASE(ter_random) {
+  std::srand(42);
+  for (size_t i = 0; i < 200; ++i) {
+    CheckSameTer(RandomTokens(std::rand() % 30, 8),
+                 RandomTokens(std::rand() % 30, 8));
+  }
+}
@@ -1,17 +1,25 @@
 #include "TerScorer.h"
 
 #include <cmath>
+#include <fstream>
 #include <sstream>
 #include <stdexcept>
 
 #include "ScoreStats.h"
-#include "TER/tercalc.h"
+#include "TER/fastTerCalc.h"
 #include "TER/terAlignment.h"
 #include "Util.h"
 
 using namespace std;
 using namespace TERCpp;
 
+namespace {
+
+// token id standing for the empty word of an empty sentence
+const int kEmptyWord = -1;
+
+} // namespace
+
 namespace MosesTuning
 {
   
@@ -55,12 +63,20 @@ void TerScorer::setReferenceFiles ( const vector<string>& referenceFiles )
 void TerScorer::prepareStats ( size_t sid, const string& text, ScoreStats& entry )
 {
   string sentence = this->preprocessSentence(text);
+  vector<int> testtokens;
+  TokenizeAndEncode(sentence, testtokens);
+  // terCalc, which the statistics have always been computed with, read an
+  // empty sentence as a single empty word.
+  if ( testtokens.empty() ) {
+    testtokens.push_back ( kEmptyWord );
+  }
 
   terAlignment result;
   result.numEdits = 0.0 ;
   result.numWords = 0.0 ;
   result.averageWords = 0.0;
 
+  fastTerCalc evaluation;
   for ( int incRefs = 0; incRefs < ( int ) m_multi_references.size(); incRefs++ ) {
     if ( sid >= m_multi_references.at(incRefs).size() ) {
       stringstream msg;
@@ -68,9 +84,11 @@ void TerScorer::prepareStats ( size_t sid, const string& text, ScoreStats& entry
       throw runtime_error ( msg.str() );
     }
 
-    vector<int> testtokens;
     vector<int> reftokens;
     reftokens = m_multi_references.at ( incRefs ).at ( sid );
+    if ( reftokens.empty() ) {
+      reftokens.push_back ( kEmptyWord );
+    }
     double averageLength=0.0;
     for ( int incRefsBis = 0; incRefsBis < ( int ) m_multi_references.size(); incRefsBis++ ) {
       if ( sid >= m_multi_references.at(incRefsBis).size() ) {
@@ -81,17 +99,13 @@ void TerScorer::prepareStats ( size_t sid, const string& text, ScoreStats& entry
       averageLength+=(double)m_multi_references.at ( incRefsBis ).at ( sid ).size();
     }
     averageLength=averageLength/( double ) m_multi_references.size();
-    TokenizeAndEncode(sentence, testtokens);
-    terCalc * evaluation=new terCalc();
-    evaluation->setDebugMode ( false );
-    terAlignment tmp_result = evaluation->TER ( reftokens, testtokens );
+    terAlignment tmp_result = evaluation.TER ( testtokens, reftokens );
     tmp_result.averageWords=averageLength;
     if ( ( result.numEdits == 0.0 ) && ( result.averageWords == 0.0 ) ) {
       result = tmp_result;
     } else if ( result.scoreAv() > tmp_result.scoreAv() ) {
       result = tmp_result;
     }
-    delete evaluation;
   }
   ostringstream stats;
   // multiplication by 100 in order to keep the average precision
@@ -10,6 +10,7 @@
 #include "ScorerFactory.h"
 #include "Timer.h"
 #include "Util.h"
+#include "../moses/src/ThreadPool.h"
 
 using namespace std;
 using namespace MosesTuning;
@@ -20,6 +21,37 @@ Scorer* g_scorer = NULL;
 bool g_has_more_files = false;
 bool g_has_more_scorers = false;
 const float g_alpha = 0.05;
+size_t g_threads = 1;
+
+#ifdef WITH_THREADS
+/**
+ * Prepares the statistics of one candidate sentence.  The first error is
+ * kept in the shared string and rethrown once the pool has finished.
+ */
+class PrepareStatsTask : public Moses::Task
+{
+ public:
+  PrepareStatsTask(size_t sid, const string& line, ScoreStats& entry,
+                   boost::mutex& mutex, string& error)
+      : m_sid(sid), m_line(line), m_entry(entry), m_mutex(mutex), m_error(error) {}
+
+  virtual void Run() {
+    try {
+      g_scorer->prepareStats(m_sid, m_line, m_entry);
+    } catch (const exception& e) {
+      boost::mutex::scoped_lock lock(m_mutex);
+      if (m_error.empty()) m_error = e.what();
+    }
+  }
+
+ private:
+  size_t m_sid;
+  string m_line;
+  ScoreStats& m_entry;
+  boost::mutex& m_mutex;
+  string& m_error;
+};
+#endif
 
 
 class EvaluatorUtil {
@@ -43,6 +75,23 @@ void EvaluatorUtil::evaluate(const string& candFile, int bootstrap)
   // Loading sentences and preparing statistics
   ScoreStats scoreentry;
   string line;
+#ifdef WITH_THREADS
+  if (g_threads > 1 && g_scorer->isThreadSafe())
+  {
+    vector<string> lines;
+    while (getline(cand, line))
+      lines.push_back(line);
+    entries.resize(lines.size());
+    boost::mutex mutex;
+    string error;
+    Moses::ThreadPool pool(g_threads);
+    for (size_t sid = 0; sid < lines.size(); ++sid)
+      pool.Submit(new PrepareStatsTask(sid, lines[sid], entries[sid], mutex, error));
+    pool.Stop(true);
+    if (!error.empty()) throw runtime_error(error);
+  }
+  else
+#endif
   while (getline(cand, line))
   {
     g_scorer->prepareStats(entries.size(), line, scoreentry);
@@ -138,6 +187,9 @@ void usage()
   cerr << "[--filter|-l] filter command which will be used to preprocess the sentences" << endl;
   cerr << "[--bootstrap|-b] number of booststraped samples (default 0 - no bootstraping)" << endl;
   cerr << "[--rseed|-r] the random seed for bootstraping (defaults to system clock)" << endl;
+#ifdef WITH_THREADS
+  cerr << "[--threads|-T] prepare the statistics of scorers that allow it (TER) in parallel (default 1)" << endl;
+#endif
   cerr << "[--help|-h] print this message and exit" << endl;
   cerr << endl;
   cerr << "Evaluator is able to compute more metrics at once. To do this," << endl;
@@ -169,6 +221,9 @@ static struct option long_options[] = {
   {"rseed", required_argument, 0, 'r'},
   {"factors", required_argument, 0, 'f'},
   {"filter", required_argument, 0, 'l'},
+#ifdef WITH_THREADS
+  {"threads", required_argument, 0, 'T'},
+#endif
   {"help", no_argument, 0, 'h'},
   {0, 0, 0, 0}
 };
@@ -197,7 +252,7 @@ void ParseCommandOptions(int argc, char** argv, ProgramOption* opt) {
   int c;
   int option_index;
   int last_scorer_index = -1;
-  while ((c = getopt_long(argc, argv, "s:c:R:C:b:r:f:l:h", long_options, &option_index)) != -1) {
+  while ((c = getopt_long(argc, argv, "s:c:R:C:b:r:f:l:T:h", long_options, &option_index)) != -1) {
     switch(c) {
       case 's':
         opt->scorer_types.push_back(string(optarg));
@@ -228,6 +283,12 @@ void ParseCommandOptions(int argc, char** argv, ProgramOption* opt) {
       case 'l':
         opt->scorer_filter[last_scorer_index] = string(optarg);
         break;
+#ifdef WITH_THREADS
+      case 'T':
+        g_threads = strtol(optarg, NULL, 10);
+        if (g_threads < 1) g_threads = 1;
+        break;
+#endif
       default:
         usage();
     }
@@ -12,6 +12,7 @@
 #include <boost/scoped_ptr.hpp>
 
 #include "Data.h"
+#include "HypothesisStore.h"
 #include "Scorer.h"
 #include "ScorerFactory.h"
 #include "Timer.h"
@@ -34,10 +35,14 @@ void usage()
   cerr << "[--scfile|-S] the scorer data output file" << endl;
   cerr << "[--ffile|-F] the feature data output file" << endl;
   cerr << "[--prev-ffile|-E] comma separated list of previous feature data" << endl;
+  cerr << "[--store|-B] also append the hypotheses to this hypothesis store" << endl;
   cerr << "[--prev-scfile|-R] comma separated list of previous scorer data" << endl;
   cerr << "[--factors|-f] list of factors passed to the scorer (e.g. 0|2)" << endl;
   cerr << "[--filter|-l] filter command used to preprocess the sentences" << endl;
   cerr << "[--allow-duplicates|-d] omit the duplicate removal step" << endl;
+#ifdef WITH_THREADS
+  cerr << "[--threads|-T] number of threads computing statistics (default 1)" << endl;
+#endif
   cerr << "[-v] verbose level" << endl;
   cerr << "[--help|-h] print this message and exit" << endl;
   exit(1);
@@ -55,6 +60,10 @@ static struct option long_options[] = {
   {"ffile", required_argument, 0, 'F'},
   {"prev-scfile", required_argument, 0, 'R'},
   {"prev-ffile", required_argument, 0, 'E'},
+  {"store", required_argument, 0, 'B'},
+#ifdef WITH_THREADS
+  {"threads", required_argument, 0, 'T'},
+#endif
   {"verbose", required_argument, 0, 'v'},
   {"help", no_argument, 0, 'h'},
   {"allow-duplicates", no_argument, 0, 'd'},
@@ -73,8 +82,10 @@ struct ProgramOption {
   string featureDataFile;
   string prevScoreDataFile;
   string prevFeatureDataFile;
+  string storeFile;
   bool binmode;
   bool allowDuplicates;
+  size_t num_threads;
   int verbosity;
 
   ProgramOption()
@@ -88,8 +99,10 @@ struct ProgramOption {
         featureDataFile("features.data"),
         prevScoreDataFile(""),
         prevFeatureDataFile(""),
+        storeFile(""),
         binmode(false),
         allowDuplicates(false),
+        num_threads(1),
         verbosity(0) { }
 };
 
@@ -97,7 +110,7 @@ void ParseCommandOptions(int argc, char** argv, ProgramOption* opt) {
   int c;
   int option_index;
 
-  while ((c = getopt_long(argc, argv, "s:r:f:l:n:S:F:R:E:v:hbd", long_options, &option_index)) != -1) {
+  while ((c = getopt_long(argc, argv, "s:r:f:l:n:S:F:R:E:B:T:v:hbd", long_options, &option_index)) != -1) {
     switch (c) {
       case 's':
         opt->scorerType = string(optarg);
@@ -132,6 +145,15 @@ void ParseCommandOptions(int argc, char** argv, ProgramOption* opt) {
       case 'R':
         opt->prevScoreDataFile = string(optarg);
         break;
+      case 'B':
+        opt->storeFile = string(optarg);
+        break;
+#ifdef WITH_THREADS
+      case 'T':
+        opt->num_threads = strtol(optarg, NULL, 10);
+        if (opt->num_threads < 1) opt->num_threads = 1;
+        break;
+#endif
       case 'v':
         opt->verbosity = atoi(optarg);
         break;
@@ -225,7 +247,7 @@ int main(int argc, char** argv)
 
     // computing score statistics of each nbest file
     for (size_t i = 0; i < nbestFiles.size(); i++) {
-      data.loadNBest(nbestFiles.at(i));
+      data.loadNBest(nbestFiles.at(i), option.num_threads);
     }
 
     PrintUserTime("Nbest entries loaded and scored");
@@ -237,6 +259,13 @@ int main(int argc, char** argv)
     //END_ADDED
 
     data.save(option.featureDataFile, option.scoreDataFile, option.binmode);
+
+    if (option.storeFile.length() > 0) {
+      const size_t added = HypothesisStore::Append(option.storeFile,
+                           *data.getFeatureData(), *data.getScoreData());
+      cerr << "Added " << added << " hypotheses to " << option.storeFile << endl;
+      PrintUserTime("Hypothesis store updated");
+    }
     PrintUserTime("Stopping...");
 
     return EXIT_SUCCESS;
@@ -79,6 +79,7 @@ int main(int argc, char** argv)
   string sparseInitFile;
   vector<string> scoreFiles;
   vector<string> featureFiles;
+  string storeFile;
   int seed;
   string outputFile;
   float c = 0.01;      // Step-size cap C
@@ -95,6 +96,7 @@ int main(int argc, char** argv)
       ("help,h", po::value(&help)->zero_tokens()->default_value(false), "Print this help message and exit")
       ("scfile,S", po::value<vector<string> >(&scoreFiles), "Scorer data files")
       ("ffile,F", po::value<vector<string> > (&featureFiles), "Feature data files")
+      ("store,B", po::value<string>(&storeFile), "Hypothesis store, instead of scorer and feature data files")
       ("random-seed,r", po::value<int>(&seed), "Seed for random number generation")
       ("output-file,o", po::value<string>(&outputFile), "Output file")
       ("cparam,C", po::value<float>(&c), "MIRA C-parameter, lower for more regularization (default 0.01)")
@@ -185,7 +187,9 @@ int main(int argc, char** argv)
   
   // Training loop
   boost::scoped_ptr<HypPackEnumerator> train;
-  if(streaming)
+  if(!storeFile.empty())
+    train.reset(new StoreHypPackEnumerator(storeFile, no_shuffle || streaming));
+  else if(streaming)
     train.reset(new StreamingHypPackEnumerator(featureFiles, scoreFiles));
   else
     train.reset(new RandomAccessHypPackEnumerator(featureFiles, scoreFiles, no_shuffle));
@@ -109,6 +109,7 @@ void usage(int ret)
   cerr << "[--scconfig|-c] configuration string passed to scorer" << endl;
   cerr << "[--scfile|-S] comma separated list of scorer data files (default " << kDefaultScorerFile << ")" << endl;
   cerr << "[--ffile|-F] comma separated list of feature data files (default " << kDefaultFeatureFile << ")" << endl;
+  cerr << "[--store|-B] hypothesis store to load instead of scorer and feature data files" << endl;
   cerr << "[--ifile|-i] the starting point data file (default " << kDefaultInitFile << ")" << endl;
   cerr << "[--positive|-P] indexes with positive weights (default none)"<<endl;
 #ifdef WITH_THREADS
@@ -135,6 +136,7 @@ static struct option long_options[] = {
   {"scfile", 1, 0, 'S'},
   {"ffile", 1, 0, 'F'},
   {"ifile", 1, 0, 'i'},
+  {"store", 1, 0, 'B'},
 #ifdef WITH_THREADS
   {"threads", required_argument, 0, 'T'},
 #endif
@@ -157,6 +159,7 @@ struct ProgramOption {
   string scorer_config;
   string scorer_file;
   string feature_file;
+  string store_file;
   string init_file;
   string positive_string;
   size_t num_threads;
@@ -175,6 +178,7 @@ struct ProgramOption {
         scorer_config(""),
         scorer_file(kDefaultScorerFile),
         feature_file(kDefaultFeatureFile),
+        store_file(""),
         init_file(kDefaultInitFile),
         positive_string(kDefaultPositiveString),
         num_threads(1),
@@ -186,7 +190,7 @@ void ParseCommandOptions(int argc, char** argv, ProgramOption* opt) {
   int c;
   int option_index;
 
-  while ((c = getopt_long(argc, argv, "o:r:d:n:m:t:s:S:F:v:p:P:", long_options, &option_index)) != -1) {
+  while ((c = getopt_long(argc, argv, "o:r:d:n:m:t:s:S:F:B:v:p:P:", long_options, &option_index)) != -1) {
     switch (c) {
       case 'o':
         opt->to_optimize_str = string(optarg);
@@ -222,6 +226,9 @@ void ParseCommandOptions(int argc, char** argv, ProgramOption* opt) {
       case 'i':
         opt->init_file = string(optarg);
         break;
+      case 'B':
+        opt->store_file = string(optarg);
+        break;
       case 'v':
         setverboselevel(strtol(optarg, NULL, 10));
         break;
@@ -351,9 +358,13 @@ int main(int argc, char **argv)
   //load data
   Data data(scorer.get());
 
-  for (size_t i = 0; i < ScoreDataFiles.size(); i++) {
-    cerr<<"Loading Data from: "<< ScoreDataFiles.at(i) << " and " << FeatureDataFiles.at(i) << endl;
-    data.load(FeatureDataFiles.at(i), ScoreDataFiles.at(i));
+  if (option.store_file.length() > 0) {
+    data.loadStore(option.store_file);
+  } else {
+    for (size_t i = 0; i < ScoreDataFiles.size(); i++) {
+      cerr<<"Loading Data from: "<< ScoreDataFiles.at(i) << " and " << FeatureDataFiles.at(i) << endl;
+      data.load(FeatureDataFiles.at(i), ScoreDataFiles.at(i));
+    }
   }
 
   scorer->setScoreData(data.getScoreData().get());
@@ -40,6 +40,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 
 #include "BleuScorer.h"
 #include "FeatureDataIterator.h"
+#include "HypothesisStore.h"
 #include "ScoreDataIterator.h"
 
 using namespace std;
@@ -91,6 +92,30 @@ static void outputSample(ostream& out, const FeatureDataItem& f1, const FeatureD
   }
 }
 
+// A hypothesis is (file, index) when reading feature and score data files,
+// and (0, index into the store) when reading a hypothesis store.
+static const ScoreDataItem& scoresOf(const pair<size_t,size_t>& translation,
+                                     const HypothesisStore& store,
+                                     vector<ScoreDataIterator>& scoreDataIters,
+                                     ScoreDataItem& buffer) {
+  if (store.isOpen()) {
+    store.getScoreDataItem(translation.second, buffer);
+    return buffer;
+  }
+  return scoreDataIters[translation.first]->operator[](translation.second);
+}
+
+static const FeatureDataItem& featuresOf(const pair<size_t,size_t>& translation,
+                                         const HypothesisStore& store,
+                                         vector<FeatureDataIterator>& featureDataIters,
+                                         FeatureDataItem& buffer) {
+  if (store.isOpen()) {
+    store.getFeatureDataItem(translation.second, buffer);
+    return buffer;
+  }
+  return featureDataIters[translation.first]->operator[](translation.second);
+}
+
 }
 
 int main(int argc, char** argv)
@@ -98,6 +123,7 @@ int main(int argc, char** argv)
   bool help;
   vector<string> scoreFiles;
   vector<string> featureFiles;
+  string storeFile;
   int seed;
   string outputFile;
   // TODO: Add these constants to options
@@ -110,6 +136,7 @@ int main(int argc, char** argv)
       ("help,h", po::value(&help)->zero_tokens()->default_value(false), "Print this help message and exit")
       ("scfile,S", po::value<vector<string> >(&scoreFiles), "Scorer data files")
       ("ffile,F", po::value<vector<string> > (&featureFiles), "Feature data files")
+      ("store,B", po::value<string>(&storeFile), "Hypothesis store, instead of scorer and feature data files")
       ("random-seed,r", po::value<int>(&seed), "Seed for random number generation")
       ("output-file,o", po::value<string>(&outputFile), "Output file")
       ;
@@ -134,7 +161,12 @@ int main(int argc, char** argv)
     srand(time(NULL));
   }
 
-  if (scoreFiles.size() == 0 || featureFiles.size() == 0) {
+  HypothesisStore store;
+  if (!storeFile.empty()) {
+    store.open(storeFile);
+    featureFiles.clear();
+    scoreFiles.clear();
+  } else if (scoreFiles.size() == 0 || featureFiles.size() == 0) {
     cerr << "No data to process" << endl;
     exit(0);
   }
@@ -168,14 +200,23 @@ int main(int argc, char** argv)
 
   //loop through nbest lists
   size_t sentenceId = 0;
+  ScoreDataItem scores1, scores2;
+  FeatureDataItem features1, features2;
   while(1) {
     vector<pair<size_t,size_t> > hypotheses;
     //TODO: de-deuping. Collect hashes of score,feature pairs and
     //only add index if it's unique.
-    if (featureDataIters[0] == FeatureDataIterator::end()) {
+    if (store.isOpen()) {
+      if (sentenceId == store.NumberOfSentences()) {
+        break;
+      }
+      for (size_t h = store.begin(sentenceId); h < store.end(sentenceId); ++h) {
+        hypotheses.push_back(pair<size_t,size_t>(0,h));
+      }
+    } else if (featureDataIters[0] == FeatureDataIterator::end()) {
       break;
     }
-    for (size_t i = 0; i < featureFiles.size(); ++i) {
+    for (size_t i = 0; !store.isOpen() && i < featureFiles.size(); ++i) {
       if (featureDataIters[i] == FeatureDataIterator::end()) {
         cerr << "Error: Feature file " << i << " ended prematurely" << endl;
         exit(1);
@@ -197,14 +238,14 @@ int main(int argc, char** argv)
     vector<SampledPair> samples;
     vector<float> scores;
     size_t n_translations = hypotheses.size();
-    for(size_t  i=0; i<n_candidates; i++) {
+    for(size_t  i=0; n_translations && i<n_candidates; i++) {
       size_t rand1 = rand() % n_translations;
       pair<size_t,size_t> translation1 = hypotheses[rand1];
-      float bleu1 = sentenceLevelBleuPlusOne(scoreDataIters[translation1.first]->operator[](translation1.second));
+      float bleu1 = sentenceLevelBleuPlusOne(scoresOf(translation1, store, scoreDataIters, scores1));
 
       size_t rand2 = rand() % n_translations;
       pair<size_t,size_t> translation2 = hypotheses[rand2];
-      float bleu2 = sentenceLevelBleuPlusOne(scoreDataIters[translation2.first]->operator[](translation2.second));
+      float bleu2 = sentenceLevelBleuPlusOne(scoresOf(translation2, store, scoreDataIters, scores2));
 
       /*
       cerr << "t(" << translation1.first << "," << translation1.second << ") = " << bleu1 <<
@@ -228,17 +269,15 @@ int main(int argc, char** argv)
     for (size_t i = 0; collected < n_samples && i < samples.size(); ++i) {
       if (samples[i].getDiff() < sample_threshold) continue;
       ++collected;
-      size_t file_id1 = samples[i].getTranslation1().first;
-      size_t hypo_id1 = samples[i].getTranslation1().second;
-      size_t file_id2 = samples[i].getTranslation2().first;
-      size_t hypo_id2 = samples[i].getTranslation2().second;
+      const FeatureDataItem& f1 = featuresOf(samples[i].getTranslation1(), store,
+                                             featureDataIters, features1);
+      const FeatureDataItem& f2 = featuresOf(samples[i].getTranslation2(), store,
+                                             featureDataIters, features2);
       *out << "1";
-      outputSample(*out, featureDataIters[file_id1]->operator[](hypo_id1),
-                        featureDataIters[file_id2]->operator[](hypo_id2));
+      outputSample(*out, f1, f2);
       *out << endl;
       *out << "0";
-      outputSample(*out, featureDataIters[file_id2]->operator[](hypo_id2),
-                        featureDataIters[file_id1]->operator[](hypo_id1));
+      outputSample(*out, f2, f1);
       *out << endl;
     }
     //advance all iterators
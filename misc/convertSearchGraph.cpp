@@ -0,0 +1,181 @@
+// Converts a binary search graph, written with -output-search-graph-binary,
+// to the text search graph the decoder writes with -output-search-graph
+// (or -output-search-graph-extended with -extended).
+
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "BinarySearchGraph.h"
+
+using namespace Moses;
+
+namespace
+{
+
+void printHelp()
+{
+  std::cerr << "Usage: convertSearchGraph [-extended] [file]\n"
+            "options: \n"
+            "\t-extended -- output the extended format of the phrase-based decoder\n"
+            "\tfile      -- binary search graph, standard input if none\n"
+            "\n";
+}
+
+//! the labeled scores of -output-search-graph-extended
+void OutputLabeledScores(std::ostream &out, const std::vector<std::string> &names,
+                         const std::vector<float> &scores)
+{
+  std::string lastName = "";
+  for (size_t i = 0; i < names.size(); ++i) {
+    if (i>0) {
+      out << " ";
+    }
+    if (lastName != names[i]) {
+      out << names[i] << ": ";
+      lastName = names[i];
+    }
+    out << scores[i];
+  }
+}
+
+//! a sentence as written by Manager::OutputSearchGraph()
+bool OutputPhraseBased(std::ostream &out, const BinarySearchGraph &graph,
+                       const std::vector<std::string> &featureNames, bool extended)
+{
+  std::map<int, size_t> index;
+  std::vector<float> transitionScores(featureNames.size());
+  for (size_t i = 0; i < graph.nodes.size(); ++i) {
+    const BinarySearchGraphNode &node = graph.nodes[i];
+    index[node.id] = i;
+    out << graph.translationId;
+
+    // special case: initial hypothesis
+    if (node.id == 0) {
+      out << " hyp=0 stack=0";
+      if (!extended) {
+        out << " forward=" << node.forward << " fscore=" << node.fscore;
+      }
+      out << "\n";
+      continue;
+    }
+
+    std::map<int, size_t>::const_iterator prev;
+    if (node.back.empty() || (prev = index.find(node.back[0])) == index.end()) {
+      std::cerr << "hypothesis " << node.id << " of sentence " << graph.translationId
+                << " has no previous hypothesis" << std::endl;
+      return false;
+    }
+    const BinarySearchGraphNode &prevNode = graph.nodes[prev->second];
+    const BinarySearchGraphRule &rule = graph.rules[node.rule];
+
+    out << " hyp=" << ((extended && node.winner != -1) ? node.winner : node.id)
+        << " stack=" << node.stack
+        << " back=" << prevNode.id
+        << " score=" << node.score
+        << " transition=" << (node.score - prevNode.score);
+    if (node.winner != -1) {
+      out << " recombined=" << node.winner;
+    }
+    out << " forward=" << node.forward << " fscore=" << node.fscore
+        << " covered=" << node.startPos << "-" << node.endPos;
+
+    if (!extended) {
+      out << " out=" << rule.target << "\n";
+      continue;
+    }
+    for (size_t j = 0; j < transitionScores.size(); ++j) {
+      transitionScores[j] = node.scores[j] - prevNode.scores[j];
+    }
+    out << " scores=[ ";
+    OutputLabeledScores(out, featureNames, transitionScores);
+    out << " ]";
+    out << " out=" << rule.source << "|" << rule.target << "\n";
+  }
+  return true;
+}
+
+//! a sentence as written by ChartManager::GetSearchGraph()
+void OutputChart(std::ostream &out, const BinarySearchGraph &graph)
+{
+  for (size_t i = 0; i < graph.nodes.size(); ++i) {
+    const BinarySearchGraphNode &node = graph.nodes[i];
+    out << graph.translationId << " " << node.id;
+    if (node.winner != -1) {
+      out << "->" << node.winner;
+    }
+    out << " " << graph.rules[node.rule].target
+        << " [" << node.startPos << ".." << node.endPos << "]";
+    for (size_t j = 0; j < node.back.size(); ++j) {
+      out << " " << node.back[j];
+    }
+    out << " [total=" << node.score << "]";
+    out << " <<" << node.scores[0];
+    for (size_t j = 1; j < node.scores.size(); ++j) {
+      out << ", " << node.scores[j];
+    }
+    out << ">>\n";
+  }
+}
+
+}
+
+int main(int argc, char** argv)
+{
+  bool extended = false;
+  std::string inFilePath;
+  for(int i = 1; i < argc; ++i) {
+    std::string arg(argv[i]);
+    if("-extended" == arg) {
+      extended = true;
+    } else if(inFilePath.empty() && '-' != arg[0]) {
+      inFilePath = arg;
+    } else {
+      printHelp();
+      return 1;
+    }
+  }
+
+  std::ifstream inFile;
+  if (!inFilePath.empty()) {
+    inFile.open(inFilePath.c_str(), std::ios::in | std::ios::binary);
+    if (!inFile) {
+      std::cerr << "ERROR: could not open " << inFilePath << std::endl;
+      return 1;
+    }
+  }
+  std::istream &in = inFilePath.empty() ? std::cin : inFile;
+
+  BinarySearchGraphReader reader(in);
+  if (reader.Failed()) {
+    std::cerr << "ERROR: not a binary search graph" << std::endl;
+    return 1;
+  }
+  const BinarySearchGraphHeader &header = reader.GetHeader();
+  if (header.decoder == BinarySearchGraphHeader::PhraseBased) {
+    // as the phrase-based decoder sets its search graph stream
+    std::cout.setf(std::ios::fixed);
+    std::cout.precision(3);
+  } else if (extended) {
+    std::cerr << "ERROR: -extended is for search graphs of the phrase-based decoder" << std::endl;
+    return 1;
+  }
+
+  BinarySearchGraph graph;
+  while (reader.Read(graph)) {
+    if (header.decoder == BinarySearchGraphHeader::PhraseBased) {
+      if (!OutputPhraseBased(std::cout, graph, header.featureNames, extended)) {
+        return 1;
+      }
+    } else {
+      OutputChart(std::cout, graph);
+    }
+  }
+  if (reader.Failed()) {
+    std::cerr << "ERROR: corrupt binary search graph" << std::endl;
+    return 1;
+  }
+  return 0;
+}
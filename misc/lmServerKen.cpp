@@ -0,0 +1,174 @@
+// Stand-in for contrib/lmserver that serves a KenLM model, for testing the
+// remote language model (LanguageModelRemote) without SRILM.  Speaks the same
+// protocol:
+//
+//   prob w c1 c2 ...\n            -> one float (log10 prob) and "\r\n"
+//   probs\tw c1 ...\tw c1 ...\n   -> one float per n-gram and "\r\n"
+//
+// where the context words c1 c2 ... are given most recent first.
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#ifdef WITH_THREADS
+#include <boost/thread.hpp>
+#endif
+
+#include "lm/model.hh"
+
+using namespace std;
+
+namespace
+{
+
+typedef lm::ngram::Model Model;
+
+float NGramProb(const Model &model, const string &ngram)
+{
+  vector<lm::WordIndex> words;
+  size_t begin = 0;
+  while (begin < ngram.size()) {
+    size_t end = ngram.find(' ', begin);
+    if (end == string::npos) end = ngram.size();
+    if (end > begin) {
+      words.push_back(model.GetVocabulary().Index(ngram.substr(begin, end - begin)));
+    }
+    begin = end + 1;
+  }
+  if (words.empty()) return -999.0f;
+  lm::ngram::State state;
+  const size_t contextSize = min(words.size() - 1, static_cast<size_t>(model.Order() - 1));
+  return model.FullScoreForgotState(&words[1], &words[1] + contextSize, words[0], state).prob;
+}
+
+bool WriteAll(int sock, const string &data)
+{
+  size_t done = 0;
+  while (done < data.size()) {
+    ssize_t w = write(sock, data.data() + done, data.size() - done);
+    if (w < 0) {
+      if (errno == EINTR) continue;
+      return false;
+    }
+    done += w;
+  }
+  return true;
+}
+
+void AppendProb(float prob, string &out)
+{
+  out.append(reinterpret_cast<const char *>(&prob), sizeof(float));
+}
+
+string Answer(const Model &model, const string &line)
+{
+  string out;
+  if (line.compare(0, 6, "probs\t") == 0) {
+    size_t begin = 6;
+    while (true) {
+      size_t end = line.find('\t', begin);
+      AppendProb(NGramProb(model, line.substr(begin, end - begin)), out);
+      if (end == string::npos) break;
+      begin = end + 1;
+    }
+  } else if (line.compare(0, 5, "prob ") == 0) {
+    AppendProb(NGramProb(model, line.substr(5)), out);
+  } else {
+    out = "ERROR";
+  }
+  out += "\r\n";
+  return out;
+}
+
+void Serve(const Model *model, int sock)
+{
+  string buffer;
+  char chunk[65536];
+  while (true) {
+    ssize_t r = read(sock, chunk, sizeof(chunk));
+    if (r < 0 && errno == EINTR) continue;
+    if (r <= 0) break;
+    buffer.append(chunk, r);
+
+    // Answer all complete requests; more may already be on their way.
+    string out;
+    size_t begin = 0, end;
+    while ((end = buffer.find('\n', begin)) != string::npos) {
+      size_t len = end - begin;
+      if (len > 0 && buffer[end - 1] == '\r') --len;
+      out += Answer(*model, buffer.substr(begin, len));
+      begin = end + 1;
+    }
+    buffer.erase(0, begin);
+    if (!WriteAll(sock, out)) break;
+  }
+  close(sock);
+}
+
+}  // namespace
+
+int main(int argc, char **argv)
+{
+  string lmFile;
+  int port = 0;
+  for (int i = 1; i < argc; ++i) {
+    string s(argv[i]);
+    if (s == "-lm" && i+1 < argc) lmFile = argv[++i];
+    else if (s == "-port" && i+1 < argc) port = atoi(argv[++i]);
+    else {
+      cerr << "usage " << argv[0] << " :\n\n"
+           "options:\n"
+           "\t-lm string   -- ARPA or KenLM binary language model\n"
+           "\t-port int    -- port to listen on\n"
+           "\nUse with language model type 7 (remote), file host:port.\n";
+      return 1;
+    }
+  }
+  if (lmFile.empty() || port <= 0) {
+    cerr << "ERROR: -lm and -port are required\n";
+    return 1;
+  }
+
+  Model model(lmFile.c_str());
+
+  int listener = socket(AF_INET, SOCK_STREAM, 0);
+  int flag = 1;
+  setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &flag, sizeof(flag));
+  struct sockaddr_in address;
+  memset(&address, 0, sizeof(address));
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_ANY);
+  address.sin_port = htons(port);
+  if (bind(listener, (struct sockaddr *)&address, sizeof(address)) < 0 ||
+      listen(listener, 64) < 0) {
+    perror("cannot listen");
+    return 1;
+  }
+  cerr << "Serving " << lmFile << " on port " << port << endl;
+
+  while (true) {
+    int sock = accept(listener, NULL, NULL);
+    if (sock < 0) {
+      if (errno == EINTR) continue;
+      perror("accept failed");
+      return 1;
+    }
+    setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
+#ifdef WITH_THREADS
+    boost::thread(Serve, &model, sock).detach();
+#else
+    Serve(&model, sock);
+#endif
+  }
+}
@@ -13,6 +13,10 @@
 #include "Phrase.h"
 #include "InputFileStream.h"
 #include "Timer.h"
+#include "ScoreIndexManager.h"
+#include "Util.h"
+#include "LM/Base.h"
+#include "LM/Factory.h"
 
 using namespace std;
 using namespace Moses;
@@ -46,6 +50,7 @@ int main(int argc,char **argv)
   int cn=0;
   bool aligninfo=false;
   std::vector<std::pair<std::string,std::pair<char*,char*> > > ftts;
+  std::vector<std::string> lms;
   int verb=0;
   for(int i=1; i<argc; ++i) {
     std::string s(argv[i]);
@@ -59,6 +64,7 @@ int main(int argc,char **argv)
     else if(s=="-cn") cn=1;
     else if(s=="-irst") cn=2;
     else if(s=="-alignment-info") aligninfo=true;
+    else if(s=="-lm") lms.push_back(argv[++i]);
     else if(s=="-v") verb=atoi(argv[++i]);
     else if(s=="-h") {
       std::cerr<<"usage "<<argv[0]<<" :\n\n"
@@ -67,6 +73,9 @@ int main(int argc,char **argv)
                "\t-out string      -- output file name prefix for binary ttable\n"
                "\t-nscores int     -- number of scores in ttable\n"
                "\t-alignment-info  -- include alignment info in the binary ttable (suffix \".wa\")\n"
+               "\t-lm string       -- language model, as on an lmodel-file line of moses.ini;\n"
+               "\t                    store its estimate of each target phrase (repeat for\n"
+               "\t                    each LM, in the order of moses.ini)\n"
                "\nfunctions:\n"
                "\t - convert ascii ttable in binary format\n"
                "\t - if ttable is not read from stdin:\n"
@@ -88,6 +97,33 @@ int main(int argc,char **argv)
 
       pdt.PrintWordAlignment(aligninfo);
 
+      ScoreIndexManager scoreIndexManager;
+      std::vector<LanguageModel*> languageModels;
+      std::vector<std::string> fingerprints;
+      for(size_t i=0; i<lms.size(); ++i) {
+        std::vector<std::string> token=Tokenize(lms[i]);
+        if(token.size()!=4) {
+          std::cerr<<"ERROR: expected -lm 'LM-TYPE FACTOR-TYPE NGRAM-ORDER filePath'\n";
+          return 1;
+        }
+        LanguageModel *lm=LanguageModelFactory::CreateLanguageModel(
+                            static_cast<LMImplementation>(Scan<int>(token[0])),
+                            Tokenize<FactorType>(token[1],","),
+                            Scan<size_t>(token[2]),
+                            token[3],
+                            scoreIndexManager,
+                            0);
+        if(lm==NULL) {
+          std::cerr<<"ERROR: cannot load language model '"<<lms[i]<<"'\n";
+          return 1;
+        }
+        languageModels.push_back(lm);
+        fingerprints.push_back(LanguageModelFactory::Fingerprint(lms[i]));
+      }
+      if(languageModels.size())
+        pdt.StoreLMEstimates(languageModels,fingerprints,
+                             Tokenize<FactorType>(ftts[0].second.second,","));
+
       if (ftts[0].first=="-") {
         std::cerr<< "stdin\n";
         pdt.Create(std::cin,fto);
@@ -96,6 +132,7 @@ int main(int argc,char **argv)
         InputFileStream in(ftts[0].first);
         pdt.Create(in,fto);
       }
+      RemoveAllInColl(languageModels);
     } else {
 #if 0
       std::vector<PhraseDictionaryTree const*> pdicts;
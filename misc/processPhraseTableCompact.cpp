@@ -0,0 +1,273 @@
+// Builds a compact, memory-mapped phrase table (phrase table type 12) from a
+// text phrase table that is sorted by source phrase.  See
+// moses/src/CompactPT/Format.h for the layout.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "CompactPT/Format.h"
+#include "CompactPT/MinimalPerfectHash.h"
+#include "CompactPT/ScoreQuantizer.h"
+#include "InputFileStream.h"
+#include "Util.h"
+
+using namespace std;
+using namespace Moses;
+
+namespace
+{
+
+struct Line {
+  string source;
+  vector<string> target;
+  vector<float> scores;
+  string alignment;
+  size_t numFields;
+};
+
+bool ParseLine(const string &text, size_t numScores, Line &line)
+{
+  vector<string> fields = TokenizeMultiCharSeparator(text, "|||");
+  if (fields.size() < 3) {
+    return false;
+  }
+  line.numFields = fields.size();
+  line.source = Join(" ", Tokenize(fields[0]));
+  line.target = Tokenize(fields[1]);
+  line.scores.clear();
+  Tokenize<float>(line.scores, fields[2]);
+  line.alignment = fields.size() > 3 ? fields[3] : "";
+  return line.scores.size() == numScores;
+}
+
+struct FrequencyGreater {
+  bool operator()(const pair<string, uint64_t> &a,
+                  const pair<string, uint64_t> &b) const {
+    return a.second > b.second || (a.second == b.second && a.first < b.first);
+  }
+};
+
+template<typename T>
+void WriteArray(ofstream &out, const vector<T> &vec, uint64_t &offset)
+{
+  // Keep every section 8-byte aligned.
+  static const char padding[8] = {0};
+  const uint64_t pos = out.tellp();
+  const uint64_t pad = (8 - pos % 8) % 8;
+  out.write(padding, pad);
+  offset = pos + pad;
+  if (!vec.empty()) {
+    out.write(reinterpret_cast<const char *>(&vec[0]), vec.size() * sizeof(T));
+  }
+}
+
+}  // namespace
+
+int main(int argc, char **argv)
+{
+  string in, out;
+  size_t numScores = 5;
+  for (int i = 1; i < argc; ++i) {
+    string s(argv[i]);
+    if (s == "-ttable" && i+1 < argc) in = argv[++i];
+    else if (s == "-out" && i+1 < argc) out = argv[++i];
+    else if (s == "-nscores" && i+1 < argc) numScores = atoi(argv[++i]);
+    else {
+      cerr << "usage " << argv[0] << " :\n\n"
+           "options:\n"
+           "\t-ttable string   -- text phrase table sorted by source phrase (may be gzipped)\n"
+           "\t-out string      -- output file name for the compact table\n"
+           "\t-nscores int     -- number of scores in ttable\n"
+           "\nUse the output with phrase table type 12.\n";
+      return 1;
+    }
+  }
+  if (in.empty() || out.empty()) {
+    cerr << "ERROR: -ttable and -out are required\n";
+    return 1;
+  }
+
+  // Pass 1: target vocabulary frequencies and score codebooks.
+  map<string, uint64_t> counts;
+  vector<ScoreQuantizer> quantizers(numScores);
+  size_t numFields = 0;
+  size_t lineNum = 0;
+  {
+    InputFileStream inStream(in);
+    string text;
+    Line line;
+    while (getline(inStream, text)) {
+      ++lineNum;
+      if (!ParseLine(text, numScores, line)) {
+        cerr << "ERROR: bad line " << lineNum << endl;
+        return 1;
+      }
+      if (lineNum == 1) {
+        numFields = line.numFields;
+      } else if (line.numFields != numFields) {
+        cerr << "ERROR: line " << lineNum << " has " << line.numFields
+             << " fields, but line 1 has " << numFields << endl;
+        return 1;
+      }
+      for (size_t i = 0; i < line.target.size(); ++i) {
+        ++counts[line.target[i]];
+      }
+      for (size_t i = 0; i < numScores; ++i) {
+        quantizers[i].Observe(line.scores[i]);
+      }
+      if (lineNum % 100000 == 0) cerr << "." << flush;
+    }
+  }
+  const bool hasAlignment = numFields > 3;
+  cerr << "\npass 1: " << lineNum << " lines, " << counts.size()
+       << " target words" << endl;
+
+  vector<pair<string, uint64_t> > byFrequency(counts.begin(), counts.end());
+  counts.clear();
+  sort(byFrequency.begin(), byFrequency.end(), FrequencyGreater());
+  map<string, uint64_t> vocab;
+  vector<uint64_t> vocabIndex;
+  vector<char> vocabStrings;
+  for (size_t i = 0; i < byFrequency.size(); ++i) {
+    vocab[byFrequency[i].first] = i;
+    vocabIndex.push_back(vocabStrings.size());
+    vocabStrings.insert(vocabStrings.end(), byFrequency[i].first.begin(),
+                        byFrequency[i].first.end());
+  }
+  vocabIndex.push_back(vocabStrings.size());
+
+  vector<float> codebook;
+  for (size_t i = 0; i < numScores; ++i) {
+    quantizers[i].Train(CompactPT::kCodebookSize);
+    const vector<float> &codes = quantizers[i].GetCodebook();
+    codebook.insert(codebook.end(), codes.begin(), codes.end());
+  }
+
+  // Pass 2: encode the entries into a temporary blob file.
+  const string blobPath = out + ".blob.tmp";
+  vector<MinimalPerfectHash::KeyHash> keys;
+  vector<uint64_t> keyOffsets;
+  uint64_t blobSize = 0;
+  {
+    ofstream blob(blobPath.c_str(), ios::out | ios::binary);
+    InputFileStream inStream(in);
+    string text, entry, candidates, previous;
+    uint64_t numCandidates = 0;
+    Line line;
+    lineNum = 0;
+    bool more = true;
+    while (more) {
+      more = !getline(inStream, text).fail();
+      if (more) {
+        ++lineNum;
+        if (!ParseLine(text, numScores, line)) {
+          cerr << "ERROR: bad line " << lineNum << endl;
+          remove(blobPath.c_str());
+          return 1;
+        }
+      }
+      if (!more || (lineNum > 1 && line.source != previous)) {
+        // Flush the previous source phrase.
+        entry.clear();
+        CompactPT::EncodeVarint(numCandidates, entry);
+        entry += candidates;
+        keys.push_back(MinimalPerfectHash::Hash(previous.data(), previous.size()));
+        keyOffsets.push_back(blobSize);
+        blob.write(entry.data(), entry.size());
+        blobSize += entry.size();
+        candidates.clear();
+        numCandidates = 0;
+      }
+      if (!more) {
+        break;
+      }
+      previous = line.source;
+
+      CompactPT::EncodeVarint(line.target.size(), candidates);
+      for (size_t i = 0; i < line.target.size(); ++i) {
+        CompactPT::EncodeVarint(vocab[line.target[i]], candidates);
+      }
+      for (size_t i = 0; i < numScores; ++i) {
+        candidates += static_cast<char>(quantizers[i].Encode(line.scores[i]));
+      }
+      if (hasAlignment) {
+        vector<string> points = Tokenize(line.alignment);
+        CompactPT::EncodeVarint(points.size(), candidates);
+        for (size_t i = 0; i < points.size(); ++i) {
+          vector<size_t> point = Tokenize<size_t>(points[i], "-");
+          if (point.size() != 2) {
+            cerr << "ERROR: bad alignment point on line " << lineNum << endl;
+            remove(blobPath.c_str());
+            return 1;
+          }
+          CompactPT::EncodeVarint(point[0], candidates);
+          CompactPT::EncodeVarint(point[1], candidates);
+        }
+      }
+      ++numCandidates;
+    }
+    if (lineNum == 0) {
+      keys.clear();
+      keyOffsets.clear();
+    }
+  }
+  cerr << "pass 2: " << keys.size() << " source phrases, " << blobSize
+       << " bytes of entries" << endl;
+
+  vector<MinimalPerfectHash::Displacement> buckets;
+  if (!MinimalPerfectHash::Build(keys, buckets)) {
+    cerr << "ERROR: could not build the source phrase hash; is the phrase table sorted by source phrase?" << endl;
+    remove(blobPath.c_str());
+    return 1;
+  }
+  vector<uint32_t> fingerprints(keys.size());
+  vector<uint64_t> entries(keys.size());
+  for (size_t i = 0; i < keys.size(); ++i) {
+    const uint64_t slot = MinimalPerfectHash::Slot(keys[i], &buckets[0],
+                          buckets.size(), keys.size());
+    fingerprints[slot] = keys[i].fingerprint;
+    entries[slot] = keyOffsets[i];
+  }
+
+  CompactPT::Header header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, CompactPT::kMagic, sizeof(header.magic));
+  header.version = CompactPT::kVersion;
+  header.numScores = numScores;
+  header.hasAlignment = hasAlignment;
+  header.numSources = keys.size();
+  header.numBuckets = buckets.size();
+  header.vocabSize = byFrequency.size();
+  header.blobSize = blobSize;
+
+  ofstream outStream(out.c_str(), ios::out | ios::binary);
+  outStream.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  WriteArray(outStream, buckets, header.bucketOffset);
+  WriteArray(outStream, fingerprints, header.fingerprintOffset);
+  WriteArray(outStream, entries, header.entryOffset);
+  WriteArray(outStream, vocabIndex, header.vocabIndexOffset);
+  WriteArray(outStream, vocabStrings, header.vocabStringOffset);
+  WriteArray(outStream, codebook, header.codebookOffset);
+  WriteArray(outStream, vector<char>(), header.blobOffset);
+  if (blobSize > 0) {
+    ifstream blob(blobPath.c_str(), ios::in | ios::binary);
+    outStream << blob.rdbuf();
+  }
+  remove(blobPath.c_str());
+
+  outStream.seekp(0);
+  outStream.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  outStream.close();
+  if (!outStream.good()) {
+    cerr << "ERROR: failed writing " << out << endl;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,314 @@
+// Compiles a text SCFG rule table (Moses format) into the memory-mapped
+// UTrie layout read by RuleTableUTrieMmap (phrase table type 11).
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "InputFileStream.h"
+#include "RuleTable/UTrieMmapFormat.h"
+#include "Util.h"
+
+using namespace std;
+using namespace Moses;
+
+namespace
+{
+
+struct BuildNode {
+  BuildNode() : gapChild(UTrieMmapFormat::kNoNode) {}
+  map<uint32_t, uint32_t> edges;
+  uint32_t gapChild;
+  vector<uint32_t> rules;
+};
+
+struct BuildRule {
+  uint32_t lhs;
+  vector<uint32_t> symbols;
+  vector<UTrieMmapFormat::AlignPoint> aligns;
+  vector<float> scores;
+};
+
+struct EdgeLess {
+  bool operator()(const UTrieMmapFormat::Edge &a,
+                  const UTrieMmapFormat::Edge &b) const {
+    return a.word < b.word;
+  }
+};
+
+class Compiler
+{
+public:
+  Compiler(size_t numScores) : m_numScores(numScores), m_nodes(1) {}
+
+  bool AddRule(const string &line, size_t lineNum);
+  bool Write(const string &path);
+
+  size_t GetRuleCount() const {
+    return m_rules.size();
+  }
+
+private:
+  uint32_t GetVocabId(const string &str);
+  bool IsNonTerminal(const string &tok) const {
+    return tok.size() > 1 && tok[0] == '[' && tok[tok.size()-1] == ']';
+  }
+
+  size_t m_numScores;
+  map<string, uint32_t> m_vocab;
+  vector<BuildNode> m_nodes;
+  vector<BuildRule> m_rules;
+};
+
+uint32_t Compiler::GetVocabId(const string &str)
+{
+  map<string, uint32_t>::const_iterator p = m_vocab.find(str);
+  if (p != m_vocab.end()) {
+    return p->second;
+  }
+  const uint32_t id = m_vocab.size();
+  m_vocab[str] = id;
+  return id;
+}
+
+bool Compiler::AddRule(const string &line, size_t lineNum)
+{
+  vector<string> tokens;
+  TokenizeMultiCharSeparator(tokens, line, "|||");
+  if (tokens.size() != 4 && tokens.size() != 5) {
+    cerr << "Syntax error on line " << lineNum << endl;
+    return false;
+  }
+
+  vector<string> source = Tokenize(tokens[0]);
+  vector<string> target = Tokenize(tokens[1]);
+  if (source.empty() || target.empty()
+      || !IsNonTerminal(source.back()) || !IsNonTerminal(target.back())) {
+    cerr << "Missing left-hand side on line " << lineNum << endl;
+    return false;
+  }
+
+  BuildRule rule;
+  Tokenize<float>(rule.scores, tokens[2]);
+  if (rule.scores.size() != m_numScores) {
+    cerr << "Size of scoreVector != number (" << rule.scores.size() << "!="
+         << m_numScores << ") of score components on line " << lineNum << endl;
+    return false;
+  }
+
+  vector<string> alignTokens = Tokenize(tokens[3]);
+  for (size_t i = 0; i < alignTokens.size(); ++i) {
+    vector<size_t> points = Tokenize<size_t>(alignTokens[i], "-");
+    if (points.size() != 2) {
+      cerr << "Bad alignment point on line " << lineNum << endl;
+      return false;
+    }
+    UTrieMmapFormat::AlignPoint point;
+    point.source = points[0];
+    point.target = points[1];
+    rule.aligns.push_back(point);
+  }
+
+  // Target non-terminals "[X][NP]" are labelled with their second label.
+  for (size_t i = 0; i+1 < target.size(); ++i) {
+    string tok = target[i];
+    if (IsNonTerminal(tok)) {
+      size_t nextPos = tok.find("[", 1);
+      if (nextPos == string::npos) {
+        cerr << "Bad non-terminal " << tok << " on line " << lineNum << endl;
+        return false;
+      }
+      tok = tok.substr(nextPos);
+    }
+    rule.symbols.push_back(GetVocabId(tok));
+  }
+  rule.lhs = GetVocabId(target.back());
+
+  // Source non-terminals are unlabelled: every one maps to the gap child.
+  uint32_t node = 0;
+  for (size_t i = 0; i+1 < source.size(); ++i) {
+    if (IsNonTerminal(source[i])) {
+      if (m_nodes[node].gapChild == UTrieMmapFormat::kNoNode) {
+        m_nodes[node].gapChild = m_nodes.size();
+        m_nodes.push_back(BuildNode());
+      }
+      node = m_nodes[node].gapChild;
+    } else {
+      const uint32_t word = GetVocabId(source[i]);
+      map<uint32_t, uint32_t>::const_iterator p = m_nodes[node].edges.find(word);
+      if (p != m_nodes[node].edges.end()) {
+        node = p->second;
+      } else {
+        const uint32_t child = m_nodes.size();
+        m_nodes[node].edges[word] = child;
+        m_nodes.push_back(BuildNode());
+        node = child;
+      }
+    }
+  }
+
+  m_nodes[node].rules.push_back(m_rules.size());
+  m_rules.push_back(rule);
+  return true;
+}
+
+template<typename T>
+void WriteArray(ofstream &out, const vector<T> &vec, uint64_t &offset)
+{
+  // Keep every section 8-byte aligned.
+  static const char padding[8] = {0};
+  const uint64_t pos = out.tellp();
+  const uint64_t pad = (8 - pos % 8) % 8;
+  out.write(padding, pad);
+  offset = pos + pad;
+  if (!vec.empty()) {
+    out.write(reinterpret_cast<const char *>(&vec[0]), vec.size() * sizeof(T));
+  }
+}
+
+bool Compiler::Write(const string &path)
+{
+  UTrieMmapFormat::Header header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, UTrieMmapFormat::kMagic, sizeof(header.magic));
+  header.version = UTrieMmapFormat::kVersion;
+  header.numScores = m_numScores;
+
+  // Vocabulary, sorted so that the decoder can binary search it.
+  vector<uint32_t> remap(m_vocab.size());
+  vector<uint64_t> vocabIndex;
+  vector<char> vocabStrings;
+  vocabIndex.reserve(m_vocab.size()+1);
+  for (map<string, uint32_t>::const_iterator p = m_vocab.begin();
+       p != m_vocab.end(); ++p) {
+    remap[p->second] = vocabIndex.size();
+    vocabIndex.push_back(vocabStrings.size());
+    vocabStrings.insert(vocabStrings.end(), p->first.begin(), p->first.end());
+  }
+  vocabIndex.push_back(vocabStrings.size());
+  header.vocabSize = m_vocab.size();
+
+  vector<UTrieMmapFormat::Node> nodes(m_nodes.size());
+  vector<UTrieMmapFormat::Edge> edges;
+  vector<UTrieMmapFormat::Rule> rules;
+  vector<uint32_t> symbols;
+  vector<UTrieMmapFormat::AlignPoint> aligns;
+  vector<float> scores;
+  rules.reserve(m_rules.size());
+  scores.reserve(m_rules.size() * m_numScores);
+
+  for (size_t i = 0; i < m_nodes.size(); ++i) {
+    const BuildNode &buildNode = m_nodes[i];
+    UTrieMmapFormat::Node &node = nodes[i];
+
+    node.firstEdge = edges.size();
+    node.numEdges = buildNode.edges.size();
+    for (map<uint32_t, uint32_t>::const_iterator p = buildNode.edges.begin();
+         p != buildNode.edges.end(); ++p) {
+      UTrieMmapFormat::Edge edge;
+      edge.word = remap[p->first];
+      edge.child = p->second;
+      edges.push_back(edge);
+    }
+    sort(edges.begin() + node.firstEdge, edges.end(), EdgeLess());
+    node.gapChild = buildNode.gapChild;
+
+    node.firstRule = rules.size();
+    node.numRules = buildNode.rules.size();
+    for (size_t j = 0; j < buildNode.rules.size(); ++j) {
+      const BuildRule &buildRule = m_rules[buildNode.rules[j]];
+      UTrieMmapFormat::Rule rule;
+      rule.lhs = remap[buildRule.lhs];
+      rule.firstSymbol = symbols.size();
+      rule.numSymbols = buildRule.symbols.size();
+      for (size_t k = 0; k < buildRule.symbols.size(); ++k) {
+        symbols.push_back(remap[buildRule.symbols[k]]);
+      }
+      rule.firstAlign = aligns.size();
+      rule.numAligns = buildRule.aligns.size();
+      aligns.insert(aligns.end(), buildRule.aligns.begin(),
+                    buildRule.aligns.end());
+      scores.insert(scores.end(), buildRule.scores.begin(),
+                    buildRule.scores.end());
+      rules.push_back(rule);
+    }
+  }
+
+  header.nodeCount = nodes.size();
+  header.edgeCount = edges.size();
+  header.ruleCount = rules.size();
+  header.symbolCount = symbols.size();
+  header.alignCount = aligns.size();
+
+  ofstream out(path.c_str(), ios::out | ios::binary);
+  if (!out.good()) {
+    cerr << "Cannot open " << path << " for writing" << endl;
+    return false;
+  }
+  out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  WriteArray(out, vocabIndex, header.vocabIndexOffset);
+  WriteArray(out, vocabStrings, header.vocabStringOffset);
+  WriteArray(out, nodes, header.nodeOffset);
+  WriteArray(out, edges, header.edgeOffset);
+  WriteArray(out, rules, header.ruleOffset);
+  WriteArray(out, symbols, header.symbolOffset);
+  WriteArray(out, aligns, header.alignOffset);
+  WriteArray(out, scores, header.scoreOffset);
+
+  // Rewrite the header now that the offsets are known.
+  out.seekp(0);
+  out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  out.close();
+  return out.good();
+}
+
+}  // namespace
+
+int main(int argc, char **argv)
+{
+  string in, out;
+  size_t numScores = 5;
+  for (int i = 1; i < argc; ++i) {
+    string s(argv[i]);
+    if (s == "-ttable" && i+1 < argc) in = argv[++i];
+    else if (s == "-out" && i+1 < argc) out = argv[++i];
+    else if (s == "-nscores" && i+1 < argc) numScores = atoi(argv[++i]);
+    else {
+      cerr << "usage " << argv[0] << " :\n\n"
+           "options:\n"
+           "\t-ttable string   -- text rule table (Moses format, may be gzipped)\n"
+           "\t-out string      -- output file name for the compiled table\n"
+           "\t-nscores int     -- number of scores in ttable\n"
+           "\nUse the output with phrase table type 11 and the scope-3 parser.\n";
+      return 1;
+    }
+  }
+  if (in.empty() || out.empty()) {
+    cerr << "ERROR: -ttable and -out are required\n";
+    return 1;
+  }
+
+  Compiler compiler(numScores);
+  InputFileStream inStream(in);
+  string line;
+  size_t lineNum = 0;
+  while (getline(inStream, line)) {
+    ++lineNum;
+    if (!compiler.AddRule(line, lineNum)) {
+      return 1;
+    }
+    if (lineNum % 100000 == 0) cerr << "." << flush;
+  }
+  cerr << "\nread " << compiler.GetRuleCount() << " rules" << endl;
+
+  if (!compiler.Write(out)) {
+    cerr << "ERROR: failed writing " << out << endl;
+    return 1;
+  }
+  return 0;
+}
@@ -40,6 +40,7 @@ POSSIBILITY OF SUCH DAMAGE.
 #include "StaticData.h"
 #include "DummyScoreProducers.h"
 #include "InputFileStream.h"
+#include "BinarySearchGraph.h"
 #include "PhraseDictionary.h"
 #include "ChartTrellisPathList.h"
 #include "ChartTrellisPath.h"
@@ -64,11 +65,13 @@ IOWrapper::IOWrapper(const std::vector<FactorType>	&inputFactorOrder
   ,m_inputFactorUsed(inputFactorUsed)
   ,m_nBestStream(NULL)
   ,m_outputSearchGraphStream(NULL)
+  ,m_outputSearchGraphBinaryStream(NULL)
   ,m_detailedTranslationReportingStream(NULL)
   ,m_inputFilePath(inputFilePath)
   ,m_detailOutputCollector(NULL)
   ,m_nBestOutputCollector(NULL)
   ,m_searchGraphOutputCollector(NULL)
+  ,m_searchGraphBinaryOutputCollector(NULL)
   ,m_singleBestOutputCollector(NULL)
 {
   const StaticData &staticData = StaticData::Instance();
@@ -106,6 +109,18 @@ IOWrapper::IOWrapper(const std::vector<FactorType>	&inputFactorOrder
     m_searchGraphOutputCollector = new Moses::OutputCollector(m_outputSearchGraphStream);
   }
 
+  // ... in binary
+  if (staticData.GetOutputSearchGraphBinary()) {
+    string fileName = staticData.GetParam("output-search-graph-binary")[0];
+    std::ofstream *file = new std::ofstream(fileName.c_str(), ios::out | ios::binary);
+    m_outputSearchGraphBinaryStream = file;
+    BinarySearchGraphHeader header;
+    header.decoder = BinarySearchGraphHeader::Chart;
+    header.featureNames = staticData.GetScoreIndexManager().GetFeatureShortNames();
+    BinarySearchGraphWriter::WriteHeader(*file, header);
+    m_searchGraphBinaryOutputCollector = new Moses::OutputCollector(m_outputSearchGraphBinaryStream);
+  }
+
   // detailed translation reporting
   if (staticData.IsDetailedTranslationReportingEnabled()) {
     const std::string &path = staticData.GetDetailedTranslationReportingFilePath();
@@ -124,10 +139,12 @@ IOWrapper::~IOWrapper()
     delete m_nBestStream;
   }
   delete m_outputSearchGraphStream;
+  delete m_outputSearchGraphBinaryStream;
   delete m_detailedTranslationReportingStream;
   delete m_detailOutputCollector;
   delete m_nBestOutputCollector;
   delete m_searchGraphOutputCollector;
+  delete m_searchGraphBinaryOutputCollector;
   delete m_singleBestOutputCollector;
 }
 
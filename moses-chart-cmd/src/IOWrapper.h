@@ -64,7 +64,7 @@ protected:
   const std::vector<Moses::FactorType>	&m_inputFactorOrder;
   const std::vector<Moses::FactorType>	&m_outputFactorOrder;
   const Moses::FactorMask								&m_inputFactorUsed;
-  std::ostream 									*m_nBestStream, *m_outputSearchGraphStream;
+  std::ostream 									*m_nBestStream, *m_outputSearchGraphStream, *m_outputSearchGraphBinaryStream;
   std::ostream                  *m_detailedTranslationReportingStream;
   std::string										m_inputFilePath;
   std::istream									*m_inputStream;
@@ -72,6 +72,7 @@ protected:
   Moses::OutputCollector                *m_detailOutputCollector;
   Moses::OutputCollector                *m_nBestOutputCollector;
   Moses::OutputCollector                *m_searchGraphOutputCollector;
+  Moses::OutputCollector                *m_searchGraphBinaryOutputCollector;
   Moses::OutputCollector                *m_singleBestOutputCollector;
 
 public:
@@ -96,6 +97,10 @@ public:
     return m_searchGraphOutputCollector;
   }
 
+  Moses::OutputCollector *GetSearchGraphBinaryOutputCollector() {
+    return m_searchGraphBinaryOutputCollector;
+  }
+
   static void FixPrecision(std::ostream &, size_t size=3);
 };
 
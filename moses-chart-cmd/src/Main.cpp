@@ -123,6 +123,14 @@ public:
       oc->Write(lineNumber, out.str());
     }
 
+    if (staticData.GetOutputSearchGraphBinary()) {
+      std::ostringstream out;
+      manager.OutputSearchGraphBinary(lineNumber, out);
+      OutputCollector *oc = m_ioWrapper.GetSearchGraphBinaryOutputCollector();
+      CHECK(oc);
+      oc->Write(lineNumber, out.str());
+    }
+
     IFVERBOSE(2) {
       PrintUserTime("Sentence Decoding Time:");
     }
@@ -43,6 +43,7 @@ POSSIBILITY OF SUCH DAMAGE.
 #include "StaticData.h"
 #include "DummyScoreProducers.h"
 #include "InputFileStream.h"
+#include "BinarySearchGraph.h"
 
 using namespace std;
 using namespace Moses;
@@ -64,6 +65,7 @@ IOWrapper::IOWrapper(
   ,m_nBestStream(NULL)
   ,m_outputWordGraphStream(NULL)
   ,m_outputSearchGraphStream(NULL)
+  ,m_outputSearchGraphBinaryStream(NULL)
   ,m_detailedTranslationReportingStream(NULL)
   ,m_alignmentOutputStream(NULL)
 {
@@ -86,6 +88,7 @@ IOWrapper::IOWrapper(const std::vector<FactorType>	&inputFactorOrder
   ,m_nBestStream(NULL)
   ,m_outputWordGraphStream(NULL)
   ,m_outputSearchGraphStream(NULL)
+  ,m_outputSearchGraphBinaryStream(NULL)
   ,m_detailedTranslationReportingStream(NULL)
   ,m_alignmentOutputStream(NULL)
 {
@@ -110,6 +113,7 @@ IOWrapper::~IOWrapper()
   if (m_outputSearchGraphStream != NULL) {
     delete m_outputSearchGraphStream;
   }
+  delete m_outputSearchGraphBinaryStream;
   delete m_detailedTranslationReportingStream;
   delete m_alignmentOutputStream;
 }
@@ -157,6 +161,17 @@ void IOWrapper::Initialization(const std::vector<FactorType>	&/*inputFactorOrder
     file->open(fileName.c_str());
   }
 
+  // ... in binary
+  if (staticData.GetOutputSearchGraphBinary()) {
+    string fileName = staticData.GetParam("output-search-graph-binary")[0];
+    std::ofstream *file = new std::ofstream(fileName.c_str(), ios::out | ios::binary);
+    m_outputSearchGraphBinaryStream = file;
+    BinarySearchGraphHeader header;
+    header.decoder = BinarySearchGraphHeader::PhraseBased;
+    header.featureNames = staticData.GetScoreIndexManager().GetFeatureShortNames();
+    BinarySearchGraphWriter::WriteHeader(*file, header);
+  }
+
   // detailed translation reporting
   if (staticData.IsDetailedTranslationReportingEnabled()) {
     const std::string &path = staticData.GetDetailedTranslationReportingFilePath();
@@ -70,7 +70,7 @@ protected:
   Moses::InputFileStream				*m_inputFile;
   std::istream									*m_inputStream;
   std::ostream 									*m_nBestStream
-  ,*m_outputWordGraphStream,*m_outputSearchGraphStream;
+  ,*m_outputWordGraphStream,*m_outputSearchGraphStream,*m_outputSearchGraphBinaryStream;
   std::ostream                  *m_detailedTranslationReportingStream;
   std::ofstream *m_alignmentOutputStream;
   bool													m_surpressSingleBestOutput;
@@ -116,6 +116,9 @@ public:
   std::ostream &GetOutputSearchGraphStream() {
     return *m_outputSearchGraphStream;
   }
+  std::ostream &GetOutputSearchGraphBinaryStream() {
+    return *m_outputSearchGraphBinaryStream;
+  }
 
   std::ostream &GetDetailedTranslationReportingStream() {
     assert (m_detailedTranslationReportingStream);
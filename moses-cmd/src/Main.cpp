@@ -78,12 +78,14 @@ public:
                   InputType* source, OutputCollector* outputCollector, OutputCollector* nbestCollector,
                   OutputCollector* latticeSamplesCollector,
                   OutputCollector* wordGraphCollector, OutputCollector* searchGraphCollector,
+                  OutputCollector* searchGraphBinaryCollector,
                   OutputCollector* detailedTranslationCollector,
                   OutputCollector* alignmentInfoCollector ) :
     m_source(source), m_lineNumber(lineNumber),
     m_outputCollector(outputCollector), m_nbestCollector(nbestCollector),
     m_latticeSamplesCollector(latticeSamplesCollector),
     m_wordGraphCollector(wordGraphCollector), m_searchGraphCollector(searchGraphCollector),
+    m_searchGraphBinaryCollector(searchGraphBinaryCollector),
     m_detailedTranslationCollector(detailedTranslationCollector),
     m_alignmentInfoCollector(alignmentInfoCollector) {}
 
@@ -136,6 +138,13 @@ public:
 #endif
     }		
 
+    // output search graph in binary
+    if (m_searchGraphBinaryCollector) {
+      ostringstream out;
+      manager.OutputSearchGraphBinary(m_lineNumber, out);
+      m_searchGraphBinaryCollector->Write(m_lineNumber, out.str());
+    }
+
     // apply decision rule and output best translation(s)
     if (m_outputCollector) {
       ostringstream out;
@@ -284,6 +293,7 @@ private:
   OutputCollector* m_latticeSamplesCollector;
   OutputCollector* m_wordGraphCollector;
   OutputCollector* m_searchGraphCollector;
+  OutputCollector* m_searchGraphBinaryCollector;
   OutputCollector* m_detailedTranslationCollector;
   OutputCollector* m_alignmentInfoCollector;
   std::ofstream *m_alignmentStream;
@@ -456,6 +466,10 @@ int main(int argc, char** argv)
     if (staticData.GetOutputSearchGraph()) {
       searchGraphCollector.reset(new OutputCollector(&(ioWrapper->GetOutputSearchGraphStream())));
     }
+    auto_ptr<OutputCollector> searchGraphBinaryCollector;
+    if (staticData.GetOutputSearchGraphBinary()) {
+      searchGraphBinaryCollector.reset(new OutputCollector(&(ioWrapper->GetOutputSearchGraphBinaryStream())));
+    }
   
     // initialize stram for details about the decoder run
     auto_ptr<OutputCollector> detailedTranslationCollector;
@@ -487,6 +501,7 @@ int main(int argc, char** argv)
                             latticeSamplesCollector.get(),
                             wordGraphCollector.get(),
                             searchGraphCollector.get(),
+                            searchGraphBinaryCollector.get(),
                             detailedTranslationCollector.get(),
                             alignmentInfoCollector.get() );
       // execute task
@@ -4,6 +4,7 @@
 #include "StaticData.h"
 #include "TargetPhrase.h"
 #include <iomanip>
+#include <limits>
 
 using namespace std;
 
@@ -22,6 +23,33 @@ BilingualDynSuffixArray::BilingualDynSuffixArray():
 	m_scoreCmp = 0;
 }
 
+BilingualDynSuffixArray::BilingualDynSuffixArray(const BilingualDynSuffixArray &other):
+	m_inputFactors(other.m_inputFactors),
+	m_outputFactors(other.m_outputFactors),
+	m_srcSntBreaks(other.m_srcSntBreaks),
+	m_trgSntBreaks(other.m_trgSntBreaks),
+	m_alignments(other.m_alignments),
+	m_rawAlignments(other.m_rawAlignments),
+	m_maxPhraseLength(other.m_maxPhraseLength),
+	m_maxSampleSize(other.m_maxSampleSize)
+{
+	{
+		// decoding threads may be adding to other's cache
+#ifdef WITH_THREADS
+		boost::mutex::scoped_lock lock(other.m_wordPairCacheLock);
+#endif
+		m_wordPairCache = other.m_wordPairCache;
+		m_freqWordsCached = other.m_freqWordsCached;
+	}
+	m_srcCorpus = new std::vector<wordID_t>(*other.m_srcCorpus);
+	m_trgCorpus = new std::vector<wordID_t>(*other.m_trgCorpus);
+	m_srcSA = other.m_srcSA ? new DynSuffixArray(*other.m_srcSA, m_srcCorpus) : 0;
+	m_trgSA = other.m_trgSA ? new DynSuffixArray(*other.m_trgSA, m_trgCorpus) : 0;
+	m_srcVocab = new Vocab(*other.m_srcVocab);
+	m_trgVocab = new Vocab(*other.m_trgVocab);
+	m_scoreCmp = other.m_scoreCmp ? new ScoresComp(*other.m_scoreCmp) : 0;
+}
+
 BilingualDynSuffixArray::~BilingualDynSuffixArray() 
 {
 	if(m_srcSA) delete m_srcSA;
@@ -226,7 +254,6 @@ pair<float, float> BilingualDynSuffixArray::GetLexicalWeight(const PhrasePair& p
 	std::map<pair<wordID_t, wordID_t>, float> targetProbs; // collect sum of target probs given source words
 	//const SentenceAlignment& alignment = m_alignments[phrasepair.m_sntIndex];
 	const SentenceAlignment& alignment = GetSentenceAlignment(phrasepair.m_sntIndex);
-	std::map<pair<wordID_t, wordID_t>, pair<float, float> >::const_iterator itrCache; 
 	// for each source word
 	for(int srcIdx = phrasepair.m_startSource; srcIdx <= phrasepair.m_endSource; ++srcIdx) {
 		float srcSumPairProbs(0);
@@ -235,14 +262,9 @@ pair<float, float> BilingualDynSuffixArray::GetLexicalWeight(const PhrasePair& p
     // for each target word aligned to this source word in this alignment
 		if(srcWordAlignments.size() == 0) { // get p(NULL|src)
 			pair<wordID_t, wordID_t> wordpair = make_pair(srcWord, m_srcVocab->GetkOOVWordID());
-			itrCache = m_wordPairCache.find(wordpair);
-			if(itrCache == m_wordPairCache.end()) { // if not in cache
-				CacheWordProbs(srcWord);
-				itrCache = m_wordPairCache.find(wordpair); // search cache again
-			}
-			CHECK(itrCache != m_wordPairCache.end());
-			srcSumPairProbs += itrCache->second.first;
-			targetProbs[wordpair] = itrCache->second.second;
+			const pair<float, float> probs = GetWordPairProbs(wordpair);
+			srcSumPairProbs += probs.first;
+			targetProbs[wordpair] = probs.second;
 		}
 		else { // extract p(trg|src) 
 			for(size_t i = 0; i < srcWordAlignments.size(); ++i) { // for each aligned word
@@ -250,14 +272,9 @@ pair<float, float> BilingualDynSuffixArray::GetLexicalWeight(const PhrasePair& p
 				wordID_t trgWord = m_trgCorpus->at(trgIdx + m_trgSntBreaks[phrasepair.m_sntIndex]);
 				// get probability of this source->target word pair
 				pair<wordID_t, wordID_t> wordpair = make_pair(srcWord, trgWord);
-				itrCache = m_wordPairCache.find(wordpair);
-				if(itrCache == m_wordPairCache.end()) { // if not in cache
-          CacheWordProbs(srcWord);
-					itrCache = m_wordPairCache.find(wordpair); // search cache again
-				}
-				CHECK(itrCache != m_wordPairCache.end());
-				srcSumPairProbs += itrCache->second.first;
-				targetProbs[wordpair] = itrCache->second.second;	
+				const pair<float, float> probs = GetWordPairProbs(wordpair);
+				srcSumPairProbs += probs.first;
+				targetProbs[wordpair] = probs.second;
 			} 
 		}
 		float srcNormalizer = srcWordAlignments.size() < 2 ? 1.0 : 1.0 / float(srcWordAlignments.size());
@@ -301,6 +318,26 @@ void BilingualDynSuffixArray::CacheFreqWords() const {
   }
   cerr << "\tCached " << m_freqWordsCached.size() << " source words\n";
 }
+pair<float, float> BilingualDynSuffixArray::GetWordPairProbs(const pair<wordID_t, wordID_t> &wordpair) const
+{
+	{
+#ifdef WITH_THREADS
+		boost::mutex::scoped_lock lock(m_wordPairCacheLock);
+#endif
+		WordPairCache::const_iterator itrCache = m_wordPairCache.find(wordpair);
+		if(itrCache != m_wordPairCache.end())
+			return itrCache->second;
+	}
+	// not in cache: compute without holding the lock, then search cache again
+	CacheWordProbs(wordpair.first);
+#ifdef WITH_THREADS
+	boost::mutex::scoped_lock lock(m_wordPairCacheLock);
+#endif
+	WordPairCache::const_iterator itrCache = m_wordPairCache.find(wordpair);
+	CHECK(itrCache != m_wordPairCache.end());
+	return itrCache->second;
+}
+
 void BilingualDynSuffixArray::CacheWordProbs(wordID_t srcWord) const 
 {
 	std::map<wordID_t, int> counts;
@@ -328,14 +365,20 @@ void BilingualDynSuffixArray::CacheWordProbs(wordID_t srcWord) const
 		}
 	}
 	// now we've gotten counts of all target words aligned to this source word
-	// get probs and cache all pairs
+	// get probs of all pairs
+	WordPairCache probs;
 	for(std::map<wordID_t, int>::const_iterator itrCnt = counts.begin();
 			itrCnt != counts.end(); ++itrCnt) {
 		pair<wordID_t, wordID_t> wordPair = make_pair(srcWord, itrCnt->first);
 		float srcTrgPrb = float(itrCnt->second) / float(denom);	// gives p(src->trg)
 		float trgSrcPrb = float(itrCnt->second) / float(counts.size()); // gives p(trg->src) 
-		m_wordPairCache[wordPair] = pair<float, float>(srcTrgPrb, trgSrcPrb);
+		probs[wordPair] = pair<float, float>(srcTrgPrb, trgSrcPrb);
 	}
+	// and cache them
+#ifdef WITH_THREADS
+	boost::mutex::scoped_lock lock(m_wordPairCacheLock);
+#endif
+	m_wordPairCache.insert(probs.begin(), probs.end());
 }
 
 SAPhrase BilingualDynSuffixArray::TrgPhraseFromSntIdx(const PhrasePair& phrasepair) const 
@@ -493,25 +536,23 @@ void BilingualDynSuffixArray::addSntPair(string& source, string& target, string&
   //m_trgSA->Insert(&trgFactor, oldTrgCrpSize);
   LoadRawAlignments(alignment);
   m_trgVocab->MakeClosed();
-  //for(size_t i=0; i < sphrase.GetSize(); ++i)
-    //ClearWordInCache(sIDs[i]);
+  // the word translation probabilities of the new source words have changed
+  for(size_t i=0; i < sphrase.GetSize(); ++i)
+    ClearWordInCache(sIDs[i]);
   
 }
 void BilingualDynSuffixArray::ClearWordInCache(wordID_t srcWord) {
-  if(m_freqWordsCached.find(srcWord) != m_freqWordsCached.end())
-    return;
-	std::map<std::pair<wordID_t, wordID_t>, std::pair<float, float> >::iterator it,
-    first, last;
-  for(it = m_wordPairCache.begin(); it != m_wordPairCache.end(); ++it) {
-    if(it->first.first == srcWord) {  // all source words grouped 
-      first = it; // copy first entry of srcWord
-      last = it++;
-      while(it != m_wordPairCache.end() && (it->first.first == srcWord)) {
-        last = it++;
-      }
-    }
-    m_wordPairCache.erase(first, last);
+  {
+#ifdef WITH_THREADS
+    boost::mutex::scoped_lock lock(m_wordPairCacheLock);
+#endif
+    // all pairs of srcWord are adjacent in the cache
+    m_wordPairCache.erase(m_wordPairCache.lower_bound(make_pair(srcWord, wordID_t(0))),
+      m_wordPairCache.upper_bound(make_pair(srcWord, std::numeric_limits<wordID_t>::max())));
   }
+  // the frequent words stay cached, with their new probabilities
+  if(m_freqWordsCached.find(srcWord) != m_freqWordsCached.end())
+    CacheWordProbs(srcWord);
 }
 SentenceAlignment::SentenceAlignment(int sntIndex, int sourceSize, int targetSize) 
 	:m_sntIndex(sntIndex)
@@ -9,6 +9,10 @@
 #include "InputFileStream.h"
 #include "FactorTypeSet.h"
 
+#ifdef WITH_THREADS
+#include <boost/thread/mutex.hpp>
+#endif
+
 namespace Moses {
 
 /** @todo ask Abbey Levenberg
@@ -88,6 +92,8 @@ private:
 class BilingualDynSuffixArray {
 public: 
 	BilingualDynSuffixArray();
+	//! deep copy, so that one version can be updated while another is read
+	BilingualDynSuffixArray(const BilingualDynSuffixArray &other);
 	~BilingualDynSuffixArray();
 	bool Load( const std::vector<FactorType>& inputFactors,
 		const std::vector<FactorType>& outputTactors,
@@ -112,8 +118,12 @@ private:
 	std::vector<SentenceAlignment> m_alignments;
 	std::vector<std::vector<short> > m_rawAlignments;
 
-	mutable std::map<std::pair<wordID_t, wordID_t>, std::pair<float, float> > m_wordPairCache; 
+	typedef std::map<std::pair<wordID_t, wordID_t>, std::pair<float, float> > WordPairCache;
+	mutable WordPairCache m_wordPairCache; 
   mutable std::set<wordID_t> m_freqWordsCached;
+#ifdef WITH_THREADS
+  mutable boost::mutex m_wordPairCacheLock;
+#endif
 	const size_t m_maxPhraseLength, m_maxSampleSize;
 
 	int LoadCorpus(InputFileStream&, const std::vector<FactorType>& factors, 
@@ -131,7 +141,10 @@ private:
 	TargetPhrase* GetMosesFactorIDs(const SAPhrase&) const;
 	SAPhrase TrgPhraseFromSntIdx(const PhrasePair&) const;
 	bool GetLocalVocabIDs(const Phrase&, SAPhrase &) const;
+	//! computes the probabilities of all pairs of the source word, and caches them
 	void CacheWordProbs(wordID_t) const;
+	//! probabilities of the word pair, cached if need be
+	std::pair<float, float> GetWordPairProbs(const std::pair<wordID_t, wordID_t>&) const;
   void CacheFreqWords() const;
   void ClearWordInCache(wordID_t);
 	std::pair<float, float> GetLexicalWeight(const PhrasePair&) const;
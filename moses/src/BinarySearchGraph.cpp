@@ -0,0 +1,452 @@
+// $Id$
+// vim:tabstop=2
+
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2006 University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <stdint.h>
+#include "BinarySearchGraph.h"
+
+namespace Moses
+{
+
+namespace
+{
+
+const char kMagic[8] = {'M', 'O', 'S', 'E', 'S', 'H', 'G', '\0'};
+const uint64_t kVersion = 1;
+
+// node flags
+const uint64_t Recombined = 1;
+const uint64_t FeaturesOfBack = 2;
+
+void PutVarint(std::string &out, uint64_t value)
+{
+  while (value >= 0x80) {
+    out += static_cast<char>((value & 0x7f) | 0x80);
+    value >>= 7;
+  }
+  out += static_cast<char>(value);
+}
+
+void PutSigned(std::string &out, int64_t value)
+{
+  PutVarint(out, (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+}
+
+template <class T>
+void PutRaw(std::string &out, T value)
+{
+  out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+void PutString(std::string &out, const std::string &str)
+{
+  PutVarint(out, str.size());
+  out += str;
+}
+
+bool SameBits(float a, float b)
+{
+  return std::memcmp(&a, &b, sizeof(float)) == 0;
+}
+
+// reads variable-length integers from a stream, for the header and the
+// record lengths
+bool GetVarint(std::istream &in, uint64_t &value)
+{
+  value = 0;
+  for (int shift = 0; shift < 64; shift += 7) {
+    int c = in.get();
+    if (c == EOF) {
+      return false;
+    }
+    value |= static_cast<uint64_t>(c & 0x7f) << shift;
+    if ((c & 0x80) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// reads size bytes into str, in pieces so that a corrupt size fails at the
+// end of the stream instead of allocating it all up front
+bool GetBytes(std::istream &in, uint64_t size, std::string &str)
+{
+  const uint64_t kPiece = 1 << 20;
+  str.clear();
+  while (str.size() < size) {
+    const size_t old = str.size();
+    str.resize(old + std::min<uint64_t>(size - old, kPiece));
+    if (!in.read(&str[old], str.size() - old)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// decodes a record. After any read past its end, Ok() is false and the
+// values returned are 0
+class Cursor
+{
+public:
+  Cursor(const std::string &data)
+    : m_pos(data.data())
+    , m_end(data.data() + data.size())
+    , m_ok(true)
+  {}
+
+  bool Ok() const {
+    return m_ok;
+  }
+  bool AtEnd() const {
+    return m_pos == m_end;
+  }
+
+  uint64_t GetVarint() {
+    uint64_t value = 0;
+    for (int shift = 0; shift < 64 && m_pos != m_end; shift += 7) {
+      unsigned char c = *m_pos++;
+      value |= static_cast<uint64_t>(c & 0x7f) << shift;
+      if ((c & 0x80) == 0) {
+        return value;
+      }
+    }
+    m_ok = false;
+    return 0;
+  }
+
+  // a number of items that each take at least one byte, so a count larger
+  // than the bytes left means the record is corrupt
+  uint64_t GetCount() {
+    uint64_t value = GetVarint();
+    if (value > static_cast<uint64_t>(m_end - m_pos)) {
+      m_ok = false;
+      return 0;
+    }
+    return value;
+  }
+
+  int64_t GetSigned() {
+    uint64_t value = GetVarint();
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+  }
+
+  template <class T>
+  T GetRaw() {
+    T value = 0;
+    if (m_end - m_pos < static_cast<ptrdiff_t>(sizeof(T))) {
+      m_ok = false;
+      return value;
+    }
+    std::memcpy(&value, m_pos, sizeof(T));
+    m_pos += sizeof(T);
+    return value;
+  }
+
+  void GetString(std::string &str) {
+    uint64_t size = GetVarint();
+    if (static_cast<uint64_t>(m_end - m_pos) < size) {
+      m_ok = false;
+      str.clear();
+      return;
+    }
+    str.assign(m_pos, size);
+    m_pos += size;
+  }
+
+private:
+  const char *m_pos;
+  const char *m_end;
+  bool m_ok;
+};
+
+}
+
+void BinarySearchGraphWriter::WriteHeader(std::ostream &out, const BinarySearchGraphHeader &header)
+{
+  std::string data(kMagic, sizeof(kMagic));
+  PutVarint(data, kVersion);
+  PutVarint(data, header.decoder);
+  PutVarint(data, header.featureNames.size());
+  for (size_t i = 0; i < header.featureNames.size(); ++i) {
+    PutString(data, header.featureNames[i]);
+  }
+  out.write(data.data(), data.size());
+}
+
+BinarySearchGraphWriter::BinarySearchGraphWriter(BinarySearchGraphHeader::Decoder decoder, long translationId)
+  : m_decoder(decoder)
+  , m_translationId(translationId)
+  , m_numStrings(0)
+  , m_numRules(0)
+  , m_numNodes(0)
+  , m_previousId(0)
+{
+}
+
+size_t BinarySearchGraphWriter::AddString(const std::string &str)
+{
+  std::pair<std::map<std::string, size_t>::iterator, bool> ret =
+    m_stringIndex.insert(std::make_pair(str, m_numStrings));
+  if (ret.second) {
+    PutString(m_strings, str);
+    ++m_numStrings;
+  }
+  return ret.first->second;
+}
+
+bool BinarySearchGraphWriter::FindRule(const void *key, size_t &rule) const
+{
+  std::map<const void*, size_t>::const_iterator p = m_ruleKeys.find(key);
+  if (p == m_ruleKeys.end()) {
+    return false;
+  }
+  rule = p->second;
+  return true;
+}
+
+size_t BinarySearchGraphWriter::AddRule(const void *key, const std::string &source, const std::string &target)
+{
+  std::pair<size_t, size_t> strings(AddString(source), AddString(target));
+  std::pair<std::map<std::pair<size_t, size_t>, size_t>::iterator, bool> ret =
+    m_ruleIndex.insert(std::make_pair(strings, m_numRules));
+  if (ret.second) {
+    PutVarint(m_rules, strings.first);
+    PutVarint(m_rules, strings.second);
+    ++m_numRules;
+  }
+  if (key != NULL) {
+    m_ruleKeys[key] = ret.first->second;
+  }
+  return ret.first->second;
+}
+
+void BinarySearchGraphWriter::AddNode(const BinarySearchGraphNode &node)
+{
+  // the feature values are stored as changes to those of the first
+  // back-pointer, if it was written
+  const float *reference = NULL;
+  if (!node.back.empty()) {
+    std::map<int, size_t>::const_iterator p = m_scoreOffsets.find(node.back[0]);
+    if (p != m_scoreOffsets.end()) {
+      reference = &m_scores[p->second];
+    }
+  }
+
+  uint64_t flags = 0;
+  if (node.winner >= 0) {
+    flags |= Recombined;
+  }
+  if (reference != NULL) {
+    flags |= FeaturesOfBack;
+  }
+  PutVarint(m_nodes, flags);
+  PutSigned(m_nodes, static_cast<int64_t>(node.id) - m_previousId);
+  if (node.winner >= 0) {
+    PutSigned(m_nodes, static_cast<int64_t>(node.id) - node.winner);
+  }
+  PutVarint(m_nodes, node.back.size());
+  for (size_t i = 0; i < node.back.size(); ++i) {
+    PutSigned(m_nodes, static_cast<int64_t>(node.id) - node.back[i]);
+  }
+  PutVarint(m_nodes, node.startPos);
+  PutVarint(m_nodes, node.endPos - node.startPos);
+  PutVarint(m_nodes, node.rule);
+  PutRaw(m_nodes, node.score);
+  if (m_decoder == BinarySearchGraphHeader::PhraseBased) {
+    PutVarint(m_nodes, node.stack);
+    PutSigned(m_nodes, static_cast<int64_t>(node.forward) - node.id);
+    PutRaw(m_nodes, node.fscore);
+  }
+
+  size_t numChanged = 0;
+  for (size_t i = 0; i < node.scores.size(); ++i) {
+    if (!SameBits(node.scores[i], reference ? reference[i] : 0.0f)) {
+      ++numChanged;
+    }
+  }
+  PutVarint(m_nodes, numChanged);
+  size_t next = 0;
+  for (size_t i = 0; i < node.scores.size(); ++i) {
+    if (!SameBits(node.scores[i], reference ? reference[i] : 0.0f)) {
+      PutVarint(m_nodes, i - next);
+      PutRaw(m_nodes, node.scores[i]);
+      next = i + 1;
+    }
+  }
+
+  m_scoreOffsets[node.id] = m_scores.size();
+  m_scores.insert(m_scores.end(), node.scores.begin(), node.scores.end());
+  m_previousId = node.id;
+  ++m_numNodes;
+}
+
+void BinarySearchGraphWriter::Write(std::ostream &out) const
+{
+  std::string prefix;
+  PutSigned(prefix, m_translationId);
+  PutVarint(prefix, m_numStrings);
+  std::string rulesPrefix;
+  PutVarint(rulesPrefix, m_numRules);
+  std::string nodesPrefix;
+  PutVarint(nodesPrefix, m_numNodes);
+
+  std::string length;
+  PutVarint(length, prefix.size() + m_strings.size() + rulesPrefix.size() + m_rules.size()
+            + nodesPrefix.size() + m_nodes.size());
+  out.write(length.data(), length.size());
+  out.write(prefix.data(), prefix.size());
+  out.write(m_strings.data(), m_strings.size());
+  out.write(rulesPrefix.data(), rulesPrefix.size());
+  out.write(m_rules.data(), m_rules.size());
+  out.write(nodesPrefix.data(), nodesPrefix.size());
+  out.write(m_nodes.data(), m_nodes.size());
+}
+
+BinarySearchGraphReader::BinarySearchGraphReader(std::istream &in)
+  : m_in(in)
+  , m_failed(true)
+{
+  char magic[sizeof(kMagic)];
+  uint64_t version, decoder, numFeatures;
+  if (!m_in.read(magic, sizeof(magic))
+      || std::memcmp(magic, kMagic, sizeof(kMagic)) != 0
+      || !GetVarint(m_in, version) || version != kVersion
+      || !GetVarint(m_in, decoder) || decoder > BinarySearchGraphHeader::Chart
+      || !GetVarint(m_in, numFeatures)) {
+    return;
+  }
+  m_header.decoder = static_cast<BinarySearchGraphHeader::Decoder>(decoder);
+  for (uint64_t i = 0; i < numFeatures; ++i) {
+    uint64_t size;
+    std::string name;
+    if (!GetVarint(m_in, size) || !GetBytes(m_in, size, name)) {
+      return;
+    }
+    m_header.featureNames.push_back(name);
+  }
+  m_failed = false;
+}
+
+bool BinarySearchGraphReader::Read(BinarySearchGraph &graph)
+{
+  if (m_failed) {
+    return false;
+  }
+  if (m_in.peek() == EOF) {
+    return false;
+  }
+  uint64_t length;
+  if (!GetVarint(m_in, length)) {
+    m_failed = true;
+    return false;
+  }
+  if (!GetBytes(m_in, length, m_record)) {
+    m_failed = true;
+    return false;
+  }
+
+  Cursor cursor(m_record);
+  graph.translationId = cursor.GetSigned();
+
+  std::vector<std::string> strings(cursor.GetCount());
+  for (size_t i = 0; i < strings.size() && cursor.Ok(); ++i) {
+    cursor.GetString(strings[i]);
+  }
+
+  graph.rules.resize(cursor.GetCount());
+  for (size_t i = 0; i < graph.rules.size() && cursor.Ok(); ++i) {
+    uint64_t source = cursor.GetVarint();
+    uint64_t target = cursor.GetVarint();
+    if (source >= strings.size() || target >= strings.size()) {
+      m_failed = true;
+      return false;
+    }
+    graph.rules[i].source = strings[source];
+    graph.rules[i].target = strings[target];
+  }
+
+  const size_t numFeatures = m_header.featureNames.size();
+  graph.nodes.resize(cursor.GetCount());
+  m_nodeIndex.clear();
+  int previousId = 0;
+  for (size_t i = 0; i < graph.nodes.size() && cursor.Ok(); ++i) {
+    BinarySearchGraphNode &node = graph.nodes[i];
+    uint64_t flags = cursor.GetVarint();
+    node.id = static_cast<int>(previousId + cursor.GetSigned());
+    node.winner = (flags & Recombined) ? static_cast<int>(node.id - cursor.GetSigned()) : -1;
+    node.back.resize(cursor.GetCount());
+    for (size_t j = 0; j < node.back.size() && cursor.Ok(); ++j) {
+      node.back[j] = static_cast<int>(node.id - cursor.GetSigned());
+    }
+    node.startPos = cursor.GetVarint();
+    node.endPos = node.startPos + cursor.GetVarint();
+    node.rule = cursor.GetVarint();
+    if (node.rule >= graph.rules.size()) {
+      m_failed = true;
+      return false;
+    }
+    node.score = cursor.GetRaw<float>();
+    if (m_header.decoder == BinarySearchGraphHeader::PhraseBased) {
+      node.stack = cursor.GetVarint();
+      node.forward = static_cast<int>(node.id + cursor.GetSigned());
+      node.fscore = cursor.GetRaw<double>();
+    } else {
+      node.stack = 0;
+      node.forward = -1;
+      node.fscore = 0;
+    }
+
+    node.scores.assign(numFeatures, 0.0f);
+    if (flags & FeaturesOfBack) {
+      std::map<int, size_t>::const_iterator p;
+      if (node.back.empty() || (p = m_nodeIndex.find(node.back[0])) == m_nodeIndex.end()) {
+        m_failed = true;
+        return false;
+      }
+      node.scores = graph.nodes[p->second].scores;
+    }
+    size_t numChanged = cursor.GetVarint();
+    size_t index = 0;
+    for (size_t j = 0; j < numChanged && cursor.Ok(); ++j) {
+      index += cursor.GetVarint();
+      if (index >= numFeatures) {
+        m_failed = true;
+        return false;
+      }
+      node.scores[index++] = cursor.GetRaw<float>();
+    }
+
+    m_nodeIndex[node.id] = i;
+    previousId = node.id;
+  }
+
+  if (!cursor.Ok() || !cursor.AtEnd()) {
+    m_failed = true;
+    return false;
+  }
+  return true;
+}
+
+}
@@ -0,0 +1,171 @@
+// $Id$
+// vim:tabstop=2
+
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2006 University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#ifndef moses_BinarySearchGraph_h
+#define moses_BinarySearchGraph_h
+
+#include <iostream>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace Moses
+{
+
+/** Compact binary search graphs, written by both decoders with
+ *  -output-search-graph-binary. Only the standard library is used here, so
+ *  that readers can build these two files on their own.
+ *
+ *  A file is a header followed by one record per sentence, each written as
+ *  soon as the sentence is translated. Numbers are stored as variable-length
+ *  integers, 7 bits a byte, signed ones zig-zag encoded; scores as floats in
+ *  host byte order.
+ *
+ *  header:   "MOSESHG\0" version decoder numFeatures featureName*
+ *  record:   length translationId
+ *            numStrings string*  numRules (source target)*  numNodes node*
+ *  node:     flags  id-previousId  [id-winnerId]  numBack (id-backId)*
+ *            startPos endPos-startPos rule score
+ *            [stack forward-id fscore(double)]        phrase-based only
+ *            numChanged (index-previousIndex value)*
+ *
+ *  Strings are interned, and rules are pairs of them, so every phrase is
+ *  stored once per sentence. Hypotheses are referred to by the difference
+ *  of their ids. The feature values are those of the derivation so far;
+ *  only the values that differ from those of the first back-pointer are
+ *  stored, flagged by FeaturesOfBack.
+ */
+struct BinarySearchGraphHeader {
+  enum Decoder {
+    PhraseBased = 0,
+    Chart = 1
+  };
+
+  Decoder decoder;
+  std::vector<std::string> featureNames; //! short name of each feature
+};
+
+//! a source and target phrase of the search graph, for the chart decoder
+//! the printed target phrase and no source
+struct BinarySearchGraphRule {
+  std::string source;
+  std::string target;
+};
+
+//! one hypothesis of the search graph
+struct BinarySearchGraphNode {
+  int id;
+  int winner; //! hypothesis this one was recombined into, -1 for none
+  //! the previous hypothesis (phrase-based, none for the initial one) or
+  //! the hypotheses of the non-terminals (chart)
+  std::vector<int> back;
+  size_t startPos, endPos; //! source words of the phrase or rule
+  size_t rule; //! index into the sentence's rules
+  float score; //! score so far
+  std::vector<float> scores; //! feature values so far
+
+  // phrase-based decoder only
+  size_t stack; //! number of source words covered
+  int forward; //! best next hypothesis, -1 for none
+  double fscore; //! score of the best completion
+};
+
+//! the search graph of one sentence
+struct BinarySearchGraph {
+  long translationId;
+  std::vector<BinarySearchGraphRule> rules;
+  std::vector<BinarySearchGraphNode> nodes;
+};
+
+/** Encodes the search graph of a sentence, hypothesis by hypothesis, and
+ *  writes it as one record.
+ */
+class BinarySearchGraphWriter
+{
+public:
+  static void WriteHeader(std::ostream &out, const BinarySearchGraphHeader &header);
+
+  BinarySearchGraphWriter(BinarySearchGraphHeader::Decoder decoder, long translationId);
+
+  //! index of the rule interned under key, if it was added
+  bool FindRule(const void *key, size_t &rule) const;
+  //! intern a rule. key, if not NULL, makes the rule known to FindRule()
+  size_t AddRule(const void *key, const std::string &source, const std::string &target);
+
+  /** encode a hypothesis. Back-pointers and winner should have been added
+   *  before it, which the decoders' search graphs always do.
+   */
+  void AddNode(const BinarySearchGraphNode &node);
+
+  void Write(std::ostream &out) const;
+
+private:
+  size_t AddString(const std::string &str);
+
+  BinarySearchGraphHeader::Decoder m_decoder;
+  long m_translationId;
+  std::map<std::string, size_t> m_stringIndex;
+  std::string m_strings;
+  size_t m_numStrings;
+  std::map<std::pair<size_t, size_t>, size_t> m_ruleIndex;
+  std::map<const void*, size_t> m_ruleKeys;
+  std::string m_rules;
+  size_t m_numRules;
+  std::string m_nodes;
+  size_t m_numNodes;
+  int m_previousId;
+  std::map<int, size_t> m_scoreOffsets; //! of each node's feature values in m_scores
+  std::vector<float> m_scores;
+};
+
+/** Reads a file of binary search graphs, sentence by sentence.
+ */
+class BinarySearchGraphReader
+{
+public:
+  //! reads the header; check with Failed()
+  BinarySearchGraphReader(std::istream &in);
+
+  const BinarySearchGraphHeader &GetHeader() const {
+    return m_header;
+  }
+
+  //! the next sentence. false at the end of the file or if it is corrupt
+  bool Read(BinarySearchGraph &graph);
+
+  //! whether the file wasn't a binary search graph or was corrupt
+  bool Failed() const {
+    return m_failed;
+  }
+
+private:
+  std::istream &m_in;
+  BinarySearchGraphHeader m_header;
+  bool m_failed;
+  std::string m_record;
+  std::map<int, size_t> m_nodeIndex;
+};
+
+}
+
+#endif
@@ -195,6 +195,10 @@ Hypothesis *BackwardsEdge::CreateHypothesis(const Hypothesis &hypothesis, const
 bool
 BackwardsEdge::SeenPosition(const size_t x, const size_t y)
 {
+  if (m_parent.UsesFlatQueue()) {
+    const size_t pos = x * m_translations.size() + y;
+    return pos < m_seenGrid.size() && m_seenGrid[pos];
+  }
   std::set< int >::iterator iter = m_seenPosition.find((x<<16) + y);
   return (iter != m_seenPosition.end());
 }
@@ -202,6 +206,17 @@ BackwardsEdge::SeenPosition(const size_t x, const size_t y)
 void
 BackwardsEdge::SetSeenPosition(const size_t x, const size_t y)
 {
+  if (m_parent.UsesFlatQueue()) {
+    const size_t pos = x * m_translations.size() + y;
+    if (pos >= m_seenGrid.size()) {
+      // add rows, at least doubling them
+      const size_t rows = std::max(x + 1, 2 * m_seenGrid.size() / m_translations.size());
+      m_seenGrid.resize(rows * m_translations.size(), false);
+    }
+    m_seenGrid[pos] = true;
+    return;
+  }
+
   CHECK(x < (1<<17));
   CHECK(y < (1<<17));
 
@@ -252,6 +267,7 @@ BitmapContainer::BitmapContainer(const WordsBitmap &bitmap
                                  , HypothesisStackCubePruning &stack)
   : m_bitmap(bitmap)
   , m_stack(stack)
+  , m_useFlatQueue(StaticData::Instance().GetCubePruningFlatQueue())
   , m_numStackInsertions(0)
 {
   m_hypotheses = HypothesisSet();
@@ -270,6 +286,9 @@ BitmapContainer::~BitmapContainer()
     delete item;
     m_queue.pop();
   }
+  for (size_t i = 0; i < m_flatQueue.size(); ++i) {
+    FREEHYPO(m_flatQueue[i].GetHypothesis());
+  }
 
   // Delete all edges.
   RemoveAllInColl(m_edges);
@@ -285,6 +304,15 @@ BitmapContainer::Enqueue(int hypothesis_pos
                          , Hypothesis *hypothesis
                          , BackwardsEdge *edge)
 {
+  if (m_useFlatQueue) {
+    m_flatQueue.push_back(HypothesisQueueItem(hypothesis_pos
+                          , translation_pos
+                          , hypothesis
+                          , edge));
+    std::push_heap(m_flatQueue.begin(), m_flatQueue.end(), QueueItemOrderer());
+    return;
+  }
+
   HypothesisQueueItem *item = new HypothesisQueueItem(hypothesis_pos
       , translation_pos
       , hypothesis
@@ -292,38 +320,22 @@ BitmapContainer::Enqueue(int hypothesis_pos
   m_queue.push(item);
 }
 
-HypothesisQueueItem*
-BitmapContainer::Dequeue(bool keepValue)
-{
-  if (!m_queue.empty()) {
-    HypothesisQueueItem *item = m_queue.top();
-
-    if (!keepValue) {
-      m_queue.pop();
-    }
-
-    return item;
-  }
-
-  return NULL;
-}
-
-HypothesisQueueItem*
+const HypothesisQueueItem*
 BitmapContainer::Top() const
 {
-  return m_queue.top();
+  return m_useFlatQueue ? &m_flatQueue.front() : m_queue.top();
 }
 
 size_t
 BitmapContainer::Size()
 {
-  return m_queue.size();
+  return m_useFlatQueue ? m_flatQueue.size() : m_queue.size();
 }
 
 bool
 BitmapContainer::Empty() const
 {
-  return m_queue.empty();
+  return m_useFlatQueue ? m_flatQueue.empty() : m_queue.empty();
 }
 
 
@@ -374,12 +386,16 @@ BitmapContainer::AddHypothesis(Hypothesis *hypothesis)
 void
 BitmapContainer::AddBackwardsEdge(BackwardsEdge *edge)
 {
-  m_edges.insert(edge);
+  m_edges.push_back(edge);
 }
 
 void
 BitmapContainer::InitializeEdges()
 {
+  // the edges are initialised in address order, which decides the order of
+  // equally scored hypotheses in the queue
+  std::sort(m_edges.begin(), m_edges.end());
+
   BackwardsEdgeSet::iterator iter = m_edges.begin();
   BackwardsEdgeSet::iterator iterEnd = m_edges.end();
 
@@ -402,30 +418,43 @@ BitmapContainer::EnsureMinStackHyps(const size_t minNumHyps)
 void
 BitmapContainer::ProcessBestHypothesis()
 {
-  if (m_queue.empty()) {
+  if (Empty()) {
     return;
   }
 
   // Get the currently best hypothesis from the queue.
-  HypothesisQueueItem *item = Dequeue();
+  if (m_useFlatQueue) {
+    std::pop_heap(m_flatQueue.begin(), m_flatQueue.end(), QueueItemOrderer());
+    // copied, as the successors are added to the heap
+    const HypothesisQueueItem item = m_flatQueue.back();
+    m_flatQueue.pop_back();
+    ProcessQueueItem(item);
+  } else {
+    HypothesisQueueItem *item = m_queue.top();
+    m_queue.pop();
+    ProcessQueueItem(*item);
 
-  // If the priority queue is exhausted, we are done and should have exited
-  CHECK(item != NULL);
+    // We are done with the queue item, we delete it.
+    delete item;
+  }
+}
 
+void
+BitmapContainer::ProcessQueueItem(const HypothesisQueueItem &item)
+{
   // check we are pulling things off of priority queue in right order
   if (!Empty()) {
-    HypothesisQueueItem *check = Dequeue(true);
-    CHECK(item->GetHypothesis()->GetTotalScore() >= check->GetHypothesis()->GetTotalScore());
+    CHECK(item.GetHypothesis()->GetTotalScore() >= Top()->GetHypothesis()->GetTotalScore());
   }
 
   // Logging for the criminally insane
   IFVERBOSE(3) {
     //		const StaticData &staticData = StaticData::Instance();
-    item->GetHypothesis()->PrintHypothesis();
+    item.GetHypothesis()->PrintHypothesis();
   }
 
   // Add best hypothesis to hypothesis stack.
-  const bool newstackentry = m_stack.AddPrune(item->GetHypothesis());
+  const bool newstackentry = m_stack.AddPrune(item.GetHypothesis());
   if (newstackentry)
     m_numStackInsertions++;
 
@@ -434,10 +463,7 @@ BitmapContainer::ProcessBestHypothesis()
   }
 
   // Create new hypotheses for the two successors of the hypothesis just added.
-  item->GetBackwardsEdge()->PushSuccessors(item->GetHypothesisPos(), item->GetTranslationPos());
-
-  // We are done with the queue item, we delete it.
-  delete item;
+  item.GetBackwardsEdge()->PushSuccessors(item.GetHypothesisPos(), item.GetTranslationPos());
 }
 
 void
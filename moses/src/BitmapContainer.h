@@ -44,8 +44,10 @@ class HypothesisQueueItem;
 class QueueItemOrderer;
 
 typedef std::vector< Hypothesis* > HypothesisSet;
-typedef std::set< BackwardsEdge* > BackwardsEdgeSet;
+typedef std::vector< BackwardsEdge* > BackwardsEdgeSet;
 typedef std::priority_queue< HypothesisQueueItem*, std::vector< HypothesisQueueItem* >, QueueItemOrderer> HypothesisQueue;
+//! heap of queue items kept by value, see BitmapContainer
+typedef std::vector< HypothesisQueueItem > HypothesisFlatQueue;
 
 ////////////////////////////////////////////////////////////////////////////////
 // Hypothesis Priority Queue Code
@@ -75,19 +77,19 @@ public:
   ~HypothesisQueueItem() {
   }
 
-  int GetHypothesisPos() {
+  int GetHypothesisPos() const {
     return m_hypothesis_pos;
   }
 
-  int GetTranslationPos() {
+  int GetTranslationPos() const {
     return m_translation_pos;
   }
 
-  Hypothesis *GetHypothesis() {
+  Hypothesis *GetHypothesis() const {
     return m_hypothesis;
   }
 
-  BackwardsEdge *GetBackwardsEdge() {
+  BackwardsEdge *GetBackwardsEdge() const {
     return m_edge;
   }
 };
@@ -96,6 +98,10 @@ public:
 class QueueItemOrderer
 {
 public:
+  bool operator()(const HypothesisQueueItem &itemA, const HypothesisQueueItem &itemB) const {
+    return (itemA.GetHypothesis()->GetTotalScore() < itemB.GetHypothesis()->GetTotalScore());
+  }
+
   bool operator()(HypothesisQueueItem* itemA, HypothesisQueueItem* itemB) const {
     float scoreA = itemA->GetHypothesis()->GetTotalScore();
     float scoreB = itemB->GetHypothesis()->GetTotalScore();
@@ -165,6 +171,9 @@ private:
 
   std::vector< const Hypothesis* > m_hypotheses;
   std::set< int > m_seenPosition;
+  // with a flat queue: one bit per (hypothesis, translation), a row for each
+  // hypothesis reached so far
+  std::vector< bool > m_seenGrid;
 
   // We don't want to instantiate "empty" objects.
   BackwardsEdge();
@@ -206,12 +215,20 @@ private:
   HypothesisStackCubePruning &m_stack;
   HypothesisSet m_hypotheses;
   BackwardsEdgeSet m_edges;
+  // Expanded hypotheses are queued either by pointer in m_queue or, if
+  // m_useFlatQueue, by value in the binary heap m_flatQueue. The heap is
+  // kept with the same algorithm as std::priority_queue, so both pop in
+  // the same order.
+  bool m_useFlatQueue;
   HypothesisQueue m_queue;
+  HypothesisFlatQueue m_flatQueue;
   size_t m_numStackInsertions;
 
   // We always require a corresponding bitmap to be supplied.
   BitmapContainer();
   BitmapContainer(const BitmapContainer &);
+
+  void ProcessQueueItem(const HypothesisQueueItem &item);
 public:
   BitmapContainer(const WordsBitmap &bitmap
                   , HypothesisStackCubePruning &stack);
@@ -221,8 +238,7 @@ public:
   ~BitmapContainer();
 
   void Enqueue(int hypothesis_pos, int translation_pos, Hypothesis *hypothesis, BackwardsEdge *edge);
-  HypothesisQueueItem *Dequeue(bool keepValue=false);
-  HypothesisQueueItem *Top() const;
+  const HypothesisQueueItem *Top() const;
   size_t Size();
   bool Empty() const;
 
@@ -230,6 +246,9 @@ public:
   const HypothesisSet &GetHypotheses() const;
   size_t GetHypothesesSize() const;
   const BackwardsEdgeSet &GetBackwardsEdges();
+  bool UsesFlatQueue() const {
+    return m_useFlatQueue;
+  }
 
   void InitializeEdges();
   void ProcessBestHypothesis();
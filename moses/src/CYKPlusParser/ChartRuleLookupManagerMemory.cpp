@@ -27,6 +27,9 @@
 #include "StaticData.h"
 #include "NonTerminal.h"
 #include "ChartCellCollection.h"
+#include "Terminal.h"
+
+#include <boost/unordered_set.hpp>
 
 namespace Moses
 {
@@ -42,18 +45,22 @@ ChartRuleLookupManagerMemory::ChartRuleLookupManagerMemory(
   size_t sourceSize = src.GetSize();
   m_dottedRuleColls.resize(sourceSize);
 
+  boost::unordered_set<Word, TerminalHasher, TerminalEqualityPred> vocab;
+  for (size_t pos = 0; pos < sourceSize; ++pos) {
+    const Word &word = src.GetWord(pos);
+    if (vocab.insert(word).second) {
+      m_sentenceVocab.push_back(word);
+    }
+  }
+
   const PhraseDictionaryNodeSCFG &rootNode = m_ruleTable.GetRootNode();
+  const bool rootExtendable = IsExtendable(rootNode);
 
   for (size_t ind = 0; ind < m_dottedRuleColls.size(); ++ind) {
-#ifdef USE_BOOST_POOL
-    DottedRuleInMemory *initDottedRule = m_dottedRulePool.malloc();
-    new (initDottedRule) DottedRuleInMemory(rootNode);
-#else
-    DottedRuleInMemory *initDottedRule = new DottedRuleInMemory(rootNode);
-#endif
+    DottedRuleInMemory *initDottedRule = m_dottedRuleArena.Create(rootNode);
 
     DottedRuleColl *dottedRuleColl = new DottedRuleColl(sourceSize - ind + 1);
-    dottedRuleColl->Add(0, initDottedRule); // init rule. stores the top node in tree
+    dottedRuleColl->Add(0, initDottedRule, rootExtendable); // init rule. stores the top node in tree
 
     m_dottedRuleColls[ind] = dottedRuleColl;
   }
@@ -100,18 +107,12 @@ void ChartRuleLookupManagerMemory::GetChartRuleCollection(
       const PhraseDictionaryNodeSCFG *node = prevDottedRule.GetLastNode().GetChild(sourceWord);
 
       // if we found a new rule -> create it and add it to the list
-      if (node != NULL) {
+      if (node != NULL && IsUseful(*node)) {
 				// create the rule
-#ifdef USE_BOOST_POOL
-        DottedRuleInMemory *dottedRule = m_dottedRulePool.malloc();
-        new (dottedRule) DottedRuleInMemory(*node, sourceWordLabel,
-                                            prevDottedRule);
-#else
-        DottedRuleInMemory *dottedRule = new DottedRuleInMemory(*node,
-                                                                sourceWordLabel,
-                                                                prevDottedRule);
-#endif
-        dottedRuleCol.Add(relEndPos+1, dottedRule);
+        DottedRuleInMemory *dottedRule = m_dottedRuleArena.Create(*node,
+                                                                  sourceWordLabel,
+                                                                  prevDottedRule);
+        dottedRuleCol.Add(relEndPos+1, dottedRule, IsExtendable(*node));
       }
     }
 
@@ -228,20 +229,15 @@ void ChartRuleLookupManagerMemory::ExtendPartialRuleApplication(
         const PhraseDictionaryNodeSCFG * child =
           node.GetChild(sourceNonTerm, cellLabel.GetLabel());
 
-        // nothing found? then we are done
-        if (child == NULL) {
+        // nothing found, or nothing this sentence can use? then we are done
+        if (child == NULL || !IsUseful(*child)) {
           continue;
         }
 
         // create new rule
-#ifdef USE_BOOST_POOL
-        DottedRuleInMemory *rule = m_dottedRulePool.malloc();
-        new (rule) DottedRuleInMemory(*child, cellLabel, prevDottedRule);
-#else
-        DottedRuleInMemory *rule = new DottedRuleInMemory(*child, cellLabel,
-                                                          prevDottedRule);
-#endif
-        dottedRuleColl.Add(stackInd, rule);
+        DottedRuleInMemory *rule = m_dottedRuleArena.Create(*child, cellLabel,
+                                                            prevDottedRule);
+        dottedRuleColl.Add(stackInd, rule, IsExtendable(*child));
       }
     }
   } 
@@ -266,16 +262,41 @@ void ChartRuleLookupManagerMemory::ExtendPartialRuleApplication(
 
       // create new rule
       const PhraseDictionaryNodeSCFG &child = p->second;
-#ifdef USE_BOOST_POOL
-      DottedRuleInMemory *rule = m_dottedRulePool.malloc();
-      new (rule) DottedRuleInMemory(child, *cellLabel, prevDottedRule);
-#else
-      DottedRuleInMemory *rule = new DottedRuleInMemory(child, *cellLabel,
-                                                        prevDottedRule);
-#endif
-      dottedRuleColl.Add(stackInd, rule);
+      if (!IsUseful(child)) {
+        continue;
+      }
+      DottedRuleInMemory *rule = m_dottedRuleArena.Create(child, *cellLabel,
+                                                          prevDottedRule);
+      dottedRuleColl.Add(stackInd, rule, IsExtendable(child));
     }
   }
 }
 
+bool ChartRuleLookupManagerMemory::IsExtendable(
+  const PhraseDictionaryNodeSCFG &node)
+{
+  boost::unordered_map<const PhraseDictionaryNodeSCFG*, bool>::const_iterator
+    iter = m_extendable.find(&node);
+  if (iter != m_extendable.end()) {
+    return iter->second;
+  }
+
+  // any non-terminal could be matched.  Terminals must occur in the sentence
+  bool extendable = false;
+  const PhraseDictionaryNodeSCFG::NonTerminalMap &nonTermMap =
+    node.GetNonTerminalMap();
+  PhraseDictionaryNodeSCFG::NonTerminalMap::const_iterator p;
+  for (p = nonTermMap.begin(); p != nonTermMap.end() && !extendable; ++p) {
+    extendable = IsUseful(p->second);
+  }
+  std::vector<Word>::const_iterator q;
+  for (q = m_sentenceVocab.begin(); q != m_sentenceVocab.end() && !extendable; ++q) {
+    const PhraseDictionaryNodeSCFG *child = node.GetChild(*q);
+    extendable = (child != NULL && IsUseful(*child));
+  }
+
+  m_extendable[&node] = extendable;
+  return extendable;
+}
+
 }  // namespace Moses
@@ -23,9 +23,7 @@
 
 #include <vector>
 
-#ifdef USE_BOOST_POOL
-#include <boost/pool/object_pool.hpp>
-#endif
+#include <boost/unordered_map.hpp>
 
 #include "ChartRuleLookupManagerCYKPlus.h"
 #include "DotChartInMemory.h"
@@ -63,14 +61,25 @@ class ChartRuleLookupManagerMemory : public ChartRuleLookupManagerCYKPlus
     size_t stackInd,
     DottedRuleColl &dottedRuleColl);
 
+  // Whether a rule could still be extended to a rule application using only
+  // words of this sentence.  Answers are cached, so that the rule table's
+  // subtrees that need other words are each rejected once per sentence.
+  bool IsExtendable(const PhraseDictionaryNodeSCFG &node);
+
+  // Whether the node has translations or is extendable
+  bool IsUseful(const PhraseDictionaryNodeSCFG &node) {
+    return node.GetTargetPhraseCollection() != NULL || IsExtendable(node);
+  }
+
   std::vector<DottedRuleColl*> m_dottedRuleColls;
   const PhraseDictionarySCFG &m_ruleTable;
-#ifdef USE_BOOST_POOL
-  // Use an object pool to allocate the dotted rules for this sentence.  We
-  // allocate a lot of them and this has been seen to significantly improve
-  // performance, especially for multithreaded decoding.
-  boost::object_pool<DottedRuleInMemory> m_dottedRulePool;
-#endif
+  // The dotted rules for this sentence.  We allocate a lot of them, and
+  // allocating them in blocks significantly improves performance, especially
+  // for multithreaded decoding.
+  DottedRuleArena m_dottedRuleArena;
+  // distinct words of the sentence
+  std::vector<Word> m_sentenceVocab;
+  boost::unordered_map<const PhraseDictionaryNodeSCFG*, bool> m_extendable;
 };
 
 }  // namespace Moses
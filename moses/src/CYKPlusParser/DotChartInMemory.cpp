@@ -19,22 +19,14 @@
 
 #include "DotChartInMemory.h"
 
-#include "Util.h"
-
-#include <algorithm>
-
 namespace Moses
 {
 
-DottedRuleColl::~DottedRuleColl()
+DottedRuleArena::~DottedRuleArena()
 {
-#ifdef USE_BOOST_POOL
-  // Do nothing.  DottedRule objects are stored in object pools owned by
-  // the sentence-specific ChartRuleLookupManagers.
-#else
-  std::for_each(m_coll.begin(), m_coll.end(),
-                RemoveAllInColl<CollType::value_type>);
-#endif
+  for (size_t i = 0; i < m_blocks.size(); ++i) {
+    m_allocator.deallocate(m_blocks[i], BLOCK_SIZE);
+  }
 }
 
 }
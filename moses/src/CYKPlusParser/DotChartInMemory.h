@@ -23,6 +23,7 @@
 #include "RuleTable/PhraseDictionaryNodeSCFG.h"
 
 #include "util/check.hh"
+#include <memory>
 #include <vector>
 
 namespace Moses
@@ -52,6 +53,41 @@ class DottedRuleInMemory : public DottedRule
 
 typedef std::vector<const DottedRuleInMemory*> DottedRuleList;
 
+// Allocates the DottedRuleInMemory objects of one sentence in blocks, which
+// are all freed together when the arena is destroyed.  DottedRuleInMemory
+// has a trivial destructor, so the objects are never destroyed one by one.
+class DottedRuleArena
+{
+ public:
+  DottedRuleArena() : m_free(0) {}
+  ~DottedRuleArena();
+
+  DottedRuleInMemory *Create(const PhraseDictionaryNodeSCFG &node) {
+    return new (Allocate()) DottedRuleInMemory(node);
+  }
+
+  DottedRuleInMemory *Create(const PhraseDictionaryNodeSCFG &node,
+                             const ChartCellLabel &cellLabel,
+                             const DottedRuleInMemory &prev) {
+    return new (Allocate()) DottedRuleInMemory(node, cellLabel, prev);
+  }
+
+ private:
+  static const size_t BLOCK_SIZE = 1024;
+
+  void *Allocate() {
+    if (m_free == 0) {
+      m_blocks.push_back(m_allocator.allocate(BLOCK_SIZE));
+      m_free = BLOCK_SIZE;
+    }
+    return m_blocks.back() + (BLOCK_SIZE - m_free--);
+  }
+
+  std::allocator<DottedRuleInMemory> m_allocator;
+  std::vector<DottedRuleInMemory*> m_blocks;
+  size_t m_free;  // unused objects in the last block
+};
+
 // Collection of all in-memory DottedRules that share a common start point,
 // grouped by end point.  Additionally, maintains a list of all
 // DottedRules that could be expanded further, i.e. for which the
@@ -84,8 +120,6 @@ public:
     : m_coll(size)
   {}
 
-  ~DottedRuleColl();
-
   const DottedRuleList &Get(size_t pos) const {
     return m_coll[pos];
   }
@@ -93,18 +127,17 @@ public:
     return m_coll[pos];
   }
 
-  void Add(size_t pos, const DottedRuleInMemory *dottedRule) {
+  // expandable: whether the rule could still be extended in this sentence
+  void Add(size_t pos, const DottedRuleInMemory *dottedRule, bool expandable) {
     CHECK(dottedRule);
     m_coll[pos].push_back(dottedRule);
-    if (!dottedRule->GetLastNode().IsLeaf()) {
+    if (expandable) {
       m_expandableDottedRuleList.push_back(dottedRule);
     }
   }
 
   void Clear(size_t pos) {
-#ifdef USE_BOOST_POOL
     m_coll[pos].clear();
-#endif
   }
 
   const DottedRuleList &GetExpandableDottedRuleList() const {
@@ -31,6 +31,7 @@
 #include "ChartTranslationOption.h"
 #include "ChartTranslationOptionList.h"
 #include "ChartManager.h"
+#include "ChartCoarseChart.h"
 
 using namespace std;
 
@@ -38,6 +39,17 @@ namespace Moses
 {
 extern bool g_debug;
 
+namespace
+{
+struct SameLabel {
+  SameLabel(const Word &label) : m_label(label) {}
+  bool operator()(const Word *label) const {
+    return NonTerminalEqualityPred()(*label, m_label);
+  }
+  const Word &m_label;
+};
+}
+
 /** Constructor
  * \param startPos endPos range of this cell
  * \param manager pointer back to the manager 
@@ -86,12 +98,13 @@ void ChartCell::PruneToSize()
  *  (implementation of cube pruning)
  * \param transOptList list of applicable rules to create hypotheses for the cell
  * \param allChartCells entire chart - needed to look up underlying hypotheses
+ * \param popLimit maximum number of hypotheses to create
+ * \return number of hypotheses created
  */
-void ChartCell::ProcessSentence(const ChartTranslationOptionList &transOptList
-                                , const ChartCellCollection &allChartCells)
+size_t ChartCell::ProcessSentence(const ChartTranslationOptionList &transOptList
+                                  , const ChartCellCollection &allChartCells
+                                  , size_t popLimit)
 {
-  const StaticData &staticData = StaticData::Instance();
-
   // priority queue for applicable rules with selected hypotheses
   RuleCubeQueue queue(m_manager);
 
@@ -103,18 +116,73 @@ void ChartCell::ProcessSentence(const ChartTranslationOptionList &transOptList
   }
 
   // pluck things out of queue and add to hypo collection
-  const size_t popLimit = staticData.GetCubePruningPopLimit();
-  for (size_t numPops = 0; numPops < popLimit && !queue.IsEmpty(); ++numPops) 
+  size_t numPops;
+  for (numPops = 0; numPops < popLimit && !queue.IsEmpty(); ++numPops) 
   {
     ChartHypothesis *hypo = queue.Pop();
     AddHypothesis(hypo);
   }
+  return numPops;
+}
+
+/** Coarse pass of coarse-to-fine decoding: for each rule, the best
+ *  translation of each target label, scored without the language model
+ *  across non-terminals. Hypotheses of a label then all recombine, leaving
+ *  the best one. The rules and the hypotheses they created are recorded
+ *  in coarseChart.
+ */
+void ChartCell::ProcessSentenceCoarse(const ChartTranslationOptionList &transOptList
+                                      , const ChartCellCollection &allChartCells
+                                      , ChartCoarseChart &coarseChart)
+{
+  coarseChart.BeginCell();
+  std::vector<const Word*> labels;
+  for (size_t i = 0; i < transOptList.GetSize(); ++i) {
+    const ChartTranslationOption &transOpt = transOptList.Get(i);
+    const size_t rule = coarseChart.AddRule(transOpt);
+
+    // target phrases are sorted by score, so the first of each label is
+    // its best
+    labels.clear();
+    RuleCubeItem *item = new RuleCubeItem(transOpt, allChartCells);
+    for (;;) {
+      const Word &targetLHS = item->GetTranslationDimension().GetTargetPhrase()->GetTargetLHS();
+      if (std::find_if(labels.begin(), labels.end(), SameLabel(targetLHS)) == labels.end()) {
+        labels.push_back(&targetLHS);
+        ChartHypothesis *hypo = new ChartHypothesis(transOpt, *item, m_manager);
+        hypo->CalcCoarseScore();
+        coarseChart.AddEdge(rule, m_hypoColl[targetLHS].GetSortedHypotheses(),
+                            hypo->GetTotalScore());
+        AddHypothesis(hypo);
+      }
+      if (!item->GetTranslationDimension().HasMoreTranslations()) {
+        break;
+      }
+      RuleCubeItem *next = new RuleCubeItem(*item, -1);
+      delete item;
+      item = next;
+    }
+    delete item;
+  }
+}
+
+/** Delete the hypotheses of the cell so it can be decoded again. The
+ *  collection of each label stays, as do the labels, so that rules of
+ *  wider cells found with them still point at them.
+ */
+void ChartCell::ClearHypotheses()
+{
+  MapType::iterator iter;
+  for (iter = m_hypoColl.begin(); iter != m_hypoColl.end(); ++iter) {
+    iter->second.Clear();
+  }
 }
 
 //! call SortHypotheses() in each hypo collection in this cell
 void ChartCell::SortHypotheses()
 {
-  CHECK(m_targetLabelSet.Empty());
+  // the labels are only already set when the cell is decoded a second
+  // time, by coarse-to-fine decoding, and then point at the same collections
   MapType::iterator iter;
   for (iter = m_hypoColl.begin(); iter != m_hypoColl.end(); ++iter) {
     ChartHypothesisCollection &coll = iter->second;
@@ -132,7 +200,10 @@ const ChartHypothesis *ChartCell::GetBestHypothesis() const
   MapType::const_iterator iter;
   for (iter = m_hypoColl.begin(); iter != m_hypoColl.end(); ++iter) {
     const HypoList &sortedList = iter->second.GetSortedHypotheses();
-    CHECK(sortedList.size() > 0);
+    if (sortedList.empty()) {
+      // a label of the coarse pass that the full pass didn't reach
+      continue;
+    }
 
     const ChartHypothesis *hypo = sortedList[0];
     if (hypo->GetTotalScore() > bestScore) {
@@ -193,6 +264,15 @@ void ChartCell::GetSearchGraph(long translationId, std::ostream &outputSearchGra
   }
 }
 
+//! collect the search graph hypotheses of each hypo collection
+void ChartCell::GetSearchGraph(const std::map<unsigned, bool> &reachable, std::vector<const ChartHypothesis*> &searchGraph) const
+{
+  MapType::const_iterator iter;
+  for (iter = m_hypoColl.begin(); iter != m_hypoColl.end(); ++iter) {
+    iter->second.GetSearchGraph(reachable, searchGraph);
+  }
+}
+
 std::ostream& operator<<(std::ostream &out, const ChartCell &cell)
 {
   ChartCell::MapType::const_iterator iterOutside;
@@ -42,6 +42,7 @@ namespace Moses
 class ChartTranslationOptionList;
 class ChartCellCollection;
 class ChartManager;
+class ChartCoarseChart;
 
 /** 1 cell in chart decoder.
  *  Doesn't directly hold hypotheses. Each cell contain a map of ChartHypothesisCollection that have different constituent labels
@@ -75,8 +76,13 @@ public:
   ChartCell(size_t startPos, size_t endPos, ChartManager &manager);
   ~ChartCell();
 
-  void ProcessSentence(const ChartTranslationOptionList &transOptList
-                       ,const ChartCellCollection &allChartCells);
+  size_t ProcessSentence(const ChartTranslationOptionList &transOptList
+                         ,const ChartCellCollection &allChartCells
+                         ,size_t popLimit);
+  void ProcessSentenceCoarse(const ChartTranslationOptionList &transOptList
+                             ,const ChartCellCollection &allChartCells
+                             ,ChartCoarseChart &coarseChart);
+  void ClearHypotheses();
 
   //! Get all hypotheses in the cell that have the specified constituent label
   const HypoList *GetSortedHypotheses(const Word &constituentLabel) const
@@ -92,6 +98,11 @@ public:
 
   const ChartHypothesis *GetBestHypothesis() const;
 
+  //! the range of the source sentence this cell covers
+  const WordsRange &GetCoverage() const {
+    return m_coverage;
+  }
+
   //! @todo what is a m_sourceWordLabel?
   const ChartCellLabel &GetSourceWordLabel() const {
     CHECK(m_coverage.GetNumWordsCovered() == 1);
@@ -114,6 +125,7 @@ public:
   }
 
   void GetSearchGraph(long translationId, std::ostream &outputSearchGraphStream, const std::map<unsigned,bool> &reachable) const;
+  void GetSearchGraph(const std::map<unsigned,bool> &reachable, std::vector<const ChartHypothesis*> &searchGraph) const;
 
 };
 
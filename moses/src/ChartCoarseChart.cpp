@@ -0,0 +1,136 @@
+/***********************************************************************
+ Moses - statistical machine translation system
+ Copyright (C) 2006-2012 University of Edinburgh
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ ***********************************************************************/
+
+#include <algorithm>
+#include <limits>
+#include <boost/unordered_map.hpp>
+#include "ChartCoarseChart.h"
+#include "ChartCell.h"
+#include "ChartHypothesis.h"
+#include "ChartTranslationOption.h"
+#include "ChartTranslationOptionList.h"
+
+namespace Moses
+{
+
+size_t ChartCoarseChart::AddRule(const ChartTranslationOption &transOpt)
+{
+  Rule rule;
+  rule.targetPhraseCollection = &transOpt.GetTargetPhraseCollection();
+  rule.stackVec = transOpt.GetStackVec();
+  rule.keep = false;
+  m_rules.push_back(rule);
+  return m_rules.size() - 1;
+}
+
+void ChartCoarseChart::Prune(const ChartCell &topCell, float threshold)
+{
+  const float minusInfinity = -std::numeric_limits<float>::infinity();
+
+  // the outside score of each node, starting from the labels of the top
+  // cell, from which any derivation can be output
+  boost::unordered_map<const HypoList*, float> outside;
+  float best = minusInfinity;
+  const ChartCellLabelSet &topLabels = topCell.GetTargetLabelSet();
+  for (ChartCellLabelSet::const_iterator p = topLabels.begin();
+       p != topLabels.end(); ++p) {
+    const HypoList *stack = p->second.GetStack();
+    if (stack != NULL && !stack->empty()) {
+      outside[stack] = 0;
+      best = std::max(best, stack->front()->GetTotalScore());
+    }
+  }
+
+  if (best == minusInfinity) {
+    // no coarse derivation of the sentence. Leave the full pass its rules
+    for (size_t i = 0; i < m_rules.size(); ++i) {
+      m_rules[i].keep = true;
+    }
+    return;
+  }
+
+  // edges were added bottom-up, so going backwards each head's outside
+  // score is complete before it is passed on to the non-terminals
+  const float minScore = best - threshold;
+  for (std::vector<Edge>::const_reverse_iterator e = m_edges.rbegin();
+       e != m_edges.rend(); ++e) {
+    boost::unordered_map<const HypoList*, float>::const_iterator head =
+      outside.find(e->head);
+    if (head == outside.end()) {
+      continue;
+    }
+    const float score = head->second + e->score;
+    if (score < minScore) {
+      continue;
+    }
+
+    Rule &rule = m_rules[e->rule];
+    rule.keep = true;
+    for (StackVec::const_iterator p = rule.stackVec.begin();
+         p != rule.stackVec.end(); ++p) {
+      const HypoList *stack = *p;
+      const float childOutside = score - stack->front()->GetTotalScore();
+      std::pair<boost::unordered_map<const HypoList*, float>::iterator, bool> ret =
+        outside.insert(std::make_pair(stack, childOutside));
+      if (!ret.second && ret.first->second < childOutside) {
+        ret.first->second = childOutside;
+      }
+    }
+  }
+}
+
+size_t ChartCoarseChart::GetNumKept() const
+{
+  size_t ret = 0;
+  for (size_t i = 0; i < m_rules.size(); ++i) {
+    if (m_rules[i].keep) {
+      ++ret;
+    }
+  }
+  return ret;
+}
+
+void ChartCoarseChart::GetRules(size_t cell, const WordsRange &range,
+                                ChartTranslationOptionList &list) const
+{
+  list.Clear();
+  const size_t end = (cell + 1 < m_cellBegin.size()) ? m_cellBegin[cell + 1]
+                                                      : m_rules.size();
+  for (size_t i = m_cellBegin[cell]; i < end; ++i) {
+    const Rule &rule = m_rules[i];
+    if (!rule.keep) {
+      continue;
+    }
+    // the full pass may not have reached every label the coarse pass did
+    bool applicable = true;
+    for (StackVec::const_iterator p = rule.stackVec.begin();
+         p != rule.stackVec.end(); ++p) {
+      if ((*p)->empty()) {
+        applicable = false;
+        break;
+      }
+    }
+    if (applicable) {
+      list.Add(*rule.targetPhraseCollection, rule.stackVec, range);
+    }
+  }
+  list.ApplyThreshold();
+}
+
+}
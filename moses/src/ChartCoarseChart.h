@@ -0,0 +1,92 @@
+/***********************************************************************
+ Moses - statistical machine translation system
+ Copyright (C) 2006-2012 University of Edinburgh
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ ***********************************************************************/
+
+#pragma once
+
+#include <vector>
+#include "HypoList.h"
+#include "StackVec.h"
+
+namespace Moses
+{
+
+class ChartCell;
+class ChartTranslationOption;
+class ChartTranslationOptionList;
+class TargetPhraseCollection;
+class WordsRange;
+
+/** The rules applied by the coarse pass of coarse-to-fine chart decoding.
+ *  The coarse pass scores each rule with its own language model estimate
+ *  instead of the n-grams across its non-terminals, so the hypotheses of a
+ *  cell with the same label all recombine and the chart is a hypergraph
+ *  with one node per (cell, label).  Each derivation step is recorded as an
+ *  edge; Prune() then finds, by Viterbi outside scores, the best coarse
+ *  derivation of the sentence through each rule and keeps the rules within
+ *  a threshold of the best derivation overall for the full pass.
+ */
+class ChartCoarseChart
+{
+public:
+  ChartCoarseChart() {}
+
+  //! the following rules and edges belong to the next cell in decoding order
+  void BeginCell() { m_cellBegin.push_back(m_rules.size()); }
+
+  //! record a rule applied in the current cell, returning its index
+  size_t AddRule(const ChartTranslationOption &transOpt);
+
+  //! record that rule created a hypothesis in head with the given coarse score
+  void AddEdge(size_t rule, const HypoList &head, float score) {
+    Edge edge = { rule, &head, score };
+    m_edges.push_back(edge);
+  }
+
+  //! compute outside scores and mark the rules to keep
+  void Prune(const ChartCell &topCell, float threshold);
+
+  //! number of rules applied by the coarse pass, and how many of them were kept
+  size_t GetNumRules() const { return m_rules.size(); }
+  size_t GetNumKept() const;
+
+  /** fill list with the kept rules of the given cell, in decoding order, whose
+   *  non-terminals all have hypotheses in the full pass
+   */
+  void GetRules(size_t cell, const WordsRange &range,
+                ChartTranslationOptionList &list) const;
+
+private:
+  struct Rule {
+    const TargetPhraseCollection *targetPhraseCollection;
+    StackVec stackVec;
+    bool keep;
+  };
+
+  struct Edge {
+    size_t rule;
+    const HypoList *head;
+    float score; //! coarse inside score, including the non-terminals' best
+  };
+
+  std::vector<Rule> m_rules;
+  std::vector<Edge> m_edges;
+  std::vector<size_t> m_cellBegin; //! index of each cell's first rule
+};
+
+}
@@ -179,6 +179,20 @@ void ChartHypothesis::CalcScore()
   m_totalScore	= m_scoreBreakdown.GetWeightedScore();
 }
 
+/** score for the coarse pass of coarse-to-fine decoding: the estimated
+  * score of the rule, whose language model n-grams are scored on their own,
+  * plus the scores of the prev hypos. No feature function states are set,
+  * so all coarse hypotheses of a label recombine.
+  */
+void ChartHypothesis::CalcCoarseScore()
+{
+  m_totalScore = GetCurrTargetPhrase().GetFutureScore();
+  std::vector<const ChartHypothesis*>::iterator iter;
+  for (iter = m_prevHypos.begin(); iter != m_prevHypos.end(); ++iter) {
+    m_totalScore += (*iter)->GetTotalScore();
+  }
+}
+
 void ChartHypothesis::AddArc(ChartHypothesis *loserHypo)
 {
   if (!m_arcList) {
@@ -223,7 +237,7 @@ void ChartHypothesis::CleanupArcList()
    */
   const StaticData &staticData = StaticData::Instance();
   size_t nBestSize = staticData.GetNBestSize();
-  bool distinctNBest = staticData.GetDistinctNBest() || staticData.UseMBR() || staticData.GetOutputSearchGraph();
+  bool distinctNBest = staticData.GetDistinctNBest() || staticData.UseMBR() || staticData.GetOutputSearchGraph() || staticData.GetOutputSearchGraphBinary();
 
   if (!distinctNBest && m_arcList->size() > nBestSize) {
     // prune arc list only if there too many arcs
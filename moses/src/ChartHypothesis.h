@@ -127,6 +127,7 @@ public:
 	int RecombineCompare(const ChartHypothesis &compare) const;
 
   void CalcScore();
+  void CalcCoarseScore();
 
   void AddArc(ChartHypothesis *loserHypo);
   void CleanupArcList();
@@ -51,6 +51,19 @@ ChartHypothesisCollection::~ChartHypothesisCollection()
   //RemoveAllInColl(m_hypos);
 }
 
+//! delete all hypotheses, leaving the collection as newly created
+void ChartHypothesisCollection::Clear()
+{
+  HCType::iterator iter;
+  for (iter = m_hypos.begin() ; iter != m_hypos.end() ; ++iter) {
+    ChartHypothesis *hypo = *iter;
+    ChartHypothesis::Delete(hypo);
+  }
+  m_hypos.clear();
+  m_hyposOrdered.clear();
+  m_bestScore = -std::numeric_limits<float>::infinity();
+}
+
 /** public function to add hypothesis to this collection. 
  * Returns false if equiv hypo exists in collection, otherwise returns true.
  * Takes care of update arc list for n-best list creation.
@@ -305,6 +318,30 @@ void ChartHypothesisCollection::GetSearchGraph(long translationId, std::ostream
   }
 }
 
+//! the hypotheses written by GetSearchGraph() above, in the same order
+void ChartHypothesisCollection::GetSearchGraph(const std::map<unsigned, bool> &reachable, std::vector<const ChartHypothesis*> &searchGraph) const
+{
+  HCType::const_iterator iter;
+  for (iter = m_hypos.begin() ; iter != m_hypos.end() ; ++iter) {
+    const ChartHypothesis *mainHypo = *iter;
+    if (StaticData::Instance().GetUnprunedSearchGraph() ||
+        reachable.find(mainHypo->GetId()) != reachable.end()) {
+      searchGraph.push_back(mainHypo);
+    }
+
+    const ChartArcList *arcList = mainHypo->GetArcList();
+    if (arcList) {
+      ChartArcList::const_iterator iterArc;
+      for (iterArc = arcList->begin(); iterArc != arcList->end(); ++iterArc) {
+        const ChartHypothesis *arc = *iterArc;
+        if (reachable.find(arc->GetId()) != reachable.end()) {
+          searchGraph.push_back(arc);
+        }
+      }
+    }
+  }
+}
+
 std::ostream& operator<<(std::ostream &out, const ChartHypothesisCollection &coll)
 {
   HypoList::const_iterator iterInside;
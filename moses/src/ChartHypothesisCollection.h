@@ -98,6 +98,7 @@ public:
   void Remove(const HCType::iterator &iter);
 
   void PruneToSize(ChartManager &manager);
+  void Clear();
 
   size_t GetSize() const {
     return m_hypos.size();
@@ -118,6 +119,7 @@ public:
   float GetBestScore() const { return m_bestScore; }
 
   void GetSearchGraph(long translationId, std::ostream &outputSearchGraphStream, const std::map<unsigned,bool> &reachable) const;
+  void GetSearchGraph(const std::map<unsigned,bool> &reachable, std::vector<const ChartHypothesis*> &searchGraph) const;
 
 };
 
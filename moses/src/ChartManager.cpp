@@ -19,9 +19,13 @@
  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
  ***********************************************************************/
 
+#include <algorithm>
 #include <stdio.h>
+#include <sstream>
 #include "ChartManager.h"
+#include "BinarySearchGraph.h"
 #include "ChartCell.h"
+#include "ChartCoarseChart.h"
 #include "ChartHypothesis.h"
 #include "ChartTrellisDetourQueue.h"
 #include "ChartTrellisNode.h"
@@ -87,27 +91,53 @@ void ChartManager::ProcessSentence()
 
   AddXmlChartOptions();
 
-  // MAIN LOOP
   size_t size = m_source.GetSize();
+
+  // with coarse-to-fine decoding, a coarse pass first finds the rules worth
+  // decoding with the full model
+  const float coarseThreshold = StaticData::Instance().GetCubePruningCoarseThreshold();
+  std::auto_ptr<ChartCoarseChart> coarseChart;
+  if (coarseThreshold >= 0 && size > 0) {
+    coarseChart.reset(new ChartCoarseChart);
+    ProcessSentenceCoarse(*coarseChart, coarseThreshold);
+  }
+  ChartTranslationOptionList coarseRules(StaticData::Instance().GetRuleLimit());
+
+  // MAIN LOOP
+  const size_t popLimit = StaticData::Instance().GetCubePruningPopLimit();
+  size_t cellsLeft = size * (size + 1) / 2;
+  size_t cellIndex = 0;
   for (size_t width = 1; width <= size; ++width) {
     for (size_t startPos = 0; startPos <= size-width; ++startPos) {
       size_t endPos = startPos + width - 1;
       WordsRange range(startPos, endPos);
-
-      // create trans opt
-      m_transOptColl.CreateTranslationOptionsForRange(range);
-
-      // decode
       ChartCell &cell = m_hypoStackColl.Get(range);
 
-      cell.ProcessSentence(m_transOptColl.GetTranslationOptionList()
-                           ,m_hypoStackColl);
+      // create trans opt, or take those kept by the coarse pass
+      const ChartTranslationOptionList *transOptList;
+      if (coarseChart.get()) {
+        coarseChart->GetRules(cellIndex++, cell.GetCoverage(), coarseRules);
+        transOptList = &coarseRules;
+      } else {
+        m_transOptColl.CreateTranslationOptionsForRange(range);
+        transOptList = &m_transOptColl.GetTranslationOptionList();
+      }
+
+      // decode, with the pops narrowed to the time left if there is a
+      // deadline.  The cell still gets a few pops, since with a syntax
+      // grammar the best one may not have a label that can be used above it
+      const size_t cellPopLimit = std::max(m_deadline.BeginStep(popLimit, cellsLeft--),
+                                           std::min(popLimit, MIN_DEADLINE_STACK_SIZE));
+      const size_t numPops = cell.ProcessSentence(*transOptList
+                             ,m_hypoStackColl, cellPopLimit);
+      m_deadline.EndStep(numPops);
       m_transOptColl.Clear();
       cell.PruneToSize();
       cell.CleanupArcList();
       cell.SortHypotheses();
     }
   }
+  GetSentenceStats().SetDeadlineStats(m_deadline.GetNumNarrowed(), m_deadline.WasPassed());
 
   IFVERBOSE(1) {
 
@@ -130,6 +160,41 @@ void ChartManager::ProcessSentence()
   }
 }
 
+/** coarse pass of coarse-to-fine decoding. Looks up the rules of every
+ *  cell and decodes with the coarse model, recording the rules in
+ *  coarseChart and marking those that are part of a coarse derivation within
+ *  threshold of the best one. The chart is then emptied, keeping only its
+ *  labels, for the full pass.
+ */
+void ChartManager::ProcessSentenceCoarse(ChartCoarseChart &coarseChart, float threshold)
+{
+  size_t size = m_source.GetSize();
+  for (size_t width = 1; width <= size; ++width) {
+    for (size_t startPos = 0; startPos <= size-width; ++startPos) {
+      WordsRange range(startPos, startPos + width - 1);
+      m_transOptColl.CreateTranslationOptionsForRange(range);
+      ChartCell &cell = m_hypoStackColl.Get(range);
+      cell.ProcessSentenceCoarse(m_transOptColl.GetTranslationOptionList()
+                                 ,m_hypoStackColl, coarseChart);
+      m_transOptColl.Clear();
+      cell.PruneToSize();
+      cell.CleanupArcList();
+      cell.SortHypotheses();
+    }
+  }
+
+  coarseChart.Prune(m_hypoStackColl.Get(WordsRange(0, size-1)), threshold);
+  VERBOSE(2, "Coarse pass kept " << coarseChart.GetNumKept() << " of "
+          << coarseChart.GetNumRules() << " rules" << endl);
+
+  for (size_t width = 1; width <= size; ++width) {
+    for (size_t startPos = 0; startPos <= size-width; ++startPos) {
+      m_hypoStackColl.Get(WordsRange(startPos, startPos + width - 1)).ClearHypotheses();
+    }
+  }
+  AddXmlChartOptions();
+}
+
 /** add specific translation options and hypotheses according to the XML override translation scheme.
  *  Doesn't seem to do anything about walls and zones.
  *  @todo check walls & zones. Check that the implementation doesn't leak, xml options sometimes does if you're not careful
@@ -285,6 +350,61 @@ void ChartManager::GetSearchGraph(long translationId, std::ostream &outputSearch
   }
 }
 
+//! the same hypotheses as GetSearchGraph(), as one binary record
+void ChartManager::OutputSearchGraphBinary(long translationId, std::ostream &outputSearchGraphStream) const
+{
+  BinarySearchGraphWriter writer(BinarySearchGraphHeader::Chart, translationId);
+  size_t size = m_source.GetSize();
+  const ChartHypothesis *bestHypo = (size == 0) ? NULL
+                                    : m_hypoStackColl.Get(WordsRange(0, size-1)).GetBestHypothesis();
+  if (bestHypo == NULL) {
+    // no hypothesis. Still write the sentence, so that there is one for each
+    writer.Write(outputSearchGraphStream);
+    return;
+  }
+
+  std::map<unsigned,bool> reachable;
+  FindReachableHypotheses(bestHypo, reachable);
+  std::vector<const ChartHypothesis*> searchGraph;
+  for (size_t width = 1; width <= size; ++width) {
+    for (size_t startPos = 0; startPos <= size-width; ++startPos) {
+      WordsRange range(startPos, startPos + width - 1);
+      m_hypoStackColl.Get(range).GetSearchGraph(reachable, searchGraph);
+    }
+  }
+
+  BinarySearchGraphNode node;
+  for (size_t i = 0; i < searchGraph.size(); ++i) {
+    const ChartHypothesis &hypo = *searchGraph[i];
+    node.id = hypo.GetId();
+    const ChartHypothesis *winner = hypo.GetWinningHypothesis();
+    node.winner = (winner != NULL && winner != &hypo) ? winner->GetId() : -1;
+    node.back.clear();
+    const std::vector<const ChartHypothesis*> &prevHypos = hypo.GetPrevHypos();
+    for (size_t j = 0; j < prevHypos.size(); ++j) {
+      node.back.push_back(prevHypos[j]->GetId());
+    }
+    node.startPos = hypo.GetCurrSourceRange().GetStartPos();
+    node.endPos = hypo.GetCurrSourceRange().GetEndPos();
+    node.score = hypo.GetTotalScore();
+    const ScoreComponentCollection &scoreBreakdown = hypo.GetScoreBreakdown();
+    node.scores.resize(scoreBreakdown.size());
+    for (size_t j = 0; j < scoreBreakdown.size(); ++j) {
+      node.scores[j] = scoreBreakdown[j];
+    }
+
+    // the target phrase as printed in the text search graph
+    const TargetPhrase *targetPhrase = &hypo.GetCurrTargetPhrase();
+    if (!writer.FindRule(targetPhrase, node.rule)) {
+      std::ostringstream target;
+      target << *targetPhrase;
+      node.rule = writer.AddRule(targetPhrase, "", target.str());
+    }
+    writer.AddNode(node);
+  }
+  writer.Write(outputSearchGraphStream);
+}
+
 void ChartManager::FindReachableHypotheses( const ChartHypothesis *hypo, std::map<unsigned,bool> &reachable ) const
 {
 	// do not recurse, if already visited
@@ -30,12 +30,14 @@
 #include "SentenceStats.h"
 #include "TranslationSystem.h"
 #include "ChartRuleLookupManager.h"
+#include "Deadline.h"
 
 #include <boost/shared_ptr.hpp>
 
 namespace Moses
 {
 
+class ChartCoarseChart;
 class ChartHypothesis;
 class ChartTrellisDetourQueue;
 class ChartTrellisNode;
@@ -54,6 +56,8 @@ private:
                                  const ChartTrellisNode &,
                                  ChartTrellisDetourQueue &);
 
+  void ProcessSentenceCoarse(ChartCoarseChart &coarseChart, float threshold);
+
   InputType const& m_source; /**< source sentence to be translated */
   ChartCellCollection m_hypoStackColl;
   ChartTranslationOptionCollection m_transOptColl; /**< pre-computed list of translation options for the phrases in this sentence */
@@ -62,6 +66,7 @@ private:
   clock_t m_start; /**< starting time, used for logging */
   std::vector<ChartRuleLookupManager*> m_ruleLookupManagers;
   unsigned m_hypothesisId; /* For handing out hypothesis ids to ChartHypothesis */
+  Deadline m_deadline; /**< time allowed for this sentence */
 
 public:
   ChartManager(InputType const& source, const TranslationSystem* system);
@@ -72,6 +77,7 @@ public:
   void CalcNBest(size_t count, ChartTrellisPathList &ret, bool onlyDistinct=0) const;
 
   void GetSearchGraph(long translationId, std::ostream &outputSearchGraphStream) const;
+  void OutputSearchGraphBinary(long translationId, std::ostream &outputSearchGraphStream) const;
 	void FindReachableHypotheses( const ChartHypothesis *hypo, std::map<unsigned,bool> &reachable ) const; /* auxilliary function for GetSearchGraph */
 
   //! the input sentence being decoded
@@ -0,0 +1,98 @@
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2012 University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#pragma once
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+namespace Moses
+{
+
+/** On-disk layout of the compact phrase table (phrase table type 12, built
+ * by misc/processPhraseTableCompact).
+ *
+ * Source phrases are keyed by a minimal perfect hash.  Each hash slot holds
+ * a 32-bit fingerprint of its source phrase (to reject phrases that are not
+ * in the table) and the byte offset of its entry in the blob.  An entry is
+ * a varint-coded list of target candidates:
+ *
+ *   numCandidates
+ *   per candidate: numWords wordId* scoreCode[numScores] (numPoints (s t)*)?
+ *
+ * Target words are IDs into a shared vocabulary ordered by decreasing
+ * frequency, so frequent words get one-byte codes.  Each score is a one-byte
+ * index into a per-component codebook of 256 probabilities.  Alignment
+ * points are only present if the header's hasAlignment flag is set.
+ */
+namespace CompactPT
+{
+
+const char kMagic[8] = {'M', 'o', 's', 'e', 's', 'C', 'P', 'T'};
+const uint32_t kVersion = 1;
+const size_t kCodebookSize = 256;
+
+struct Header {
+  char magic[8];
+  uint32_t version;
+  uint32_t numScores;
+  uint32_t hasAlignment;
+  uint32_t padding;
+
+  uint64_t numSources;
+  uint64_t numBuckets;
+  uint64_t bucketOffset;       // numBuckets MinimalPerfectHash::Displacement
+  uint64_t fingerprintOffset;  // numSources uint32_t
+  uint64_t entryOffset;        // numSources uint64_t offsets into the blob
+
+  uint64_t vocabSize;
+  uint64_t vocabIndexOffset;   // (vocabSize+1) uint64_t string offsets
+  uint64_t vocabStringOffset;
+
+  uint64_t codebookOffset;     // numScores * kCodebookSize floats
+  uint64_t blobOffset;
+  uint64_t blobSize;
+};
+
+inline void EncodeVarint(uint64_t value, std::string &out)
+{
+  while (value >= 0x80) {
+    out += static_cast<char>((value & 0x7F) | 0x80);
+    value >>= 7;
+  }
+  out += static_cast<char>(value);
+}
+
+inline uint64_t DecodeVarint(const unsigned char *&p)
+{
+  uint64_t value = 0;
+  unsigned shift = 0;
+  while (*p & 0x80) {
+    value |= static_cast<uint64_t>(*p++ & 0x7F) << shift;
+    shift += 7;
+  }
+  value |= static_cast<uint64_t>(*p++) << shift;
+  return value;
+}
+
+}  // namespace CompactPT
+
+}  // namespace Moses
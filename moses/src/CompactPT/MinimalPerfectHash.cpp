@@ -0,0 +1,123 @@
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2012 University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#include "CompactPT/MinimalPerfectHash.h"
+
+#include "util/murmur_hash.hh"
+
+#include <algorithm>
+#include <utility>
+
+namespace Moses
+{
+
+namespace
+{
+
+struct BucketSizeGreater {
+  bool operator()(const std::vector<size_t> *a,
+                  const std::vector<size_t> *b) const {
+    return a->size() > b->size();
+  }
+};
+
+}  // namespace
+
+MinimalPerfectHash::KeyHash MinimalPerfectHash::Hash(const void *data,
+                                                     size_t len)
+{
+  KeyHash key;
+  key.h1 = util::MurmurHash64A(data, len, 1);
+  key.h2 = util::MurmurHash64A(data, len, 2);
+  key.fingerprint = static_cast<uint32_t>(util::MurmurHash64A(data, len, 3));
+  return key;
+}
+
+bool MinimalPerfectHash::Build(const std::vector<KeyHash> &keys,
+                               std::vector<Displacement> &buckets)
+{
+  const uint64_t numKeys = keys.size();
+  const uint64_t numBuckets = NumBuckets(numKeys);
+  Displacement zero = {0, 0};
+  buckets.assign(numBuckets, zero);
+  if (numKeys == 0) {
+    return true;
+  }
+
+  std::vector<std::vector<size_t> > members(numBuckets);
+  for (size_t i = 0; i < keys.size(); ++i) {
+    members[keys[i].h1 % numBuckets].push_back(i);
+  }
+  std::vector<const std::vector<size_t> *> order;
+  order.reserve(numBuckets);
+  for (size_t i = 0; i < members.size(); ++i) {
+    if (!members[i].empty()) {
+      order.push_back(&members[i]);
+    }
+  }
+  std::stable_sort(order.begin(), order.end(), BucketSizeGreater());
+
+  std::vector<bool> taken(numKeys, false);
+  std::vector<uint64_t> positions;
+  for (size_t b = 0; b < order.size(); ++b) {
+    const std::vector<size_t> &bucket = *order[b];
+    const uint64_t bucketId = keys[bucket[0]].h1 % numBuckets;
+
+    // Keys with the same (f1, f2) can never be separated.
+    for (size_t i = 0; i < bucket.size(); ++i) {
+      for (size_t j = i+1; j < bucket.size(); ++j) {
+        if (Position(keys[bucket[i]], 0, 0, numKeys) ==
+            Position(keys[bucket[j]], 0, 0, numKeys) &&
+            Position(keys[bucket[i]], 1, 0, numKeys) ==
+            Position(keys[bucket[j]], 1, 0, numKeys)) {
+          return false;
+        }
+      }
+    }
+
+    bool placed = false;
+    for (uint64_t d0 = 0; d0 < numKeys && !placed; ++d0) {
+      for (uint64_t d1 = 0; d1 < numKeys && !placed; ++d1) {
+        positions.clear();
+        bool ok = true;
+        for (size_t i = 0; i < bucket.size() && ok; ++i) {
+          const uint64_t pos = Position(keys[bucket[i]], d0, d1, numKeys);
+          ok = !taken[pos] &&
+               std::find(positions.begin(), positions.end(), pos) ==
+               positions.end();
+          positions.push_back(pos);
+        }
+        if (ok) {
+          for (size_t i = 0; i < positions.size(); ++i) {
+            taken[positions[i]] = true;
+          }
+          buckets[bucketId].d0 = d0;
+          buckets[bucketId].d1 = d1;
+          placed = true;
+        }
+      }
+    }
+    if (!placed) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace Moses
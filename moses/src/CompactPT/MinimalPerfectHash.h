@@ -0,0 +1,84 @@
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2012 University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#pragma once
+
+#include <stdint.h>
+
+#include <cstddef>
+#include <vector>
+
+namespace Moses
+{
+
+/** Minimal perfect hash in the "hash, displace" style: keys are split into
+ * small buckets and each bucket stores a displacement pair that places all
+ * of its keys on distinct slots in [0, numKeys).  The largest buckets are
+ * placed first, while the table is still mostly empty.
+ *
+ * A key that was not in the build set maps to an arbitrary slot, so callers
+ * must store and compare a fingerprint (KeyHash::fingerprint) per slot.
+ */
+class MinimalPerfectHash
+{
+public:
+  struct KeyHash {
+    uint64_t h1;
+    uint64_t h2;
+    uint32_t fingerprint;
+  };
+
+  struct Displacement {
+    uint32_t d0;
+    uint32_t d1;
+  };
+
+  //! average number of keys per bucket
+  static const size_t kKeysPerBucket = 4;
+
+  static KeyHash Hash(const void *data, size_t len);
+
+  static uint64_t NumBuckets(uint64_t numKeys) {
+    return numKeys / kKeysPerBucket + 1;
+  }
+
+  /** Compute one displacement per bucket for the given keys.  Returns false
+   * if two keys have identical hashes (e.g. duplicate keys).
+   */
+  static bool Build(const std::vector<KeyHash> &keys,
+                    std::vector<Displacement> &buckets);
+
+  static uint64_t Slot(const KeyHash &key,
+                       const Displacement *buckets,
+                       uint64_t numBuckets,
+                       uint64_t numKeys) {
+    const Displacement &d = buckets[key.h1 % numBuckets];
+    return Position(key, d.d0, d.d1, numKeys);
+  }
+
+private:
+  static uint64_t Position(const KeyHash &key, uint64_t d0, uint64_t d1,
+                           uint64_t numKeys) {
+    const uint64_t f1 = key.h2 % numKeys;
+    const uint64_t f2 = (key.h1 >> 32) % numKeys;
+    return (f1 + (d0 * f2) % numKeys + d1) % numKeys;
+  }
+};
+
+}  // namespace Moses
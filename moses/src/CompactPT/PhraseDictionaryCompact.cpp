@@ -0,0 +1,215 @@
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2012 University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#include "CompactPT/PhraseDictionaryCompact.h"
+
+#include "FactorCollection.h"
+#include "StaticData.h"
+#include "TargetPhrase.h"
+#include "TargetPhraseCollection.h"
+#include "UserMessage.h"
+#include "Util.h"
+
+#include "util/file.hh"
+#include "util/mmap.hh"
+
+#include <cstring>
+#include <set>
+#include <sstream>
+
+namespace Moses
+{
+
+PhraseDictionaryCompact::~PhraseDictionaryCompact()
+{
+  CleanUp();
+}
+
+bool PhraseDictionaryCompact::Load(const std::vector<FactorType> &input
+                                   , const std::vector<FactorType> &output
+                                   , const std::string &filePath
+                                   , const std::vector<float> &weight
+                                   , size_t tableLimit
+                                   , const LMList &languageModels
+                                   , float weightWP)
+{
+  m_input = input;
+  m_output = output;
+  m_weight = weight;
+  m_weightWP = weightWP;
+  m_languageModels = &languageModels;
+  m_tableLimit = tableLimit;
+
+  util::scoped_fd file(util::OpenReadOrThrow(filePath.c_str()));
+  const uint64_t size = util::SizeFile(file.get());
+  if (size < sizeof(CompactPT::Header)) {
+    UserMessage::Add("Compact phrase table is truncated: " + filePath);
+    return false;
+  }
+  util::MapRead(util::LAZY, file.get(), 0, size, m_memory);
+  m_header = Section<CompactPT::Header>(0);
+
+  if (std::memcmp(m_header->magic, CompactPT::kMagic,
+                  sizeof(CompactPT::kMagic)) != 0) {
+    UserMessage::Add("Not a compact phrase table: " + filePath);
+    return false;
+  }
+  if (m_header->version != CompactPT::kVersion) {
+    std::stringstream strme;
+    strme << "Unsupported compact phrase table version: " << m_header->version;
+    UserMessage::Add(strme.str());
+    return false;
+  }
+  if (m_header->numScores != weight.size()) {
+    std::stringstream strme;
+    strme << "Size of scoreVector != number (" << m_header->numScores << "!="
+          << weight.size() << ") of score components in " << filePath;
+    UserMessage::Add(strme.str());
+    return false;
+  }
+  return true;
+}
+
+const unsigned char *PhraseDictionaryCompact::FindEntry(const std::string &key) const
+{
+  if (m_header->numSources == 0) {
+    return NULL;
+  }
+  const MinimalPerfectHash::KeyHash hash =
+    MinimalPerfectHash::Hash(key.data(), key.size());
+  const uint64_t slot = MinimalPerfectHash::Slot(
+                          hash,
+                          Section<MinimalPerfectHash::Displacement>(m_header->bucketOffset),
+                          m_header->numBuckets,
+                          m_header->numSources);
+  if (Section<uint32_t>(m_header->fingerprintOffset)[slot] != hash.fingerprint) {
+    return NULL;
+  }
+  const uint64_t offset = Section<uint64_t>(m_header->entryOffset)[slot];
+  return Section<unsigned char>(m_header->blobOffset) + offset;
+}
+
+const Word &PhraseDictionaryCompact::GetTargetWord(uint64_t id) const
+{
+  std::map<uint64_t, Word>::iterator iter = m_wordCache.find(id);
+  if (iter != m_wordCache.end()) {
+    return iter->second;
+  }
+
+  const uint64_t *index = Section<uint64_t>(m_header->vocabIndexOffset);
+  const char *strings = Section<char>(m_header->vocabStringOffset);
+  const std::string str(strings + index[id], index[id+1] - index[id]);
+
+  FactorCollection &factorCollection = FactorCollection::Instance();
+  std::vector<std::string> factors =
+    TokenizeMultiCharSeparator(str, StaticData::Instance().GetFactorDelimiter());
+  CHECK(factors.size() == m_output.size());
+  Word &word = m_wordCache[id];
+  for (size_t i = 0; i < m_output.size(); ++i) {
+    word[m_output[i]] = factorCollection.AddFactor(Output, m_output[i], factors[i]);
+  }
+  return word;
+}
+
+TargetPhraseCollection *PhraseDictionaryCompact::DecodeEntry(
+  const unsigned char *p, const Phrase &source) const
+{
+  const float *codebook = Section<float>(m_header->codebookOffset);
+  const size_t numScores = m_header->numScores;
+  std::vector<float> scoreVector(numScores);
+  std::set<std::pair<size_t, size_t> > alignmentInfo;
+
+  TargetPhraseCollection *ret = new TargetPhraseCollection();
+  const uint64_t numCandidates = CompactPT::DecodeVarint(p);
+  for (uint64_t i = 0; i < numCandidates; ++i) {
+    TargetPhrase *targetPhrase = new TargetPhrase(Output);
+
+    const uint64_t numWords = CompactPT::DecodeVarint(p);
+    for (uint64_t j = 0; j < numWords; ++j) {
+      targetPhrase->AddWord(GetTargetWord(CompactPT::DecodeVarint(p)));
+    }
+
+    for (size_t j = 0; j < numScores; ++j) {
+      const float score = codebook[j * CompactPT::kCodebookSize + *p++];
+      scoreVector[j] = FloorScore(TransformScore(score));
+    }
+
+    if (m_header->hasAlignment) {
+      alignmentInfo.clear();
+      const uint64_t numPoints = CompactPT::DecodeVarint(p);
+      for (uint64_t j = 0; j < numPoints; ++j) {
+        const size_t sourcePos = CompactPT::DecodeVarint(p);
+        const size_t targetPos = CompactPT::DecodeVarint(p);
+        alignmentInfo.insert(std::make_pair(sourcePos, targetPos));
+      }
+      targetPhrase->SetAlignmentInfo(alignmentInfo);
+    }
+
+    targetPhrase->SetScore(m_feature, scoreVector, m_weight, m_weightWP,
+                           *m_languageModels);
+    targetPhrase->SetSourcePhrase(&source);
+    ret->Add(targetPhrase);
+  }
+
+  ret->Prune(m_tableLimit > 0, m_tableLimit);
+  return ret;
+}
+
+const TargetPhraseCollection *PhraseDictionaryCompact::GetTargetPhraseCollection(
+  const Phrase &source) const
+{
+  if (source.GetSize() == 0) {
+    return NULL;
+  }
+
+  std::pair<Cache::iterator, bool> piter =
+    m_cache.insert(std::make_pair(source, static_cast<const TargetPhraseCollection *>(NULL)));
+  if (!piter.second) {
+    return piter.first->second;
+  }
+
+  std::string key;
+  for (size_t i = 0; i < source.GetSize(); ++i) {
+    if (i) {
+      key += ' ';
+    }
+    key += source.GetWord(i).GetString(m_input, false);
+  }
+
+  const unsigned char *entry = FindEntry(key);
+  if (entry) {
+    piter.first->second = DecodeEntry(entry, piter.first->first);
+  }
+  return piter.first->second;
+}
+
+void PhraseDictionaryCompact::InitializeForInput(const InputType & /* source */)
+{
+  CleanUp();
+}
+
+void PhraseDictionaryCompact::CleanUp()
+{
+  for (Cache::iterator iter = m_cache.begin(); iter != m_cache.end(); ++iter) {
+    delete iter->second;
+  }
+  m_cache.clear();
+}
+
+}  // namespace Moses
@@ -0,0 +1,100 @@
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2012 University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#pragma once
+
+#include "CompactPT/Format.h"
+#include "CompactPT/MinimalPerfectHash.h"
+#include "Phrase.h"
+#include "PhraseDictionary.h"
+#include "TypeDef.h"
+
+#include "util/mmap.hh"
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace Moses
+{
+
+class LMList;
+
+/** Phrase table backed by a memory-mapped compact file (see CompactPT/Format.h).
+ * Target phrases are decoded from the mapped file on demand and cached until
+ * the next sentence.  The mapping is shared between threads by the OS; the
+ * decoded cache is not, so this dictionary is loaded once per thread.
+ */
+class PhraseDictionaryCompact : public PhraseDictionary
+{
+public:
+  PhraseDictionaryCompact(size_t numScoreComponent,
+                          PhraseDictionaryFeature *feature)
+    : PhraseDictionary(numScoreComponent, feature)
+    , m_header(NULL)
+    , m_weightWP(0)
+    , m_languageModels(NULL) {}
+
+  ~PhraseDictionaryCompact();
+
+  bool Load(const std::vector<FactorType> &input
+            , const std::vector<FactorType> &output
+            , const std::string &filePath
+            , const std::vector<float> &weight
+            , size_t tableLimit
+            , const LMList &languageModels
+            , float weightWP);
+
+  const TargetPhraseCollection *GetTargetPhraseCollection(const Phrase &source) const;
+
+  void InitializeForInput(const InputType &source);
+
+  ChartRuleLookupManager *CreateRuleLookupManager(const InputType &,
+                                                  const ChartCellCollection &) {
+    CHECK(false);
+    return 0;
+  }
+
+private:
+  template<typename T>
+  const T *Section(uint64_t offset) const {
+    return reinterpret_cast<const T *>(m_memory.begin() + offset);
+  }
+
+  const unsigned char *FindEntry(const std::string &key) const;
+  TargetPhraseCollection *DecodeEntry(const unsigned char *p,
+                                      const Phrase &source) const;
+  const Word &GetTargetWord(uint64_t id) const;
+  void CleanUp();
+
+  util::scoped_memory m_memory;
+  const CompactPT::Header *m_header;
+
+  std::vector<FactorType> m_input, m_output;
+  std::vector<float> m_weight;
+  float m_weightWP;
+  const LMList *m_languageModels;
+
+  // Per-sentence state.
+  typedef std::map<Phrase, const TargetPhraseCollection *> Cache;
+  mutable Cache m_cache;
+  mutable std::map<uint64_t, Word> m_wordCache;
+};
+
+}  // namespace Moses
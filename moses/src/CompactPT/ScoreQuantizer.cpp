@@ -0,0 +1,103 @@
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2012 University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#include "CompactPT/ScoreQuantizer.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace Moses
+{
+
+float ScoreQuantizer::ToLog(float value)
+{
+  // Same floor as FloorScore() after TransformScore().
+  return value > 0 ? std::max(std::log(value), -100.0f) : -100.0f;
+}
+
+uint32_t ScoreQuantizer::NextRandom()
+{
+  // xorshift32: the sample only needs to be spread over the input.
+  m_random ^= m_random << 13;
+  m_random ^= m_random >> 17;
+  m_random ^= m_random << 5;
+  return m_random;
+}
+
+void ScoreQuantizer::Observe(float value)
+{
+  ++m_seen;
+  if (m_sample.size() < m_sampleSize) {
+    m_sample.push_back(ToLog(value));
+    return;
+  }
+  // Reservoir sampling.
+  const uint64_t r = ((static_cast<uint64_t>(NextRandom()) << 32) |
+                      NextRandom()) % m_seen;
+  if (r < m_sampleSize) {
+    m_sample[r] = ToLog(value);
+  }
+}
+
+void ScoreQuantizer::Train(size_t numCodes)
+{
+  std::sort(m_sample.begin(), m_sample.end());
+  std::vector<float> logCodes;
+
+  // Equal-frequency bins; identical values never straddle two bins so that
+  // frequent exact values (e.g. 1 and 2.718) are reproduced exactly.
+  const size_t n = m_sample.size();
+  size_t begin = 0;
+  for (size_t code = 0; code < numCodes && begin < n; ++code) {
+    size_t end = std::max(begin + 1, (code + 1) * n / numCodes);
+    end = std::min(end, n);
+    while (end < n && m_sample[end] == m_sample[end-1]) {
+      ++end;
+    }
+    double sum = 0;
+    for (size_t i = begin; i < end; ++i) {
+      sum += m_sample[i];
+    }
+    logCodes.push_back(sum / (end - begin));
+    begin = end;
+  }
+  if (logCodes.empty()) {
+    logCodes.push_back(0);
+  }
+
+  m_codebook.clear();
+  m_boundaries.clear();
+  for (size_t i = 0; i < logCodes.size(); ++i) {
+    m_codebook.push_back(std::exp(logCodes[i]));
+    if (i > 0) {
+      m_boundaries.push_back((logCodes[i-1] + logCodes[i]) / 2);
+    }
+  }
+  m_codebook.resize(numCodes, m_codebook.back());
+  m_sample.clear();
+}
+
+uint8_t ScoreQuantizer::Encode(float value) const
+{
+  const float logValue = ToLog(value);
+  return std::upper_bound(m_boundaries.begin(), m_boundaries.end(), logValue)
+         - m_boundaries.begin();
+}
+
+}  // namespace Moses
@@ -0,0 +1,66 @@
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2012 University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#pragma once
+
+#include <stdint.h>
+
+#include <cstddef>
+#include <vector>
+
+namespace Moses
+{
+
+/** Quantizes the scores of one phrase table component to a one-byte code.
+ * Training collects a bounded reservoir sample of the values and splits it
+ * into equal-frequency bins in the log domain; each code represents the
+ * mean (in the log domain) of its bin.
+ */
+class ScoreQuantizer
+{
+public:
+  ScoreQuantizer(size_t sampleSize = 1000000, uint32_t seed = 1)
+    : m_sampleSize(sampleSize), m_seen(0), m_random(seed) {}
+
+  //! add a training value (a probability, as in the text phrase table)
+  void Observe(float value);
+
+  //! compute the codebook from the observed sample
+  void Train(size_t numCodes);
+
+  uint8_t Encode(float value) const;
+
+  const std::vector<float> &GetCodebook() const {
+    return m_codebook;
+  }
+
+private:
+  static float ToLog(float value);
+  uint32_t NextRandom();
+
+  size_t m_sampleSize;
+  uint64_t m_seen;
+  uint32_t m_random;
+  std::vector<float> m_sample;
+
+  std::vector<float> m_codebook;    // probabilities, ascending
+  std::vector<float> m_boundaries;  // log-domain midpoints between codes
+};
+
+}  // namespace Moses
@@ -0,0 +1,87 @@
+// $Id$
+// vim:tabstop=2
+
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2006 University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#include <sys/time.h>
+#include "Deadline.h"
+#include "StaticData.h"
+
+namespace Moses
+{
+
+Deadline::Deadline()
+  : m_start(Now())
+  , m_seconds(StaticData::Instance().GetDeadline())
+  , m_stepStart(m_start)
+  , m_workTime(0)
+  , m_work(0)
+  , m_numNarrowed(0)
+  , m_passed(false)
+{
+}
+
+double Deadline::Now()
+{
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+bool Deadline::Passed() const
+{
+  return IsSet() && Now() - m_start > m_seconds;
+}
+
+size_t Deadline::BeginStep(size_t maxUnits, size_t steps)
+{
+  m_stepStart = Now();
+  if (!IsSet() || maxUnits <= 1) {
+    return maxUnits;
+  }
+
+  const double left = m_start + m_seconds - m_stepStart;
+  size_t units = maxUnits;
+  if (left <= 0) {
+    if (!m_passed) {
+      VERBOSE(1, "Deadline of " << m_seconds << " seconds passed, completing the translation greedily" << std::endl);
+    }
+    m_passed = true;
+    units = 1;
+  } else if (m_work > 0 && m_workTime > 0) {
+    // units the share of this step allows at the cost so far
+    const double allowed = left / steps / (m_workTime / m_work);
+    if (allowed < maxUnits) {
+      units = (allowed < 1) ? 1 : static_cast<size_t>(allowed);
+    }
+  }
+  if (units < maxUnits) {
+    ++m_numNarrowed;
+  }
+  return units;
+}
+
+void Deadline::EndStep(size_t units)
+{
+  m_workTime += Now() - m_stepStart;
+  m_work += units;
+}
+
+}
@@ -0,0 +1,84 @@
+// $Id$
+// vim:tabstop=2
+
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2006 University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#ifndef moses_Deadline_h
+#define moses_Deadline_h
+
+#include <cstddef>
+
+namespace Moses
+{
+
+/** Wall-clock time allowed for translating one sentence (see switch
+ * -deadline), counted from construction. Each sentence's manager has its
+ * own, so it holds when sentences are translated in several threads.
+ *
+ * The search asks it how much work each of its steps (a stack, a chart
+ * cell) may do. The time left is shared evenly among the steps left, using
+ * the time a unit of work (expanding a hypothesis, popping a cube) has
+ * taken so far in this sentence. Once the time is up, every step is
+ * allowed a single unit. The phrase-based searches still keep
+ * MIN_DEADLINE_STACK_SIZE hypotheses a stack, and normal search expands
+ * them best first until one is extended, so that a best hypothesis with no
+ * legal extension does not end the search.
+ */
+class Deadline
+{
+public:
+  Deadline();
+
+  //! whether a deadline is set at all
+  bool IsSet() const {
+    return m_seconds >= 0;
+  }
+  //! whether the time is up
+  bool Passed() const;
+
+  /** the units of work the next step may do, between 1 and maxUnits;
+   * steps is the number of steps left, including this one */
+  size_t BeginStep(size_t maxUnits, size_t steps);
+  //! the step begun last did this many units of work
+  void EndStep(size_t units);
+
+  //! number of steps allowed less work than asked for
+  size_t GetNumNarrowed() const {
+    return m_numNarrowed;
+  }
+  //! whether the time was up before the search ended
+  bool WasPassed() const {
+    return m_passed;
+  }
+
+private:
+  double m_start, m_seconds;
+  double m_stepStart, m_workTime;
+  size_t m_work;
+  size_t m_numNarrowed;
+  bool m_passed;
+
+  //! wall-clock time in seconds
+  static double Now();
+};
+
+}
+
+#endif
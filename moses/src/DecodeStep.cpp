@@ -23,6 +23,8 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include "PhraseDictionaryMemory.h"
 #include "GenerationDictionary.h"
 #include "StaticData.h"
+#include "TranslationSystem.h"
+#include "ScoreComponentCollection.h"
 
 namespace Moses
 {
@@ -61,6 +63,43 @@ const GenerationDictionary* DecodeStep::GetGenerationDictionaryFeature() const
   return dynamic_cast<const GenerationDictionary*>(m_decodeFeature);
 }
 
+bool DecodeStep::LMScoresAreCosts(const TranslationSystem* system)
+{
+  const bool oovFeature = StaticData::Instance().GetLMEnableOOVFeature();
+  const LMList &languageModels = system->GetLanguageModels();
+  for (LMList::const_iterator lm = languageModels.begin(); lm != languageModels.end(); ++lm) {
+    if ((*lm)->GetWeight() < 0 || (oovFeature && (*lm)->GetOOVWeight() > 0)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+float DecodeStep::ScoreWithoutLM(const TranslationSystem* system, const ScoreComponentCollection &scores)
+{
+  ScoreComponentCollection withoutLM(scores);
+  withoutLM.ZeroAllLM(system->GetLanguageModels());
+  return withoutLM.InnerProduct(StaticData::Instance().GetAllWeights());
+}
+
+float DecodeStep::EstimateLMScore(const TranslationSystem* system, const Phrase &phrase)
+{
+  const bool oovFeature = StaticData::Instance().GetLMEnableOOVFeature();
+  const LMList &languageModels = system->GetLanguageModels();
+  float estimate = 0;
+  for (LMList::const_iterator lm = languageModels.begin(); lm != languageModels.end(); ++lm) {
+    if (!(*lm)->Useable(phrase)) continue;
+    float fullScore, nGramScore;
+    size_t oovCount;
+    (*lm)->CalcScore(phrase, fullScore, nGramScore, oovCount);
+    estimate += fullScore * (*lm)->GetWeight();
+    if (oovFeature) {
+      estimate += oovCount * (*lm)->GetOOVWeight();
+    }
+  }
+  return estimate;
+}
+
 }
 
 
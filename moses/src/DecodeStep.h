@@ -38,6 +38,8 @@ class PartialTranslOptColl;
 class FactorCollection;
 class InputType;
 class TranslationSystem;
+class ScoreComponentCollection;
+class Phrase;
 
 /** Specification for a decoding step.
  * The factored translation model consists of Translation and Generation
@@ -53,6 +55,15 @@ protected:
   std::vector<FactorType> m_newOutputFactors; //! list of the factors that are new in this step, may be empty
   const DecodeFeature* m_decodeFeature;
 
+  /** whether the LM scores of an option can only lower its future score
+   * (non-negative LM weights, non-positive OOV weights), so that the score
+   * without them bounds the future score of an option once it is scored */
+  static bool LMScoresAreCosts(const TranslationSystem* system);
+  //! weighted sum of the scores, without those of the LMs
+  static float ScoreWithoutLM(const TranslationSystem* system, const ScoreComponentCollection &scores);
+  //! weighted full LM and OOV scores of the phrase on its own
+  static float EstimateLMScore(const TranslationSystem* system, const Phrase &phrase);
+
 public:
   DecodeStep(); //! not implemented
   DecodeStep(const DecodeFeature *featurePtr, const DecodeStep* prevDecodeStep);
@@ -25,6 +25,9 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include "TranslationOptionCollection.h"
 #include "PartialTranslOptColl.h"
 #include "FactorCollection.h"
+#include "TranslationSystem.h"
+#include <algorithm>
+#include <queue>
 
 namespace Moses
 {
@@ -49,30 +52,48 @@ TranslationOption *DecodeStepGeneration::MergeGeneration(const TranslationOption
   return newTransOpt;
 }
 
-// helpers
-typedef pair<Word, ScoreComponentCollection> WordPair;
-typedef list< WordPair > WordList;
-// 1st = word
-// 2nd = score
-typedef list< WordPair >::const_iterator WordListIterator;
+namespace
+{
+
+// a generation of a word and its weighted score, with the LM score of the
+// word on its own as an estimate of what it adds to the LM score
+typedef pair<float, const OutputWordCollection::value_type*> WordOption;
 
-/** used in generation: increases iterators when looping through the exponential number of generation expansions */
-inline void IncrementIterators(vector< WordListIterator > &wordListIterVector
-                               , const vector< WordList > &wordListVector)
+bool CompareWordOptions(const WordOption &a, const WordOption &b)
 {
-  for (size_t currPos = 0 ; currPos < wordListVector.size() ; currPos++) {
-    WordListIterator &iter = wordListIterVector[currPos];
-    iter++;
-    if (iter != wordListVector[currPos].end()) {
-      // eg. 4 -> 5
-      return;
-    } else {
-      //  eg 9 -> 10
-      iter = wordListVector[currPos].begin();
-    }
+  return a.first > b.first;
+}
+
+// a combination of generations, by the position of each word's generation
+// in its list, and the option it makes
+struct Combination {
+  vector<size_t> choice;
+  // the combinations following this one only advance words from here on,
+  // so that each is reached once
+  size_t firstAdvance;
+  TranslationOption *option;
+
+  bool operator<(const Combination &other) const {
+    return option->GetFutureScore() < other.option->GetFutureScore();
+  }
+};
+
+// adds the combinations following combination, each advancing one word to
+// its next generation
+void AddSuccessors(const Combination &combination, const vector< vector<WordOption> > &wordListVector
+                   , vector<Combination> &successors)
+{
+  for (size_t currPos = combination.firstAdvance ; currPos < wordListVector.size() ; currPos++) {
+    if (combination.choice[currPos] + 1 == wordListVector[currPos].size()) continue;
+    successors.push_back(combination);
+    successors.back().choice[currPos]++;
+    successors.back().firstAdvance = currPos;
   }
 }
 
+}
+
+
 void DecodeStepGeneration::Process(const TranslationSystem* system
                                    , const TranslationOption &inputPartialTranslOpt
                                    , const DecodeStep &decodeStep
@@ -96,14 +117,15 @@ void DecodeStepGeneration::Process(const TranslationSystem* system
   const Phrase &targetPhrase  = inputPartialTranslOpt.GetTargetPhrase();
   size_t targetLength         = targetPhrase.GetSize();
 
-  // generation list for each word in phrase
-  vector< WordList > wordListVector(targetLength);
+  // generations of each word in phrase, best first
+  vector< vector<WordOption> > wordListVector(targetLength);
 
   // create generation list
-  int wordListVectorPos = 0;
+  const vector<float> &allWeights = StaticData::Instance().GetAllWeights();
+  Phrase wordPhrase(1);
+  wordPhrase.AddWord();
   for (size_t currPos = 0 ; currPos < targetLength ; currPos++) { // going thorugh all words
-    // generatable factors for this word to be put in wordList
-    WordList &wordList = wordListVector[wordListVectorPos];
+    vector<WordOption> &wordList = wordListVector[currPos];
     const Word &word = targetPhrase.GetWord(currPos);
 
     // consult dictionary for possible generations for this word
@@ -114,49 +136,66 @@ void DecodeStepGeneration::Process(const TranslationSystem* system
       //toc->ProcessUnknownWord(sourceWordsRange.GetStartPos(), factorCollection);
       return; // can't be part of a phrase, special handling
     } else {
-      // sort(*wordColl, CompareWordCollScore);
       OutputWordCollection::const_iterator iterWordColl;
       for (iterWordColl = wordColl->begin() ; iterWordColl != wordColl->end(); ++iterWordColl) {
-        const Word &outputWord = (*iterWordColl).first;
-        const ScoreComponentCollection& score = (*iterWordColl).second;
-        // enter into word list generated factor(s) and its(their) score(s)
-        wordList.push_back(WordPair(outputWord, score));
+        // enter into word list generated factor(s) and its(their) weighted score
+        wordPhrase.GetWord(0) = word;
+        wordPhrase.GetWord(0).Merge(iterWordColl->first);
+        const float score = iterWordColl->second.InnerProduct(allWeights) + EstimateLMScore(system, wordPhrase);
+        wordList.push_back(WordOption(score, &*iterWordColl));
       }
-
-      wordListVectorPos++; // done, next word
+      if (wordList.empty()) return;
+      std::stable_sort(wordList.begin(), wordList.end(), CompareWordOptions);
     }
   }
 
-  // use generation list (wordList)
-  // set up iterators (total number of expansions)
-  size_t numIteration = 1;
-  vector< WordListIterator >  wordListIterVector(targetLength);
-  vector< const Word* >       mergeWords(targetLength);
-  for (size_t currPos = 0 ; currPos < targetLength ; currPos++) {
-    wordListIterVector[currPos] = wordListVector[currPos].begin();
-    numIteration *= wordListVector[currPos].size();
-  }
-
-  // go thru each possible factor for each word & create hypothesis
-  for (size_t currIter = 0 ; currIter < numIteration ; currIter++) {
-    ScoreComponentCollection generationScore; // total score for this string of words
+  // Create the combinations cube pruning style: take the best option
+  // created so far and create those of the combinations following it, until
+  // twice as many options are taken as the collection keeps once the step is
+  // done. The combinations that would be pruned anyway are never created.
+  const size_t maxTaken = 2 * outputPartialTranslOptColl.GetMaxSize();
+  size_t taken = 0;
+  priority_queue<Combination> queue;
+  vector<Combination> pending(1);
+  pending[0].choice.resize(targetLength, 0);
+  pending[0].firstAdvance = 0;
+  vector< const Word* > mergeWords(targetLength);
+  while (true) {
+    while (!pending.empty()) {
+      Combination combination = pending.back();
+      pending.pop_back();
+
+      ScoreComponentCollection generationScore; // total score for this string of words
+
+      // create vector of words with new factors for last phrase
+      for (size_t currPos = 0 ; currPos < targetLength ; currPos++) {
+        const OutputWordCollection::value_type &wordPair = *wordListVector[currPos][combination.choice[currPos]].second;
+        mergeWords[currPos] = &(wordPair.first);
+        generationScore.PlusEquals(wordPair.second);
+      }
 
-    // create vector of words with new factors for last phrase
-    for (size_t currPos = 0 ; currPos < targetLength ; currPos++) {
-      const WordPair &wordPair = *wordListIterVector[currPos];
-      mergeWords[currPos] = &(wordPair.first);
-      generationScore.PlusEquals(wordPair.second);
+      // merge with existing trans opt
+      Phrase genPhrase( mergeWords);
+      combination.option = MergeGeneration(inputPartialTranslOpt, genPhrase, generationScore);
+      if (combination.option == NULL) {
+        // conflicting factors; the combinations following it may not be
+        AddSuccessors(combination, wordListVector, pending);
+        continue;
+      }
+      combination.option->CalcScore(system);
+      queue.push(combination);
     }
 
-    // merge with existing trans opt
-    Phrase genPhrase( mergeWords);
-    TranslationOption *newTransOpt = MergeGeneration(inputPartialTranslOpt, genPhrase, generationScore);
-    if (newTransOpt != NULL) {
-      outputPartialTranslOptColl.Add(system, newTransOpt);
-    }
+    if (queue.empty() || taken == maxTaken) break;
+    const Combination best = queue.top();
+    queue.pop();
+    outputPartialTranslOptColl.AddScored(best.option);
+    ++taken;
+    AddSuccessors(best, wordListVector, pending);
+  }
 
-    // increment iterators
-    IncrementIterators(wordListIterVector, wordListVector);
+  for (; !queue.empty(); queue.pop()) {
+    delete queue.top().option;
   }
 }
 
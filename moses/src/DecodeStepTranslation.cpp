@@ -25,9 +25,19 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include "TranslationOptionCollection.h"
 #include "PartialTranslOptColl.h"
 #include "FactorCollection.h"
+#include "TranslationSystem.h"
+#include <algorithm>
 
 namespace Moses
 {
+namespace
+{
+bool CompareCandidates(const std::pair<float, const TargetPhrase*> &a, const std::pair<float, const TargetPhrase*> &b)
+{
+  return a.first > b.first;
+}
+}
+
 DecodeStepTranslation::DecodeStepTranslation(const PhraseDictionaryFeature* pdf, const DecodeStep* prev)
   : DecodeStep(pdf, prev)
 {
@@ -75,12 +85,27 @@ void DecodeStepTranslation::Process(const TranslationSystem* system
     TargetPhraseCollection::const_iterator iterTargetPhrase, iterEnd;
     iterEnd = (!adhereTableLimit || tableLimit == 0 || phraseColl->GetSize() < tableLimit) ? phraseColl->end() : phraseColl->begin() + tableLimit;
 
+    // merge the target phrases best first by the score the options will
+    // have without LM scores, and stop once that is too low to be kept
+    const bool bounded = LMScoresAreCosts(system);
+    const float inputScore = ScoreWithoutLM(system, inputPartialTranslOpt.GetScoreBreakdown())
+                             - currSize * system->GetWeightWordPenalty();
+    std::vector<std::pair<float, const TargetPhrase*> > candidates;
     for (iterTargetPhrase = phraseColl->begin(); iterTargetPhrase != iterEnd; ++iterTargetPhrase) {
       const TargetPhrase& targetPhrase = **iterTargetPhrase;
       // skip if the
       if (targetPhrase.GetSize() != currSize) continue;
 
-      TranslationOption *newTransOpt = MergeTranslation(inputPartialTranslOpt, targetPhrase);
+      const float bound = inputScore + ScoreWithoutLM(system, targetPhrase.GetScoreBreakdown());
+      candidates.push_back(std::make_pair(bound, &targetPhrase));
+    }
+    std::stable_sort(candidates.begin(), candidates.end(), CompareCandidates);
+
+    for (size_t i = 0; i < candidates.size(); ++i) {
+      if (bounded && candidates[i].first < outputPartialTranslOptColl.GetThreshold()) {
+        break;
+      }
+      TranslationOption *newTransOpt = MergeTranslation(inputPartialTranslOpt, *candidates[i].second);
       if (newTransOpt != NULL) {
         outputPartialTranslOptColl.Add(system, newTransOpt );
       }
@@ -0,0 +1,72 @@
+#ifndef moses_DynSAInclude_LayeredMap_h
+#define moses_DynSAInclude_LayeredMap_h
+
+#include <vector>
+#include <boost/shared_ptr.hpp>
+#include <boost/unordered_map.hpp>
+
+namespace Moses
+{
+
+/** A map that is extended a batch of entries at a time, and whose versions
+ *  share their entries.  The entries are kept in immutable layers, newest
+ *  last, which copies of the map share; a layer is merged into the one below
+ *  once it is at least half its size, so the layers shrink geometrically.
+ *  Each entry is thus copied O(log n) times as the map grows, and a lookup
+ *  searches O(log n) layers.
+ */
+template<typename K, typename V, typename H = boost::hash<K> >
+class LayeredMap
+{
+public:
+  typedef boost::unordered_map<K, V, H> Map;
+
+  bool empty() const {
+    return m_layers.empty();
+  }
+
+  //! the value of key in the newest layer that has it, NULL if none does
+  const V *find(const K &key) const {
+    for (size_t i = m_layers.size(); i > 0; --i) {
+      typename Map::const_iterator iter = m_layers[i - 1]->find(key);
+      if (iter != m_layers[i - 1]->end()) {
+        return &iter->second;
+      }
+    }
+    return NULL;
+  }
+
+  //! add entries, replacing the values of keys already in the map
+  void add(const boost::shared_ptr<const Map> &entries) {
+    if (entries->empty()) {
+      return;
+    }
+    m_layers.push_back(entries);
+    while (m_layers.size() > 1 &&
+           m_layers[m_layers.size() - 2]->size() <= 2 * m_layers.back()->size()) {
+      const Map &newer = *m_layers.back();
+      Map *merged = new Map(*m_layers[m_layers.size() - 2]);
+      for (typename Map::const_iterator iter = newer.begin(); iter != newer.end(); ++iter) {
+        (*merged)[iter->first] = iter->second;
+      }
+      m_layers.pop_back();
+      m_layers.back().reset(merged);
+    }
+  }
+
+  //! all entries, each with its newest value
+  void flatten(Map &out) const {
+    for (size_t i = 0; i < m_layers.size(); ++i) {
+      for (typename Map::const_iterator iter = m_layers[i]->begin(); iter != m_layers[i]->end(); ++iter) {
+        out[iter->first] = iter->second;
+      }
+    }
+  }
+
+private:
+  std::vector<boost::shared_ptr<const Map> > m_layers; // oldest first
+};
+
+}
+
+#endif
@@ -163,6 +163,16 @@ namespace randlm {
 	 / static_cast<float>(1ull << 20) << "MB" << std::endl;
       return clearNodes(root_);
     }
+    void clearNgramsEndingWith(const wordID_t* ngram, int len) {
+      // removes all cached ngrams that end with this ngram
+      clearBelow(root_, ngram, len);
+    }
+    void clearNgramsWithContextEndingWith(const wordID_t* ngram, int len) {
+      // removes all cached ngrams whose context (all but the last word)
+      // ends with this ngram
+      iterate(root_->childs_, itr)
+        clearBelow(itr->second, ngram, len);
+    }
     int nodes() {
       // returns number of nodes
       return cur_nodes_;
@@ -179,6 +189,22 @@ namespace randlm {
       ++cur_nodes_;
       return new CacheNode<T>(unknown_value_);
     }
+    void clearBelow(CacheNode<T> * node, const wordID_t* ngram, int len) {
+      // nodes are keyed on the last word first
+      for(int i = len - 1; i > 0; --i) {
+	childPtr child = node->childs_.find(ngram[i]);
+	if(child == node->childs_.end())
+	  return;
+	node = child->second;
+      }
+      childPtr child = node->childs_.find(ngram[0]);
+      if(child == node->childs_.end())
+	return;
+      clearNodes(child->second);
+      delete child->second;
+      --cur_nodes_;
+      node->childs_.erase(child);
+    }
     bool clearNodes(CacheNode<T> * node) {
       //delete children from this node
       if(!node->childs_.empty()) {
@@ -3,6 +3,8 @@
 
 #include <algorithm>
 #include <vector>
+#include <boost/unordered_map.hpp>
+#include "LayeredMap.h"
 #include "perfectHash.h"
 #include "RandLMCache.h"
 #include "types.h"
@@ -20,6 +22,13 @@ const bool strict_checks_ = false;
 template<typename T>
 class OnlineRLM: public PerfectHash<T> {
 public:
+  // Counts of ngrams updated since loading, kept apart from the filter so
+  // that the filter can be read while updates are made (see LM/ORLM.h).
+  // CountMap holds the counts of one batch of updates, UpdatedCounts those
+  // of all batches.
+  typedef boost::unordered_map<std::vector<wordID_t>, int> CountMap;
+  typedef Moses::LayeredMap<std::vector<wordID_t>, int> UpdatedCounts;
+
   OnlineRLM(uint16_t MBs, int width, int bucketRange, count_t order, 
     Moses::Vocab* v, float qBase = 8): PerfectHash<T>(MBs, width, bucketRange, qBase), 
     vocab_(v), bAdapting_(false), order_(order), corpusSize_(0), alpha_(0) {
@@ -49,11 +58,16 @@ public:
     delete bPrefix_;
     delete bHit_;
   }
-  float getProb(const wordID_t* ngram, int len, const void** state);
+  float getProb(const wordID_t* ngram, int len, const void** state,
+    Cache<float>* cache = NULL, const UpdatedCounts* updates = NULL);
   //float getProb2(const wordID_t* ngram, int len, const void** state);
   bool insert(const std::vector<string>& ngram, const int value);
   bool update(const std::vector<string>& ngram, const int value);
-  int query(const wordID_t* IDs, const int len);
+  bool update(const wordID_t* IDs, const int len, const int value);
+  bool update(const wordID_t* IDs, const int len, const int value, 
+    CountMap& batch, const UpdatedCounts& updates);
+  void applyUpdates(const UpdatedCounts& updates);
+  int query(const wordID_t* IDs, const int len, const UpdatedCounts* updates = NULL);
   int sbsqQuery(const std::vector<string>& ngram, int* len, 
     bool bStrict = false);
   int sbsqQuery(const wordID_t* IDs, const int len, int* codes, 
@@ -79,7 +93,7 @@ protected:
   void markQueried(hpdEntry_t& value);
   bool markPrefix(const wordID_t* IDs, const int len, bool bSet);
 private:
-  const void* getContext(const wordID_t* ngram, int len); 
+  const void* getContext(const wordID_t* ngram, int len, Cache<float>* cache); 
   const bool bAdapting_; // used to signal adaptation of model
   const count_t order_; // LM order
   uint64_t corpusSize_; // total training corpus size
@@ -111,17 +125,22 @@ template<typename T>
 bool OnlineRLM<T>::update(const std::vector<string>& ngram, const int value) {
   int len = ngram.size();
   std::vector<wordID_t> wrdIDs(len);
-  uint64_t index(this->cells_ + 1);
-  hpdEntry_t hpdItr;
   vocab_->MakeOpen();
   for(int i = 0; i < len; ++i) 
     wrdIDs[i] = vocab_->GetWordID(ngram[i]);
+  return update(&wrdIDs[0], len, value);
+}
+
+template<typename T>
+bool OnlineRLM<T>::update(const wordID_t* IDs, const int len, const int value) {
+  uint64_t index(this->cells_ + 1);
+  hpdEntry_t hpdItr;
   // if updating, minimize false positives by pre-checking if context already in model 
   bool bIncluded(true); 
   if(value > 1 && len < (int)order_)
-    bIncluded = markPrefix(&wrdIDs[0], ngram.size(), true); // mark context
+    bIncluded = markPrefix(IDs, len, true); // mark context
   if(bIncluded) { // if context found 
-    bIncluded = PerfectHash<T>::update2(&wrdIDs[0], len, value, hpdItr, index);
+    bIncluded = PerfectHash<T>::update2(IDs, len, value, hpdItr, index);
     if(index < this->cells_) {
       markQueried(index);
     }
@@ -130,8 +149,50 @@ bool OnlineRLM<T>::update(const std::vector<string>& ngram, const int value) {
 
   return bIncluded;
 }
+
+template<typename T>
+bool OnlineRLM<T>::update(const wordID_t* IDs, const int len, const int value,
+  CountMap& batch, const UpdatedCounts& updates) {
+  // as update() but records the new count in batch, on top of the counts
+  // already in updates, and leaves the filter alone
+  if(value > 1 && len > 1 && len < (int)order_) { // context must be in model
+    const std::vector<wordID_t> context(IDs, IDs + len - 1);
+    hpdEntry_t hpdItr;
+    uint64_t filterIdx(0);
+    if(batch.find(context) == batch.end() && updates.find(context) == NULL &&
+       PerfectHash<T>::query(IDs, len - 1, hpdItr, filterIdx) == -1)
+      return false;
+  }
+  std::pair<typename CountMap::iterator, bool> ret = 
+    batch.insert(std::make_pair(std::vector<wordID_t>(IDs, IDs + len), 0));
+  if(ret.second)
+    ret.first->second = query(IDs, len, &updates);
+  ret.first->second += value;
+  return true;
+}
+
+template<typename T>
+void OnlineRLM<T>::applyUpdates(const UpdatedCounts& updates) {
+  // fold counts recorded by update(..., batch, updates) into the filter,
+  // lower orders first as update() expects
+  CountMap counts;
+  updates.flatten(counts);
+  for(count_t order = 1; order <= order_; ++order) {
+    iterate(counts, itr) {
+      if(itr->first.size() != order) continue;
+      const int delta = itr->second - query(&itr->first[0], order);
+      if(delta > 0)
+        update(&itr->first[0], order, delta);
+    }
+  }
+}
 template<typename T>
-int OnlineRLM<T>::query(const wordID_t* IDs, int len) {
+int OnlineRLM<T>::query(const wordID_t* IDs, int len, const UpdatedCounts* updates) {
+  if(updates && !updates->empty()) {
+    const int* count = updates->find(std::vector<wordID_t>(IDs, IDs + len));
+    if(count != NULL) 
+      return *count;
+  }
   uint64_t filterIdx = 0;
   hpdEntry_t hpdItr;
   int value(0);
@@ -270,19 +331,20 @@ int OnlineRLM<T>::sbsqQuery(const wordID_t* IDs, const int len, int* codes,
 
 template<typename T>
 float OnlineRLM<T>::getProb(const wordID_t* ngram, int len, 
-  const void** state) {
+  const void** state, Cache<float>* cache, const UpdatedCounts* updates) {
   static const float oovprob = log10(1.0 / (static_cast<float>(vocab_->Size()) - 1));
   float logprob(0);
   const void* context = (state) ? *state : 0;
+  if(cache == NULL) cache = cache_;
   // if full ngram and prob not in cache
-  if(!cache_->checkCacheNgram(ngram, len, &logprob, &context)) {
+  if(!cache->checkCacheNgram(ngram, len, &logprob, &context)) {
     // get full prob and put in cache
     int num_fnd(0), den_val(0);
     int *in = new int[len]; // in[] keeps counts of increasing order numerator 
     for(int i = 0; i < len; ++i) in[i] = 0;
     for(int i = len - 1; i >= 0; --i) {
       if(ngram[i] == vocab_->GetkOOVWordID()) break;  // no need to query if OOV
-      in[i] = query(&ngram[i], len - i);
+      in[i] = query(&ngram[i], len - i, updates);
       if(in[i] > 0) {
         num_fnd = len - i;
       }
@@ -290,7 +352,7 @@ float OnlineRLM<T>::getProb(const wordID_t* ngram, int len,
     }
     while(num_fnd > 1) { // get lower order count
       //get sub-context of size one less than length found (exluding target) 
-      if(((den_val = query(&ngram[len - num_fnd], num_fnd - 1)) > 0) &&
+      if(((den_val = query(&ngram[len - num_fnd], num_fnd - 1, updates)) > 0) &&
           (den_val >= in[len - num_fnd]) && (in[len - num_fnd] > 0)) {
         break;
       }
@@ -317,18 +379,18 @@ float OnlineRLM<T>::getProb(const wordID_t* ngram, int len,
         break;
     }
     // need unique context
-    context = getContext(&ngram[len - num_fnd], num_fnd);
+    context = getContext(&ngram[len - num_fnd], num_fnd, cache);
     // put whatever was found in cache
-    cache_->setCacheNgram(ngram, len, logprob, context);
+    cache->setCacheNgram(ngram, len, logprob, context);
   } // end checkCache
   return logprob; 
 }
 
 template<typename T>
-const void* OnlineRLM<T>::getContext(const wordID_t* ngram, int len) {
+const void* OnlineRLM<T>::getContext(const wordID_t* ngram, int len, Cache<float>* cache) {
   int dummy(0);
   float* *addresses = new float*[len];  // only interested in addresses of cache
-  CHECK(cache_->getCache2(ngram, len, &addresses[0], &dummy) == len);
+  CHECK(cache->getCache2(ngram, len, &addresses[0], &dummy) == len);
   // return address of cache node
   
   float *addr0 = addresses[0];
@@ -23,6 +23,15 @@ DynSuffixArray::~DynSuffixArray()
   delete m_L;
 }
 
+DynSuffixArray::DynSuffixArray(const DynSuffixArray &other, vuint_t *corpus)
+{
+  m_SA = new vuint_t(*other.m_SA);
+  m_ISA = new vuint_t(*other.m_ISA);
+  m_F = new vuint_t(*other.m_F);
+  m_L = new vuint_t(*other.m_L);
+  m_corpus = corpus;
+}
+
 DynSuffixArray::DynSuffixArray(vuint_t* crp)
 {
   // make native int array and pass to SA builder
@@ -22,6 +22,8 @@ class DynSuffixArray
 public:
   DynSuffixArray();
   DynSuffixArray(vuint_t*);
+  //! copy of other over corpus, which must be a copy of other's corpus
+  DynSuffixArray(const DynSuffixArray &other, vuint_t *corpus);
   ~DynSuffixArray();
   bool GetCorpusIndex(const vuint_t*, vuint_t*);
   void Load(FILE*);
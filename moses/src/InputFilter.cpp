@@ -0,0 +1,150 @@
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2012 University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#include <algorithm>
+
+#include "InputFilter.h"
+#include "InputFileStream.h"
+#include "UserMessage.h"
+#include "Util.h"
+#include "util/murmur_hash.hh"
+#include "util/tokenize_piece.hh"
+
+using namespace std;
+
+namespace Moses
+{
+
+namespace
+{
+
+// hash of an n-gram, extended by one word
+inline uint64_t HashWord(const char *word, size_t size, uint64_t ngramHash)
+{
+  return util::MurmurHashNative(word, size, ngramHash);
+}
+
+void StripXml(string &line, const pair<string, string> &brackets)
+{
+  size_t begin;
+  while ((begin = line.find(brackets.first)) != string::npos) {
+    size_t end = line.find(brackets.second, begin + brackets.first.size());
+    if (end == string::npos) {
+      return;
+    }
+    line.replace(begin, end + brackets.second.size() - begin, " ");
+  }
+}
+
+bool IsNonTerminal(const StringPiece &word)
+{
+  return word.size() > 1 && word.data()[0] == '[' && word.data()[word.size() - 1] == ']';
+}
+
+}
+
+InputFilter::InputFilter(const vector<FactorType> &factorOrder
+                         , const string &factorDelimiter
+                         , size_t maxLength)
+  : m_factorOrder(factorOrder)
+  , m_factorDelimiter(factorDelimiter)
+  , m_maxLength(maxLength)
+  , m_ngrams(factorOrder.size())
+{
+}
+
+bool InputFilter::Load(const string &filePath
+                       , const pair<string, string> *xmlBrackets)
+{
+  if (!FileExists(filePath)) {
+    UserMessage::Add("Cannot read input file " + filePath + " to filter the tables");
+    return false;
+  }
+  InputFileStream in(filePath);
+
+  string line;
+  vector<string> words;
+  while (getline(in, line)) {
+    if (xmlBrackets) {
+      StripXml(line, *xmlBrackets);
+    }
+    words.clear();
+    words.push_back("<s>");
+    Tokenize(words, line);
+    words.push_back("</s>");
+    AddSentence(words);
+  }
+  return true;
+}
+
+void InputFilter::AddSentence(const vector<string> &words)
+{
+  for (size_t ind = 0; ind < m_factorOrder.size(); ++ind) {
+    // the factor of each word, or an empty string if it has none
+    vector<StringPiece> factors;
+    factors.reserve(words.size());
+    for (size_t pos = 0; pos < words.size(); ++pos) {
+      util::TokenIter<util::MultiCharacter> factor(words[pos], util::MultiCharacter(m_factorDelimiter));
+      for (size_t skip = 0; skip < ind && factor; ++skip) {
+        ++factor;
+      }
+      factors.push_back(factor ? *factor : StringPiece());
+    }
+
+    NgramSet &ngrams = m_ngrams[ind];
+    for (size_t start = 0; start < factors.size(); ++start) {
+      const size_t end = min(factors.size(), start + m_maxLength);
+      uint64_t hash = 0;
+      for (size_t pos = start; pos < end; ++pos) {
+        hash = HashWord(factors[pos].data(), factors[pos].size(), hash);
+        ngrams.insert(hash);
+      }
+    }
+  }
+}
+
+bool InputFilter::Matches(const StringPiece &source, FactorType factor) const
+{
+  vector<FactorType>::const_iterator iter = find(m_factorOrder.begin(), m_factorOrder.end(), factor);
+  if (iter == m_factorOrder.end()) {
+    // not a factor of the input
+    return true;
+  }
+  const NgramSet &ngrams = m_ngrams[iter - m_factorOrder.begin()];
+
+  uint64_t hash = 0;
+  size_t length = 0;
+  for (util::TokenIter<util::AnyCharacter, true> word(source, util::AnyCharacter(" \t")); word; ++word) {
+    if (IsNonTerminal(*word)) {
+      if (length > 0 && length <= m_maxLength && ngrams.find(hash) == ngrams.end()) {
+        return false;
+      }
+      hash = 0;
+      length = 0;
+      continue;
+    }
+    const char *end = std::search(word->data(), word->data() + word->size(),
+                                  m_factorDelimiter.begin(), m_factorDelimiter.end());
+    hash = HashWord(word->data(), end - word->data(), hash);
+    ++length;
+  }
+  return length == 0 || length > m_maxLength || ngrams.find(hash) != ngrams.end();
+}
+
+}
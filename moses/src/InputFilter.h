@@ -0,0 +1,79 @@
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2012 University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#ifndef moses_InputFilter_h
+#define moses_InputFilter_h
+
+#include <stdint.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <boost/unordered_set.hpp>
+
+#include "TypeDef.h"
+#include "util/string_piece.hh"
+
+namespace Moses
+{
+
+/** The source n-grams of the sentences of an input file, so that the text
+ * phrase, rule and reordering tables can be loaded with only the entries
+ * that can match the input, like filter-model-given-input.pl does.
+ *
+ * The input is read as plain text, one sentence per line, with the factors
+ * of each word in the order of the input-factors parameter.  Each sentence
+ * is surrounded by <s> and </s> for the glue rules of chart decoding.
+ * N-grams are kept as hashes: a collision can only keep an entry that is
+ * not needed.
+ */
+class InputFilter
+{
+public:
+  /** maxLength: longest n-gram kept.  Longer phrases always match. */
+  InputFilter(const std::vector<FactorType> &factorOrder
+              , const std::string &factorDelimiter
+              , size_t maxLength);
+
+  /** xmlBrackets: if not NULL, the markup between these is removed */
+  bool Load(const std::string &filePath
+            , const std::pair<std::string, std::string> *xmlBrackets);
+
+  /** Whether the source side of a table entry can match the input.  Words
+   * are separated by spaces and the first factor of each word is the given
+   * one.  Words in [] are non-terminals, which match anything, so each run
+   * of words between them must occur in the input.
+   */
+  bool Matches(const StringPiece &source, FactorType factor) const;
+
+private:
+  typedef boost::unordered_set<uint64_t> NgramSet;
+
+  void AddSentence(const std::vector<std::string> &words);
+
+  std::vector<FactorType> m_factorOrder;
+  std::string m_factorDelimiter;
+  size_t m_maxLength;
+  //! n-grams of each factor, in the order of m_factorOrder
+  std::vector<NgramSet> m_ngrams;
+};
+
+}
+
+#endif
@@ -87,6 +87,10 @@ public:
   virtual void CalcScoreFromCache(const Phrase &phrase, float &fullScore, float &ngramScore, std::size_t &oovCount) const {
   }
 
+  //! true if IssueRequestsFor() and sync() should be used with this LM
+  virtual bool UsesBatchedRequests() const {
+    return false;
+  }
   virtual void IssueRequestsFor(Hypothesis& hypo,
                                 const FFState* input_state) {
   }
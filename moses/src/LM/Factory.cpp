@@ -20,11 +20,16 @@ License along with this library; if not, write to the Free Software
 Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 ***********************************************************************/
 
+#include <algorithm>
 #include <iostream>
+#include <fstream>
+#include <sstream>
 #include "LM/Factory.h"
 #include "UserMessage.h"
 #include "TypeDef.h"
 #include "FactorCollection.h"
+#include "Util.h"
+#include "util/murmur_hash.hh"
 
 // include appropriate header
 #ifdef LM_SRI
@@ -142,6 +147,36 @@ LanguageModel* CreateLanguageModel(LMImplementation lmImplementation
 
   return new LMRefCount(scoreIndexManager, lm);
 }
+
+std::string Fingerprint(const std::string &lmodelFileLine)
+{
+  vector<string> token = Tokenize(lmodelFileLine);
+  if (token.size() < 4) {
+    return lmodelFileLine;
+  }
+
+  // hashing the whole file would cost as much as loading it
+  const size_t sampleSize = 1 << 20;
+  uint64_t hash = 0;
+  std::ifstream file(token[3].c_str(), std::ios::in | std::ios::binary);
+  file.seekg(0, std::ios::end);
+  if (file) {
+    const std::streamoff fileSize = file.tellg();
+    vector<char> sample(sampleSize);
+    file.seekg(0);
+    file.read(&sample[0], sampleSize);
+    hash = util::MurmurHashNative(&sample[0], file.gcount(), fileSize);
+    file.clear();
+    file.seekg(std::max<std::streamoff>(0, fileSize - sampleSize));
+    file.read(&sample[0], sampleSize);
+    hash = util::MurmurHashNative(&sample[0], file.gcount(), hash);
+  }
+
+  std::ostringstream fingerprint;
+  fingerprint << token[0] << " " << token[1] << " " << token[2] << " " << std::hex << hash;
+  return fingerprint.str();
+}
+
 }
 
 }
@@ -27,6 +27,13 @@ LanguageModel* CreateLanguageModel(LMImplementation lmImplementation
                                    , ScoreIndexManager &scoreIndexManager
                                    , int dub);
 
+/**
+ * identifies the model an lmodel-file line loads, for values computed with
+ * it and stored elsewhere: its type, factors and order, and a checksum of
+ * the size, start and end of its file
+ */
+std::string Fingerprint(const std::string &lmodelFileLine);
+
 };
 
 }
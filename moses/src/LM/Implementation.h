@@ -93,9 +93,9 @@ public:
   virtual const FFState *GetBeginSentenceState() const = 0;
   virtual FFState *NewState(const FFState *from = NULL) const = 0;
 
-  void CalcScore(const Phrase &phrase, float &fullScore, float &ngramScore, size_t &oovCount) const;
+  virtual void CalcScore(const Phrase &phrase, float &fullScore, float &ngramScore, size_t &oovCount) const;
 
-  FFState *Evaluate(const Hypothesis &hypo, const FFState *ps, ScoreComponentCollection *out, const LanguageModel *feature) const;
+  virtual FFState *Evaluate(const Hypothesis &hypo, const FFState *ps, ScoreComponentCollection *out, const LanguageModel *feature) const;
 
   FFState* EvaluateChart(const ChartHypothesis& cur_hypo, int featureID, ScoreComponentCollection* accumulator, const LanguageModel *feature) const;
 
@@ -125,6 +125,16 @@ public:
   //! overrideable funtions for IRST LM to cleanup. Maybe something to do with on demand/cache loading/unloading
   virtual void InitializeBeforeSentenceProcessing() {};
   virtual void CleanUpAfterSentenceProcessing() {};
+
+  /* Batched lookups for LMs with slow queries (see SearchNormalBatch).
+   * IssueRequestsFor() sends the n-grams Evaluate() will need for hypo without
+   * waiting for the answers; sync() waits for all outstanding answers.
+   */
+  virtual bool UsesBatchedRequests() const {
+    return false;
+  }
+  virtual void IssueRequestsFor(const Hypothesis &/*hypo*/) const {}
+  virtual void sync() const {}
 };
 
 class LMRefCount : public LanguageModel {
@@ -169,6 +179,18 @@ class LMRefCount : public LanguageModel {
       return m_impl->GetScoreProducerDescription(param);
     }
 
+    bool UsesBatchedRequests() const {
+      return m_impl->UsesBatchedRequests();
+    }
+
+    void IssueRequestsFor(Hypothesis &hypo, const FFState * /*input_state*/) {
+      m_impl->IssueRequestsFor(hypo);
+    }
+
+    void sync() {
+      m_impl->sync();
+    }
+
     LanguageModelImplementation *MosesServerCppShouldNotHaveLMCode() { return m_impl.get(); }
 
   private:
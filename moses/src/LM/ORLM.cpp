@@ -11,6 +11,33 @@
 using std::map;
 namespace Moses 
 {
+namespace
+{
+// number of versions whose changed ngrams are kept for cache invalidation
+const size_t kMaxChanges = 64;
+// a thread's cache is emptied after a sentence once it has this many nodes
+const int kMaxCacheNodes = 4000000;
+}
+
+LanguageModelORLM::~LanguageModelORLM() {
+  m_threadData.reset();
+  if (m_snapshot) {
+    // add new words to the vocabulary, with the ids they were given
+    m_lm->vocab_->MakeOpen();
+    for (size_t i = 0; i < m_newWordStrings.size(); ++i) {
+      CHECK(m_lm->vocab_->GetWordID(m_newWordStrings[i]) == m_firstNewWordId + i);
+    }
+    m_lm->vocab_->MakeClosed();
+    // fold updates into the model
+    m_lm->applyUpdates(m_snapshot->counts);
+    //save LM with markings
+    Utils::rtrim(m_filePath, ".gz");
+    FileHandler fout(m_filePath + ".marked.gz", std::ios::out|std::ios::binary, false);
+    m_lm->save(&fout);
+    fout.close();
+  }
+  delete m_lm;
+}
 bool LanguageModelORLM::Load(const std::string &filePath, FactorType factorType, 
 			       size_t nGramOrder) {
   cerr << "Loading LanguageModelORLM..." << endl;
@@ -24,6 +51,10 @@ bool LanguageModelORLM::Load(const std::string &filePath, FactorType factorType,
   // get special word ids
   m_oov_id = m_lm->vocab_->GetWordID("<unk>");
   CreateFactors();
+  // the vocabulary is only read from now on, see UpdateORLM()
+  m_lm->vocab_->MakeClosed();
+  m_firstNewWordId = m_lm->vocab_->Size() + 1;
+  m_snapshot.reset(new Snapshot);
   return true;
 }
 void LanguageModelORLM::CreateFactors() {
@@ -61,9 +92,63 @@ void LanguageModelORLM::CreateFactors() {
 wordID_t LanguageModelORLM::GetLmID(const std::string& str) const {
   return m_lm->vocab_->GetWordID(str);
 }
-wordID_t LanguageModelORLM::GetLmID(const Factor* factor) const {
+wordID_t LanguageModelORLM::GetLmID(const Factor* factor, const Snapshot &snapshot) const {
   size_t factorId = factor->GetId();
-  return (factorId >= lm_ids_vec_.size()) ? m_oov_id : lm_ids_vec_[factorId];
+  wordID_t id = (factorId >= lm_ids_vec_.size()) ? m_oov_id : lm_ids_vec_[factorId];
+  if (id == m_oov_id && !snapshot.newWords.empty()) {
+    const wordID_t *newId = snapshot.newWords.find(factorId);
+    if (newId != NULL) id = *newId;
+  }
+  return id;
+}
+wordID_t LanguageModelORLM::GetUpdateID(const std::string& str) {
+  // as the vocabulary would number it, without changing the vocabulary
+  wordID_t id = m_lm->vocab_->GetWordID(str);
+  if (id != m_lm->vocab_->GetkOOVWordID()) return id;
+  std::pair<boost::unordered_map<std::string, wordID_t>::iterator, bool> ret =
+    m_newWordIds.insert(std::make_pair(str, m_firstNewWordId + m_newWordStrings.size()));
+  if (ret.second) m_newWordStrings.push_back(str);
+  return ret.first->second;
+}
+LanguageModelORLM::SnapshotPtr LanguageModelORLM::GetSnapshot() const {
+#ifdef WITH_THREADS
+  boost::mutex::scoped_lock lock(m_snapshotLock);
+#endif
+  return m_snapshot;
+}
+LanguageModelORLM::ThreadData &LanguageModelORLM::GetThreadData() const {
+  ThreadData *data = m_threadData.get();
+  if (data == NULL) {
+    data = new ThreadData;
+    data->snapshot = GetSnapshot();
+    m_threadData.reset(data);
+  }
+  return *data;
+}
+void LanguageModelORLM::InitializeBeforeSentenceProcessing() {
+  // pick up updates made since the last sentence
+  ThreadData &data = GetThreadData();
+  SnapshotPtr current = GetSnapshot();
+  const size_t behind = current->version - data.snapshot->version;
+  if (behind == 0) return;
+  if (behind > current->changes.size()) {
+    data.cache.clear();
+  } else {
+    for (size_t i = current->changes.size() - behind; i < current->changes.size(); ++i) {
+      const NGramList &changed = *current->changes[i];
+      for (size_t j = 0; j < changed.size(); ++j) {
+        // probabilities use the counts of the ngram's suffixes (numerators)
+        // and of its context's suffixes (denominators)
+        data.cache.clearNgramsEndingWith(&changed[j][0], changed[j].size());
+        data.cache.clearNgramsWithContextEndingWith(&changed[j][0], changed[j].size());
+      }
+    }
+  }
+  data.snapshot = current;
+}
+void LanguageModelORLM::CleanUpAfterSentenceProcessing() {
+  ThreadData &data = GetThreadData();
+  if (data.cache.nodes() > kMaxCacheNodes) data.cache.clear();
 }
 LMResult LanguageModelORLM::GetValue(const std::vector<const Word*> &contextFactor, 
     State* finalState) const {
@@ -71,15 +156,17 @@ LMResult LanguageModelORLM::GetValue(const std::vector<const Word*> &contextFact
   // set up context
   //std::vector<long unsigned int> factor(1,0);
   //std::vector<string> sngram;
+  ThreadData &data = GetThreadData();
+  const Snapshot &snapshot = *data.snapshot;
   wordID_t ngram[MAX_NGRAM_SIZE];
   int count = contextFactor.size();
   for (int i = 0; i < count; i++) {
-    ngram[i] = GetLmID((*contextFactor[i])[factorType]);
+    ngram[i] = GetLmID((*contextFactor[i])[factorType], snapshot);
     //sngram.push_back(contextFactor[i]->GetString(factor, false));
   }
   //float logprob = FloorScore(TransformLMScore(lm_->getProb(sngram, count, finalState)));
   LMResult ret;
-  ret.score = FloorScore(TransformLMScore(m_lm->getProb(&ngram[0], count, finalState)));
+  ret.score = FloorScore(TransformLMScore(m_lm->getProb(&ngram[0], count, finalState, &data.cache, &snapshot.counts)));
   ret.unknown = count && (ngram[count - 1] == m_oov_id);
   /*if (finalState)
     std::cout << " = " << logprob << "(" << *finalState << ", " << *len <<")"<< std::endl;
@@ -89,13 +176,53 @@ LMResult LanguageModelORLM::GetValue(const std::vector<const Word*> &contextFact
   return ret;
 }
 bool LanguageModelORLM::UpdateORLM(const std::vector<string>& ngram, const int value) {
+  std::vector<std::pair<std::vector<string>, int> > ngrams(1, std::make_pair(ngram, value));
+  return UpdateORLM(ngrams) == 1;
+}
+size_t LanguageModelORLM::UpdateORLM(const std::vector<std::pair<std::vector<string>, int> >& ngrams) {
   /*cerr << "Inserting into ORLM: \"";
   iterate(ngram, nit)
     cerr << *nit << " ";
   cerr << "\"\t" << value << endl; */
-  m_lm->vocab_->MakeOpen();
-  bool res = m_lm->update(ngram, value); 
-  m_lm->vocab_->MakeClosed();
-  return res;
+#ifdef WITH_THREADS
+  boost::mutex::scoped_lock lock(m_updateLock);
+#endif
+  // copy, update and publish; readers keep using the old snapshot meanwhile
+  boost::shared_ptr<Snapshot> next(new Snapshot(*GetSnapshot()));
+  boost::shared_ptr<CountMap> counts(new CountMap);
+  boost::shared_ptr<WordMap::Map> newWords(new WordMap::Map);
+  boost::shared_ptr<NGramList> changed(new NGramList);
+  FactorCollection &factorCollection = FactorCollection::Instance();
+  size_t applied = 0;
+  for(size_t order = 1; order <= m_nGramOrder; ++order) {
+    for(size_t i = 0; i < ngrams.size(); ++i) {
+      const std::vector<string> &ngram = ngrams[i].first;
+      if(ngram.size() != order) continue;
+      std::vector<wordID_t> ids(order);
+      for(size_t j = 0; j < order; ++j) {
+        ids[j] = GetUpdateID(ngram[j]);
+        const Factor *factor = factorCollection.AddFactor(Output, m_factorType, ngram[j]);
+        if(GetLmID(factor, *next) == m_oov_id && ids[j] != m_oov_id)
+          (*newWords)[factor->GetId()] = ids[j];
+      }
+      if(m_lm->update(&ids[0], order, ngrams[i].second, *counts, next->counts)) {
+        changed->push_back(ids);
+        ++applied;
+      }
+    }
+  }
+  next->counts.add(counts);
+  next->newWords.add(newWords);
+  ++next->version;
+  next->changes.push_back(changed);
+  while(next->changes.size() > kMaxChanges)
+    next->changes.pop_front();
+  {
+#ifdef WITH_THREADS
+    boost::mutex::scoped_lock lock(m_snapshotLock);
+#endif
+    m_snapshot = next;
+  }
+  return applied;
 }
 }
@@ -1,11 +1,21 @@
 #pragma once
 
+#include <deque>
 #include <string>
 #include <vector>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/unordered_map.hpp>
+#ifdef WITH_THREADS
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/tss.hpp>
+#endif
+
 #include "Factor.h"
 #include "Util.h"
 #include "LM/SingleFactor.h"
 #include "DynSAInclude/onlineRLM.h"
+#include "DynSAInclude/LayeredMap.h"
 //#include "multiOnlineRLM.h"
 #include "DynSAInclude/FileHandler.h"
 #include "DynSAInclude/vocab.h"
@@ -16,36 +26,77 @@ class Factor;
 class Phrase;
 
 /** @todo ask ollie
+ *
+ * Updates (UpdateORLM) may be made while other threads decode.  They are
+ * recorded in a copy of the current Snapshot of updated counts, which is then
+ * published; each decoding thread picks up the latest snapshot at the start
+ * of a sentence, so readers never wait for an update.  The counts and new
+ * words of a snapshot are LayeredMaps, so a new snapshot shares them with the
+ * old one instead of copying them.  Words new to the model are numbered by
+ * the updater and only added to the vocabulary, which the filter's readers
+ * use, when the model is saved.  Each thread keeps its own probability cache
+ * across sentences and drops only the entries that depend on ngrams changed
+ * since its last snapshot.
  */
 class LanguageModelORLM : public LanguageModelPointerState {
 public:
   typedef count_t T;  // type for ORLM filter
   LanguageModelORLM()
-    : m_lm(0) {}
+    : m_lm(0), m_firstNewWordId(0) {}
   bool Load(const std::string &filePath, FactorType factorType, size_t nGramOrder);
   virtual LMResult GetValue(const std::vector<const Word*> &contextFactor, State* finalState = NULL) const;
-  ~LanguageModelORLM() {
-    //save LM with markings
-    Utils::rtrim(m_filePath, ".gz");
-    FileHandler fout(m_filePath + ".marked.gz", std::ios::out|std::ios::binary, false);
-    m_lm->save(&fout);
-    fout.close();
-    delete m_lm;
-  }
-  void CleanUpAfterSentenceProcessing() {m_lm->clearCache();} // clear caches
-  void InitializeBeforeSentenceProcessing() { // nothing to do
-    //m_lm->initThreadSpecificData(); // Creates thread specific data iff
-                                    // compiled with multithreading.
-  }
+  ~LanguageModelORLM();
+  void CleanUpAfterSentenceProcessing();
+  void InitializeBeforeSentenceProcessing();
   bool UpdateORLM(const std::vector<string>& ngram, const int value);
+  //! apply several updates at once, lower orders first; returns the number applied
+  size_t UpdateORLM(const std::vector<std::pair<std::vector<string>, int> >& ngrams);
  protected:
+  typedef OnlineRLM<T>::CountMap CountMap;
+  typedef OnlineRLM<T>::UpdatedCounts UpdatedCounts;
+  typedef LayeredMap<size_t, wordID_t> WordMap;
+  typedef std::vector<std::vector<wordID_t> > NGramList;
+
+  struct Snapshot {
+    size_t version;
+    UpdatedCounts counts;  // counts of all ngrams updated since loading
+    WordMap newWords;  // factor id -> word id of words added since loading
+    // ngrams changed by each of the last versions, oldest first
+    std::deque<boost::shared_ptr<const NGramList> > changes;
+    Snapshot() : version(0) {}
+  };
+  typedef boost::shared_ptr<const Snapshot> SnapshotPtr;
+
+  struct ThreadData {
+    SnapshotPtr snapshot;
+    randlm::Cache<float> cache;
+    ThreadData() : cache(8888.8888, 9999.9999) {} // unknown_value, null_value
+  };
+
   OnlineRLM<T>* m_lm;
   //MultiOnlineRLM<T>* m_lm;
   wordID_t m_oov_id;
   std::vector<wordID_t> lm_ids_vec_;
+
+  SnapshotPtr m_snapshot;
+  // words added since loading, numbered after the vocabulary's
+  boost::unordered_map<std::string, wordID_t> m_newWordIds;
+  std::vector<std::string> m_newWordStrings;
+  wordID_t m_firstNewWordId;
+#ifdef WITH_THREADS
+  mutable boost::mutex m_snapshotLock;  // guards m_snapshot, only for a pointer copy
+  boost::mutex m_updateLock;
+  mutable boost::thread_specific_ptr<ThreadData> m_threadData;
+#else
+  mutable std::auto_ptr<ThreadData> m_threadData;
+#endif
+
   void CreateFactors();
   wordID_t GetLmID(const std::string &str) const;
-  wordID_t GetLmID(const Factor *factor) const;
+  wordID_t GetLmID(const Factor *factor, const Snapshot &snapshot) const;
+  wordID_t GetUpdateID(const std::string &str);
+  SnapshotPtr GetSnapshot() const;
+  ThreadData &GetThreadData() const;
 };
 } // end namespace
 
@@ -1,13 +1,25 @@
+#include <errno.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <arpa/inet.h>
 #include <netdb.h>
 #include "LM/Remote.h"
 #include "Factor.h"
+#include "Hypothesis.h"
+#include "Phrase.h"
+#include "Util.h"
+
+#include "util/murmur_hash.hh"
+
+#ifdef WITH_THREADS
+#include <boost/thread/locks.hpp>
+#endif
 
 namespace Moses
 {
@@ -15,6 +27,54 @@ namespace Moses
 const Factor* LanguageModelRemote::BOS = NULL;
 const Factor* LanguageModelRemote::EOS = (LanguageModelRemote::BOS + 1);
 
+namespace
+{
+
+void WriteAll(int sock, const std::string &data)
+{
+  size_t done = 0;
+  while (done < data.size()) {
+    ssize_t w = write(sock, data.data() + done, data.size() - done);
+    if (w < 0) {
+      if (errno == EINTR) continue;
+      perror("write to lm server failed");
+      exit(1);
+    }
+    done += w;
+  }
+}
+
+void ReadAll(int sock, char *buf, size_t size)
+{
+  size_t done = 0;
+  while (done < size) {
+    ssize_t r = read(sock, buf + done, size - done);
+    if (r < 0) {
+      if (errno == EINTR) continue;
+      perror("read from lm server failed");
+      exit(1);
+    }
+    if (r == 0) {
+      std::cerr << "lm server closed the connection" << std::endl;
+      exit(1);
+    }
+    done += r;
+  }
+}
+
+}
+
+std::size_t LanguageModelRemote::NGramHash::operator()(const NGram &ngram) const
+{
+  return util::MurmurHashNative(&ngram[0], ngram.size() * sizeof(const Factor*));
+}
+
+LanguageModelRemote::Connection::~Connection()
+{
+  // Step 8 When finished send all lingering transmissions and close the connection
+  if (sock >= 0) close(sock);
+}
+
 bool LanguageModelRemote::Load(const std::string &filePath
                                , FactorType factorType
                                , size_t nGramOrder)
@@ -23,43 +83,214 @@ bool LanguageModelRemote::Load(const std::string &filePath
   m_nGramOrder    = nGramOrder;
 
   int cutAt = filePath.find(':',0);
-  std::string host = filePath.substr(0,cutAt);
+  m_host = filePath.substr(0,cutAt);
   //std::cerr << "port string = '" << filePath.substr(cutAt+1,filePath.size()-cutAt) << "'\n";
-  int port = atoi(filePath.substr(cutAt+1,filePath.size()-cutAt).c_str());
-  bool good = start(host,port);
-  if (!good) {
-    std::cerr << "failed to connect to lm server on " << host << " on port " << port << std::endl;
-  }
-  ClearSentenceCache();
-  return good;
-}
+  m_port = atoi(filePath.substr(cutAt+1,filePath.size()-cutAt).c_str());
 
-
-bool LanguageModelRemote::start(const std::string& host, int port)
-{
-  //std::cerr << "host = " << host << ", port = " << port << "\n";
-  sock = socket(AF_INET, SOCK_STREAM, 0);
-  hp = gethostbyname(host.c_str());
+  struct hostent *hp = gethostbyname(m_host.c_str());
   if (hp==NULL) {
     herror("gethostbyname failed");
     exit(1);
   }
+  bzero((char *)&m_server, sizeof(m_server));
+  bcopy(hp->h_addr, (char *)&m_server.sin_addr, hp->h_length);
+  m_server.sin_family = hp->h_addrtype;
+  m_server.sin_port = htons(m_port);
+
+  std::auto_ptr<Connection> connection(new Connection);
+  if (!Connect(*connection)) {
+    std::cerr << "failed to connect to lm server on " << m_host << " on port " << m_port << std::endl;
+    return false;
+  }
+
+  // Check that the server understands batched requests.  A server that does
+  // not answers "ERROR\r\n" rather than a float and "\r\n".
+  WriteAll(connection->sock, "probs\t</s>\n");
+  char res[6];
+  ReadAll(connection->sock, res, sizeof(res));
+  if (memcmp(res, "ERROR\r", sizeof(res)) == 0) {
+    std::cerr << "lm server on " << m_host << " on port " << m_port
+              << " does not support batched requests; please update it" << std::endl;
+    return false;
+  }
+
+  m_connection.reset(connection.release());
+  ClearSentenceCache();
+  return true;
+}
 
-  bzero((char *)&server, sizeof(server));
-  bcopy(hp->h_addr, (char *)&server.sin_addr, hp->h_length);
-  server.sin_family = hp->h_addrtype;
-  server.sin_port = htons(port);
+bool LanguageModelRemote::Connect(Connection &connection) const
+{
+  connection.sock = socket(AF_INET, SOCK_STREAM, 0);
+  if (connection.sock < 0) {
+    perror("socket failed");
+    return false;
+  }
 
   int errors = 0;
-  while (connect(sock, (struct sockaddr *)&server, sizeof(server)) < 0) {
+  while (connect(connection.sock, (struct sockaddr *)&m_server, sizeof(m_server)) < 0) {
     //std::cerr << "Error: connect()\n";
     sleep(1);
     errors++;
     if (errors > 5) return false;
   }
+
+  // Requests are small and answered one batch at a time; don't let Nagle's
+  // algorithm hold them back.
+  int flag = 1;
+  setsockopt(connection.sock, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
   return true;
 }
 
+LanguageModelRemote::Connection &LanguageModelRemote::GetConnection() const
+{
+  Connection *connection = m_connection.get();
+  if (connection == NULL) {
+    connection = new Connection;
+    m_connection.reset(connection);
+    if (!Connect(*connection)) {
+      std::cerr << "failed to connect to lm server on " << m_host << " on port " << m_port << std::endl;
+      exit(1);
+    }
+  }
+  return *connection;
+}
+
+void LanguageModelRemote::ClearSentenceCache()
+{
+#ifdef WITH_THREADS
+  boost::unique_lock<boost::shared_mutex> lock(m_cacheLock);
+#endif
+  m_cache.clear();
+}
+
+void LanguageModelRemote::MakeNGram(const std::vector<const Word*> &contextFactor, NGram &ngram) const
+{
+  const FactorType factor = GetFactorType();
+  const size_t count = contextFactor.size();
+  const size_t len = std::min(count, m_nGramOrder);
+  ngram.resize(len);
+  for (size_t i = 0; i + 1 < len; ++i) {
+    const Factor* f = contextFactor[count - len + i]->GetFactor(factor);
+    ngram[i] = f ? f : BOS;
+  }
+  const Factor* event_word = contextFactor[count - 1]->GetFactor(factor);
+  ngram[len - 1] = event_word ? event_word : EOS;
+}
+
+bool LanguageModelRemote::LookUp(const NGram &ngram, float &prob) const
+{
+#ifdef WITH_THREADS
+  boost::shared_lock<boost::shared_mutex> lock(m_cacheLock);
+#endif
+  ResultMap::const_iterator iter = m_cache.find(ngram);
+  if (iter == m_cache.end()) return false;
+  prob = iter->second;
+  return true;
+}
+
+void LanguageModelRemote::Request(Connection &connection, const NGram &ngram) const
+{
+  if (connection.synced) {
+    // A new round of requests: the answers of the previous one have been used.
+    connection.lastResults.clear();
+    connection.synced = false;
+  }
+  if (!connection.pending.insert(ngram).second) return;
+  connection.batch.push_back(ngram);
+  if (connection.batch.size() >= kMaxBatchSize) {
+    Send(connection);
+  }
+}
+
+void LanguageModelRemote::Send(Connection &connection) const
+{
+  if (connection.batch.empty()) return;
+
+  // Bound the number of unanswered n-grams so the server never blocks on a
+  // full socket while we are still writing.
+  while (!connection.inFlight.empty() &&
+         connection.numInFlight + connection.batch.size() > kMaxInFlight) {
+    Receive(connection);
+  }
+
+  std::string out = "probs";
+  for (size_t i = 0; i < connection.batch.size(); ++i) {
+    const NGram &ngram = connection.batch[i];
+    out += '\t';
+    const Factor* event_word = ngram.back();
+    out += (event_word == EOS) ? "</s>" : event_word->GetString();
+    for (size_t j = ngram.size() - 1; j-- > 0; ) {
+      out += ' ';
+      out += (ngram[j] == BOS) ? "<s>" : ngram[j]->GetString();
+    }
+  }
+  out += '\n';
+  WriteAll(connection.sock, out);
+
+  connection.numInFlight += connection.batch.size();
+  connection.inFlight.push_back(std::vector<NGram>());
+  connection.inFlight.back().swap(connection.batch);
+}
+
+void LanguageModelRemote::Receive(Connection &connection) const
+{
+  std::vector<NGram> &batch = connection.inFlight.front();
+  std::vector<char> res(batch.size() * sizeof(float) + 2);
+  ReadAll(connection.sock, &res[0], res.size());
+  if (res[res.size() - 2] != '\r' || res[res.size() - 1] != '\n') {
+    std::cerr << "malformed answer from lm server" << std::endl;
+    exit(1);
+  }
+
+  std::vector<float> probs(batch.size());
+  for (size_t i = 0; i < batch.size(); ++i) {
+    float raw;
+    memcpy(&raw, &res[i * sizeof(float)], sizeof(float));
+    probs[i] = FloorScore(TransformLMScore(raw));
+    connection.lastResults[batch[i]] = probs[i];
+    connection.pending.erase(batch[i]);
+  }
+
+  {
+#ifdef WITH_THREADS
+    boost::unique_lock<boost::shared_mutex> lock(m_cacheLock);
+#endif
+    if (m_cache.size() + batch.size() > kMaxCacheSize) m_cache.clear();
+    for (size_t i = 0; i < batch.size(); ++i) {
+      m_cache[batch[i]] = probs[i];
+    }
+  }
+
+  connection.numInFlight -= batch.size();
+  connection.inFlight.pop_front();
+}
+
+void LanguageModelRemote::Sync(Connection &connection) const
+{
+  Send(connection);
+  while (!connection.inFlight.empty()) {
+    Receive(connection);
+  }
+  connection.synced = true;
+}
+
+void LanguageModelRemote::RequestNGrams(const std::vector<const Word*> &words, size_t begin) const
+{
+  Connection &connection = GetConnection();
+  std::vector<const Word*> contextFactor;
+  NGram ngram;
+  float prob;
+  for (size_t i = begin; i < words.size(); ++i) {
+    const size_t start = (i + 1 > m_nGramOrder) ? i + 1 - m_nGramOrder : 0;
+    contextFactor.assign(words.begin() + start, words.begin() + i + 1);
+    MakeNGram(contextFactor, ngram);
+    if (!LookUp(ngram, prob)) {
+      Request(connection, ngram);
+    }
+  }
+}
+
 LMResult LanguageModelRemote::GetValue(const std::vector<const Word*> &contextFactor, State* finalState) const
 {
   LMResult ret;
@@ -71,74 +302,89 @@ LMResult LanguageModelRemote::GetValue(const std::vector<const Word*> &contextFa
     return ret;
   }
   //std::cerr << "contextFactor.size() = " << count << "\n";
-  size_t max = m_nGramOrder;
-  const FactorType factor = GetFactorType();
-  if (max > count) max = count;
-
-  Cache* cur = &m_cache;
-  int pc = static_cast<int>(count) - 1;
-  for (int i = 0; i < pc; ++i) {
-    const Factor* f = contextFactor[i]->GetFactor(factor);
-    cur = &cur->tree[f ? f : BOS];
-  }
-  const Factor* event_word = contextFactor[pc]->GetFactor(factor);
-  cur = &cur->tree[event_word ? event_word : EOS];
-  if (cur->prob) {
-    if (finalState) *finalState = cur->boState;
-    ret.score = cur->prob;
-    return ret;
+
+  NGram ngram;
+  MakeNGram(contextFactor, ngram);
+  if (!LookUp(ngram, ret.score)) {
+    Connection &connection = GetConnection();
+    ResultMap::const_iterator iter = connection.lastResults.find(ngram);
+    if (iter == connection.lastResults.end()) {
+      Request(connection, ngram);
+      Sync(connection);
+      iter = connection.lastResults.find(ngram);
+    }
+    ret.score = iter->second;
   }
-  cur->boState = *reinterpret_cast<const State*>(&m_curId);
-  ++m_curId;
 
-  std::ostringstream os;
-  os << "prob ";
-  if (event_word == NULL) {
-    os << "</s>";
-  } else {
-    os << event_word->GetString();
+  // Every n-gram is its own state, as before; the hash stands in for it.
+  if (finalState) {
+    *finalState = reinterpret_cast<State>(NGramHash()(ngram) | 1);
   }
-  for (size_t i=1; i<max; i++) {
-    const Factor* f = contextFactor[count-1-i]->GetFactor(factor);
-    if (f == NULL) {
-      os << " <s>";
+  return ret;
+}
+
+void LanguageModelRemote::CalcScore(const Phrase &phrase, float &fullScore, float &ngramScore, size_t &oovCount) const
+{
+  // Send the n-grams of each run of terminals in one go.
+  std::vector<const Word*> words;
+  for (size_t pos = 0; pos < phrase.GetSize(); ++pos) {
+    const Word &word = phrase.GetWord(pos);
+    if (word.IsNonTerminal()) {
+      RequestNGrams(words, 0);
+      words.clear();
     } else {
-      os << ' ' << f->GetString();
+      words.push_back(&word);
     }
   }
-  os << std::endl;
-  std::string out = os.str();
-  write(sock, out.c_str(), out.size());
-  char res[6];
-  int r = read(sock, res, 6);
-  int errors = 0;
-  int cnt = 0;
-  while (1) {
-    if (r < 0) {
-      errors++;
-      sleep(1);
-      //std::cerr << "Error: read()\n";
-      if (errors > 5) exit(1);
-    } else if (r==0 || res[cnt] == '\n') {
-      break;
-    } else {
-      cnt += r;
-      if (cnt==6) break;
-      read(sock, &res[cnt], 6-cnt);
-    }
+  RequestNGrams(words, 0);
+  sync();
+
+  LanguageModelImplementation::CalcScore(phrase, fullScore, ngramScore, oovCount);
+}
+
+void LanguageModelRemote::IssueRequestsFor(const Hypothesis &hypo) const
+{
+  // The same n-grams as LanguageModelImplementation::Evaluate.
+  if (GetNGramOrder() <= 1 || hypo.GetCurrTargetLength() == 0)
+    return;
+
+  const size_t currEndPos = hypo.GetCurrTargetWordsRange().GetEndPos();
+  const size_t startPos = hypo.GetCurrTargetWordsRange().GetStartPos();
+  const size_t endPos = std::min(startPos + GetNGramOrder() - 2, currEndPos);
+
+  std::vector<const Word*> words;
+  for (int currPos = (int) startPos - (int) GetNGramOrder() + 1 ; currPos <= (int) endPos ; currPos++) {
+    words.push_back(currPos >= 0 ? &hypo.GetWord(currPos) : &GetSentenceStartArray());
   }
-  cur->prob = FloorScore(TransformLMScore(*reinterpret_cast<float*>(res)));
-  if (finalState) {
-    *finalState = cur->boState;
+  RequestNGrams(words, GetNGramOrder() - 1);
+
+  if (hypo.IsSourceCompleted()) {
+    const size_t size = hypo.GetSize();
+    words.clear();
+    for (size_t i = 0 ; i < GetNGramOrder() - 1 ; i ++) {
+      int currPos = (int)(size - GetNGramOrder() + i + 1);
+      words.push_back(currPos >= 0 ? &hypo.GetWord((size_t)currPos) : &GetSentenceStartArray());
+    }
+    words.push_back(&GetSentenceEndArray());
+    RequestNGrams(words, GetNGramOrder() - 1);
   }
-  ret.score = cur->prob;
-  return ret;
+}
+
+void LanguageModelRemote::sync() const
+{
+  Sync(GetConnection());
+}
+
+FFState *LanguageModelRemote::Evaluate(const Hypothesis &hypo, const FFState *ps, ScoreComponentCollection *out, const LanguageModel *feature) const
+{
+  // Nothing is sent if the batch search already issued these n-grams.
+  IssueRequestsFor(hypo);
+  sync();
+  return LanguageModelImplementation::Evaluate(hypo, ps, out, feature);
 }
 
 LanguageModelRemote::~LanguageModelRemote()
 {
-  // Step 8 When finished send all lingering transmissions and close the connection
-  close(sock);
 }
 
 }
@@ -4,43 +4,108 @@
 #include "LM/SingleFactor.h"
 #include "TypeDef.h"
 #include "Factor.h"
+#include <deque>
+#include <memory>
 #include <sys/socket.h>
 #include <sys/types.h>
 #include <netinet/in.h>
 
+#include <boost/unordered_map.hpp>
+#include <boost/unordered_set.hpp>
+
+#ifdef WITH_THREADS
+#include <boost/thread/shared_mutex.hpp>
+#include <boost/thread/tss.hpp>
+#endif
+
 namespace Moses
 {
 
-/** @todo ask miles
+/** Language model queried over a socket from an lmserver (contrib/lmserver,
+ *  or misc/lmServerKen for testing), given as host:port in moses.ini.
+ *
+ *  N-grams are sent in batches ("probs" messages), several of which may be
+ *  in flight at a time on each decoding thread's connection.  Answers go into
+ *  a cache shared by all threads and kept across sentences.  With the batch
+ *  search algorithm (-search-algorithm 4) the n-grams of all hypothesis
+ *  expansions are issued before any answer is waited for.
  */
 class LanguageModelRemote : public LanguageModelPointerState
 {
+public:
+  //! n-gram as factor pointers, oldest word first
+  typedef std::vector<const Factor*> NGram;
+
+  struct NGramHash : public std::unary_function<const NGram&, std::size_t> {
+    std::size_t operator()(const NGram &ngram) const;
+  };
+
+  //! maximum number of n-grams in one request
+  static const size_t kMaxBatchSize = 256;
+  //! maximum number of unanswered n-grams per connection
+  static const size_t kMaxInFlight = 8192;
+  //! the shared cache is emptied when it grows beyond this
+  static const size_t kMaxCacheSize = 4000000;
+
 private:
-  struct Cache {
-    std::map<const Factor*, Cache> tree;
-    float prob;
-    State boState;
-    Cache() : prob(0) {}
+  typedef boost::unordered_map<NGram, float, NGramHash> ResultMap;
+
+  // One connection per decoding thread.  The server answers requests in the
+  // order they were sent.
+  struct Connection {
+    int sock;
+    std::vector<NGram> batch;                  // not yet sent
+    std::deque<std::vector<NGram> > inFlight;  // sent, waiting for answers
+    size_t numInFlight;
+    boost::unordered_set<NGram, NGramHash> pending;
+    ResultMap lastResults;  // answers to the current round of requests
+    bool synced;
+    Connection() : sock(-1), numInFlight(0), synced(false) {}
+    ~Connection();
   };
 
-  int sock, port;
-  struct hostent *hp;
-  struct sockaddr_in server;
-  mutable size_t m_curId;
-  mutable Cache m_cache;
-  bool start(const std::string& host, int port);
+  std::string m_host;
+  int m_port;
+  struct sockaddr_in m_server;
+
+#ifdef WITH_THREADS
+  mutable boost::thread_specific_ptr<Connection> m_connection;
+  mutable boost::shared_mutex m_cacheLock;
+#else
+  mutable std::auto_ptr<Connection> m_connection;
+#endif
+  mutable ResultMap m_cache;
+
   static const Factor* BOS;
   static const Factor* EOS;
+
+  bool Connect(Connection &connection) const;
+  Connection &GetConnection() const;
+  void MakeNGram(const std::vector<const Word*> &contextFactor, NGram &ngram) const;
+  bool LookUp(const NGram &ngram, float &prob) const;
+  void Request(Connection &connection, const NGram &ngram) const;
+  void Send(Connection &connection) const;
+  void Receive(Connection &connection) const;
+  void Sync(Connection &connection) const;
+  void RequestNGrams(const std::vector<const Word*> &words, size_t begin) const;
+
 public:
+  LanguageModelRemote() : m_port(0) {}
   ~LanguageModelRemote();
-  void ClearSentenceCache() {
-    m_cache.tree.clear();
-    m_curId = 1000;
-  }
+  void ClearSentenceCache();
   virtual LMResult GetValue(const std::vector<const Word*> &contextFactor, State* finalState = 0) const;
   bool Load(const std::string &filePath
             , FactorType factorType
             , size_t nGramOrder);
+
+  void CalcScore(const Phrase &phrase, float &fullScore, float &ngramScore, size_t &oovCount) const;
+  FFState *Evaluate(const Hypothesis &hypo, const FFState *ps, ScoreComponentCollection *out, const LanguageModel *feature) const;
+
+  bool UsesBatchedRequests() const {
+    return true;
+  }
+  void IssueRequestsFor(const Hypothesis &hypo) const;
+  void sync() const;
 };
 
 }
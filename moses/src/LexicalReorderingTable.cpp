@@ -1,5 +1,6 @@
 #include "LexicalReorderingTable.h"
 #include "InputFileStream.h"
+#include "InputFilter.h"
 //#include "LVoc.h" //need IPhrase
 
 #include "StaticData.h"
@@ -168,8 +169,13 @@ void  LexicalReorderingTableMemory::LoadFromFile(const std::string& filePath)
   InputFileStream file(fileName);
   std::string line(""), key("");
   int numScores = -1;
+  const InputFilter *inputFilter = StaticData::Instance().GetInputFilter();
   std::cerr << "Loading table into memory...";
   while(!getline(file, line).eof()) {
+    if (inputFilter && !m_FactorsF.empty()
+        && !inputFilter->Matches(line.substr(0, line.find("|||")), m_FactorsF[0])) {
+      continue;
+    }
     std::vector<std::string> tokens = TokenizeMultiCharSeparator(line, "|||");
     int t = 0 ;
     std::string f(""),e(""),c("");
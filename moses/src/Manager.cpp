@@ -39,6 +39,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include "LMList.h"
 #include "TranslationOptionCollection.h"
 #include "DummyScoreProducers.h"
+#include "BinarySearchGraph.h"
 #ifdef HAVE_PROTOBUF
 #include "hypergraph.pb.h"
 #include "rule.pb.h"
@@ -896,6 +897,52 @@ void Manager::OutputSearchGraph(long translationId, std::ostream &outputSearchGr
   }
 }
 
+//! the same hypotheses as OutputSearchGraph(), as one binary record
+void Manager::OutputSearchGraphBinary(long translationId, std::ostream &outputSearchGraphStream) const
+{
+  vector<SearchGraphNode> searchGraph;
+  GetSearchGraph(searchGraph);
+
+  const vector<FactorType> &outputFactorOrder = StaticData::Instance().GetOutputFactorOrder();
+  BinarySearchGraphWriter writer(BinarySearchGraphHeader::PhraseBased, translationId);
+  BinarySearchGraphNode node;
+  for (size_t i = 0; i < searchGraph.size(); ++i) {
+    const SearchGraphNode &searchNode = searchGraph[i];
+    const Hypothesis &hypo = *searchNode.hypo;
+    const Hypothesis *prevHypo = hypo.GetPrevHypo();
+
+    node.id = hypo.GetId();
+    node.winner = (searchNode.recombinationHypo != NULL) ? searchNode.recombinationHypo->GetId() : -1;
+    node.back.clear();
+    node.stack = hypo.GetWordsBitmap().GetNumWordsCovered();
+    node.forward = searchNode.forward;
+    node.fscore = searchNode.fscore;
+    node.score = hypo.GetScore();
+    const ScoreComponentCollection &scoreBreakdown = hypo.GetScoreBreakdown();
+    node.scores.resize(scoreBreakdown.size());
+    for (size_t j = 0; j < scoreBreakdown.size(); ++j) {
+      node.scores[j] = scoreBreakdown[j];
+    }
+
+    if (prevHypo == NULL) {
+      // initial hypothesis
+      node.startPos = node.endPos = 0;
+      node.rule = writer.AddRule(NULL, "", "");
+    } else {
+      node.back.push_back(prevHypo->GetId());
+      node.startPos = hypo.GetCurrSourceWordsRange().GetStartPos();
+      node.endPos = hypo.GetCurrSourceWordsRange().GetEndPos();
+      const TranslationOption *transOpt = &hypo.GetTranslationOption();
+      if (!writer.FindRule(transOpt, node.rule)) {
+        node.rule = writer.AddRule(transOpt, hypo.GetSourcePhraseStringRep(),
+                                   hypo.GetCurrTargetPhrase().GetStringRep(outputFactorOrder));
+      }
+    }
+    writer.AddNode(node);
+  }
+  writer.Write(outputSearchGraphStream);
+}
+
 void Manager::GetForwardBackwardSearchGraph(std::map< int, bool >* pConnected,
     std::vector< const Hypothesis* >* pConnectedList, std::map < const Hypothesis*, set< const Hypothesis* > >* pOutgoingHyps, vector< float>* pFwdBwdScores) const
 {
@@ -35,6 +35,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include "WordsBitmap.h"
 #include "Search.h"
 #include "SearchCubePruning.h"
+#include "Deadline.h"
 
 namespace Moses
 {
@@ -105,6 +106,7 @@ protected:
   size_t interrupted_flag;
   std::auto_ptr<SentenceStats> m_sentenceStats;
   int m_hypoId; //used to number the hypos as they are created.
+  Deadline m_deadline; /**< time allowed for this sentence */
 
   void GetConnectedGraph(
     std::map< int, bool >* pConnected,
@@ -138,6 +140,7 @@ public:
 #endif
 
   void OutputSearchGraph(long translationId, std::ostream &outputSearchGraphStream) const;
+  void OutputSearchGraphBinary(long translationId, std::ostream &outputSearchGraphStream) const;
   void GetSearchGraph(std::vector<SearchGraphNode>& searchGraph) const;
   const InputType& GetSource() const {
     return m_source;
@@ -149,6 +152,9 @@ public:
   void CalcDecoderStatistics() const;
   void ResetSentenceStats(const InputType& source);
   SentenceStats& GetSentenceStats() const;
+  Deadline& GetDeadline() {
+    return m_deadline;
+  }
 
   /***
    *For Lattice MBR
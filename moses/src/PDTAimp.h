@@ -35,7 +35,8 @@ class PDTAimp
 protected:
   PDTAimp(PhraseDictionaryTreeAdaptor *p,unsigned nis)
     : m_languageModels(0),m_weightWP(0.0),m_dict(0),
-      m_obj(p),useCache(1),m_numInputScores(nis),totalE(0),distinctE(0) {}
+      m_obj(p),useCache(1),m_numInputScores(nis),m_numLMEstimates(0),
+      m_useLMEstimates(false),totalE(0),distinctE(0) {}
 
 public:
   std::vector<float> m_weights;
@@ -54,6 +55,11 @@ public:
   std::vector<vTPC> m_rangeCache;
   unsigned m_numInputScores;
 
+  // LM estimates stored after the scores of each target phrase, and whether
+  // they are for the LMs of the system
+  size_t m_numLMEstimates;
+  bool m_useLMEstimates;
+
   UniqueObjectManager<Phrase> uniqSrcPhr;
 
   size_t totalE,distinctE;
@@ -152,13 +158,14 @@ public:
       StringTgtCand::first_type const& factorStrings=cands[i].first;
       StringTgtCand::second_type const& probVector=cands[i].second;
 
-      std::vector<float> scoreVector(probVector.size());
-      std::transform(probVector.begin(),probVector.end(),scoreVector.begin(),
+      std::vector<float> scoreVector(probVector.size()-m_numLMEstimates);
+      std::transform(probVector.begin(),probVector.begin()+scoreVector.size(),scoreVector.begin(),
                      TransformScore);
       std::transform(scoreVector.begin(),scoreVector.end(),scoreVector.begin(),
                      FloorScore);
       //CreateTargetPhrase(targetPhrase,factorStrings,scoreVector,&src);
-      CreateTargetPhrase(targetPhrase,factorStrings,scoreVector,wacands[i],&src);
+      CreateTargetPhrase(targetPhrase,factorStrings,scoreVector,
+                         GetLMEstimates(probVector,scoreVector.size()),wacands[i],&src);
       costs.push_back(std::make_pair(-targetPhrase.GetFutureScore(),tCands.size()));
       tCands.push_back(targetPhrase);
     }
@@ -214,6 +221,25 @@ public:
       UserMessage::Add(strme.str());
       exit(1);
     }
+
+    // the stored LM estimates are used only if they were computed with
+    // the same LMs, in the same order
+    const std::vector<std::string> &lmKeys=m_dict->GetLMEstimateKeys();
+    m_numLMEstimates=3*lmKeys.size();
+    if(lmKeys.size()) {
+      m_useLMEstimates=(lmKeys.size()==languageModels.size());
+      LMList::const_iterator lm=languageModels.begin();
+      for(size_t i=0; m_useLMEstimates && i<lmKeys.size(); ++i, ++lm)
+        m_useLMEstimates=(lmKeys[i]==staticData.GetLMFingerprint(*lm));
+      if(!m_useLMEstimates)
+        VERBOSE(1,"LM estimates of bin ttable " << filePath
+                << " are for other language models, ignoring them" << std::endl);
+    }
+  }
+
+  // the LM estimates of a target phrase, given its scores and where they end
+  const float *GetLMEstimates(std::vector<float> const& scores,size_t begin) const {
+    return m_useLMEstimates ? &scores[begin] : 0;
   }
 
   typedef PhraseDictionaryTree::PrefixPtr PPtr;
@@ -255,9 +281,10 @@ public:
   void CreateTargetPhrase(TargetPhrase& targetPhrase,
                           StringTgtCand::first_type const& factorStrings,
                           StringTgtCand::second_type const& scoreVector,
+                          const float *lmEstimates,
                           const std::string& alignmentString,
                           Phrase const* srcPtr=0) const {
-    CreateTargetPhrase(targetPhrase, factorStrings, scoreVector, srcPtr);
+    CreateTargetPhrase(targetPhrase, factorStrings, scoreVector, lmEstimates, srcPtr);
     targetPhrase.SetAlignmentInfo(alignmentString);
   }
 
@@ -265,6 +292,7 @@ public:
   void CreateTargetPhrase(TargetPhrase& targetPhrase,
                           StringTgtCand::first_type const& factorStrings,
                           StringTgtCand::second_type const& scoreVector,
+                          const float *lmEstimates,
                           Phrase const* srcPtr=0) const {
     FactorCollection &factorCollection = FactorCollection::Instance();
 
@@ -276,7 +304,7 @@ public:
         w[m_output[l]]= factorCollection.AddFactor(Output, m_output[l], factors[l]);
       }
     }
-    targetPhrase.SetScore(m_obj->GetFeature(), scoreVector, m_weights, m_weightWP, *m_languageModels);
+    targetPhrase.SetScore(m_obj->GetFeature(), scoreVector, m_weights, m_weightWP, *m_languageModels, lmEstimates);
     targetPhrase.SetSourcePhrase(srcPtr);
   }
 
@@ -305,15 +333,106 @@ public:
     return rv;
   }
 
-  // POD for target phrase scores
-  struct TScores {
+  // a target candidate of a range, found at the node of states[state]
+  struct Candidate {
+    StringTgtCand const* cand;
+    size_t state;
     float total;
-    StringTgtCand::second_type trans;
-    Phrase const* src;
 
-    TScores() : total(0.0),src(0) {}
+    Candidate(StringTgtCand const* c,size_t st,float t) : cand(c),state(st),total(t) {}
+    bool operator<(Candidate const& other) const {
+      return cand->first<other.cand->first;
+    }
   };
 
+  // weighted sum of the input scores of a path
+  float InputScore(std::vector<float> const& scores) const {
+    return std::inner_product(scores.begin(), scores.end(), m_weights.begin(), 0.0f);
+  }
+
+  // adds a path to those ending at the same position, or replaces the one
+  // at the same node if it has better input scores
+  void AddState(std::vector<State>& states,State const& state) const {
+    for(size_t i=0; i<states.size(); ++i) {
+      if(states[i].ptr==state.ptr) {
+        if(InputScore(states[i].scores)<InputScore(state.scores)) states[i]=state;
+        return;
+      }
+    }
+    states.push_back(state);
+  }
+
+  // collects the target candidates at the nodes of the paths over the
+  // range, keeps the best scoring one of each target phrase, and caches
+  // them; tcands and cands are buffers reused from range to range
+  void CacheRange(Position begin,Position end,std::vector<State> const& states,
+                  std::vector<std::vector<StringTgtCand> >& tcands,
+                  std::vector<Candidate>& cands) {
+    if(tcands.size()<states.size()) tcands.resize(states.size());
+    cands.clear();
+    for(size_t j=0; j<states.size(); ++j) {
+      tcands[j].clear();
+      // now, look up the target candidates (aprx. TargetPhraseCollection) for
+      // the current path through the CN
+      m_dict->GetTargetCandidates(states[j].ptr,tcands[j]);
+      totalE+=tcands[j].size();
+
+      const float inputScore=InputScore(states[j].scores);
+      for(size_t i=0; i<tcands[j].size(); ++i) {
+        StringTgtCand const& cand=tcands[j][i];
+        //tally up, logging the phrase table scores
+        float score=inputScore;
+        for(size_t k=0; k+m_numLMEstimates<cand.second.size(); ++k)
+          score+=TransformScore(cand.second[k])*m_weights[m_numInputScores+k];
+        //count word penalty
+        score-=cand.first.size() * m_weightWP;
+        cands.push_back(Candidate(&cand,j,score));
+      }
+    }
+    if(cands.empty()) return;
+
+    // the same target phrase may be found at several nodes
+    std::stable_sort(cands.begin(),cands.end());
+
+    std::vector<TargetPhrase> tCands;
+    std::vector<std::pair<float,size_t> > costs;
+    std::vector<Phrase const*> srcPtrs(states.size(),0);
+    for(size_t i=0, next; i<cands.size(); i=next) {
+      size_t best=i;
+      for(next=i+1; next<cands.size() && !(cands[i]<cands[next]); ++next)
+        if(cands[best].total<cands[next].total) best=next;
+      ++distinctE;
+
+      StringTgtCand const& cand=*cands[best].cand;
+      State const& state=states[cands[best].state];
+      Phrase const*& srcPtr=srcPtrs[cands[best].state];
+      if(!srcPtr) srcPtr=uniqSrcPhr(state.src);
+
+      //put input scores in first - already logged, just drop in directly
+      std::vector<float> nscores(state.scores);
+      //put in phrase table scores, logging as we insert
+      const size_t numScores=cand.second.size()-m_numLMEstimates;
+      nscores.resize(m_numInputScores+numScores,0.0f);
+      std::transform(cand.second.begin(),cand.second.begin()+numScores,nscores.begin() + m_numInputScores,TransformScore);
+      CHECK(nscores.size()==m_weights.size());
+
+      TargetPhrase targetPhrase(Output);
+      CreateTargetPhrase(targetPhrase,cand.first,nscores,
+                         GetLMEstimates(cand.second,numScores),srcPtr);
+      costs.push_back(std::make_pair(-targetPhrase.GetFutureScore(),tCands.size()));
+      tCands.push_back(targetPhrase);
+    }
+
+    TargetPhraseCollection *rv=PruneTargetCandidates(tCands,costs);
+    if(rv->IsEmpty())
+      delete rv;
+    else {
+      CHECK(m_rangeCache[begin][end-1]==0);
+      m_rangeCache[begin][end-1]=rv;
+      m_tgtColls.push_back(rv);
+    }
+  }
+
   void CacheSource(ConfusionNet const& src) {
     CHECK(m_dict);
     const size_t srcSize=src.GetSize();
@@ -350,113 +469,82 @@ public:
       TRACE_ERR("\n");
     }
 
-    typedef StringTgtCand::first_type sPhrase;
-    typedef std::map<StringTgtCand::first_type,TScores> E2Costs;
-
-    std::map<Range,E2Costs> cov2cand;
-    std::vector<State> stack;
-    for(Position i=0 ; i < srcSize ; ++i)
-      stack.push_back(State(i, i, m_dict->GetRoot(), std::vector<float>(m_numInputScores,0.0)));
-
-    while(!stack.empty()) {
-      State curr(stack.back());
-      stack.pop_back();
-
-      CHECK(curr.end()<srcSize);
-      const ConfusionNet::Column &currCol=src[curr.end()];
-      // in a given column, loop over all possibilities
-      for(size_t colidx=0; colidx<currCol.size(); ++colidx) {
-        const Word& w=currCol[colidx].first; // w=the i^th possibility in column colidx
+    // look up each word of the input in the vocabulary of the table once
+    std::vector<std::vector<LabelId> > labels(srcSize);
+    for(size_t i=0; i<srcSize; ++i) {
+      labels[i].reserve(src[i].size());
+      for(size_t colidx=0; colidx<src[i].size(); ++colidx) {
         std::string s;
-        Factors2String(w,s);
-        bool isEpsilon=(s=="" || s==EPSILON);
-
-        //assert that we have the right number of link params in this CN option
-        CHECK(currCol[colidx].second.size() >= m_numInputScores);
-
-        // do not start with epsilon (except at first position)
-        if(isEpsilon && curr.begin()==curr.end() && curr.begin()>0) continue;
-
-        // At a given node in the prefix tree, look to see if w defines an edge to
-        // another node (Extend).  Stay at the same node if w==EPSILON
-        PPtr nextP = (isEpsilon ? curr.ptr : m_dict->Extend(curr.ptr,s));
-
-        if(nextP) { // w is a word that should be considered
-          Range newRange(curr.begin(),curr.end()+src.GetColumnIncrement(curr.end(),colidx));
+        Factors2String(src[i][colidx].first,s);
+        labels[i].push_back(m_dict->GetSourceLabel(s));
+      }
+    }
 
-          //add together the link scores from the current state and the new arc
-          float inputScoreSum = 0;
-          std::vector<float> newInputScores(m_numInputScores,0.0);
-          if (m_numInputScores) {
-            std::transform(currCol[colidx].second.begin(), currCol[colidx].second.end(),
-                           curr.GetScores().begin(),
-                           newInputScores.begin(),
+    // The paths from each start position are extended column by column, so
+    // that all paths ending at a position are known before any is extended
+    // further. Paths that reach the same node of the prefix tree (the same
+    // source words) are merged, keeping the best input scores: they have the
+    // same target candidates and continuations.
+    m_rangeCache.resize(srcSize,vTPC(srcSize,0));
+    std::vector<std::vector<State> > statesAt(srcSize+1);
+    std::vector<std::vector<StringTgtCand> > tcands;
+    std::vector<Candidate> cands;
+    for(Position begin=0; begin<srcSize; ++begin) {
+      statesAt[begin].push_back(State(begin, begin, m_dict->GetRoot(), std::vector<float>(m_numInputScores,0.0)));
+
+      for(Position end=begin; end<=srcSize; ++end) {
+        std::vector<State> &states=statesAt[end];
+        if(states.empty()) continue;
+
+        if(end>begin)
+          CacheRange(begin,end,states,tcands,cands);
+
+        if(end==srcSize) {
+          states.clear();
+          continue;
+        }
+        const ConfusionNet::Column &currCol=src[end];
+        for(size_t j=0; j<states.size(); ++j) {
+          State const& curr=states[j];
+          //if the sum of the link scores is too low, then we won't expand this.
+          //TODO: dodgy! shouldn't we consider weights here? what about zero-weight params?
+          if(m_numInputScores && std::accumulate(curr.scores.begin(),curr.scores.end(),0.0)<=LOWEST_SCORE)
+            continue;
+
+          // in a given column, loop over all possibilities
+          for(size_t colidx=0; colidx<currCol.size(); ++colidx) {
+            const LabelId label=labels[end][colidx];
+            const bool isEpsilon=(label==Epsilon);
+
+            //assert that we have the right number of link params in this CN option
+            CHECK(currCol[colidx].second.size() >= m_numInputScores);
+
+            // do not start with epsilon (except at first position)
+            if(isEpsilon && curr.begin()==curr.end() && curr.begin()>0) continue;
+
+            // At a given node in the prefix tree, look to see if w defines an edge to
+            // another node (Extend).  Stay at the same node if w==EPSILON
+            PPtr nextP = m_dict->Extend(curr.ptr,label);
+            if(!nextP) continue;
+
+            const size_t newEnd=end+src.GetColumnIncrement(end,colidx);
+            ++exploredPaths[newEnd-begin];
+
+            State next(begin,newEnd,nextP,curr.scores);
+            //add together the link scores from the current state and the new arc
+            std::transform(next.scores.begin(), next.scores.end(),
+                           currCol[colidx].second.begin(),
+                           next.scores.begin(),
                            std::plus<float>());
+            next.src=curr.src;
+            if(!isEpsilon) next.src.AddWord(currCol[colidx].first);
 
-
-            //we need to sum up link weights (excluding realWordCount, which isn't in numLinkParams)
-            //if the sum is too low, then we won't expand this.
-            //TODO: dodgy! shouldn't we consider weights here? what about zero-weight params?
-            inputScoreSum = std::accumulate(newInputScores.begin(),newInputScores.begin()+m_numInputScores,0.0);
-          }
-
-          Phrase newSrc(curr.src);
-          if(!isEpsilon) newSrc.AddWord(w);
-          if(newRange.second<srcSize && inputScoreSum>LOWEST_SCORE) {
-            // if there is more room to grow, add a new state onto the queue
-            // to be explored that represents [begin, curEnd+)
-            stack.push_back(State(newRange,nextP,newInputScores));
-            stack.back().src=newSrc;
-          }
-
-          std::vector<StringTgtCand> tcands;
-          // now, look up the target candidates (aprx. TargetPhraseCollection) for
-          // the current path through the CN
-          m_dict->GetTargetCandidates(nextP,tcands);
-
-          if(newRange.second>=exploredPaths.size()+newRange.first)
-            exploredPaths.resize(newRange.second-newRange.first+1,0);
-          ++exploredPaths[newRange.second-newRange.first];
-
-          totalE+=tcands.size();
-
-          if(tcands.size()) {
-            E2Costs& e2costs=cov2cand[newRange];
-            Phrase const* srcPtr=uniqSrcPhr(newSrc);
-            for(size_t i=0; i<tcands.size(); ++i) {
-              //put input scores in first - already logged, just drop in directly
-              std::vector<float> nscores(newInputScores);
-
-              //resize to include phrase table scores
-              nscores.resize(m_numInputScores+tcands[i].second.size(),0.0f);
-
-              //put in phrase table scores, logging as we insert
-              std::transform(tcands[i].second.begin(),tcands[i].second.end(),nscores.begin() + m_numInputScores,TransformScore);
-
-              CHECK(nscores.size()==m_weights.size());
-
-              //tally up
-              float score=std::inner_product(nscores.begin(), nscores.end(), m_weights.begin(), 0.0f);
-
-              //count word penalty
-              score-=tcands[i].first.size() * m_weightWP;
-
-              std::pair<E2Costs::iterator,bool> p=e2costs.insert(std::make_pair(tcands[i].first,TScores()));
-
-              if(p.second) ++distinctE;
-
-              TScores & scores=p.first->second;
-              if(p.second || scores.total<score) {
-                scores.total=score;
-                scores.trans=nscores;
-                scores.src=srcPtr;
-              }
-            }
+            AddState(statesAt[newEnd],next);
           }
         }
+        states.clear();
       }
-    } // end while(!stack.empty())
-
+    }
 
     if (StaticData::Instance().GetVerboseLevel() >= 2 && exploredPaths.size()) {
       TRACE_ERR("CN (explored): ");
@@ -470,38 +558,6 @@ public:
     for(size_t len=1; len<=srcSize; ++len)
       pathExplored[len]+=exploredPaths[len];
 
-
-    m_rangeCache.resize(src.GetSize(),vTPC(src.GetSize(),0));
-
-    for(std::map<Range,E2Costs>::const_iterator i=cov2cand.begin(); i!=cov2cand.end(); ++i) {
-      CHECK(i->first.first<m_rangeCache.size());
-      CHECK(i->first.second>0);
-      CHECK(static_cast<size_t>(i->first.second-1)<m_rangeCache[i->first.first].size());
-      CHECK(m_rangeCache[i->first.first][i->first.second-1]==0);
-
-      std::vector<TargetPhrase> tCands;
-      tCands.reserve(i->second.size());
-      std::vector<std::pair<float,size_t> > costs;
-      costs.reserve(i->second.size());
-
-      for(E2Costs::const_iterator j=i->second.begin(); j!=i->second.end(); ++j) {
-        TScores const & scores=j->second;
-        TargetPhrase targetPhrase(Output);
-        CreateTargetPhrase(targetPhrase,j->first,scores.trans,scores.src);
-        costs.push_back(std::make_pair(-targetPhrase.GetFutureScore(),tCands.size()));
-        tCands.push_back(targetPhrase);
-        //std::cerr << i->first.first << "-" << i->first.second << ": " << targetPhrase << std::endl;
-      }
-
-      TargetPhraseCollection *rv=PruneTargetCandidates(tCands,costs);
-
-      if(rv->IsEmpty())
-        delete rv;
-      else {
-        m_rangeCache[i->first.first][i->first.second-1]=rv;
-        m_tgtColls.push_back(rv);
-      }
-    }
     // free memory
     m_dict->FreeMemory();
   }
@@ -48,6 +48,7 @@ Parameter::Parameter()
   AddParam("global-lexical-file", "gl", "discriminatively trained global lexical translation model file");
   AddParam("input-factors", "list of factors in the input");
   AddParam("input-file", "i", "location of the input file to be translated");
+  AddParam("filter-given-input", "fgi", "Load only the entries of text phrase, rule and reordering tables that can match the input file. (default = false)");
   AddParam("inputtype", "text (0), confusion network (1), word lattice (2) (default = 0)");
   AddParam("labeled-n-best-list", "print out labels for each weight type in n-best list. default is true");
   AddParam("include-alignment-in-n-best", "include word alignment in the n-best list. default is false");
@@ -117,8 +118,10 @@ Parameter::Parameter()
   AddParam("recover-input-path", "r", "(conf net/word lattice only) - recover input path corresponding to the best translation");
   AddParam("output-word-graph", "owg", "Output stack info as word graph. Takes filename, 0=only hypos in stack, 1=stack + nbest hypos");
   AddParam("time-out", "seconds after which is interrupted (-1=no time-out, default is -1)");
+  AddParam("deadline", "wall-clock milliseconds allowed for translating each sentence; the search narrows as the time runs out, keeping a few hypotheses a stack so that it can go on (default: no deadline)");
   AddParam("output-search-graph", "osg", "Output connected hypotheses of search into specified filename");
   AddParam("output-search-graph-extended", "osgx", "Output connected hypotheses of search into specified filename, in extended format");
+  AddParam("output-search-graph-binary", "osgb", "Output connected hypotheses of search into specified filename, in the compact binary format read by convertSearchGraph");
   AddParam("unpruned-search-graph", "usg", "When outputting chart search graph, do not exclude dead ends. Note: stack pruning may have eliminated some hypotheses");
 #ifdef HAVE_PROTOBUF
   AddParam("output-search-graph-pb", "pb", "Write phrase lattice to protocol buffer objects in the specified path.");
@@ -126,6 +129,8 @@ Parameter::Parameter()
   AddParam("cube-pruning-pop-limit", "cbp", "How many hypotheses should be popped for each stack. (default = 1000)");
   AddParam("cube-pruning-diversity", "cbd", "How many hypotheses should be created for each coverage. (default = 0)");
   AddParam("cube-pruning-lazy-scoring", "cbls", "Don't fully score a hypothesis until it is popped");
+  AddParam("cube-pruning-flat-queue", "cbfq", "Keep the cube pruning queues without per-item allocation; same results. (default = true)");
+  AddParam("cube-pruning-coarse-threshold", "cbct", "Decode first with a coarse model that scores the language model n-grams of each rule on their own, then with the full model using only the rules of coarse derivations within this score of the best (chart decoder only; default: decode once)");
   AddParam("parsing-algorithm", "Which parsing algorithm to use. 0=CYK+, 1=scope-3. (default = 0)");
   AddParam("search-algorithm", "Which search algorithm to use. 0=normal stack, 1=cube pruning, 2=cube growing, 4=stack with batched lm requests (default = 0)");
   AddParam("constraint", "Location of the file with target sentences to produce constraining the search");
@@ -38,7 +38,16 @@ PartialTranslOptColl::PartialTranslOptColl()
 void PartialTranslOptColl::AddNoPrune(const TranslationSystem* system, TranslationOption *partialTranslOpt)
 {
   partialTranslOpt->CalcScore(system);
+  AddScoredNoPrune(partialTranslOpt);
+}
+
+void PartialTranslOptColl::AddScoredNoPrune(TranslationOption *partialTranslOpt)
+{
   if (partialTranslOpt->GetFutureScore() >= m_worstScore) {
+    m_bestScores.push(partialTranslOpt->GetFutureScore());
+    if (m_bestScores.size() > m_maxSize) {
+      m_bestScores.pop();
+    }
     m_list.push_back(partialTranslOpt);
     if (partialTranslOpt->GetFutureScore() > m_bestScore)
       m_bestScore = partialTranslOpt->GetFutureScore();
@@ -52,9 +61,16 @@ void PartialTranslOptColl::AddNoPrune(const TranslationSystem* system, Translati
  * This is done similar to the Prune() in TranslationOptionCollection */
 
 void PartialTranslOptColl::Add(const TranslationSystem* system, TranslationOption *partialTranslOpt)
+{
+  partialTranslOpt->CalcScore(system);
+  AddScored(partialTranslOpt);
+}
+
+/** add a partial translation option whose score is calculated already */
+void PartialTranslOptColl::AddScored(TranslationOption *partialTranslOpt)
 {
   // add
-  AddNoPrune(system,partialTranslOpt );
+  AddScoredNoPrune(partialTranslOpt);
 
   // done if not too large (lazy pruning, only if twice as large as max)
   if ( m_list.size() > 2 * m_maxSize ) {
@@ -79,9 +95,9 @@ void PartialTranslOptColl::Prune()
 
   //	TRACE_ERR( "pruning partial translation options from size " << m_list.size() << std::endl);
 
-  // find nth element
+  // find nth element, the worst of those kept
   nth_element(m_list.begin(),
-              m_list.begin() + m_maxSize,
+              m_list.begin() + m_maxSize - 1,
               m_list.end(),
               ComparePartialTranslationOption);
 
@@ -24,6 +24,8 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 
 #include <list>
 #include <iostream>
+#include <queue>
+#include <functional>
 #include "TranslationOption.h"
 #include "Util.h"
 #include "StaticData.h"
@@ -49,6 +51,10 @@ protected:
   float m_worstScore; /**< score of the worse translation option */
   size_t m_maxSize; /**< maximum number of translation options allowed */
   size_t m_totalPruned; /**< number of options pruned */
+  //! the m_maxSize best future scores of the options added, worst on top
+  std::priority_queue<float, std::vector<float>, std::greater<float> > m_bestScores;
+
+  void AddScoredNoPrune(TranslationOption *partialTranslOpt);
 
 public:
   PartialTranslOptColl();
@@ -60,8 +66,20 @@ public:
 
   void AddNoPrune(const TranslationSystem* system, TranslationOption *partialTranslOpt);
   void Add(const TranslationSystem* system, TranslationOption *partialTranslOpt);
+  void AddScored(TranslationOption *partialTranslOpt);
   void Prune();
 
+  //! maximum number of translation options kept
+  size_t GetMaxSize() const {
+    return m_maxSize;
+  }
+
+  /** future score an option needs to be among the m_maxSize best added so
+   * far; decode steps stop creating options whose score is bound below it */
+  float GetThreshold() const {
+    return (m_bestScores.empty() || m_bestScores.size() < m_maxSize) ? -std::numeric_limits<float>::infinity() : m_bestScores.top();
+  }
+
   /** returns list of translation options */
   const std::vector<TranslationOption*>& GetList() const {
     return m_list;
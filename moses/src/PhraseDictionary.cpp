@@ -21,6 +21,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 
 #include "PhraseDictionary.h"
 #include "PhraseDictionaryTreeAdaptor.h"
+#include "CompactPT/PhraseDictionaryCompact.h"
 #include "RuleTable/PhraseDictionarySCFG.h"
 #include "RuleTable/PhraseDictionaryOnDisk.h"
 #include "RuleTable/PhraseDictionaryALSuffixArray.h"
@@ -28,7 +29,10 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include "PhraseDictionaryDynSuffixArray.h"
 #endif
 #include "RuleTable/UTrie.h"
+#include "RuleTable/UTrieMmap.h"
 
+#include "DecodeGraph.h"
+#include "DecodeStep.h"
 #include "StaticData.h"
 #include "InputType.h"
 #include "TranslationOption.h"
@@ -68,7 +72,8 @@ PhraseDictionaryFeature::PhraseDictionaryFeature
 {
   const StaticData& staticData = StaticData::Instance();
   const_cast<ScoreIndexManager&>(staticData.GetScoreIndexManager()).AddScoreProducer(this);
-  if (implementation == Memory || implementation == SCFG || implementation == SuffixArray) {
+  if (implementation == Memory || implementation == SCFG || implementation == SuffixArray
+      || implementation == Scope3Binary || implementation == ALSuffixArray) {
     m_useThreadSafePhraseDictionary = true;
   } else {
     m_useThreadSafePhraseDictionary = false;
@@ -110,6 +115,22 @@ PhraseDictionary* PhraseDictionaryFeature::LoadPhraseTable(const TranslationSyst
                , system->GetWeightWordPenalty());
     CHECK(ret);
     return pdta;
+  } else if (m_implementation == Compact) {
+    VERBOSE(2,"using compact phrase tables" << std::endl);
+    if (staticData.GetInputType() != SentenceInput) {
+      UserMessage::Add("The compact phrase table does not support confusion network or lattice input");
+      CHECK(false);
+    }
+
+    PhraseDictionaryCompact* pdc = new PhraseDictionaryCompact(m_numScoreComponent, this);
+    bool ret = pdc->Load(GetInput(), GetOutput()
+                         , m_filePath
+                         , m_weight
+                         , m_tableLimit
+                         , system->GetLanguageModels()
+                         , system->GetWeightWordPenalty());
+    CHECK(ret);
+    return pdc;
   } else if (m_implementation == SCFG || m_implementation == Hiero) {
     // memory phrase table
     if (m_implementation == Hiero) {
@@ -137,6 +158,34 @@ PhraseDictionary* PhraseDictionaryFeature::LoadPhraseTable(const TranslationSyst
                          , system->GetWordPenaltyProducer());
     assert(ret);
     return dict;
+  } else if (m_implementation == Scope3Binary) {
+    VERBOSE(2,"using compiled UTrie rule table" << std::endl);
+    if (staticData.GetParsingAlgorithm() != ParseScope3) {
+      UserMessage::Add("Compiled UTrie rule tables require the scope-3 parser");
+      CHECK(false);
+    }
+
+    // the widest span the decode graph of this table lets it cover
+    size_t maxChartSpan = 0;
+    const std::vector<DecodeGraph*> &decodeGraphs = system->GetDecodeGraphs();
+    for (std::vector<DecodeGraph*>::const_iterator i = decodeGraphs.begin(); i != decodeGraphs.end(); ++i) {
+      for (DecodeGraph::const_iterator j = (*i)->begin(); j != (*i)->end(); ++j) {
+        if ((*j)->GetPhraseDictionaryFeature() == this) {
+          maxChartSpan = (*i)->GetMaxChartSpan();
+        }
+      }
+    }
+
+    RuleTableUTrieMmap *dict = new RuleTableUTrieMmap(m_numScoreComponent, this, maxChartSpan);
+    bool ret = dict->Load(GetInput()
+                         , GetOutput()
+                         , m_filePath
+                         , m_weight
+                         , m_tableLimit
+                         , system->GetLanguageModels()
+                         , system->GetWordPenaltyProducer());
+    CHECK(ret);
+    return dict;
   } else if (m_implementation == ALSuffixArray) {
     // memory phrase table
     VERBOSE(2,"using Hiero format phrase tables" << std::endl);
@@ -10,13 +10,43 @@ namespace Moses
 {
 PhraseDictionaryDynSuffixArray::PhraseDictionaryDynSuffixArray(size_t numScoreComponent,
     PhraseDictionaryFeature* feature): PhraseDictionary(numScoreComponent, feature)
+#ifdef WITH_THREADS
+  , m_publishThread(NULL)
+  , m_stop(false)
+#endif
 {
-  m_biSA = new BilingualDynSuffixArray();
+  m_biSA.reset(new BilingualDynSuffixArray());
 }
 
 PhraseDictionaryDynSuffixArray::~PhraseDictionaryDynSuffixArray()
 {
-  delete m_biSA;
+#ifdef WITH_THREADS
+  if (m_publishThread) {
+    {
+      boost::mutex::scoped_lock lock(m_updateLock);
+      m_stop = true;
+      m_updated.notify_all();
+    }
+    m_publishThread->join();
+    delete m_publishThread;
+  }
+#endif
+}
+
+PhraseDictionaryDynSuffixArray::SuffixArrayPtr PhraseDictionaryDynSuffixArray::GetCurrent() const
+{
+#ifdef WITH_THREADS
+  boost::mutex::scoped_lock lock(m_biSALock);
+#endif
+  return m_biSA;
+}
+
+const BilingualDynSuffixArray &PhraseDictionaryDynSuffixArray::GetThreadVersion() const
+{
+  if (m_threadBiSA.get() == NULL) {
+    m_threadBiSA.reset(new SuffixArrayPtr(GetCurrent()));
+  }
+  return **m_threadBiSA;
 }
 
 bool PhraseDictionaryDynSuffixArray::Load(const std::vector<FactorType>& input,
@@ -41,11 +71,13 @@ bool PhraseDictionaryDynSuffixArray::Load(const std::vector<FactorType>& input,
 void PhraseDictionaryDynSuffixArray::InitializeForInput(const InputType& input)
 {
   CHECK(&input == &input);
+  // pick up the version published last
+  m_threadBiSA.reset(new SuffixArrayPtr(GetCurrent()));
 }
 
 void PhraseDictionaryDynSuffixArray::CleanUp()
 {
-  m_biSA->CleanUp();
+  GetCurrent()->CleanUp();
 }
 
 const TargetPhraseCollection *PhraseDictionaryDynSuffixArray::GetTargetPhraseCollection(const Phrase& src) const
@@ -53,7 +85,7 @@ const TargetPhraseCollection *PhraseDictionaryDynSuffixArray::GetTargetPhraseCol
   TargetPhraseCollection *ret = new TargetPhraseCollection();
   std::vector< std::pair< Scores, TargetPhrase*> > trg;
   // extract target phrases and their scores from suffix array
-  m_biSA->GetTargetPhrasesByLexicalWeight( src, trg);
+  GetThreadVersion().GetTargetPhrasesByLexicalWeight( src, trg);
 
   std::vector< std::pair< Scores, TargetPhrase*> >::iterator itr;
   for(itr = trg.begin(); itr != trg.end(); ++itr) {
@@ -71,9 +103,62 @@ const TargetPhraseCollection *PhraseDictionaryDynSuffixArray::GetTargetPhraseCol
 
 void PhraseDictionaryDynSuffixArray::insertSnt(string& source, string& target, string& alignment)
 {
-  m_biSA->addSntPair(source, target, alignment); // insert sentence pair into suffix arrays
+  SentencePair pair;
+  pair.source = source;
+  pair.target = target;
+  pair.alignment = alignment;
+#ifdef WITH_THREADS
+  boost::mutex::scoped_lock lock(m_updateLock);
+  m_pending.push_back(pair);
+  if (m_publishThread == NULL) {
+    m_publishThread = new boost::thread(&PhraseDictionaryDynSuffixArray::Publish, this);
+  }
+  m_updated.notify_all();
+#else
+  // nothing decodes meanwhile, so the suffix array is updated in place
+  std::vector<SentencePair> pairs(1, pair);
+  AddPairs(*m_biSA, pairs);
+#endif
   //StaticData::Instance().ClearTransOptionCache(); // clear translation option cache 
 }
+
+void PhraseDictionaryDynSuffixArray::AddPairs(BilingualDynSuffixArray &biSA, std::vector<SentencePair> &pairs)
+{
+  for (size_t i = 0; i < pairs.size(); ++i) {
+    SentencePair &pair = pairs[i];
+    biSA.addSntPair(pair.source, pair.target, pair.alignment); // insert sentence pair into suffix arrays
+  }
+}
+
+#ifdef WITH_THREADS
+//! body of the thread publishing the sentence pairs inserted
+void PhraseDictionaryDynSuffixArray::Publish()
+{
+  boost::mutex::scoped_lock lock(m_updateLock);
+  while (true) {
+    while (!m_stop && m_pending.empty()) {
+      m_updated.wait(lock);
+    }
+    if (m_stop) {
+      return;
+    }
+    std::vector<SentencePair> pending;
+    pending.swap(m_pending);
+    lock.unlock();
+
+    // update a copy so that decoding threads can keep reading the current
+    // version; pairs inserted meanwhile go into the next copy
+    SuffixArrayPtr next(new BilingualDynSuffixArray(*GetCurrent()));
+    AddPairs(*next, pending);
+    {
+      boost::mutex::scoped_lock biSALock(m_biSALock);
+      m_biSA = next;
+    }
+
+    lock.lock();
+  }
+}
+#endif
 void PhraseDictionaryDynSuffixArray::deleteSnt(unsigned /* idx */, unsigned /* num2Del */)
 {
   // need to implement --
@@ -2,6 +2,14 @@
 #define moses_PhraseDictionaryDynSuffixArray_h
 
 #include <map>
+#include <string>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+#ifdef WITH_THREADS
+#include <boost/thread.hpp>
+#include <boost/thread/tss.hpp>
+#endif
 
 #include "PhraseDictionary.h"
 #include "BilingualDynSuffixArray.h"
@@ -11,6 +19,13 @@ namespace Moses
 
 /** Implementation of a phrase table using the biconcor suffix array.
  *  Wrapper around a BilingualDynSuffixArray object
+ *
+ *  insertSnt() may be called while other threads decode.  Inserted sentence
+ *  pairs are queued for a background thread, which updates a copy of the
+ *  suffix array with all of them and publishes it, so a burst of insertions
+ *  costs a single copy and decoding never waits for one.  Each decoding
+ *  thread uses the version that was current when its sentence started;
+ *  pairs still being added to the next version show up in later sentences.
  */
 class PhraseDictionaryDynSuffixArray: public PhraseDictionary
 {
@@ -34,7 +49,29 @@ public:
   void deleteSnt(unsigned, unsigned);
   ChartRuleLookupManager *CreateRuleLookupManager(const InputType&, const ChartCellCollection&);
 private:
-  BilingualDynSuffixArray *m_biSA;
+  typedef boost::shared_ptr<BilingualDynSuffixArray> SuffixArrayPtr;
+  struct SentencePair {
+    std::string source, target, alignment;
+  };
+
+  SuffixArrayPtr GetCurrent() const;
+  const BilingualDynSuffixArray &GetThreadVersion() const;
+  static void AddPairs(BilingualDynSuffixArray &biSA, std::vector<SentencePair> &pairs);
+
+  SuffixArrayPtr m_biSA;  // current version
+#ifdef WITH_THREADS
+  void Publish();
+
+  std::vector<SentencePair> m_pending;  // inserted since m_biSA was published
+  mutable boost::mutex m_biSALock;  // guards m_biSA, only for a pointer copy
+  boost::mutex m_updateLock;  // guards m_pending and m_stop
+  boost::condition_variable m_updated;  // signals pairs to publish, or m_stop
+  boost::thread *m_publishThread;  // started by the first insertSnt()
+  bool m_stop;
+  mutable boost::thread_specific_ptr<SuffixArrayPtr> m_threadBiSA;
+#else
+  mutable std::auto_ptr<SuffixArrayPtr> m_threadBiSA;
+#endif
   std::vector<float> m_weight;
   size_t m_tableLimit;
   const LMList *m_languageModels;
@@ -38,6 +38,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include "StaticData.h"
 #include "WordsRange.h"
 #include "UserMessage.h"
+#include "InputFilter.h"
 
 using namespace std;
 
@@ -76,6 +77,7 @@ bool PhraseDictionaryMemory::Load(const std::vector<FactorType> &input
   size_t line_num = 0;
   size_t numElement = NOT_FOUND; // 3=old format, 5=async format which include word alignment info
   const std::string& factorDelimiter = staticData.GetFactorDelimiter();
+  const InputFilter *inputFilter = staticData.GetInputFilter();
 
   Phrase sourcePhrase(0);
   std::vector<float> scv;
@@ -103,6 +105,9 @@ bool PhraseDictionaryMemory::Load(const std::vector<FactorType> &input
       TRACE_ERR( filePath << ":" << line_num << ": pt entry contains empty source, skipping\n");
       continue;
     }
+    if (inputFilter && !inputFilter->Matches(sourcePhraseString, input[0])) {
+      continue;
+    }
  
     //target
     std::auto_ptr<TargetPhrase> targetPhrase(new TargetPhrase(Output));
@@ -1,6 +1,9 @@
 // $Id$
 // vim:tabstop=2
 #include "PhraseDictionaryTree.h"
+#include "LM/Base.h"
+#include "Phrase.h"
+#include "StaticData.h"
 #include <map>
 #include "util/check.hh"
 #include <sstream>
@@ -117,6 +120,14 @@ PhraseDictionaryTree::PrefixPtr::operator bool() const
   return imp && imp->isValid();
 }
 
+bool PhraseDictionaryTree::PrefixPtr::operator==(const PrefixPtr& other) const
+{
+  if(imp==other.imp) return true;
+  if(!imp || !other.imp) return false;
+  if(imp->isRoot() || other.imp->isRoot()) return imp->isRoot()==other.imp->isRoot();
+  return imp->ptr()==other.imp->ptr() && imp->idx==other.imp->idx;
+}
+
 typedef LVoc<std::string> WordVoc;
 
 static WordVoc* ReadVoc(const std::string& filename)
@@ -156,6 +167,12 @@ public:
   bool usewordalign;
   bool printwordalign;
 
+  // LMs whose estimates Create() stores, and the fingerprints of the LMs of
+  // the table written or read
+  std::vector<LanguageModel*> lmEstimates;
+  std::vector<FactorType> lmOutput;
+  std::vector<std::string> lmKeys;
+
   PDTimp() : os(0),ot(0), usewordalign(false), printwordalign(false) {
     PTF::setDefault(InvalidOffT);
   }
@@ -244,11 +261,18 @@ public:
     return PPtr(pPool.get(PPimp(0,0,1)));
   }
 
+  LabelId GetSourceLabel(const std::string& w) const {
+    if(w.empty() || w==EPSILON) return Epsilon;
+    return sv->index(w);
+  }
+
   PPtr Extend(PPtr p,const std::string& w) {
-    CHECK(p);
-    if(w.empty() || w==EPSILON) return p;
+    return Extend(p,GetSourceLabel(w));
+  }
 
-    LabelId wi=sv->index(w);
+  PPtr Extend(PPtr p,LabelId wi) {
+    CHECK(p);
+    if(wi==Epsilon) return p;
 
     if(wi==InvalidLabelId) return PPtr(); // unknown word
     else if(p.imp->isRoot()) {
@@ -321,6 +345,14 @@ int PDTimp::Read(const std::string& fn)
   //sv.Read(ifsv);
   //tv.Read(iftv);
 
+  lmKeys.clear();
+  std::string ifl=fn+(UseWordAlignment() ? ".binphr.lmest.wa" : ".binphr.lmest");
+  if (FileExists(ifl)) {
+    std::ifstream in(ifl.c_str());
+    std::string line;
+    while (getline(in, line)) lmKeys.push_back(line);
+  }
+
   TRACE_ERR("binary phrasefile loaded, default OFF_T: "<<PTF::getDefault()
             <<"\n");
   return 1;
@@ -447,11 +479,13 @@ int PhraseDictionaryTree::Create(std::istream& inFile,const std::string& out)
       oft(out+".binphr.tgtdata"),
       ofi(out+".binphr.idx"),
       ofsv(out+".binphr.srcvoc"),
-      oftv(out+".binphr.tgtvoc");
+      oftv(out+".binphr.tgtvoc"),
+      ofl(out+".binphr.lmest");
 
   if (PrintWordAlignment()) {
     ofn+=".wa";
     oft+=".wa";
+    ofl+=".wa";
   }
 
   FILE *os=fOpen(ofn.c_str(),"wb"),
@@ -512,6 +546,21 @@ int PhraseDictionaryTree::Create(std::istream& inFile,const std::string& out)
       sc.push_back(((tmp>0.0)?tmp:(float)1.0e-38));
     }
 
+    if (imp->lmEstimates.size()) {
+      Phrase targetPhrase(e.size());
+      targetPhrase.CreateFromString(imp->lmOutput, targetPhraseString, StaticData::Instance().GetFactorDelimiter());
+      for (std::vector<LanguageModel*>::const_iterator lm = imp->lmEstimates.begin(); lm != imp->lmEstimates.end(); ++lm) {
+        float fullScore = 0, nGramScore = 0;
+        size_t oovCount = 0;
+        if ((*lm)->Useable(targetPhrase)) {
+          (*lm)->CalcScore(targetPhrase, fullScore, nGramScore, oovCount);
+        }
+        sc.push_back(fullScore);
+        sc.push_back(nGramScore);
+        sc.push_back(oovCount);
+      }
+    }
+
     if(f.empty()) {
       TRACE_ERR("WARNING: empty source phrase in line '"<<line<<"'\n");
       continue;
@@ -611,9 +660,31 @@ int PhraseDictionaryTree::Create(std::istream& inFile,const std::string& out)
   imp->sv->Write(ofsv);
   imp->tv->Write(oftv);
 
+  if (imp->lmEstimates.size()) {
+    std::ofstream ol(ofl.c_str());
+    for (size_t i = 0; i < imp->lmKeys.size(); ++i) ol << imp->lmKeys[i] << "\n";
+  } else {
+    remove(ofl.c_str());
+  }
+
   return 1;
 }
 
+void PhraseDictionaryTree::StoreLMEstimates(const std::vector<LanguageModel*> &languageModels,
+    const std::vector<std::string> &fingerprints,
+    const std::vector<FactorType> &output)
+{
+  CHECK(fingerprints.size() == languageModels.size());
+  imp->lmEstimates = languageModels;
+  imp->lmKeys = fingerprints;
+  imp->lmOutput = output;
+}
+
+const std::vector<std::string> &PhraseDictionaryTree::GetLMEstimateKeys() const
+{
+  return imp->lmKeys;
+}
+
 
 int PhraseDictionaryTree::Read(const std::string& fn)
 {
@@ -633,6 +704,17 @@ PhraseDictionaryTree::Extend(PrefixPtr p, const std::string& w) const
   return imp->Extend(p,w);
 }
 
+LabelId PhraseDictionaryTree::GetSourceLabel(const std::string& w) const
+{
+  return imp->GetSourceLabel(w);
+}
+
+PhraseDictionaryTree::PrefixPtr
+PhraseDictionaryTree::Extend(PrefixPtr p, LabelId w) const
+{
+  return imp->Extend(p,w);
+}
+
 void PhraseDictionaryTree::PrintTargetCandidates(PrefixPtr p,std::ostream& out) const
 {
 
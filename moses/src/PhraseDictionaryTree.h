@@ -29,6 +29,7 @@ namespace Moses
 class Phrase;
 class Word;
 class ConfusionNet;
+class LanguageModel;
 class PDTimp;
 
 typedef PrefixTreeF<LabelId,OFF_T> PTF;
@@ -67,8 +68,20 @@ public:
   //        -> use Read(outFileNamePrefix);
   int Create(std::istream& in,const std::string& outFileNamePrefix);
 
+  // have Create() store after the scores of each target phrase the full
+  // score, n-gram score and OOV count of each LM, so the decoder need not
+  // compute them.  The fingerprints identify the LMs (see
+  // LanguageModelFactory::Fingerprint()) and are written next to the table.
+  void StoreLMEstimates(const std::vector<LanguageModel*> &languageModels,
+                        const std::vector<std::string> &fingerprints,
+                        const std::vector<FactorType> &output);
+
   int Read(const std::string& fileNamePrefix);
 
+  // fingerprints of the LMs whose estimates follow the scores of the table
+  // read, empty if it has none
+  const std::vector<std::string> &GetLMEstimateKeys() const;
+
   // free memory used by the prefix tree etc.
   void FreeMemory() const;
 
@@ -94,8 +107,8 @@ public:
    *****************************/
 
   // 'pointer' into prefix tree
-  // the only permitted direct operation is a check for NULL,
-  // e.g. PrefixPtr p; if(p) ...
+  // the only permitted direct operations are a check for NULL,
+  // e.g. PrefixPtr p; if(p) ..., and whether two point to the same node
   // other usage only through PhraseDictionaryTree-functions below
 
   class PrefixPtr
@@ -105,6 +118,7 @@ public:
   public:
     PrefixPtr(PPimp* x=0) : imp(x) {}
     operator bool() const;
+    bool operator==(const PrefixPtr& other) const;
   };
 
   // return pointer to root node
@@ -114,6 +128,13 @@ public:
   // false. Requirement: the input pointer p evaluates to true.
   PrefixPtr Extend(PrefixPtr p,const std::string& s) const;
 
+  // the id of a word/Factorstring in the source vocabulary, Epsilon for the
+  // empty word and InvalidLabelId if it is unknown, so that a word met
+  // often need only be looked up once
+  LabelId GetSourceLabel(const std::string& s) const;
+  // extend pointer with a word id from GetSourceLabel()
+  PrefixPtr Extend(PrefixPtr p,LabelId w) const;
+
   // get the target candidates for a given prefix pointer
   // requirement: the pointer has to evaluate to true
   void GetTargetCandidates(PrefixPtr p,
@@ -26,6 +26,7 @@
 #include <sys/stat.h>
 #include "RuleTable/Trie.h"
 #include "FactorCollection.h"
+#include "InputFilter.h"
 #include "Word.h"
 #include "Util.h"
 #include "InputFileStream.h"
@@ -154,6 +155,7 @@ bool RuleTableLoaderStandard::Load(FormatType format
 
   const StaticData &staticData = StaticData::Instance();
   const std::string& factorDelimiter = staticData.GetFactorDelimiter();
+  const InputFilter *inputFilter = staticData.GetInputFilter();
 
 
   string lineOrig;
@@ -191,6 +193,12 @@ bool RuleTableLoaderStandard::Load(FormatType format
       TRACE_ERR( ruleTable.GetFilePath() << ":" << count << ": pt entry contains empty target, skipping\n");
       continue;
     }
+    if (inputFilter && !inputFilter->Matches(sourcePhraseString, input[0])) {
+      if (format == HieroFormat) {
+        delete line;
+      }
+      continue;
+    }
 
     Tokenize<float>(scoreVector, scoreString);
     const size_t numScoreComponents = ruleTable.GetFeature()->GetNumScoreComponents();
@@ -6,8 +6,11 @@
 //  Copyright 2011 __MyCompanyName__. All rights reserved.
 //
 
+#include <algorithm>
+#include <cstdlib>
 #include <iostream>
 #include "PhraseDictionaryALSuffixArray.h"
+#include "CYKPlusParser/ChartRuleLookupManagerMemory.h"
 #include "InputType.h"
 #include "InputFileStream.h"
 #include "RuleTable/Loader.h"
@@ -15,11 +18,87 @@
 #include "TypeDef.h"
 #include "StaticData.h"
 #include "UserMessage.h"
+#include "Util.h"
 
 using namespace std;
 
 namespace Moses 
 {
+
+namespace
+{
+
+//! rule table holding the grammar of one sentence
+class SentenceGrammar : public PhraseDictionarySCFG
+{
+public:
+  SentenceGrammar(size_t numScoreComponents, PhraseDictionaryFeature* feature, size_t tableLimit)
+    : PhraseDictionarySCFG(numScoreComponents, feature) {
+    m_tableLimit = tableLimit;
+  }
+};
+
+//! deletes the grammar after the lookup manager built on it is gone
+class GrammarOwner
+{
+public:
+  GrammarOwner(PhraseDictionarySCFG *grammar) : m_grammar(grammar) {}
+  ~GrammarOwner() {
+    delete m_grammar;
+  }
+protected:
+  PhraseDictionarySCFG *m_grammar;
+};
+
+//! rule lookup on a sentence's own grammar, which it deletes when done
+class ChartRuleLookupManagerSentenceGrammar : private GrammarOwner, public ChartRuleLookupManagerMemory
+{
+public:
+  ChartRuleLookupManagerSentenceGrammar(const InputType &sentence,
+                                        const ChartCellCollection &cellColl,
+                                        PhraseDictionarySCFG *grammar)
+    : GrammarOwner(grammar)
+    , ChartRuleLookupManagerMemory(sentence, cellColl, *grammar) {}
+};
+
+string GrammarFile(const string &dirPath, long translationId)
+{
+  return dirPath + "/grammar.out." + SPrint(translationId) + ".gz";
+}
+
+}
+
+PhraseDictionaryALSuffixArray::PhraseDictionaryALSuffixArray(size_t numScoreComponent, PhraseDictionaryFeature* feature)
+  : PhraseDictionarySCFG(numScoreComponent,feature)
+  , m_phraseFeature(feature)
+#ifdef WITH_THREADS
+  , m_prefetchThread(NULL)
+  , m_nextToLoad(0)
+  , m_loading(-1)
+  , m_maxRequested(-1)
+  , m_stop(false)
+#endif
+{
+}
+
+PhraseDictionaryALSuffixArray::~PhraseDictionaryALSuffixArray()
+{
+#ifdef WITH_THREADS
+  if (m_prefetchThread) {
+    {
+      boost::mutex::scoped_lock lock(m_mutex);
+      m_stop = true;
+      m_changed.notify_all();
+    }
+    m_prefetchThread->join();
+    delete m_prefetchThread;
+  }
+  std::map<long, PhraseDictionarySCFG*>::iterator iter;
+  for (iter = m_prefetched.begin(); iter != m_prefetched.end(); ++iter) {
+    delete iter->second;
+  }
+#endif
+}
   
 bool PhraseDictionaryALSuffixArray::Load(const std::vector<FactorType> &input
                                  , const std::vector<FactorType> &output
@@ -29,13 +108,6 @@ bool PhraseDictionaryALSuffixArray::Load(const std::vector<FactorType> &input
                                  , const LMList &languageModels
                                  , const WordPenaltyProducer* wpProducer)
 {
-  const StaticData &staticData = StaticData::Instance();
-  if (staticData.ThreadCount() > 1)
-  {
-    UserMessage::Add("Suffix array implementation is not threadsafe");
-    return false;
-  }
-  
   // file path is the directory of the rules for eacg, NOT the file of all the rules
   SetFilePath(filePath);
   m_tableLimit = tableLimit;
@@ -45,29 +117,113 @@ bool PhraseDictionaryALSuffixArray::Load(const std::vector<FactorType> &input
   m_languageModels = &languageModels;
   m_wpProducer = wpProducer;
   m_weight = &weight;
-  
+
+#ifdef WITH_THREADS
+  // loading a grammar scores its rules with the language models, so only
+  // prefetch when decoding is multi-threaded anyway and the language
+  // models must already be thread-safe
+  const StaticData &staticData = StaticData::Instance();
+  if (staticData.ThreadCount() > 1) {
+    m_nextToLoad = staticData.GetStartTranslationId();
+    m_maxRequested = m_nextToLoad - 1;
+    m_prefetchThread = new boost::thread(&PhraseDictionaryALSuffixArray::Prefetch, this);
+  }
+#endif
+
   return true;
 }
 
-void PhraseDictionaryALSuffixArray::InitializeForInput(InputType const& source)
+PhraseDictionarySCFG *PhraseDictionaryALSuffixArray::LoadGrammar(long translationId) const
 {
-  // clear out rules for previous sentence
-  m_collection.Clear();
-  
-  // populate with rules for this sentence
-  long translationId = source.GetTranslationId();
-  
-  string grammarFile = GetFilePath() + "/grammar.out." + SPrint(translationId) + ".gz";
-  
+  string grammarFile = GrammarFile(GetFilePath(), translationId);
+  if (!FileExists(grammarFile)) {
+    UserMessage::Add("Grammar file not found: " + grammarFile);
+    return NULL;
+  }
+
   // data from file
   InputFileStream inFile(grammarFile);
 
+  std::auto_ptr<PhraseDictionarySCFG> grammar(
+    new SentenceGrammar(m_numScoreComponent, m_phraseFeature, m_tableLimit));
   std::auto_ptr<RuleTableLoader> loader =
   RuleTableLoaderFactory::Create(grammarFile);
   bool ret = loader->Load(*m_input, *m_output, inFile, *m_weight, m_tableLimit,
-                          *m_languageModels, m_wpProducer, *this);
+                          *m_languageModels, m_wpProducer, *grammar);
   
-  CHECK(ret);
+  return ret ? grammar.release() : NULL;
+}
+
+PhraseDictionarySCFG *PhraseDictionaryALSuffixArray::GetGrammar(long translationId)
+{
+#ifdef WITH_THREADS
+  {
+    boost::mutex::scoped_lock lock(m_mutex);
+    if (translationId > m_maxRequested) {
+      m_maxRequested = translationId;
+      m_changed.notify_all();
+    }
+    while (m_loading == translationId) {
+      m_changed.wait(lock);
+    }
+    std::map<long, PhraseDictionarySCFG*>::iterator iter = m_prefetched.find(translationId);
+    if (iter != m_prefetched.end()) {
+      PhraseDictionarySCFG *grammar = iter->second;
+      m_prefetched.erase(iter);
+      return grammar;
+    }
+    // not prefetched. Load it here and stop the prefetch thread loading it too
+    m_nextToLoad = std::max(m_nextToLoad, translationId + 1);
+  }
+#endif
+  return LoadGrammar(translationId);
+}
+
+#ifdef WITH_THREADS
+void PhraseDictionaryALSuffixArray::Prefetch()
+{
+  // stay as many sentences ahead as can be decoded at the same time
+  const long lookAhead = std::max(StaticData::Instance().ThreadCount(), 1);
+
+  boost::mutex::scoped_lock lock(m_mutex);
+  while (true) {
+    while (!m_stop && m_nextToLoad > m_maxRequested + lookAhead) {
+      m_changed.wait(lock);
+    }
+    if (m_stop) {
+      return;
+    }
+    long translationId = m_nextToLoad++;
+    m_loading = translationId;
+    lock.unlock();
+
+    // a missing grammar is skipped, not waited for: the sentence may be past
+    // the end of the input, and if it is not GetGrammar() reports it
+    PhraseDictionarySCFG *grammar = NULL;
+    if (FileExists(GrammarFile(GetFilePath(), translationId))) {
+      grammar = LoadGrammar(translationId);
+    }
+
+    lock.lock();
+    if (grammar) {
+      m_prefetched[translationId] = grammar;
+    }
+    m_loading = -1;
+    m_changed.notify_all();
+  }
+}
+#endif
+
+ChartRuleLookupManager *PhraseDictionaryALSuffixArray::CreateRuleLookupManager(
+  const InputType &sentence,
+  const ChartCellCollection &cellCollection)
+{
+  PhraseDictionarySCFG *grammar = GetGrammar(sentence.GetTranslationId());
+  if (!grammar) {
+    UserMessage::Add("Could not load the grammar of sentence " + SPrint(sentence.GetTranslationId()));
+    exit(1);
+  }
+  return new ChartRuleLookupManagerSentenceGrammar(sentence, cellCollection, grammar);
 }
 
 }
@@ -9,20 +9,33 @@
 #ifndef moses_PhraseDictionaryALSuffixArray_h
 #define moses_PhraseDictionaryALSuffixArray_h
 
+#include <map>
+
 #include "PhraseDictionarySCFG.h"
 
+#ifdef WITH_THREADS
+#include <boost/thread.hpp>
+#endif
+
 namespace Moses {
   
 /** Implementation of in-memory phrase table for use with Adam Lopez's suffix array.
  * Does 2 things that the normal in-memory pt doesn't do:
  *  1. Loads grammar for a sentence to be decoded only when the sentence is being decoded. Unload afterwards
     2. Format of the pt file follows Hiero, rather than Moses
+ *
+ * Each sentence's grammar is a separate rule table, owned by the rule lookup
+ * manager of the sentence, so that sentences can be decoded in parallel.
+ * With -threads greater than 1, a background thread loads the grammars of the
+ * next sentences while the current ones are decoded.  Loading scores the
+ * rules with the language models, so, like multi-threaded decoding itself,
+ * this requires thread-safe language models.
  */   
 class PhraseDictionaryALSuffixArray : public PhraseDictionarySCFG
 {
 public:
-  PhraseDictionaryALSuffixArray(size_t numScoreComponent, PhraseDictionaryFeature* feature)
-  : PhraseDictionarySCFG(numScoreComponent,feature) {}
+  PhraseDictionaryALSuffixArray(size_t numScoreComponent, PhraseDictionaryFeature* feature);
+  ~PhraseDictionaryALSuffixArray();
 
   bool Load(const std::vector<FactorType> &input
             , const std::vector<FactorType> &output
@@ -32,14 +45,39 @@ public:
             , const LMList &languageModels
             , const WordPenaltyProducer* wpProducer);
 
-  void InitializeForInput(InputType const& source);
+  ChartRuleLookupManager *CreateRuleLookupManager(
+    const InputType &,
+    const ChartCellCollection &);
 
 protected:
+  //! read the grammar file of a sentence, NULL if there is none
+  PhraseDictionarySCFG *LoadGrammar(long translationId) const;
+  //! grammar of a sentence, prefetched if possible. Caller owns it
+  PhraseDictionarySCFG *GetGrammar(long translationId);
+
+  PhraseDictionaryFeature *m_phraseFeature;
   const std::vector<FactorType> *m_input, *m_output;
   const LMList *m_languageModels;
   const WordPenaltyProducer *m_wpProducer;
   const std::vector<float> *m_weight;
-  
+
+#ifdef WITH_THREADS
+  //! body of the prefetch thread
+  void Prefetch();
+
+  boost::thread *m_prefetchThread;
+  boost::mutex m_mutex;
+  boost::condition_variable m_changed;
+  //! loaded grammars that have not been asked for yet
+  std::map<long, PhraseDictionarySCFG*> m_prefetched;
+  //! next sentence the prefetch thread will load
+  long m_nextToLoad;
+  //! sentence being loaded by the prefetch thread, -1 if none
+  long m_loading;
+  //! highest sentence asked for so far
+  long m_maxRequested;
+  bool m_stop;
+#endif
 };
   
 
@@ -0,0 +1,288 @@
+/***********************************************************************
+ Moses - statistical machine translation system
+ Copyright (C) 2006-2012 University of Edinburgh
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#include "RuleTable/UTrieMmap.h"
+
+#include "AlignmentInfo.h"
+#include "RuleTable/UTrieMmapFormat.h"
+#include "RuleTable/UTrieNode.h"
+#include "Scope3Parser/MmapParser.h"
+#include "TargetPhrase.h"
+#include "TargetPhraseCollection.h"
+#include "UserMessage.h"
+#include "Util.h"
+#include "Word.h"
+
+#include "util/file.hh"
+#include "util/mmap.hh"
+
+#include <algorithm>
+#include <cstring>
+#include <set>
+#include <sstream>
+
+namespace Moses
+{
+
+namespace
+{
+
+struct EdgeWordLess {
+  bool operator()(const UTrieMmapFormat::Edge &edge, uint32_t word) const {
+    return edge.word < word;
+  }
+};
+
+}  // namespace
+
+RuleTableUTrieMmap::~RuleTableUTrieMmap()
+{
+  for (RuleCache::iterator p = m_ruleCache.begin(); p != m_ruleCache.end();
+       ++p) {
+    delete p->second;
+  }
+}
+
+bool RuleTableUTrieMmap::Load(const std::vector<FactorType> &input,
+                              const std::vector<FactorType> &output,
+                              const std::string &filePath,
+                              const std::vector<float> &weight,
+                              size_t tableLimit,
+                              const LMList &languageModels,
+                              const WordPenaltyProducer *wpProducer)
+{
+  m_input = input;
+  m_output = output;
+  m_filePath = filePath;
+  m_weight = weight;
+  m_tableLimit = tableLimit;
+  m_languageModels = &languageModels;
+  m_wpProducer = wpProducer;
+
+  util::scoped_fd file(util::OpenReadOrThrow(filePath.c_str()));
+  const uint64_t size = util::SizeFile(file.get());
+  if (size < sizeof(UTrieMmapFormat::Header)) {
+    UserMessage::Add("Compiled rule table is truncated: " + filePath);
+    return false;
+  }
+  // Pages are faulted in as the parser touches them.
+  util::MapRead(util::LAZY, file.get(), 0, size, m_memory);
+  m_header = Section<UTrieMmapFormat::Header>(0);
+
+  if (std::memcmp(m_header->magic, UTrieMmapFormat::kMagic,
+                  sizeof(UTrieMmapFormat::kMagic)) != 0) {
+    UserMessage::Add("Not a compiled rule table: " + filePath);
+    return false;
+  }
+  if (m_header->version != UTrieMmapFormat::kVersion) {
+    std::stringstream msg;
+    msg << "Unsupported compiled rule table version: " << m_header->version;
+    UserMessage::Add(msg.str());
+    return false;
+  }
+  if (m_header->numScores != weight.size()) {
+    std::stringstream msg;
+    msg << "Size of scoreVector != number (" << m_header->numScores << "!="
+        << weight.size() << ") of score components in " << filePath;
+    UserMessage::Add(msg.str());
+    return false;
+  }
+
+  // Every section must lie inside the file.  The vocabulary index is checked
+  // before it is used to find the end of the vocabulary strings.
+  using namespace UTrieMmapFormat;
+  const Header &h = *m_header;
+  bool ok = CheckSection(h.vocabIndexOffset, h.vocabSize, sizeof(uint64_t))
+            && CheckSection(h.vocabIndexOffset, h.vocabSize+1, sizeof(uint64_t))
+            && h.nodeCount > 0
+            && CheckSection(h.nodeOffset, h.nodeCount, sizeof(Node))
+            && CheckSection(h.edgeOffset, h.edgeCount, sizeof(Edge))
+            && CheckSection(h.ruleOffset, h.ruleCount, sizeof(Rule))
+            && CheckSection(h.symbolOffset, h.symbolCount, sizeof(uint32_t))
+            && CheckSection(h.alignOffset, h.alignCount, sizeof(AlignPoint))
+            && CheckSection(h.scoreOffset, h.ruleCount,
+                            static_cast<uint64_t>(h.numScores) * sizeof(float));
+  if (ok) {
+    const uint64_t *index = Section<uint64_t>(h.vocabIndexOffset);
+    ok = CheckSection(h.vocabStringOffset, index[h.vocabSize], 1);
+  }
+  if (!ok) {
+    UserMessage::Add("Compiled rule table is corrupt: " + filePath);
+    return false;
+  }
+  return true;
+}
+
+bool RuleTableUTrieMmap::CheckSection(uint64_t offset, uint64_t count,
+                                      uint64_t size) const
+{
+  const uint64_t fileSize = m_memory.size();
+  return offset <= fileSize && count <= (fileSize - offset) / size;
+}
+
+ChartRuleLookupManager *RuleTableUTrieMmap::CreateRuleLookupManager(
+  const InputType &input,
+  const ChartCellCollection &cellCollection)
+{
+  return new Scope3MmapParser(input, cellCollection, *this, m_maxChartSpan);
+}
+
+bool RuleTableUTrieMmap::FindSourceWord(const Word &word, uint32_t &id) const
+{
+  return FindVocabId(word.GetString(m_input, false), id);
+}
+
+uint32_t RuleTableUTrieMmap::FindChild(const UTrieMmapFormat::Node &node,
+                                       uint32_t word) const
+{
+  const UTrieMmapFormat::Edge *edges =
+      Section<UTrieMmapFormat::Edge>(m_header->edgeOffset);
+  const UTrieMmapFormat::Edge *begin = edges + node.firstEdge;
+  const UTrieMmapFormat::Edge *end = begin + node.numEdges;
+  const UTrieMmapFormat::Edge *p =
+      std::lower_bound(begin, end, word, EdgeWordLess());
+  return (p == end || p->word != word) ? UTrieMmapFormat::kNoNode : p->child;
+}
+
+const UTrieNode &RuleTableUTrieMmap::GetRules(uint32_t nodeIndex) const
+{
+  {
+#ifdef WITH_THREADS
+    boost::mutex::scoped_lock lock(m_ruleCacheMutex);
+#endif
+    RuleCache::const_iterator p = m_ruleCache.find(nodeIndex);
+    if (p != m_ruleCache.end()) {
+      return *p->second;
+    }
+  }
+
+  // Build and score the rules without holding the lock.  If another thread
+  // got there first, keep its copy.
+  UTrieNode *rules = new UTrieNode();
+  WordCache wordCache;
+  AddRules(GetNode(nodeIndex), wordCache, *rules);
+  if (m_tableLimit) {
+    rules->Sort(m_tableLimit);
+  }
+
+#ifdef WITH_THREADS
+  boost::mutex::scoped_lock lock(m_ruleCacheMutex);
+#endif
+  std::pair<RuleCache::iterator, bool> ret =
+      m_ruleCache.insert(std::make_pair(nodeIndex, rules));
+  if (!ret.second) {
+    delete rules;
+  }
+  return *ret.first->second;
+}
+
+bool RuleTableUTrieMmap::FindVocabId(const std::string &str,
+                                     uint32_t &id) const
+{
+  const uint64_t *index = Section<uint64_t>(m_header->vocabIndexOffset);
+  const char *strings = Section<char>(m_header->vocabStringOffset);
+  uint64_t lo = 0;
+  uint64_t hi = m_header->vocabSize;
+  while (lo < hi) {
+    const uint64_t mid = lo + (hi - lo) / 2;
+    const size_t len = index[mid+1] - index[mid];
+    const int cmp = std::memcmp(strings + index[mid], str.data(),
+                                std::min(len, str.size()));
+    if (cmp < 0 || (cmp == 0 && len < str.size())) {
+      lo = mid + 1;
+    } else if (cmp > 0 || len > str.size()) {
+      hi = mid;
+    } else {
+      id = mid;
+      return true;
+    }
+  }
+  return false;
+}
+
+std::string RuleTableUTrieMmap::GetVocabString(uint32_t id) const
+{
+  const uint64_t *index = Section<uint64_t>(m_header->vocabIndexOffset);
+  const char *strings = Section<char>(m_header->vocabStringOffset);
+  return std::string(strings + index[id], index[id+1] - index[id]);
+}
+
+const Word &RuleTableUTrieMmap::GetTargetWord(uint32_t id,
+                                              WordCache &cache) const
+{
+  WordCache::iterator p = cache.find(id);
+  if (p != cache.end()) {
+    return p->second;
+  }
+  std::string str = GetVocabString(id);
+  const size_t len = str.size();
+  const bool isNonTerm = (len > 2 && str[0] == '[' && str[len-1] == ']');
+  if (isNonTerm) {
+    str = str.substr(1, len-2);
+  }
+  Word &word = cache[id];
+  word.CreateFromString(Output, m_output, str, isNonTerm);
+  return word;
+}
+
+void RuleTableUTrieMmap::AddRules(const UTrieMmapFormat::Node &mmapNode,
+                                  WordCache &wordCache,
+                                  UTrieNode &node) const
+{
+  const UTrieMmapFormat::Rule *rules =
+      Section<UTrieMmapFormat::Rule>(m_header->ruleOffset);
+  const uint32_t *symbols = Section<uint32_t>(m_header->symbolOffset);
+  const UTrieMmapFormat::AlignPoint *aligns =
+      Section<UTrieMmapFormat::AlignPoint>(m_header->alignOffset);
+  const float *scores = Section<float>(m_header->scoreOffset);
+
+  const size_t numScores = m_header->numScores;
+  std::vector<float> scoreVector(numScores);
+  std::set<std::pair<size_t, size_t> > alignmentInfo;
+
+  for (uint32_t i = 0; i < mmapNode.numRules; ++i) {
+    const uint32_t ruleId = mmapNode.firstRule + i;
+    const UTrieMmapFormat::Rule &rule = rules[ruleId];
+
+    TargetPhrase *targetPhrase = new TargetPhrase(Output);
+    for (uint32_t j = 0; j < rule.numSymbols; ++j) {
+      targetPhrase->AddWord(GetTargetWord(symbols[rule.firstSymbol+j],
+                                          wordCache));
+    }
+    targetPhrase->SetTargetLHS(GetTargetWord(rule.lhs, wordCache));
+
+    alignmentInfo.clear();
+    for (uint32_t j = 0; j < rule.numAligns; ++j) {
+      const UTrieMmapFormat::AlignPoint &point = aligns[rule.firstAlign+j];
+      alignmentInfo.insert(std::make_pair(point.source, point.target));
+    }
+    targetPhrase->SetAlignmentInfo(alignmentInfo);
+
+    const float *ruleScores = scores + static_cast<uint64_t>(ruleId) * numScores;
+    for (size_t j = 0; j < numScores; ++j) {
+      scoreVector[j] = FloorScore(TransformScore(ruleScores[j]));
+    }
+    targetPhrase->SetScoreChart(GetFeature(), scoreVector, m_weight,
+                                *m_languageModels, m_wpProducer);
+
+    node.GetOrCreateTargetPhraseCollection(*targetPhrase).Add(targetPhrase);
+  }
+}
+
+}  // namespace Moses
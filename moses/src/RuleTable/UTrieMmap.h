@@ -0,0 +1,133 @@
+/***********************************************************************
+ Moses - statistical machine translation system
+ Copyright (C) 2006-2012 University of Edinburgh
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#pragma once
+
+#include "PhraseDictionary.h"
+#include "RuleTable/UTrieMmapFormat.h"
+#include "RuleTable/UTrieNode.h"
+#include "TypeDef.h"
+#include "Word.h"
+
+#include "util/mmap.hh"
+
+#include <boost/unordered_map.hpp>
+#ifdef WITH_THREADS
+#include <boost/thread/mutex.hpp>
+#endif
+
+#include <string>
+#include <vector>
+
+namespace Moses
+{
+
+class LMList;
+class Sentence;
+class WordPenaltyProducer;
+
+/** Read-only UTrie rule table backed by a memory-mapped file produced by
+ * processScope3Table.  Nothing is decoded at load time.  Scope3MmapParser
+ * matches sentences against the mapped trie in place.  The rules of a node
+ * are decoded and scored the first time a sentence matches it, and are kept
+ * for later sentences.
+ */
+class RuleTableUTrieMmap : public PhraseDictionary
+{
+ public:
+  RuleTableUTrieMmap(size_t numScoreComponents,
+                     PhraseDictionaryFeature *feature,
+                     size_t maxChartSpan)
+      : PhraseDictionary(numScoreComponents, feature)
+      , m_header(NULL)
+      , m_languageModels(NULL)
+      , m_wpProducer(NULL)
+      , m_maxChartSpan(maxChartSpan) {}
+
+  ~RuleTableUTrieMmap();
+
+  bool Load(const std::vector<FactorType> &input,
+            const std::vector<FactorType> &output,
+            const std::string &filePath,
+            const std::vector<float> &weight,
+            size_t tableLimit,
+            const LMList &languageModels,
+            const WordPenaltyProducer *wpProducer);
+
+  // Required by PhraseDictionary.
+  const TargetPhraseCollection *GetTargetPhraseCollection(const Phrase &) const
+  {
+    assert(false);
+    return NULL;
+  }
+
+  void InitializeForInput(const InputType &) {}
+
+  ChartRuleLookupManager *CreateRuleLookupManager(const InputType &,
+                                                  const ChartCellCollection &);
+
+  //! vocabulary ID of a source word, false if the table does not contain it
+  bool FindSourceWord(const Word &, uint32_t &) const;
+
+  const UTrieMmapFormat::Node &GetNode(uint32_t nodeIndex) const {
+    return Section<UTrieMmapFormat::Node>(m_header->nodeOffset)[nodeIndex];
+  }
+
+  //! child of node along a terminal edge, kNoNode if there is none
+  uint32_t FindChild(const UTrieMmapFormat::Node &, uint32_t word) const;
+
+  //! the rules of a node, grouped by non-terminal labels and sorted
+  const UTrieNode &GetRules(uint32_t nodeIndex) const;
+
+ private:
+  typedef boost::unordered_map<uint32_t, Word> WordCache;
+  typedef boost::unordered_map<uint32_t, const UTrieNode *> RuleCache;
+
+  template<typename T>
+  const T *Section(uint64_t offset) const
+  {
+    return reinterpret_cast<const T *>(m_memory.begin() + offset);
+  }
+
+  bool CheckSection(uint64_t offset, uint64_t count, uint64_t size) const;
+
+  bool FindVocabId(const std::string &, uint32_t &) const;
+  std::string GetVocabString(uint32_t) const;
+  const Word &GetTargetWord(uint32_t, WordCache &) const;
+
+  void AddRules(const UTrieMmapFormat::Node &, WordCache &, UTrieNode &) const;
+
+  util::scoped_memory m_memory;
+  const UTrieMmapFormat::Header *m_header;
+
+  std::vector<FactorType> m_input;
+  std::vector<FactorType> m_output;
+  std::vector<float> m_weight;
+  const LMList *m_languageModels;
+  const WordPenaltyProducer *m_wpProducer;
+  std::string m_filePath;
+  const size_t m_maxChartSpan;
+
+  mutable RuleCache m_ruleCache;
+#ifdef WITH_THREADS
+  mutable boost::mutex m_ruleCacheMutex;
+#endif
+};
+
+}  // namespace Moses
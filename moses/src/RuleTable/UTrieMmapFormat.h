@@ -0,0 +1,93 @@
+/***********************************************************************
+ Moses - statistical machine translation system
+ Copyright (C) 2006-2012 University of Edinburgh
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#pragma once
+
+#include <stdint.h>
+
+namespace Moses
+{
+
+/** On-disk layout of a compiled UTrie rule table (see RuleTableUTrieMmap and
+ * misc/processScope3Table).  The file is a Header followed by flat arrays.
+ * Everything is addressed by index or byte offset so the file can be mapped
+ * and used in place.  Node 0 is the root.
+ *
+ * Vocabulary strings are stored sorted by byte value so that a source word
+ * can be found by binary search.  Non-terminals are stored with brackets,
+ * e.g. "[NP]".  The edges of each node are sorted by vocabulary ID.
+ */
+namespace UTrieMmapFormat
+{
+
+const char kMagic[8] = {'U', 'T', 'r', 'i', 'e', 'M', 'M', '\0'};
+const uint32_t kVersion = 1;
+const uint32_t kNoNode = 0xFFFFFFFF;
+
+struct Header {
+  char magic[8];
+  uint32_t version;
+  uint32_t numScores;
+
+  uint64_t vocabSize;
+  uint64_t vocabIndexOffset;   // (vocabSize+1) uint64_t string offsets
+  uint64_t vocabStringOffset;  // concatenated strings, no terminators
+
+  uint64_t nodeCount;
+  uint64_t nodeOffset;
+  uint64_t edgeCount;
+  uint64_t edgeOffset;
+  uint64_t ruleCount;
+  uint64_t ruleOffset;
+  uint64_t symbolCount;
+  uint64_t symbolOffset;
+  uint64_t alignCount;
+  uint64_t alignOffset;
+  uint64_t scoreOffset;        // ruleCount * numScores floats
+};
+
+struct Node {
+  uint32_t firstEdge;
+  uint32_t numEdges;
+  uint32_t gapChild;           // kNoNode if there is no non-terminal child
+  uint32_t firstRule;
+  uint32_t numRules;
+};
+
+struct Edge {
+  uint32_t word;
+  uint32_t child;
+};
+
+struct Rule {
+  uint32_t lhs;
+  uint32_t firstSymbol;
+  uint32_t numSymbols;
+  uint32_t firstAlign;
+  uint32_t numAligns;
+};
+
+struct AlignPoint {
+  uint32_t source;
+  uint32_t target;
+};
+
+}  // namespace UTrieMmapFormat
+
+}  // namespace Moses
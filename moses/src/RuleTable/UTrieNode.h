@@ -38,6 +38,7 @@ namespace Moses
 {
 
 class RuleTableUTrie;
+class RuleTableUTrieMmap;
 
 //! @todo ask phil williams
 class UTrieNode
@@ -80,6 +81,7 @@ class UTrieNode
 
  private:
   friend class RuleTableUTrie;
+  friend class RuleTableUTrieMmap;
 
   UTrieNode() : m_gapNode(NULL) {}
 
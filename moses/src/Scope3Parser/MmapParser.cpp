@@ -0,0 +1,144 @@
+/***********************************************************************
+ Moses - statistical machine translation system
+ Copyright (C) 2006-2012 University of Edinburgh
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#include "Scope3Parser/MmapParser.h"
+
+#include "ChartCell.h"
+#include "ChartCellCollection.h"
+#include "ChartTranslationOptionList.h"
+#include "InputType.h"
+#include "RuleTable/UTrieMmap.h"
+#include "RuleTable/UTrieMmapFormat.h"
+#include "RuleTable/UTrieNode.h"
+#include "Sentence.h"
+
+#include <cassert>
+#include <vector>
+
+namespace Moses
+{
+
+Scope3MmapParser::Scope3MmapParser(const InputType &sentence,
+                                   const ChartCellCollection &cellColl,
+                                   const RuleTableUTrieMmap &ruleTable,
+                                   size_t maxChartSpan)
+    : ChartRuleLookupManager(sentence, cellColl)
+    , m_ruleTable(ruleTable)
+    , m_maxChartSpan(maxChartSpan)
+{
+  const Sentence &sent = dynamic_cast<const Sentence &>(sentence);
+  m_sentenceVocab.resize(sent.GetSize(), UTrieMmapFormat::kNoNode);
+  for (size_t i = 0; i < sent.GetSize(); ++i) {
+    uint32_t id;
+    if (m_ruleTable.FindSourceWord(sent.GetWord(i), id)) {
+      m_sentenceVocab[i] = id;
+    }
+  }
+}
+
+void Scope3MmapParser::GetChartRuleCollection(
+    const WordsRange &range,
+    ChartTranslationOptionList &outColl)
+{
+  if (m_maxChartSpan && range.GetNumWordsCovered() > m_maxChartSpan) {
+    return;
+  }
+  m_gaps.clear();
+  Match(0, range.GetStartPos(), range, outColl);
+}
+
+void Scope3MmapParser::Match(uint32_t nodeIndex,
+                             size_t pos,
+                             const WordsRange &range,
+                             ChartTranslationOptionList &outColl)
+{
+  const UTrieMmapFormat::Node &node = m_ruleTable.GetNode(nodeIndex);
+  if (pos > range.GetEndPos()) {
+    if (node.numRules > 0) {
+      AddRules(nodeIndex, range, outColl);
+    }
+    return;
+  }
+
+  const uint32_t word = m_sentenceVocab[pos];
+  if (word != UTrieMmapFormat::kNoNode) {
+    const uint32_t child = m_ruleTable.FindChild(node, word);
+    if (child != UTrieMmapFormat::kNoNode) {
+      Match(child, pos+1, range, outColl);
+    }
+  }
+
+  if (node.gapChild == UTrieMmapFormat::kNoNode) {
+    return;
+  }
+  // A gap can cover any sub-span that starts here and has hypotheses, but
+  // not the whole range: that cell is the one being filled.
+  for (size_t end = pos; end <= range.GetEndPos(); ++end) {
+    if (pos == range.GetStartPos() && end == range.GetEndPos()) {
+      break;
+    }
+    const WordsRange gap(pos, end);
+    if (GetCellCollection().Get(gap).GetTargetLabelSet().Empty()) {
+      continue;
+    }
+    m_gaps.push_back(gap);
+    Match(node.gapChild, end+1, range, outColl);
+    m_gaps.pop_back();
+  }
+}
+
+void Scope3MmapParser::AddRules(uint32_t nodeIndex,
+                                const WordsRange &range,
+                                ChartTranslationOptionList &outColl)
+{
+  const UTrieNode &rules = m_ruleTable.GetRules(nodeIndex);
+  const UTrieNode::LabelTable &labelTable = rules.GetLabelTable();
+  assert(labelTable.size() == m_gaps.size());
+
+  // Look up each label of each gap once, as StackLatticeBuilder does.
+  m_labelStacks.resize(m_gaps.size());
+  for (size_t i = 0; i < m_gaps.size(); ++i) {
+    const ChartCell &cell = GetCellCollection().Get(m_gaps[i]);
+    m_labelStacks[i].clear();
+    for (std::vector<Word>::const_iterator p = labelTable[i].begin();
+         p != labelTable[i].end(); ++p) {
+      m_labelStacks[i].push_back(cell.GetSortedHypotheses(*p));
+    }
+  }
+
+  const UTrieNode::LabelMap &labelMap = rules.GetLabelMap();
+  for (UTrieNode::LabelMap::const_iterator p = labelMap.begin();
+       p != labelMap.end(); ++p) {
+    const std::vector<int> &labels = p->first;
+    assert(labels.size() == m_gaps.size());
+    m_stackVec.clear();
+    for (size_t i = 0; i < labels.size(); ++i) {
+      const HypoList *stack = m_labelStacks[i][labels[i]];
+      if (!stack) {
+        break;
+      }
+      m_stackVec.push_back(stack);
+    }
+    if (m_stackVec.size() == labels.size()) {
+      outColl.Add(p->second, m_stackVec, range);
+    }
+  }
+}
+
+}  // namespace Moses
@@ -0,0 +1,71 @@
+/***********************************************************************
+ Moses - statistical machine translation system
+ Copyright (C) 2006-2012 University of Edinburgh
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#pragma once
+
+#include "ChartRuleLookupManager.h"
+#include "StackVec.h"
+#include "WordsRange.h"
+
+#include <stdint.h>
+#include <vector>
+
+namespace Moses
+{
+
+class ChartCellCollection;
+class ChartTranslationOptionList;
+class InputType;
+class RuleTableUTrieMmap;
+
+/** Rule lookup for compiled UTrie rule tables (RuleTableUTrieMmap).  The
+ * mapped trie is matched against each span in place: terminal edges are
+ * followed for the words of the span and gap edges for each sub-span whose
+ * chart cell has hypotheses.  The rules of a matched node come from the
+ * table's cache, so they are only built and scored once per process.
+ */
+class Scope3MmapParser : public ChartRuleLookupManager
+{
+ public:
+  Scope3MmapParser(const InputType &sentence,
+                   const ChartCellCollection &cellColl,
+                   const RuleTableUTrieMmap &ruleTable,
+                   size_t maxChartSpan);
+
+  void GetChartRuleCollection(const WordsRange &range,
+                              ChartTranslationOptionList &outColl);
+
+ private:
+  void Match(uint32_t nodeIndex, size_t pos, const WordsRange &range,
+             ChartTranslationOptionList &outColl);
+  void AddRules(uint32_t nodeIndex, const WordsRange &range,
+                ChartTranslationOptionList &outColl);
+
+  const RuleTableUTrieMmap &m_ruleTable;
+  const size_t m_maxChartSpan;
+  // Vocabulary ID of each sentence word, kNoNode if the table lacks it.
+  std::vector<uint32_t> m_sentenceVocab;
+  // Spans covered by the gaps matched so far.
+  std::vector<WordsRange> m_gaps;
+  // For each gap, the stack of each label in the node's label table.
+  std::vector<StackVec> m_labelStacks;
+  StackVec m_stackVec;
+};
+
+}  // namespace Moses
@@ -43,6 +43,10 @@ public:
   size_t GetTotalNumberOfScores() const {
     return m_last;
   }
+  //! short name of each score component, as printed in labeled scores
+  const std::vector<std::string> &GetFeatureShortNames() const {
+    return m_featureShortNames;
+  }
   //! print unweighted scores of each ScoreManager to stream os
   void PrintLabeledScores(std::ostream& os, const ScoreComponentCollection& scc) const;
   //! print weighted scores of each ScoreManager to stream os
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include "Manager.h"
 #include "Util.h"
 #include "SearchCubePruning.h"
@@ -90,6 +91,8 @@ void SearchCubePruning::ProcessSentence()
   const size_t Diversity = StaticData::Instance().GetCubePruningDiversity();
   VERBOSE(3,"Cube Pruning diversity is " << Diversity << std::endl)
 
+  Deadline &deadline = m_manager.GetDeadline();
+
   // go through each stack
   size_t stackNo = 1;
   std::vector < HypothesisStack* >::iterator iterStack;
@@ -116,18 +119,33 @@ void SearchCubePruning::ProcessSentence()
       // bmIter->second->EnsureMinStackHyps(PopLimit);
     }
 
+    // with a deadline, the pops and the beam are narrowed to the time left,
+    // but the stack still gets a few hypotheses in case the best cannot be
+    // extended
+    const size_t popLimit = std::max(deadline.BeginStep(PopLimit, m_hypoStackColl.end() - iterStack),
+                                     std::min(PopLimit, MIN_DEADLINE_STACK_SIZE));
+    if (deadline.IsSet()) {
+      const float ratio = (float) popLimit / PopLimit;
+      std::vector < HypothesisStack* >::iterator iterNext;
+      for (iterNext = iterStack + 1 ; iterNext != m_hypoStackColl.end() ; ++iterNext) {
+        static_cast<HypothesisStackCubePruning*>(*iterNext)->SetBeamWidth(staticData.GetBeamWidth() * ratio);
+      }
+    }
+
     // main search loop, pop k best hyps
-    for (size_t numpops = 1; numpops <= PopLimit && !BCQueue.empty(); numpops++) {
+    size_t numpops;
+    for (numpops = 0; numpops < popLimit && !BCQueue.empty(); numpops++) {
       BitmapContainer *bc = BCQueue.top();
       BCQueue.pop();
       bc->ProcessBestHypothesis();
       if (!bc->Empty())
         BCQueue.push(bc);
     }
+    deadline.EndStep(numpops);
 
     // ensure diversity, a minimum number of inserted hyps for each bitmap container;
     //    NOTE: diversity doesn't ensure they aren't pruned at some later point
-    if (Diversity > 0) {
+    if (Diversity > 0 && !deadline.WasPassed()) {
       for(bmIter = accessor.begin(); bmIter != accessor.end(); ++bmIter) {
         bmIter->second->EnsureMinStackHyps(Diversity);
       }
@@ -145,6 +163,8 @@ void SearchCubePruning::ProcessSentence()
     stackNo++;
   }
 
+  m_manager.GetSentenceStats().SetDeadlineStats(deadline.GetNumNarrowed(), deadline.WasPassed());
+
   PrintBitmapContainerGraph();
 
   // some more logging
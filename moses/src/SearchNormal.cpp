@@ -1,3 +1,4 @@
+#include <algorithm>
 #include "Manager.h"
 #include "Timer.h"
 #include "SearchNormal.h"
@@ -20,6 +21,7 @@ SearchNormal::SearchNormal(Manager& manager, const InputType &source, const Tran
   ,m_start(clock())
   ,interrupted_flag(0)
   ,m_transOptColl(transOptColl)
+  ,m_numHyposAdded(0)
 {
   VERBOSE(1, "Translating: " << m_source << endl);
   const StaticData &staticData = StaticData::Instance();
@@ -65,6 +67,9 @@ void SearchNormal::ProcessSentence()
   Hypothesis *hypo = Hypothesis::Create(m_manager,m_source, m_initialTargetPhrase);
   m_hypoStackColl[0]->AddPrune(hypo);
 
+  Deadline &deadline = m_manager.GetDeadline();
+  const size_t maxStackSize = staticData.GetMaxHypoStackSize();
+
   // go through each stack
   std::vector < HypothesisStack* >::iterator iterStack;
   for (iterStack = m_hypoStackColl.begin() ; iterStack != m_hypoStackColl.end() ; ++iterStack) {
@@ -82,7 +87,14 @@ void SearchNormal::ProcessSentence()
     IFVERBOSE(2) {
       t = clock();
     }
-    sourceHypoColl.PruneToSize(staticData.GetMaxHypoStackSize());
+    // with a deadline, the stacks are narrowed to the time left, but keep a
+    // few hypotheses in case the best ones cannot be extended
+    const size_t numToExpand = deadline.BeginStep(maxStackSize, m_hypoStackColl.end() - iterStack);
+    const size_t stackSize = std::max(numToExpand, std::min(maxStackSize, MIN_DEADLINE_STACK_SIZE));
+    if (deadline.IsSet()) {
+      SetStackLimits(iterStack + 1, stackSize);
+    }
+    sourceHypoColl.PruneToSize(stackSize);
     VERBOSE(3,std::endl);
     sourceHypoColl.CleanupArcList();
     IFVERBOSE(2) {
@@ -90,11 +102,27 @@ void SearchNormal::ProcessSentence()
     }
 
     // go through each hypothesis on the stack and try to expand it
-    HypothesisStackNormal::const_iterator iterHypo;
-    for (iterHypo = sourceHypoColl.begin() ; iterHypo != sourceHypoColl.end() ; ++iterHypo) {
-      Hypothesis &hypothesis = **iterHypo;
-      ProcessOneHypothesis(hypothesis); // expand the hypothesis
+    size_t numExpanded = 0;
+    if (!deadline.IsSet()) {
+      HypothesisStackNormal::const_iterator iterHypo;
+      for (iterHypo = sourceHypoColl.begin() ; iterHypo != sourceHypoColl.end() ; ++iterHypo) {
+        Hypothesis &hypothesis = **iterHypo;
+        ProcessOneHypothesis(hypothesis); // expand the hypothesis
+      }
+    } else {
+      // best first; once numToExpand are expanded or the deadline passes,
+      // stop as soon as any of them has been extended
+      const size_t numAddedBefore = m_numHyposAdded;
+      const std::vector<const Hypothesis*> hypos = sourceHypoColl.GetSortedList();
+      for (size_t i = 0 ; i < hypos.size() ; ++i) {
+        if ((numExpanded >= numToExpand || deadline.Passed()) && m_numHyposAdded > numAddedBefore) {
+          break;
+        }
+        ProcessOneHypothesis(*hypos[i]);
+        ++numExpanded;
+      }
     }
+    deadline.EndStep(numExpanded);
     // some logging
     IFVERBOSE(2) {
       OutputHypoStackSize();
@@ -104,6 +132,8 @@ void SearchNormal::ProcessSentence()
     actual_hypoStack = &sourceHypoColl;
   }
 
+  stats.SetDeadlineStats(deadline.GetNumNarrowed(), deadline.WasPassed());
+
   // some more logging
   IFVERBOSE(2) {
     m_manager.GetSentenceStats().SetTimeTotal( clock()-m_start );
@@ -111,6 +141,21 @@ void SearchNormal::ProcessSentence()
   VERBOSE(2, m_manager.GetSentenceStats());
 }
 
+/**
+ * Narrow the stacks from iterStack on to stackSize hypotheses, with the
+ * beam narrowed by the same ratio
+ */
+void SearchNormal::SetStackLimits(std::vector < HypothesisStack* >::iterator iterStack, size_t stackSize)
+{
+  const StaticData &staticData = StaticData::Instance();
+  const float ratio = (float) stackSize / staticData.GetMaxHypoStackSize();
+  for (; iterStack != m_hypoStackColl.end() ; ++iterStack) {
+    HypothesisStackNormal &stack = *static_cast<HypothesisStackNormal*>(*iterStack);
+    stack.SetMaxHypoStackSize(stackSize, staticData.GetMinHypoStackDiversity());
+    stack.SetBeamWidth(staticData.GetBeamWidth() * ratio);
+  }
+}
+
 
 /** Find all translation options to expand one hypothesis, trigger expansion
  * this is mostly a check for overlap with already covered words, and for
@@ -364,7 +409,9 @@ void SearchNormal::ExpandHypothesis(const Hypothesis &hypothesis, const Translat
   IFVERBOSE(2) {
     t = clock();
   }
-  m_hypoStackColl[wordsTranslated]->AddPrune(newHypo);
+  if (m_hypoStackColl[wordsTranslated]->AddPrune(newHypo)) {
+    ++m_numHyposAdded;
+  }
   IFVERBOSE(2) {
     stats.AddTimeStack( clock()-t );
   }
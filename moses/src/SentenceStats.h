@@ -70,6 +70,8 @@ public:
     m_timeCalcLM = 0;
     m_timeOtherScore = 0;
     m_timeStack = 0;
+    m_numDeadlineNarrowed = 0;
+    m_deadlinePassed = false;
     m_totalSourceWords = source.GetSize();
     m_recombinationInfos.clear();
     m_deletedWords.clear();
@@ -120,6 +122,12 @@ public:
   float GetTimeTotal() const {
     return m_timeTotal/(float)CLOCKS_PER_SEC;
   }
+  size_t GetNumDeadlineNarrowed() const {
+    return m_numDeadlineNarrowed;
+  }
+  bool GetDeadlinePassed() const {
+    return m_deadlinePassed;
+  }
   size_t GetTotalSourceWords() const {
     return m_totalSourceWords;
   }
@@ -177,6 +185,11 @@ public:
   void SetTimeTotal( clock_t t ) {
     m_timeTotal = t;
   }
+  //! steps of the search narrowed to meet the deadline, and whether it passed
+  void SetDeadlineStats(size_t numNarrowed, bool passed) {
+    m_numDeadlineNarrowed = numNarrowed;
+    m_deadlinePassed = passed;
+  }
 
 protected:
 
@@ -199,6 +212,8 @@ protected:
   clock_t m_timeOtherScore;
   clock_t m_timeStack;
   clock_t m_timeTotal;
+  size_t m_numDeadlineNarrowed;
+  bool m_deadlinePassed;
 
   //words
   size_t m_totalSourceWords;
@@ -211,6 +226,11 @@ inline std::ostream& operator<<(std::ostream& os, const SentenceStats& ss)
   float totalTime = ss.GetTimeTotal();
   float otherTime = totalTime - (ss.GetTimeCollectOpts() + ss.GetTimeBuildHyp() + ss.GetTimeEstimateScore() + ss.GetTimeCalcLM() + ss.GetTimeOtherScore() + ss.GetTimeStack());
 
+  if (ss.GetNumDeadlineNarrowed() > 0) {
+    os << "steps narrowed for deadline = " << ss.GetNumDeadlineNarrowed()
+       << (ss.GetDeadlinePassed() ? " (deadline passed)" : "") << std::endl;
+  }
+
   return os << "total hypotheses considered = " << ss.GetTotalHypos() << std::endl
          << "           number not built = " << ss.GetNumHyposNotBuilt() << std::endl
          << "     number discarded early = " << ss.GetNumHyposEarlyDiscarded() << std::endl
@@ -40,6 +40,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include "TranslationOption.h"
 #include "DecodeGraph.h"
 #include "InputFileStream.h"
+#include "InputFilter.h"
 
 #ifdef HAVE_SYNLM
 #include "SyntacticLanguageModel.h"
@@ -84,6 +85,7 @@ StaticData::StaticData()
   ,m_factorDelimiter("|") // default delimiter between factors
   ,m_lmEnableOOVFeature(false)
   ,m_isAlwaysCreateDirectTranslationOption(false)
+  ,m_inputFilter(NULL)
 {
   m_maxFactorIdx[0] = 0;  // source side
   m_maxFactorIdx[1] = 0;  // target side
@@ -221,6 +223,15 @@ bool StaticData::LoadData(Parameter *parameter)
     m_outputSearchGraphExtended = true;
   } else
     m_outputSearchGraph = false;
+  // ... in binary, independently of the text formats
+  if (m_parameter->GetParam("output-search-graph-binary").size() > 0) {
+    if (m_parameter->GetParam("output-search-graph-binary").size() != 1) {
+      UserMessage::Add(string("ERROR: wrong format for switch -output-search-graph-binary file"));
+      return false;
+    }
+    m_outputSearchGraphBinary = true;
+  } else
+    m_outputSearchGraphBinary = false;
 #ifdef HAVE_PROTOBUF
   if (m_parameter->GetParam("output-search-graph-pb").size() > 0) {
     if (m_parameter->GetParam("output-search-graph-pb").size() != 1) {
@@ -358,6 +369,9 @@ bool StaticData::LoadData(Parameter *parameter)
                            ? Scan<size_t>(m_parameter->GetParam("cube-pruning-diversity")[0]) : DEFAULT_CUBE_PRUNING_DIVERSITY;
 
   SetBooleanParameter(&m_cubePruningLazyScoring, "cube-pruning-lazy-scoring", false);
+  SetBooleanParameter(&m_cubePruningFlatQueue, "cube-pruning-flat-queue", true);
+  m_cubePruningCoarseThreshold = (m_parameter->GetParam("cube-pruning-coarse-threshold").size() > 0)
+                                  ? Scan<float>(m_parameter->GetParam("cube-pruning-coarse-threshold")[0]) : -1;
 
   // unknown word processing
   SetBooleanParameter( &m_dropUnknown, "drop-unknown", false );
@@ -403,6 +417,8 @@ bool StaticData::LoadData(Parameter *parameter)
   m_timeout_threshold = (m_parameter->GetParam("time-out").size() > 0) ?
                         Scan<size_t>(m_parameter->GetParam("time-out")[0]) : -1;
   m_timeout = (GetTimeoutThreshold() == (size_t)-1) ? false : true;
+  m_deadline = (m_parameter->GetParam("deadline").size() > 0) ?
+                Scan<float>(m_parameter->GetParam("deadline")[0]) / 1000 : -1;
 
 
   m_lmcache_cleanup_threshold = (m_parameter->GetParam("clean-lm-cache").size() > 0) ?
@@ -502,6 +518,10 @@ bool StaticData::LoadData(Parameter *parameter)
 	}
 #endif
 	
+  bool filterGivenInput;
+  SetBooleanParameter(&filterGivenInput, "filter-given-input", false);
+  if (filterGivenInput && !LoadInputFilter()) return false;
+
   if (!LoadLexicalReorderingModel()) return false;
   if (!LoadLanguageModels()) return false;
   if (!LoadGenerationTables()) return false;
@@ -628,6 +648,7 @@ StaticData::~StaticData()
   RemoveAllInColl(m_generationDictionary);
   RemoveAllInColl(m_reorderModels);
   RemoveAllInColl(m_globalLexicalModels);
+  delete m_inputFilter;
 	
 #ifdef HAVE_SYNLM
 	delete m_syntacticLanguageModel;
@@ -707,6 +728,28 @@ StaticData::~StaticData()
   }
 #endif
 
+bool StaticData::LoadInputFilter()
+{
+  if (m_parameter->GetParam("input-file").size() != 1) {
+    UserMessage::Add("filter-given-input needs the input to be given with -input-file");
+    return false;
+  }
+  if (m_inputType != SentenceInput && m_inputType != TreeInputType) {
+    UserMessage::Add("filter-given-input only works with sentence or tree input");
+    return false;
+  }
+
+  const string &filePath = m_parameter->GetParam("input-file")[0];
+  VERBOSE(1, "Reading " << filePath << " to filter the text tables" << endl);
+
+  // markup is stripped as the input is read, unless it is passed through
+  const bool hasMarkup = m_inputType == TreeInputType || m_xmlInputType != XmlPassThrough;
+
+  InputFilter *inputFilter = new InputFilter(m_inputFactorOrder, m_factorDelimiter, m_maxPhraseLength);
+  m_inputFilter = inputFilter;
+  return inputFilter->Load(filePath, hasMarkup ? &m_xmlBrackets : NULL);
+}
+
 bool StaticData::LoadLexicalReorderingModel()
 {
   VERBOSE(1, "Loading lexical distortion models...");
@@ -833,7 +876,9 @@ bool StaticData::LoadLanguageModels()
     for(size_t i=0; i<lmVector.size(); i++) {
       LanguageModel* lm = NULL;
       if (languageModelsLoaded.find(lmVector[i]) != languageModelsLoaded.end()) {
-        lm = languageModelsLoaded[lmVector[i]]->Duplicate(m_scoreIndexManager); 
+        const LanguageModel *original = languageModelsLoaded[lmVector[i]];
+        lm = original->Duplicate(m_scoreIndexManager);
+        m_lmFingerprints[lm] = m_lmFingerprints[original];
       } else {
         vector<string>	token		= Tokenize(lmVector[i]);
         if (token.size() != 4 && token.size() != 5 ) {
@@ -873,6 +918,7 @@ bool StaticData::LoadLanguageModels()
           return false;
         }
         languageModelsLoaded[lmVector[i]] = lm;
+        m_lmFingerprints[lm] = LanguageModelFactory::Fingerprint(lmVector[i]);
       }
 
       m_languageModel.Add(lm);
@@ -51,6 +51,7 @@ namespace Moses
 {
 
 class InputType;
+class InputFilter;
 class LexicalReordering;
 class GlobalLexicalModel;
 class PhraseDictionaryFeature;
@@ -82,6 +83,7 @@ protected:
   Parameter *m_parameter;
   std::vector<FactorType>	m_inputFactorOrder, m_outputFactorOrder;
   LMList									m_languageModel;
+  std::map<const LanguageModel*, std::string> m_lmFingerprints;
 #ifdef HAVE_SYNLM
 	SyntacticLanguageModel* m_syntacticLanguageModel;
 #endif
@@ -176,6 +178,7 @@ protected:
 
   bool m_timeout; //! use timeout
   size_t m_timeout_threshold; //! seconds after which time out is activated
+  float m_deadline; //! wall-clock seconds allowed for each sentence, -1 for none
 
   bool m_useTransOptCache; //! flag indicating, if the persistent translation option cache should be used
   mutable std::map<std::pair<size_t, Phrase>, std::pair<TranslationOptionList*,clock_t> > m_transOptCache; //! persistent translation option cache
@@ -186,11 +189,13 @@ protected:
   mutable boost::mutex m_transOptCacheMutex;
 #endif
   bool m_isAlwaysCreateDirectTranslationOption;
+  const InputFilter *m_inputFilter; //! n-grams of the input, if the text tables are to be filtered with them
   //! constructor. only the 1 static variable can be created
 
   bool m_outputWordGraph; //! whether to output word graph
   bool m_outputSearchGraph; //! whether to output search graph
   bool m_outputSearchGraphExtended; //! ... in extended format
+  bool m_outputSearchGraphBinary; //! ... in binary format
 #ifdef HAVE_PROTOBUF
   bool m_outputSearchGraphPB; //! whether to output search graph as a protobuf
 #endif
@@ -199,6 +204,8 @@ protected:
   size_t m_cubePruningPopLimit;
   size_t m_cubePruningDiversity;
   bool m_cubePruningLazyScoring;
+  bool m_cubePruningFlatQueue;
+  float m_cubePruningCoarseThreshold; //! threshold of the coarse pass, -1 for none
   size_t m_ruleLimit;
 
 
@@ -234,6 +241,8 @@ protected:
   bool LoadDecodeGraphs();
   bool LoadLexicalReorderingModel();
   bool LoadGlobalLexicalModel();
+  //! read the n-grams of the input file for filter-given-input
+  bool LoadInputFilter();
   void ReduceTransOptCache() const;
   bool m_continuePartialTranslation;
 
@@ -314,6 +323,12 @@ public:
   bool GetCubePruningLazyScoring() const {
     return m_cubePruningLazyScoring;
   }
+  bool GetCubePruningFlatQueue() const {
+    return m_cubePruningFlatQueue;
+  }
+  float GetCubePruningCoarseThreshold() const {
+    return m_cubePruningCoarseThreshold;
+  }
   size_t IsPathRecoveryEnabled() const {
     return m_recoverPath;
   }
@@ -400,7 +415,7 @@ public:
     return m_nBestFilePath;
   }
   bool IsNBestEnabled() const {
-    return (!m_nBestFilePath.empty()) || m_mbr || m_useLatticeMBR || m_outputSearchGraph || m_useConsensusDecoding || !m_latticeSamplesFilePath.empty()
+    return (!m_nBestFilePath.empty()) || m_mbr || m_useLatticeMBR || m_outputSearchGraph || m_outputSearchGraphBinary || m_useConsensusDecoding || !m_latticeSamplesFilePath.empty()
 #ifdef HAVE_PROTOBUF
            || m_outputSearchGraphPB
 #endif
@@ -435,6 +450,10 @@ public:
   LMList GetLMList() const { 
     return m_languageModel; 
   }
+  //! identifies the model and file the LM was loaded from, see LanguageModelFactory::Fingerprint()
+  const std::string &GetLMFingerprint(const LanguageModel *lm) const {
+    return m_lmFingerprints.find(lm)->second;
+  }
   size_t GetNumInputScores() const {
     return m_numInputScores;
   }
@@ -523,6 +542,10 @@ public:
   size_t GetTimeoutThreshold() const {
     return m_timeout_threshold;
   }
+  //! wall-clock seconds allowed for translating a sentence, negative for no limit
+  float GetDeadline() const {
+    return m_deadline;
+  }
 
   size_t GetLMCacheCleanupThreshold() const {
     return m_lmcache_cleanup_threshold;
@@ -541,6 +564,9 @@ public:
   bool GetOutputSearchGraphExtended() const {
     return m_outputSearchGraphExtended;
   }
+  bool GetOutputSearchGraphBinary() const {
+    return m_outputSearchGraphBinary;
+  }
 #ifdef HAVE_PROTOBUF
   bool GetOutputSearchGraphPB() const {
     return m_outputSearchGraphPB;
@@ -558,6 +584,11 @@ public:
     return m_xmlBrackets;
   }
 
+  //! n-grams that entries of text tables must match to be loaded. NULL to load everything
+  const InputFilter *GetInputFilter() const {
+    return m_inputFilter;
+  }
+
   bool GetUseTransOptCache() const {
     return m_useTransOptCache;
   }
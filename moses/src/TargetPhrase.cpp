@@ -43,6 +43,7 @@ namespace Moses
 TargetPhrase::TargetPhrase( std::string out_string)
   :Phrase(0),m_transScore(0.0), m_fullScore(0.0), m_sourcePhrase(0)
   , m_alignmentInfo(&AlignmentInfoCollection::Instance().GetEmptyAlignmentInfo())
+  , m_hasLMFutureScore(false)
 {
 
   //ACAT
@@ -57,6 +58,7 @@ TargetPhrase::TargetPhrase()
   , m_fullScore(0.0)
   , m_sourcePhrase(0)
   , m_alignmentInfo(&AlignmentInfoCollection::Instance().GetEmptyAlignmentInfo())
+  , m_hasLMFutureScore(false)
 {
 }
 
@@ -66,6 +68,7 @@ TargetPhrase::TargetPhrase(const Phrase &phrase)
   , m_fullScore(0.0)
   , m_sourcePhrase(0)
   , m_alignmentInfo(&AlignmentInfoCollection::Instance().GetEmptyAlignmentInfo())
+  , m_hasLMFutureScore(false)
 {
 }
 
@@ -150,7 +153,8 @@ void TargetPhrase::SetScore(const TranslationSystem* system, const Scores &score
 void TargetPhrase::SetScore(const ScoreProducer* translationScoreProducer,
                             const Scores &scoreVector,
                             const vector<float> &weightT,
-                            float weightWP, const LMList &languageModels)
+                            float weightWP, const LMList &languageModels,
+                            const float *lmEstimates)
 {
   CHECK(weightT.size() == scoreVector.size());
   // calc average score if non-best
@@ -162,19 +166,29 @@ void TargetPhrase::SetScore(const ScoreProducer* translationScoreProducer,
   float totalNgramScore  = 0;
   float totalFullScore   = 0;
   float totalOOVScore    = 0;
+  m_hasLMFutureScore = (lmEstimates != NULL);
 
   LMList::const_iterator lmIter;
   for (lmIter = languageModels.begin(); lmIter != languageModels.end(); ++lmIter) {
     const LanguageModel &lm = **lmIter;
 
-    if (lm.Useable(*this)) {
+    if (!lm.Useable(*this)) {
+      // the factors may be added later, and the LM then scores the phrase
+      m_hasLMFutureScore = false;
+    } else {
       // contains factors used by this LM
       const float weightLM = lm.GetWeight();
       const float oovWeightLM = lm.GetOOVWeight();
       float fullScore, nGramScore;
       size_t oovCount;
 
-      lm.CalcScore(*this, fullScore, nGramScore, oovCount);
+      if (lmEstimates) {
+        fullScore = lmEstimates[0];
+        nGramScore = lmEstimates[1];
+        oovCount = static_cast<size_t>(lmEstimates[2]);
+      } else {
+        lm.CalcScore(*this, fullScore, nGramScore, oovCount);
+      }
 
       if (StaticData::Instance().GetLMEnableOOVFeature()) {
         vector<float> scores(2);
@@ -192,8 +206,12 @@ void TargetPhrase::SetScore(const ScoreProducer* translationScoreProducer,
       totalFullScore   += fullScore * weightLM;
 
     }
+    if (lmEstimates) {
+      lmEstimates += 3;
+    }
   }
 
+  m_lmFutureScore = totalFullScore - totalNgramScore + totalOOVScore;
   m_fullScore = m_transScore + totalFullScore + totalOOVScore
                 - (this->GetSize() * weightWP);	 // word penalty
 }
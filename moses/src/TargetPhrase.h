@@ -58,6 +58,11 @@ protected:
   const AlignmentInfo *m_alignmentInfo;
   Word m_lhsTarget;
 
+  // weighted LM full score less n-gram score plus OOV score, kept when
+  // SetScore() took the scores of every LM from stored estimates
+  float m_lmFutureScore;
+  bool m_hasLMFutureScore;
+
 public:
   TargetPhrase();
   TargetPhrase(std::string out_string);
@@ -83,6 +88,8 @@ public:
    * @param weighT the weights for the individual scores (t-weights in the .ini file)
    * @param languageModels all the LanguageModels that should be used to compute the LM scores
    * @param weightWP the weight of the word penalty
+   * @param lmEstimates if not NULL, the full score, n-gram score and OOV count
+   *        of each of the languageModels, as CalcScore() would give them
    *
    * @TODO should this be part of the constructor?  If not, add explanation why not.
   	*/
@@ -90,7 +97,8 @@ public:
                 const Scores &scoreVector,
                 const std::vector<float> &weightT,
                 float weightWP,
-                const LMList &languageModels);
+                const LMList &languageModels,
+                const float *lmEstimates = NULL);
 
   void SetScoreChart(const ScoreProducer* translationScoreProducer
                      ,const Scores &scoreVector
@@ -133,6 +141,19 @@ public:
     return m_scoreBreakdown;
   }
 
+  //! whether the LM part of a translation option's future score is known
+  //! without scoring the phrase again
+  bool HasLMFutureScore() const {
+    return m_hasLMFutureScore;
+  }
+  float GetLMFutureScore() const {
+    return m_lmFutureScore;
+  }
+  //! to be called when factors are added to the phrase
+  void ResetLMFutureScore() {
+    m_hasLMFutureScore = false;
+  }
+
   //! TODO - why is this needed and is it set correctly by every phrase dictionary class ? should be set in constructor
   void SetSourcePhrase(Phrase const* p) {
     m_sourcePhrase=p;
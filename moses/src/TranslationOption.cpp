@@ -111,6 +111,7 @@ void TranslationOption::MergeNewFeatures(const Phrase& phrase, const ScoreCompon
   } else {
     m_targetPhrase.MergeFactors(phrase, featuresToAdd);
   }
+  m_targetPhrase.ResetLMFutureScore();
   m_scoreBreakdown.PlusEquals(score);
 }
 
@@ -140,10 +141,18 @@ void TranslationOption::CalcScore(const TranslationSystem* system)
   float oovScore = 0;
 
   const LMList &allLM = system->GetLanguageModels();
+  size_t phraseSize = GetTargetPhrase().GetSize();
+
+  if (GetTargetPhrase().HasLMFutureScore()) {
+    // the LM scores came with the phrase table and are in the breakdown already
+    m_futureScore = GetTargetPhrase().GetLMFutureScore()
+                    + m_scoreBreakdown.InnerProduct(StaticData::Instance().GetAllWeights()) - phraseSize *
+                    system->GetWeightWordPenalty();
+    return;
+  }
 
   allLM.CalcScore(GetTargetPhrase(), retFullScore, ngramScore, oovScore, &m_scoreBreakdown);
 
-  size_t phraseSize = GetTargetPhrase().GetSize();
   // future score
   m_futureScore = retFullScore - ngramScore + oovScore
                   + m_scoreBreakdown.InnerProduct(StaticData::Instance().GetAllWeights()) - phraseSize *
@@ -553,8 +553,10 @@ void TranslationOptionCollection::CreateTranslationOptionsForRange(
         const DecodeStep &decodeStep = **iterStep;
         PartialTranslOptColl* newPtoc = new PartialTranslOptColl;
 
-        // go thru each intermediate trans opt just created
-        const vector<TranslationOption*>& partTransOptList = oldPtoc->GetList();
+        // go thru each intermediate trans opt just created, best first so
+        // that the decode step can soon skip extensions too bad to be kept
+        vector<TranslationOption*> partTransOptList = oldPtoc->GetList();
+        std::stable_sort(partTransOptList.begin(), partTransOptList.end(), CompareTranslationOption);
         vector<TranslationOption*>::const_iterator iterPartialTranslOpt;
         for (iterPartialTranslOpt = partTransOptList.begin() ; iterPartialTranslOpt != partTransOptList.end() ; ++iterPartialTranslOpt) {
           TranslationOption &inputPartialTranslOpt = **iterPartialTranslOpt;
@@ -564,6 +566,9 @@ void TranslationOptionCollection::CreateTranslationOptionsForRange(
                              , this
                              , adhereTableLimit);
         }
+        // keep the best of this step only, whatever the order they came in;
+        // the decode steps skip just the extensions this would prune
+        newPtoc->Prune();
         // last but 1 partial trans not required anymore
         totalEarlyPruned += newPtoc->GetPrunedCount();
         delete oldPtoc;
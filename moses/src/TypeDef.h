@@ -56,6 +56,7 @@ namespace Moses
 const size_t DEFAULT_CUBE_PRUNING_POP_LIMIT = 1000;
 const size_t DEFAULT_CUBE_PRUNING_DIVERSITY = 0;
 const size_t DEFAULT_MAX_HYPOSTACK_SIZE = 200;
+const size_t MIN_DEADLINE_STACK_SIZE = 10; // hypotheses a stack keeps however close the deadline (see -deadline)
 const size_t DEFAULT_MAX_TRANS_OPT_CACHE_SIZE = 10000;
 const size_t DEFAULT_MAX_TRANS_OPT_SIZE	= 5000;
 const size_t DEFAULT_MAX_PART_TRANS_OPT_SIZE = 10000;
@@ -137,6 +138,8 @@ enum PhraseTableImplementation {
   ,SuffixArray	= 8
   ,Hiero        = 9
   ,ALSuffixArray = 10
+  ,Scope3Binary = 11
+  ,Compact = 12
 };
 
 enum InputTypeEnum {
@@ -22,6 +22,7 @@
 #include "Alignment.h"
 #include "AlignmentGraph.h"
 #include "Exception.h"
+#include "ExtractTask.h"
 #include "InputFileStream.h"
 #include "Node.h"
 #include "OutputFileStream.h"
@@ -32,6 +33,8 @@
 #include "Span.h"
 #include "XmlTreeParser.h"
 
+#include "../../moses/src/ThreadPool.h"
+
 #include <boost/program_options.hpp>
 
 #include <cassert>
@@ -85,13 +88,21 @@ int ExtractGHKM::Main(int argc, char *argv[])
   std::map<std::string, int> wordCount;
   std::map<std::string, std::string> wordLabel;
 
-  std::string targetLine;
-  std::string sourceLine;
-  std::string alignmentLine;
-  XmlTreeParser xmlTreeParser(labelSet, topLabelSet);
-  ScfgRuleWriter writer(fwdExtractStream, invExtractStream, options);
+  // Rules are written, and the label statistics merged, in input order.
+  ResultCollector collector(fwdExtractStream, invExtractStream,
+                            labelSet, topLabelSet, wordCount, wordLabel);
+
+#ifdef WITH_THREADS
+  Moses::ThreadPool pool(options.threads);
+  // each queued task holds a sentence pair and, once run, its rules
+  pool.SetQueueLimit(100 * options.threads);
+#endif
+
   size_t lineNum = 0;
   while (true) {
+    std::string targetLine;
+    std::string sourceLine;
+    std::string alignmentLine;
     std::getline(targetStream, targetLine);
     std::getline(sourceStream, sourceLine);
     std::getline(alignmentStream, alignmentLine);
@@ -106,84 +117,114 @@ int ExtractGHKM::Main(int argc, char *argv[])
 
     ++lineNum;
 
-    // Parse target tree.
-    if (targetLine.size() == 0) { 
-      std::cerr << "skipping line " << lineNum << " with empty target tree\n";
-      continue;
-    }
-    std::auto_ptr<ParseTree> t;
-    try {
-      t = xmlTreeParser.Parse(targetLine);
-      assert(t.get());
-    } catch (const Exception &e) {
-      std::ostringstream s;
-      s << "Failed to parse XML tree at line " << lineNum;
-      if (!e.GetMsg().empty()) {
-        s << ": " << e.GetMsg();
-      }
-      Error(s.str());
-    }
-
-    // Read source tokens.
-    std::vector<std::string> sourceTokens(ReadTokens(sourceLine));
-
-    // Read word alignments.
-    Alignment alignment;
-    try {
-      alignment = ReadAlignment(alignmentLine);
-    } catch (const Exception &e) {
-      std::ostringstream s;
-      s << "Failed to read alignment at line " << lineNum << ": ";
-      s << e.GetMsg();
-      Error(s.str());
-    }
-    if (alignment.size() == 0) {
-      std::cerr << "skipping line " << lineNum << " without alignment points\n";
+    ExtractTask *task = new ExtractTask(lineNum, targetLine, sourceLine,
+                                        alignmentLine, *this, options,
+                                        collector);
+#ifdef WITH_THREADS
+    if (options.threads > 1) {
+      pool.Submit(task);
       continue;
     }
+#endif
+    task->Run();
+    delete task;
+  }
 
-    // Record word counts.
-    if (!options.unknownWordFile.empty()) {
-      CollectWordLabelCounts(*t, wordCount, wordLabel);
-    }
+#ifdef WITH_THREADS
+  pool.Stop(true);
+#endif
 
-    // Form an alignment graph from the target tree, source words, and
-    // alignment.
-    AlignmentGraph graph(t.get(), sourceTokens, alignment);
+  if (!options.glueGrammarFile.empty()) {
+    WriteGlueGrammar(labelSet, topLabelSet, glueGrammarStream);
+  }
 
-    // Extract minimal rules, adding each rule to its root node's rule set.
-    graph.ExtractMinimalRules(options);
+  if (!options.unknownWordFile.empty()) {
+    WriteUnknownWordLabel(wordCount, wordLabel, unknownWordStream);
+  }
 
-    // Extract composed rules.
-    if (!options.minimal) {
-      graph.ExtractComposedRules(options);
-    }
+  return 0;
+}
 
-    // Write the rules, subject to scope pruning.
-    const std::vector<Node *> &targetNodes = graph.GetTargetNodes();
-    for (std::vector<Node *>::const_iterator p = targetNodes.begin();
-         p != targetNodes.end(); ++p) {
-      const std::vector<const Subgraph *> &rules = (*p)->GetRules();
-      for (std::vector<const Subgraph *>::const_iterator q = rules.begin();
-           q != rules.end(); ++q) {
-        ScfgRule r(**q);
-        // TODO Can scope pruning be done earlier?
-        if (r.Scope() <= options.maxScope) {
-          writer.Write(r);
-        }
-      }
+void ExtractGHKM::ExtractSentence(size_t lineNum,
+                                  const std::string &targetLine,
+                                  const std::string &sourceLine,
+                                  const std::string &alignmentLine,
+                                  const Options &options,
+                                  ExtractResult &result) const
+{
+  // Parse target tree.
+  if (targetLine.size() == 0) {
+    std::cerr << "skipping line " << lineNum << " with empty target tree\n";
+    return;
+  }
+  XmlTreeParser xmlTreeParser(result.labelSet, result.topLabelSet);
+  std::auto_ptr<ParseTree> t;
+  try {
+    t = xmlTreeParser.Parse(targetLine);
+    assert(t.get());
+  } catch (const Exception &e) {
+    std::ostringstream s;
+    s << "Failed to parse XML tree at line " << lineNum;
+    if (!e.GetMsg().empty()) {
+      s << ": " << e.GetMsg();
     }
+    Error(s.str());
   }
 
-  if (!options.glueGrammarFile.empty()) {
-    WriteGlueGrammar(labelSet, topLabelSet, glueGrammarStream);
+  // Read source tokens.
+  std::vector<std::string> sourceTokens(ReadTokens(sourceLine));
+
+  // Read word alignments.
+  Alignment alignment;
+  try {
+    alignment = ReadAlignment(alignmentLine);
+  } catch (const Exception &e) {
+    std::ostringstream s;
+    s << "Failed to read alignment at line " << lineNum << ": ";
+    s << e.GetMsg();
+    Error(s.str());
+  }
+  if (alignment.size() == 0) {
+    std::cerr << "skipping line " << lineNum << " without alignment points\n";
+    return;
   }
 
+  // Record word labels, for the unknown word label statistics.
   if (!options.unknownWordFile.empty()) {
-    WriteUnknownWordLabel(wordCount, wordLabel, unknownWordStream);
+    CollectWordLabels(*t, result.wordLabels);
   }
 
-  return 0;
+  // Form an alignment graph from the target tree, source words, and
+  // alignment.
+  AlignmentGraph graph(t.get(), sourceTokens, alignment);
+
+  // Extract minimal rules, adding each rule to its root node's rule set.
+  graph.ExtractMinimalRules(options);
+
+  // Extract composed rules.
+  if (!options.minimal) {
+    graph.ExtractComposedRules(options);
+  }
+
+  // Write the rules, subject to scope pruning.
+  std::ostringstream fwd;
+  std::ostringstream inv;
+  ScfgRuleWriter writer(fwd, inv, options);
+  const std::vector<Node *> &targetNodes = graph.GetTargetNodes();
+  for (std::vector<Node *>::const_iterator p = targetNodes.begin();
+       p != targetNodes.end(); ++p) {
+    const std::vector<const Subgraph *> &rules = (*p)->GetRules();
+    for (std::vector<const Subgraph *>::const_iterator q = rules.begin();
+         q != rules.end(); ++q) {
+      ScfgRule r(**q);
+      // TODO Can scope pruning be done earlier?
+      if (r.Scope() <= options.maxScope) {
+        writer.Write(r);
+      }
+    }
+  }
+  result.fwd = fwd.str();
+  result.inv = inv.str();
 }
 
 void ExtractGHKM::OpenInputFileOrDie(const std::string &filename,
@@ -289,6 +330,11 @@ void ExtractGHKM::ProcessOptions(int argc, char *argv[],
         "extract minimal rules only")
     ("PCFG",
         "include score based on PCFG scores in target corpus")
+#ifdef WITH_THREADS
+    ("Threads",
+        po::value(&options.threads)->default_value(options.threads),
+        "set number of threads extracting rules")
+#endif
     ("UnknownWordLabel",
         po::value(&options.unknownWordFile),
         "write unknown word labels to named file")
@@ -374,6 +420,10 @@ void ExtractGHKM::ProcessOptions(int argc, char *argv[],
   if (vm.count("UnpairedExtractFormat")) {
     options.unpairedExtractFormat = true;
   }
+
+  if (options.threads < 1) {
+    Error("number of threads must be at least 1");
+  }
 }
 
 void ExtractGHKM::Error(const std::string &msg) const
@@ -382,7 +432,7 @@ void ExtractGHKM::Error(const std::string &msg) const
   std::exit(1);
 }
 
-std::vector<std::string> ExtractGHKM::ReadTokens(const std::string &s)
+std::vector<std::string> ExtractGHKM::ReadTokens(const std::string &s) const
 {
   std::vector<std::string> tokens;
 
@@ -444,20 +494,17 @@ void ExtractGHKM::WriteGlueGrammar(
   out << "[X][" << topLabel << "] [X][X] [X] ||| [X][" << topLabel << "] [X][X] [" << topLabel << "] ||| 2.718 |||  0-0 1-1 " << std::endl;
 }
 
-void ExtractGHKM::CollectWordLabelCounts(
+void ExtractGHKM::CollectWordLabels(
     ParseTree &root,
-    std::map<std::string, int> &wordCount,
-    std::map<std::string, std::string> &wordLabel)
+    std::vector<std::pair<std::string, std::string> > &wordLabels) const
 {
   std::vector<const ParseTree*> leaves;
   root.GetLeaves(std::back_inserter(leaves));
   for (std::vector<const ParseTree *>::const_iterator p = leaves.begin();
        p != leaves.end(); ++p) {
     const ParseTree &leaf = **p;
-    const std::string &word = leaf.GetLabel();
-    const std::string &label = leaf.GetParent()->GetLabel();
-    ++wordCount[word];
-    wordLabel[word] = label;
+    wordLabels.push_back(std::make_pair(leaf.GetLabel(),
+                                        leaf.GetParent()->GetLabel()));
   }
 }
 
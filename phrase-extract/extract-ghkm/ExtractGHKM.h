@@ -25,6 +25,7 @@
 #include <ostream>
 #include <set>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace Moses {
@@ -33,6 +34,7 @@ class OutputFileStream;
 
 namespace GHKM {
 
+struct ExtractResult;
 struct Options;
 class ParseTree;
 
@@ -42,15 +44,22 @@ class ExtractGHKM
   ExtractGHKM() : m_name("extract-ghkm") {}
   const std::string &GetName() const { return m_name; }
   int Main(int argc, char *argv[]);
+
+  // Extracts the rules of one sentence pair.  This only reads the tool's
+  // state, so sentence pairs can be processed concurrently.
+  void ExtractSentence(size_t lineNum, const std::string &targetLine,
+                       const std::string &sourceLine,
+                       const std::string &alignmentLine,
+                       const Options &, ExtractResult &) const;
  private:
   void Error(const std::string &) const;
   void OpenInputFileOrDie(const std::string &, std::ifstream &);
   void OpenOutputFileOrDie(const std::string &, std::ofstream &);
   void OpenOutputFileOrDie(const std::string &, OutputFileStream &);
   void RecordTreeLabels(const ParseTree &, std::set<std::string> &);
-  void CollectWordLabelCounts(ParseTree &,
-                              std::map<std::string, int> &,
-                              std::map<std::string, std::string> &);
+  void CollectWordLabels(
+    ParseTree &,
+    std::vector<std::pair<std::string, std::string> > &) const;
   void WriteUnknownWordLabel(
     const std::map<std::string, int> &,
     const std::map<std::string, std::string> &,
@@ -58,7 +67,7 @@ class ExtractGHKM
   void WriteGlueGrammar(const std::set<std::string> &,
                         const std::map<std::string, int> &,
                         std::ostream &);
-  std::vector<std::string> ReadTokens(const std::string &);
+  std::vector<std::string> ReadTokens(const std::string &) const;
   
   void ProcessOptions(int, char *[], Options &) const;
 
@@ -0,0 +1,79 @@
+/***********************************************************************
+ Moses - statistical machine translation system
+ Copyright (C) 2006-2011 University of Edinburgh
+ 
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+ 
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+ 
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+
+#include "ExtractTask.h"
+
+#include "ExtractGHKM.h"
+
+#include <memory>
+
+namespace Moses {
+namespace GHKM {
+
+void ResultCollector::Add(size_t lineNum, ExtractResult *result)
+{
+#ifdef WITH_THREADS
+  boost::mutex::scoped_lock lock(m_mutex);
+#endif
+  if (lineNum != m_nextLineNum) {
+    m_pending[lineNum] = result;
+    return;
+  }
+  Merge(*result);
+  delete result;
+  ++m_nextLineNum;
+  std::map<size_t, ExtractResult *>::iterator p;
+  while ((p = m_pending.find(m_nextLineNum)) != m_pending.end()) {
+    Merge(*p->second);
+    delete p->second;
+    m_pending.erase(p);
+    ++m_nextLineNum;
+  }
+}
+
+void ResultCollector::Merge(const ExtractResult &result)
+{
+  m_fwd << result.fwd;
+  m_inv << result.inv;
+
+  m_labelSet.insert(result.labelSet.begin(), result.labelSet.end());
+  for (std::map<std::string, int>::const_iterator p =
+         result.topLabelSet.begin(); p != result.topLabelSet.end(); ++p) {
+    m_topLabelSet[p->first] += p->second;
+  }
+
+  // A word's label is the one it had in its last sentence.
+  for (std::vector<std::pair<std::string, std::string> >::const_iterator p =
+         result.wordLabels.begin(); p != result.wordLabels.end(); ++p) {
+    ++m_wordCount[p->first];
+    m_wordLabel[p->first] = p->second;
+  }
+}
+
+void ExtractTask::Run()
+{
+  std::auto_ptr<ExtractResult> result(new ExtractResult);
+  m_tool.ExtractSentence(m_lineNum, m_targetLine, m_sourceLine,
+                         m_alignmentLine, m_options, *result);
+  m_collector.Add(m_lineNum, result.release());
+}
+
+}  // namespace GHKM
+}  // namespace Moses
@@ -0,0 +1,130 @@
+/***********************************************************************
+ Moses - statistical machine translation system
+ Copyright (C) 2006-2011 University of Edinburgh
+ 
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+ 
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+ 
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+
+#pragma once
+#ifndef EXTRACT_GHKM_EXTRACT_TASK_H_
+#define EXTRACT_GHKM_EXTRACT_TASK_H_
+
+#include "../../moses/src/ThreadPool.h"
+
+#ifdef WITH_THREADS
+#include <boost/thread/mutex.hpp>
+#endif
+
+#include <map>
+#include <ostream>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace Moses {
+namespace GHKM {
+
+class ExtractGHKM;
+struct Options;
+
+// The rules and label statistics of one sentence pair.
+struct ExtractResult {
+  std::string fwd;
+  std::string inv;
+  std::set<std::string> labelSet;
+  std::map<std::string, int> topLabelSet;
+  // The (word, preterminal label) pairs of the target tree's leaves.
+  std::vector<std::pair<std::string, std::string> > wordLabels;
+};
+
+// Writes the rules of each sentence pair to the extract files and merges
+// its label statistics, in input order, whichever order the sentence pairs
+// finish in.
+class ResultCollector
+{
+ public:
+  ResultCollector(std::ostream &fwd, std::ostream &inv,
+                  std::set<std::string> &labelSet,
+                  std::map<std::string, int> &topLabelSet,
+                  std::map<std::string, int> &wordCount,
+                  std::map<std::string, std::string> &wordLabel)
+      : m_fwd(fwd)
+      , m_inv(inv)
+      , m_labelSet(labelSet)
+      , m_topLabelSet(topLabelSet)
+      , m_wordCount(wordCount)
+      , m_wordLabel(wordLabel)
+      , m_nextLineNum(1) {}
+
+  // Takes ownership of the result.  Line numbers start at 1.
+  void Add(size_t lineNum, ExtractResult *);
+
+ private:
+  // Disallow copying
+  ResultCollector(const ResultCollector &);
+  ResultCollector &operator=(const ResultCollector &);
+
+  void Merge(const ExtractResult &);
+
+  std::ostream &m_fwd;
+  std::ostream &m_inv;
+  std::set<std::string> &m_labelSet;
+  std::map<std::string, int> &m_topLabelSet;
+  std::map<std::string, int> &m_wordCount;
+  std::map<std::string, std::string> &m_wordLabel;
+  size_t m_nextLineNum;
+  std::map<size_t, ExtractResult *> m_pending;
+#ifdef WITH_THREADS
+  boost::mutex m_mutex;
+#endif
+};
+
+// Extracts the rules of one sentence pair and hands them to the collector.
+class ExtractTask : public Moses::Task
+{
+ public:
+  ExtractTask(size_t lineNum,
+              const std::string &targetLine,
+              const std::string &sourceLine,
+              const std::string &alignmentLine,
+              const ExtractGHKM &tool,
+              const Options &options,
+              ResultCollector &collector)
+      : m_lineNum(lineNum)
+      , m_targetLine(targetLine)
+      , m_sourceLine(sourceLine)
+      , m_alignmentLine(alignmentLine)
+      , m_tool(tool)
+      , m_options(options)
+      , m_collector(collector) {}
+
+  void Run();
+
+ private:
+  size_t m_lineNum;
+  std::string m_targetLine;
+  std::string m_sourceLine;
+  std::string m_alignmentLine;
+  const ExtractGHKM &m_tool;
+  const Options &m_options;
+  ResultCollector &m_collector;
+};
+
+}  // namespace GHKM
+}  // namespace Moses
+
+#endif
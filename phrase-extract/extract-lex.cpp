@@ -1,26 +1,136 @@
 #include <iostream>
 #include <fstream>
 #include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
 #include <vector>
 #include "extract-lex.h"
 #include "InputFileStream.h"
+#include "../moses/src/ThreadPool.h"
+
+#ifdef WITH_THREADS
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/tss.hpp>
+#endif
 
 using namespace std;
 using namespace MosesTraining;
 
-float COUNT_INCR = 1;
+// lines of the corpus handed to a thread at a time
+const size_t BLOCK_SIZE = 10000;
 
-void fix(std::ostream& stream) 
+void fix(std::ostream& stream)
 {
     stream.setf(std::ios::fixed);
     stream.precision(7);
 }
 
+namespace
+{
+
+// Counts of each thread, kept for the thread's lifetime so that counting
+// needs no locking, and merged once all lines are processed.
+class ThreadCounts
+{
+#ifdef WITH_THREADS
+  boost::thread_specific_ptr<ExtractLex> m_local;
+  boost::mutex m_mutex;
+  // the tables outlive their threads
+  static void Keep(ExtractLex *) {}
+#endif
+  std::vector<ExtractLex*> m_all;
+
+public:
+#ifdef WITH_THREADS
+  ThreadCounts() : m_local(&Keep) {}
+#endif
+  ~ThreadCounts() {
+    for (size_t i = 0; i < m_all.size(); ++i) {
+      delete m_all[i];
+    }
+  }
+
+  ExtractLex &GetLocal() {
+#ifdef WITH_THREADS
+    if (m_local.get() == NULL) {
+      m_local.reset(new ExtractLex);
+      boost::mutex::scoped_lock lock(m_mutex);
+      m_all.push_back(m_local.get());
+    }
+    return *m_local;
+#else
+    if (m_all.empty()) {
+      m_all.push_back(new ExtractLex);
+    }
+    return *m_all[0];
+#endif
+  }
+
+  // merges the tables of all threads into the first one
+  ExtractLex &Merge() {
+    GetLocal();
+    for (size_t i = 1; i < m_all.size(); ++i) {
+      m_all[0]->Merge(*m_all[i]);
+      delete m_all[i];
+    }
+    m_all.resize(1);
+    return *m_all[0];
+  }
+};
+
+// Counts the word pairs of a block of lines
+class ExtractTask : public Moses::Task
+{
+public:
+  ExtractTask(size_t lineCount, ThreadCounts &counts)
+    : m_lineCount(lineCount), m_counts(counts) {}
+  void Run();
+
+  vector<string> m_target, m_source, m_align;
+
+private:
+  size_t m_lineCount;
+  ThreadCounts &m_counts;
+};
+
+void ExtractTask::Run()
+{
+  ExtractLex &extract = m_counts.GetLocal();
+  vector<string> toksTarget, toksSource, toksAlign;
+  for (size_t i = 0; i < m_target.size(); ++i) {
+    toksTarget.clear();
+    toksSource.clear();
+    toksAlign.clear();
+    Tokenize(toksTarget, m_target[i]);
+    Tokenize(toksSource, m_source[i]);
+    Tokenize(toksAlign, m_align[i]);
+
+    extract.Process(toksTarget, toksSource, toksAlign, m_lineCount + i);
+  }
+}
+
+}
+
 int main(int argc, char* argv[])
 {
   cerr << "Starting...\n";
-  
-  assert(argc == 6);
+
+  int threadCount = 1;
+#ifdef WITH_THREADS
+  if (argc == 8 && strcmp(argv[6], "--threads") == 0) {
+    threadCount = atoi(argv[7]);
+    argc = 6;
+  }
+#endif
+  if (argc != 6 || threadCount < 1) {
+    cerr << "syntax: extract-lex target source alignment lex.e2f lex.f2e"
+#ifdef WITH_THREADS
+         << " [--threads NUM]"
+#endif
+         << endl;
+    exit(1);
+  }
   char* &filePathTarget = argv[1];
   char* &filePathSource = argv[2];
   char* &filePathAlign  = argv[3];
@@ -39,9 +149,14 @@ int main(int argc, char* argv[])
   fix(streamLexS2T);
   fix(streamLexT2S);
 
-  ExtractLex extractSingleton;
+  ThreadCounts counts;
+#ifdef WITH_THREADS
+  Moses::ThreadPool pool(threadCount);
+  pool.SetQueueLimit(2 * threadCount);
+#endif
 
   size_t lineCount = 0;
+  ExtractTask *task = new ExtractTask(lineCount, counts);
   string lineTarget, lineSource, lineAlign;
   while (getline(streamTarget, lineTarget))
   {
@@ -52,25 +167,33 @@ int main(int argc, char* argv[])
     assert(isSource);
     istream &isAlign = getline(streamAlign, lineAlign);
     assert(isAlign);
-    
-    vector<string> toksTarget, toksSource, toksAlign;
-    Tokenize(toksTarget, lineTarget);
-    Tokenize(toksSource, lineSource);
-    Tokenize(toksAlign, lineAlign);
-
-    /*
-    cerr  << endl
-          << toksTarget.size() << " " << lineTarget << endl
-          << toksSource.size() << " " << lineSource << endl 
-          << toksAlign.size() << " " << lineAlign << endl;
-    */
 
-    extractSingleton.Process(toksTarget, toksSource, toksAlign, lineCount);
-   
-    ++lineCount; 
+    task->m_target.push_back(lineTarget);
+    task->m_source.push_back(lineSource);
+    task->m_align.push_back(lineAlign);
+    ++lineCount;
+
+    if (task->m_target.size() == BLOCK_SIZE) {
+#ifdef WITH_THREADS
+      if (threadCount > 1) {
+        pool.Submit(task);
+      } else
+#endif
+      {
+        task->Run();
+        delete task;
+      }
+      task = new ExtractTask(lineCount, counts);
+    }
   }
+  task->Run();
+  delete task;
+
+#ifdef WITH_THREADS
+  pool.Stop(true);
+#endif
 
-  extractSingleton.Output(streamLexS2T, streamLexT2S);
+  counts.Merge().Output(streamLexS2T, streamLexT2S);
 
   streamTarget.Close();
   streamSource.Close();
@@ -84,10 +207,19 @@ int main(int argc, char* argv[])
 namespace MosesTraining
 {
 
-const std::string *Vocab::GetOrAdd(const std::string &word)
+unsigned Vocab::GetOrAdd(const std::string &word)
+{
+  std::pair<boost::unordered_map<std::string, unsigned>::iterator, bool> ret =
+    m_ids.insert(std::make_pair(word, static_cast<unsigned>(m_words.size())));
+  if (ret.second) {
+    m_words.push_back(word);
+  }
+  return ret.first->second;
+}
+
+ExtractLex::ExtractLex()
 {
- 	const string *ret = &(*m_coll.insert(word).first);
-  return ret;
+  m_nullWord = m_vocab.GetOrAdd("NULL");
 }
 
 void ExtractLex::Process(vector<string> &toksTarget, vector<string> &toksSource, vector<string> &toksAlign, size_t lineCount)
@@ -99,129 +231,140 @@ void ExtractLex::Process(vector<string> &toksTarget, vector<string> &toksSource,
   for (iterAlign = toksAlign.begin(); iterAlign != toksAlign.end(); ++iterAlign)
   {
     const string &alignTok = *iterAlign;
-    
-    vector<size_t> alignPos;
-    Tokenize(alignPos, alignTok, "-");
-    assert(alignPos.size() == 2);
 
-	if (alignPos[0] >= toksSource.size())
+    const char *start = alignTok.c_str();
+    char *end;
+    size_t sourcePos = strtoul(start, &end, 10);
+    size_t targetPos = 0;
+    bool malformed = (end == start || *end != '-');
+    if (!malformed) {
+      start = end + 1;
+      targetPos = strtoul(start, &end, 10);
+      malformed = (end == start || *end != '\0');
+    }
+    if (malformed) {
+      cerr << "ERROR: " << alignTok << " is a bad alignment point at line " << lineCount << endl;
+      exit(1);
+    }
+
+	if (sourcePos >= toksSource.size())
 	{
-		cerr << "ERROR: alignment over source length. Alignment " << alignPos[0] << " at line " << lineCount << endl;
+		cerr << "ERROR: alignment over source length. Alignment " << sourcePos << " at line " << lineCount << endl;
 		continue;
 	}
-	if (alignPos[1] >= toksTarget.size())
+	if (targetPos >= toksTarget.size())
 	{
-		cerr << "ERROR: alignment over target length. Alignment " << alignPos[1] << " at line " << lineCount << endl;
+		cerr << "ERROR: alignment over target length. Alignment " << targetPos << " at line " << lineCount << endl;
 		continue;
 	}
-	
-    assert(alignPos[0] < toksSource.size());
-    assert(alignPos[1] < toksTarget.size());
 
-    m_sourceAligned[ alignPos[0] ] = true;
-    m_targetAligned[ alignPos[1] ] = true;
+    m_sourceAligned[ sourcePos ] = true;
+    m_targetAligned[ targetPos ] = true;
 
-    const string &tmpSource = toksSource[ alignPos[0] ];
-    const string &tmpTarget = toksTarget[ alignPos[1] ];
- 
-    const string *source = m_vocab.GetOrAdd(tmpSource);
-    const string *target = m_vocab.GetOrAdd(tmpTarget);
+    unsigned source = m_vocab.GetOrAdd(toksSource[ sourcePos ]);
+    unsigned target = m_vocab.GetOrAdd(toksTarget[ targetPos ]);
 
     Process(target, source);
-    
   }
 
-  ProcessUnaligned(toksTarget, toksSource, m_sourceAligned, m_targetAligned);
-}
-
-void ExtractLex::Process(const std::string *target, const std::string *source)
-{
-  WordCount &wcS2T = m_collS2T[source];
-  WordCount &wcT2S = m_collT2S[target];
-
-  wcS2T.AddCount(COUNT_INCR);
-  wcT2S.AddCount(COUNT_INCR);
-
-  Process(wcS2T, target);
-  Process(wcT2S, source);
-}
-
-void ExtractLex::Process(WordCount &wcIn, const std::string *out)
-{
-  std::map<const std::string*, WordCount> &collOut = wcIn.GetColl();
-  WordCount &wcOut = collOut[out];
-  wcOut.AddCount(COUNT_INCR);
-}
-
-void ExtractLex::ProcessUnaligned(vector<string> &toksTarget, vector<string> &toksSource
-                                , const std::vector<bool> &m_sourceAligned, const std::vector<bool> &m_targetAligned)
-{
-  const string *nullWord = m_vocab.GetOrAdd("NULL"); 
-
   for (size_t pos = 0; pos < m_sourceAligned.size(); ++pos)
   {
-    bool isAlignedCurr = m_sourceAligned[pos];
-    if (!isAlignedCurr)
+    if (!m_sourceAligned[pos])
     {
-      const string &tmpWord = toksSource[pos];
-      const string *sourceWord = m_vocab.GetOrAdd(tmpWord);
-
-      Process(nullWord, sourceWord);
+      Process(m_nullWord, m_vocab.GetOrAdd(toksSource[pos]));
     }
   }
 
   for (size_t pos = 0; pos < m_targetAligned.size(); ++pos)
   {
-    bool isAlignedCurr = m_targetAligned[pos];
-    if (!isAlignedCurr)
+    if (!m_targetAligned[pos])
     {
-      const string &tmpWord = toksTarget[pos];
-      const string *targetWord = m_vocab.GetOrAdd(tmpWord);
-
-      Process(targetWord, nullWord);
+      Process(m_vocab.GetOrAdd(toksTarget[pos]), m_nullWord);
     }
   }
-
 }
 
-void ExtractLex::Output(std::ofstream &streamLexS2T, std::ofstream &streamLexT2S)
+void ExtractLex::Merge(const ExtractLex &other)
 {
-  Output(m_collS2T, streamLexS2T);
-  Output(m_collT2S, streamLexT2S);
+  std::vector<uint64_t> ids(other.m_vocab.GetSize());
+  for (size_t i = 0; i < ids.size(); ++i) {
+    ids[i] = m_vocab.GetOrAdd(other.m_vocab.GetWord(i));
+  }
+  boost::unordered_map<uint64_t, uint64_t>::const_iterator iter;
+  for (iter = other.m_pairs.begin(); iter != other.m_pairs.end(); ++iter) {
+    uint64_t source = ids[iter->first >> 32];
+    uint64_t target = ids[iter->first & 0xFFFFFFFF];
+    m_pairs[(source << 32) | target] += iter->second;
+  }
 }
 
-void ExtractLex::Output(const std::map<const std::string*, WordCount> &coll, std::ofstream &outStream)
+namespace
 {
-  std::map<const std::string*, WordCount>::const_iterator iterOuter;
-  for (iterOuter = coll.begin(); iterOuter != coll.end(); ++iterOuter)
-  {
-    const string &inStr = *iterOuter->first;
-    const WordCount &inWC = iterOuter->second;
 
-    const std::map<const std::string*, WordCount> &outColl = inWC.GetColl();
+// a word pair, with the words replaced by their rank in lexical order
+struct RankedPair {
+  unsigned in, out;
+  uint64_t count;
+  bool operator<(const RankedPair &other) const {
+    return in < other.in || (in == other.in && out < other.out);
+  }
+};
 
-    std::map<const std::string*, WordCount>::const_iterator iterInner;
-    for (iterInner = outColl.begin(); iterInner != outColl.end(); ++iterInner)
-    {
-      const string &outStr = *iterInner->first;
-      const WordCount &outWC = iterInner->second;
+struct WordLess {
+  WordLess(const Vocab &vocab) : m_vocab(vocab) {}
+  bool operator()(unsigned a, unsigned b) const {
+    return m_vocab.GetWord(a) < m_vocab.GetWord(b);
+  }
+  const Vocab &m_vocab;
+};
 
-      float prob = outWC.GetCount() / inWC.GetCount();
-      outStream << outStr << " "  << inStr << " " << prob << endl;
+void OutputTable(std::vector<RankedPair> &pairs, const std::vector<unsigned> &words,
+                 const Vocab &vocab, std::ostream &outStream)
+{
+  std::sort(pairs.begin(), pairs.end());
+  for (size_t begin = 0, end; begin < pairs.size(); begin = end) {
+    uint64_t total = 0;
+    for (end = begin; end < pairs.size() && pairs[end].in == pairs[begin].in; ++end) {
+      total += pairs[end].count;
+    }
+    const string &inStr = vocab.GetWord(words[pairs[begin].in]);
+    for (size_t i = begin; i < end; ++i) {
+      float prob = static_cast<float>(pairs[i].count) / static_cast<float>(total);
+      outStream << vocab.GetWord(words[pairs[i].out]) << " " << inStr << " " << prob << "\n";
     }
   }
 }
 
-std::ostream& operator<<(std::ostream &out, const WordCount &obj)
-{
-  out << "(" << obj.GetCount() << ")";
-  return out;
 }
 
-void WordCount::AddCount(float incr)
+void ExtractLex::Output(std::ostream &streamLexS2T, std::ostream &streamLexT2S) const
 {
-  m_count += incr;
+  std::vector<unsigned> words(m_vocab.GetSize());
+  for (size_t i = 0; i < words.size(); ++i) {
+    words[i] = i;
+  }
+  std::sort(words.begin(), words.end(), WordLess(m_vocab));
+  std::vector<unsigned> rank(words.size());
+  for (size_t i = 0; i < words.size(); ++i) {
+    rank[words[i]] = i;
+  }
+
+  std::vector<RankedPair> pairs;
+  pairs.reserve(m_pairs.size());
+  boost::unordered_map<uint64_t, uint64_t>::const_iterator iter;
+  for (iter = m_pairs.begin(); iter != m_pairs.end(); ++iter) {
+    RankedPair pair;
+    pair.in = rank[iter->first >> 32];
+    pair.out = rank[iter->first & 0xFFFFFFFF];
+    pair.count = iter->second;
+    pairs.push_back(pair);
+  }
+  OutputTable(pairs, words, m_vocab, streamLexS2T);
+
+  for (size_t i = 0; i < pairs.size(); ++i) {
+    std::swap(pairs[i].in, pairs[i].out);
+  }
+  OutputTable(pairs, words, m_vocab, streamLexT2S);
 }
 
 } // namespace
-
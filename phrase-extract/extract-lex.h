@@ -1,10 +1,15 @@
 #pragma once
 
+#include <stdint.h>
 #include <map>
 #include <set>
 #include <sstream>
 #include <fstream>
 #include <iostream>
+#include <string>
+#include <vector>
+
+#include <boost/unordered_map.hpp>
 
 namespace MosesTraining
 {
@@ -63,58 +68,39 @@ inline void Tokenize( std::vector<T> &output
 	return Scan<T>(output, stringVector );
 }
 
-class WordCount
-{
-	friend std::ostream& operator<<(std::ostream&, const WordCount&);
-public:
-  float m_count;
-
-  std::map<const std::string*, WordCount> m_coll;
-
-  WordCount()
-    :m_count(0)
-  {}
-
-  //WordCount(const WordCount &copy);
-
-  WordCount(float count)
-    :m_count(count)
-  {}
-
-  void AddCount(float incr);
-
-  std::map<const std::string*, WordCount> &GetColl()
-  { return m_coll; }
-  const std::map<const std::string*, WordCount> &GetColl() const
-  { return m_coll; }
-
-  const float GetCount() const
-  { return m_count; }
-
-};
-
+//! words, numbered from 0 in order of first occurrence
 class Vocab
 {
-  std::set<std::string> m_coll;
+  boost::unordered_map<std::string, unsigned> m_ids;
+  std::vector<std::string> m_words;
 public:
-  const std::string *GetOrAdd(const std::string &word);
+  unsigned GetOrAdd(const std::string &word);
+  const std::string &GetWord(unsigned id) const
+  { return m_words[id]; }
+  size_t GetSize() const
+  { return m_words.size(); }
 };
 
+//! counts of aligned word pairs, on the word ids of its own vocabulary
 class ExtractLex
 {
   Vocab m_vocab;
-  std::map<const std::string*, WordCount> m_collS2T, m_collT2S;
-
-  void Process(const std::string *target, const std::string *source);
-  void Process(WordCount &wcIn, const std::string *out);
-  void ProcessUnaligned(std::vector<std::string> &toksTarget, std::vector<std::string> &toksSource
-                        , const std::vector<bool> &m_sourceAligned, const std::vector<bool> &m_targetAligned);
+  unsigned m_nullWord;
+  // keyed by source id << 32 | target id
+  boost::unordered_map<uint64_t, uint64_t> m_pairs;
 
-  void Output(const std::map<const std::string*, WordCount> &coll, std::ofstream &outStream);
+  void Process(unsigned target, unsigned source) {
+    ++m_pairs[(static_cast<uint64_t>(source) << 32) | target];
+  }
 
 public:
+  ExtractLex();
+
   void Process(std::vector<std::string> &toksTarget, std::vector<std::string> &toksSource, std::vector<std::string> &toksAlign, size_t lineCount);
-  void Output(std::ofstream &streamLexS2T, std::ofstream &streamLexT2S);
+  //! adds the counts of other, which may number its words differently
+  void Merge(const ExtractLex &other);
+  //! writes both tables, each ordered by the conditioning word then the other word
+  void Output(std::ostream &streamLexS2T, std::ostream &streamLexT2S) const;
 
 };
 
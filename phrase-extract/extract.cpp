@@ -16,6 +16,7 @@
 
 #include <map>
 #include <set>
+#include <sstream>
 #include <vector>
 
 #include "SafeGetline.h"
@@ -23,6 +24,8 @@
 #include "tables-core.h"
 #include "InputFileStream.h"
 #include "OutputFileStream.h"
+#include "../moses/src/ThreadPool.h"
+#include "../moses/src/OutputCollector.h"
 
 using namespace std;
 using namespace MosesTraining;
@@ -72,9 +75,6 @@ bool ge(int, int);
 bool le(int, int);
 bool lt(int, int);
 
-void extractBase(SentenceAlignment &);
-void extract(SentenceAlignment &);
-void addPhrase(SentenceAlignment &, int, int, int, int, string &);
 bool isAligned (SentenceAlignment &, int, int);
 
 bool allModelsOutputFlag = false;
@@ -87,10 +87,6 @@ bool hierModel = false;
 REO_MODEL_TYPE hierType = REO_MSD;
 
 
-Moses::OutputFileStream extractFile;
-Moses::OutputFileStream extractFileInv;
-Moses::OutputFileStream extractFileOrientation;
-Moses::OutputFileStream extractFileSentenceId;
 int maxPhraseLength;
 bool orientationFlag = false;
 bool translationFlag = true;
@@ -98,6 +94,45 @@ bool sentenceIdFlag = false; //create extract file with sentence id
 bool onlyOutputSpanInfo = false;
 bool gzOutput = false;
 
+// Extracts the phrases of one sentence pair into its own buffers and hands
+// them to the collectors, which write them out in sentence order.
+class ExtractTask : public Moses::Task
+{
+private:
+  size_t m_id;
+  SentenceAlignment *m_sentence;
+  Moses::OutputCollector* m_extractCollector;
+  Moses::OutputCollector* m_extractCollectorInv;
+  Moses::OutputCollector* m_extractCollectorOrientation;
+  Moses::OutputCollector* m_extractCollectorSentenceId;
+
+public:
+  ExtractTask(size_t id, SentenceAlignment *sentence,
+              Moses::OutputCollector* extractCollector,
+              Moses::OutputCollector* extractCollectorInv,
+              Moses::OutputCollector* extractCollectorOrientation,
+              Moses::OutputCollector* extractCollectorSentenceId):
+    m_id(id),
+    m_sentence(sentence),
+    m_extractCollector(extractCollector),
+    m_extractCollectorInv(extractCollectorInv),
+    m_extractCollectorOrientation(extractCollectorOrientation),
+    m_extractCollectorSentenceId(extractCollectorSentenceId) {}
+  ~ExtractTask() { delete m_sentence; }
+  void Run();
+
+private:
+  ostringstream m_extractFile;
+  ostringstream m_extractFileInv;
+  ostringstream m_extractFileOrientation;
+  ostringstream m_extractFileSentenceId;
+
+  void extractBase(SentenceAlignment &);
+  void extract(SentenceAlignment &);
+  void addPhrase(SentenceAlignment &, int, int, int, int, string &);
+  void writePhrasesToFile();
+};
+
 }
 
 int main(int argc, char* argv[])
@@ -105,8 +140,15 @@ int main(int argc, char* argv[])
   cerr	<< "PhraseExtract v1.4, written by Philipp Koehn\n"
         << "phrase extraction from an aligned parallel corpus\n";
 
+#ifdef WITH_THREADS
+  int thread_count = 1;
+#endif
   if (argc < 6) {
-    cerr << "syntax: extract en de align extract max-length [orientation [ --model [wbe|phrase|hier]-[msd|mslr|mono] ] | --OnlyOutputSpanInfo | --NoTTable | --SentenceId]\n";
+    cerr << "syntax: extract en de align extract max-length [orientation [ --model [wbe|phrase|hier]-[msd|mslr|mono] ] | --OnlyOutputSpanInfo | --NoTTable | --SentenceId | --GZOutput"
+#ifdef WITH_THREADS
+         << " | --threads NUM"
+#endif
+         << "]\n";
     exit(1);
   }
   char* &fileNameE = argv[1];
@@ -179,6 +221,20 @@ int main(int argc, char* argv[])
       }
 
       allModelsOutputFlag = true;
+#ifdef WITH_THREADS
+    } else if (strcmp(argv[i],"-threads") == 0 ||
+               strcmp(argv[i],"--threads") == 0 ||
+               strcmp(argv[i],"--Threads") == 0) {
+      if (i+1 >= argc) {
+        cerr << "extract: syntax error, no number of threads provided to the option " << argv[i] << endl;
+        exit(1);
+      }
+      thread_count = atoi(argv[++i]);
+      if (thread_count < 1) {
+        cerr << "extract: number of threads must be at least 1" << endl;
+        exit(1);
+      }
+#endif
     } else {
       cerr << "extract: syntax error, unknown option '" << string(argv[i]) << "'\n";
       exit(1);
@@ -202,6 +258,10 @@ int main(int argc, char* argv[])
   istream *aFileP = &aFile;
 
   // open output files
+  Moses::OutputFileStream extractFile;
+  Moses::OutputFileStream extractFileInv;
+  Moses::OutputFileStream extractFileOrientation;
+  Moses::OutputFileStream extractFileSentenceId;
   if (translationFlag) {
     string fileNameExtractInv = fileNameExtract + ".inv" + (gzOutput?".gz":"");
     extractFile.Open( (fileNameExtract + (gzOutput?".gz":"")).c_str());
@@ -217,6 +277,24 @@ int main(int argc, char* argv[])
     extractFileSentenceId.Open(fileNameExtractSentenceId.c_str());
   }
 
+  // output into files. Each collector writes (and gzips) under its own lock,
+  // so one file is written by one worker at a time
+  Moses::OutputCollector extractCollector(&extractFile);
+  Moses::OutputCollector extractCollectorInv(&extractFileInv);
+  Moses::OutputCollector extractCollectorOrientation(&extractFileOrientation);
+  Moses::OutputCollector extractCollectorSentenceId(&extractFileSentenceId);
+
+#ifdef WITH_THREADS
+  // span info is written to stdout as it is found, interleaved with the
+  // sentences, so it is only printed in order by a single thread
+  if (onlyOutputSpanInfo) thread_count = 1;
+
+  // set up thread pool
+  Moses::ThreadPool pool(thread_count);
+  pool.SetQueueLimit(1000);
+#endif
+
+  size_t taskId = 0;
   int i=0;
   while(true) {
     i++;
@@ -228,7 +306,7 @@ int main(int argc, char* argv[])
     if (eFileP->eof()) break;
     SAFE_GETLINE((*fFileP), foreignString, LINE_MAX_LENGTH, '\n', __FILE__);
     SAFE_GETLINE((*aFileP), alignmentString, LINE_MAX_LENGTH, '\n', __FILE__);
-    SentenceAlignment sentence;
+    SentenceAlignment *sentence = new SentenceAlignment;
     // cout << "read in: " << englishString << " & " << foreignString << " & " << alignmentString << endl;
     //az: output src, tgt, and alingment line
     if (onlyOutputSpanInfo) {
@@ -238,11 +316,34 @@ int main(int argc, char* argv[])
       cout << "LOG: PHRASES_BEGIN:" << endl;
     }
 
-    if (sentence.create( englishString, foreignString, alignmentString, i)) {
-      extract(sentence);
+    if (sentence->create( englishString, foreignString, alignmentString, i)) {
+      ExtractTask *task = new ExtractTask(taskId++, sentence,
+                                          translationFlag ? &extractCollector : NULL,
+                                          translationFlag ? &extractCollectorInv : NULL,
+                                          orientationFlag ? &extractCollectorOrientation : NULL,
+                                          sentenceIdFlag ? &extractCollectorSentenceId : NULL);
+#ifdef WITH_THREADS
+      if (thread_count == 1) {
+        task->Run();
+        delete task;
+      } else {
+        pool.Submit(task);
+      }
+#else
+      task->Run();
+      delete task;
+#endif
+    } else {
+      delete sentence;
     }
     if (onlyOutputSpanInfo) cout << "LOG: PHRASES_END:" << endl; //az: mark end of phrases
   }
+
+#ifdef WITH_THREADS
+  // wait for all threads to finish
+  pool.Stop(true);
+#endif
+
   eFile.Close();
   fFile.Close();
   aFile.Close();
@@ -262,7 +363,13 @@ int main(int argc, char* argv[])
 namespace MosesTraining
 {
 
-void extract(SentenceAlignment &sentence)
+void ExtractTask::Run()
+{
+  extract(*m_sentence);
+  writePhrasesToFile();
+}
+
+void ExtractTask::extract(SentenceAlignment &sentence)
 {
   int countE = sentence.target.size();
   int countF = sentence.source.size();
@@ -617,7 +724,7 @@ string getOrientString(REO_POS orient, REO_MODEL_TYPE modelType)
   return "";
 }
 
-void addPhrase( SentenceAlignment &sentence, int startE, int endE, int startF, int endF , string &orientationInfo)
+void ExtractTask::addPhrase( SentenceAlignment &sentence, int startE, int endE, int startF, int endF , string &orientationInfo)
 {
   // source
   // cout << "adding ( " << startF << "-" << endF << ", " << startE << "-" << endE << ")\n";
@@ -628,31 +735,31 @@ void addPhrase( SentenceAlignment &sentence, int startE, int endE, int startF, i
   }
 
   for(int fi=startF; fi<=endF; fi++) {
-    if (translationFlag) extractFile << sentence.source[fi] << " ";
-    if (orientationFlag) extractFileOrientation << sentence.source[fi] << " ";
-    if (sentenceIdFlag) extractFileSentenceId << sentence.source[fi] << " ";
+    if (translationFlag) m_extractFile << sentence.source[fi] << " ";
+    if (orientationFlag) m_extractFileOrientation << sentence.source[fi] << " ";
+    if (sentenceIdFlag) m_extractFileSentenceId << sentence.source[fi] << " ";
   }
-  if (translationFlag) extractFile << "||| ";
-  if (orientationFlag) extractFileOrientation << "||| ";
-  if (sentenceIdFlag) extractFileSentenceId << "||| ";
+  if (translationFlag) m_extractFile << "||| ";
+  if (orientationFlag) m_extractFileOrientation << "||| ";
+  if (sentenceIdFlag) m_extractFileSentenceId << "||| ";
 
   // target
   for(int ei=startE; ei<=endE; ei++) {
-    if (translationFlag) extractFile << sentence.target[ei] << " ";
-    if (translationFlag) extractFileInv << sentence.target[ei] << " ";
-    if (orientationFlag) extractFileOrientation << sentence.target[ei] << " ";
-    if (sentenceIdFlag) extractFileSentenceId << sentence.target[ei] << " ";
+    if (translationFlag) m_extractFile << sentence.target[ei] << " ";
+    if (translationFlag) m_extractFileInv << sentence.target[ei] << " ";
+    if (orientationFlag) m_extractFileOrientation << sentence.target[ei] << " ";
+    if (sentenceIdFlag) m_extractFileSentenceId << sentence.target[ei] << " ";
   }
-  if (translationFlag) extractFile << "|||";
-  if (translationFlag) extractFileInv << "||| ";
-  if (orientationFlag) extractFileOrientation << "||| ";
-  if (sentenceIdFlag) extractFileSentenceId << "||| ";
+  if (translationFlag) m_extractFile << "|||";
+  if (translationFlag) m_extractFileInv << "||| ";
+  if (orientationFlag) m_extractFileOrientation << "||| ";
+  if (sentenceIdFlag) m_extractFileSentenceId << "||| ";
 
   // source (for inverse)
   if (translationFlag) {
     for(int fi=startF; fi<=endF; fi++)
-      extractFileInv << sentence.source[fi] << " ";
-    extractFileInv << "|||";
+      m_extractFileInv << sentence.source[fi] << " ";
+    m_extractFileInv << "|||";
   }
 
   // alignment
@@ -660,27 +767,36 @@ void addPhrase( SentenceAlignment &sentence, int startE, int endE, int startF, i
     for(int ei=startE; ei<=endE; ei++) {
       for(size_t i=0; i<sentence.alignedToT[ei].size(); i++) {
         int fi = sentence.alignedToT[ei][i];
-        extractFile << " " << fi-startF << "-" << ei-startE;
-        extractFileInv << " " << ei-startE << "-" << fi-startF;
+        m_extractFile << " " << fi-startF << "-" << ei-startE;
+        m_extractFileInv << " " << ei-startE << "-" << fi-startF;
       }
     }
   }
 
   if (orientationFlag)
-    extractFileOrientation << orientationInfo;
+    m_extractFileOrientation << orientationInfo;
 
   if (sentenceIdFlag) {
-    extractFileSentenceId << sentence.sentenceID;
+    m_extractFileSentenceId << sentence.sentenceID;
   }
 
-  if (translationFlag) extractFile << "\n";
-  if (translationFlag) extractFileInv << "\n";
-  if (orientationFlag) extractFileOrientation << "\n";
-  if (sentenceIdFlag) extractFileSentenceId << "\n";
+  if (translationFlag) m_extractFile << "\n";
+  if (translationFlag) m_extractFileInv << "\n";
+  if (orientationFlag) m_extractFileOrientation << "\n";
+  if (sentenceIdFlag) m_extractFileSentenceId << "\n";
+}
+
+void ExtractTask::writePhrasesToFile()
+{
+  // a collector gets every id, even with nothing to write, as it writes in order
+  if (m_extractCollector) m_extractCollector->Write( m_id, m_extractFile.str() );
+  if (m_extractCollectorInv) m_extractCollectorInv->Write( m_id, m_extractFileInv.str() );
+  if (m_extractCollectorOrientation) m_extractCollectorOrientation->Write( m_id, m_extractFileOrientation.str() );
+  if (m_extractCollectorSentenceId) m_extractCollectorSentenceId->Write( m_id, m_extractFileSentenceId.str() );
 }
 
 // if proper conditioning, we need the number of times a source phrase occured
-void extractBase( SentenceAlignment &sentence )
+void ExtractTask::extractBase( SentenceAlignment &sentence )
 {
   int countF = sentence.source.size();
   for(int startF=0; startF<countF; startF++) {
@@ -688,9 +804,9 @@ void extractBase( SentenceAlignment &sentence )
         (endF<countF && endF<startF+maxPhraseLength);
         endF++) {
       for(int fi=startF; fi<=endF; fi++) {
-        extractFile << sentence.source[fi] << " ";
+        m_extractFile << sentence.source[fi] << " ";
       }
-      extractFile << "|||" << endl;
+      m_extractFile << "|||" << endl;
     }
   }
 
@@ -700,9 +816,9 @@ void extractBase( SentenceAlignment &sentence )
         (endE<countE && endE<startE+maxPhraseLength);
         endE++) {
       for(int ei=startE; ei<=endE; ei++) {
-        extractFileInv << sentence.target[ei] << " ";
+        m_extractFileInv << sentence.target[ei] << " ";
       }
-      extractFileInv << "|||" << endl;
+      m_extractFileInv << "|||" << endl;
     }
   }
 }
@@ -6,12 +6,36 @@
 #include <cstdio>
 #include <sstream>
 #include <string>
-#include "zlib.h"
+#include <cstring>
 
 #include "reordering_classes.h"
+#include "InputFileStream.h"
+#include "../../moses/src/LexicalReorderingTable.h"
 
 using namespace std;
 
+namespace
+{
+const char* orientationNames[] = {"mono", "swap", "dright", "dleft", "other", "nomono"};
+}
+
+ORIENTATION parseOrientation(const char* s, size_t length)
+{
+  for(int i=MONO; i<=NOMONO; ++i) {
+    if (strlen(orientationNames[i]) == length &&
+        strncmp(s, orientationNames[i], length) == 0) {
+      return static_cast<ORIENTATION>(i);
+    }
+  }
+  cerr << "Illegal reordering type used: " << string(s, length) << endl;
+  exit(1);
+}
+
+bool Field::operator==(const Field& other) const
+{
+  return size == other.size && memcmp(begin, other.begin, size) == 0;
+}
+
 ModelScore::ModelScore()
 {
   for(int i=MONO; i<=NOMONO; ++i) {
@@ -56,12 +80,24 @@ void ModelScore::reset_f()
   }
 }
 
-void ModelScore::add_example(const string& previous, string& next)
+void ModelScore::add_example(ORIENTATION previous, ORIENTATION next)
 {
-  count_fe_prev[getType(previous)]++;
-  count_f_prev[getType(previous)]++;
-  count_fe_next[getType(next)]++;
-  count_f_next[getType(next)]++;
+  previous = getType(previous);
+  next = getType(next);
+  count_fe_prev[previous]++;
+  count_f_prev[previous]++;
+  count_fe_next[next]++;
+  count_f_next[next]++;
+}
+
+void ModelScore::add_counts(const ModelScore& other)
+{
+  for(int i=MONO; i<=NOMONO; ++i) {
+    count_fe_prev[i] += other.count_fe_prev[i];
+    count_fe_next[i] += other.count_fe_next[i];
+    count_f_prev[i] += other.count_f_prev[i];
+    count_f_next[i] += other.count_f_next[i];
+  }
 }
 
 const vector<double>& ModelScore::get_scores_fe_prev() const
@@ -85,96 +121,50 @@ const vector<double>& ModelScore::get_scores_f_next() const
 }
 
 
-ORIENTATION ModelScore::getType(const string& s)
+ORIENTATION ModelScore::getType(ORIENTATION o)
 {
-  if (s.compare("mono") == 0) {
-    return MONO;
-  } else if (s.compare("swap") == 0) {
-    return SWAP;
-  } else if (s.compare("dright") == 0) {
-    return DRIGHT;
-  } else if (s.compare("dleft") == 0) {
-    return DLEFT;
-  } else if (s.compare("other") == 0) {
-    return OTHER;
-  } else if (s.compare("nomono") == 0) {
-    return NOMONO;
-  } else {
-    cerr << "Illegal reordering type used: " << s << endl;
-    exit(1);
-  }
+  return o;
 }
 
 
-ORIENTATION ModelScoreMSLR::getType(const string& s)
+ORIENTATION ModelScoreMSLR::getType(ORIENTATION o)
 {
-  if (s.compare("mono") == 0) {
-    return MONO;
-  } else if (s.compare("swap") == 0) {
-    return SWAP;
-  } else if (s.compare("dright") == 0) {
-    return DRIGHT;
-  } else if (s.compare("dleft") == 0) {
-    return DLEFT;
-  } else if (s.compare("other") == 0 || s.compare("nomono") == 0) {
-    cerr << "Illegal reordering type used: " << s << " for model type mslr. You have to re-run step 5 in order to train such a model." <<  endl;
-    exit(1);
-  } else {
-    cerr << "Illegal reordering type used: " << s << endl;
+  if (o == OTHER || o == NOMONO) {
+    cerr << "Illegal reordering type used: " << orientationNames[o] << " for model type mslr. You have to re-run step 5 in order to train such a model." <<  endl;
     exit(1);
   }
+  return o;
 }
 
 
-ORIENTATION ModelScoreLR::getType(const string& s)
+ORIENTATION ModelScoreLR::getType(ORIENTATION o)
 {
-  if (s.compare("mono") == 0 || s.compare("dright") == 0) {
+  if (o == MONO || o == DRIGHT) {
     return DRIGHT;
-  } else if (s.compare("swap") == 0 || s.compare("dleft") == 0) {
+  } else if (o == SWAP || o == DLEFT) {
     return DLEFT;
-  } else if (s.compare("other") == 0 || s.compare("nomono") == 0) {
-    cerr << "Illegal reordering type used: " << s << " for model type LeftRight. You have to re-run step 5 in order to train such a model." <<  endl;
-    exit(1);
   } else {
-    cerr << "Illegal reordering type used: " << s << endl;
+    cerr << "Illegal reordering type used: " << orientationNames[o] << " for model type LeftRight. You have to re-run step 5 in order to train such a model." <<  endl;
     exit(1);
   }
 }
 
 
-ORIENTATION ModelScoreMSD::getType(const string& s)
+ORIENTATION ModelScoreMSD::getType(ORIENTATION o)
 {
-  if (s.compare("mono") == 0) {
-    return MONO;
-  } else if (s.compare("swap") == 0) {
-    return SWAP;
-  } else if (s.compare("dleft") == 0 ||
-             s.compare("dright") == 0 ||
-             s.compare("other") == 0) {
-    return OTHER;
-  } else if (s.compare("nomono") == 0) {
-    cerr << "Illegal reordering type used: " << s << " for model type msd. You have to re-run step 5 in order to train such a model." <<  endl;
+  if (o == MONO || o == SWAP) {
+    return o;
+  } else if (o == NOMONO) {
+    cerr << "Illegal reordering type used: " << orientationNames[o] << " for model type msd. You have to re-run step 5 in order to train such a model." <<  endl;
     exit(1);
   } else {
-    cerr << "Illegal reordering type used: " << s << endl;
-    exit(1);
+    return OTHER;
   }
 }
 
-ORIENTATION ModelScoreMonotonicity::getType(const string& s)
+ORIENTATION ModelScoreMonotonicity::getType(ORIENTATION o)
 {
-  if (s.compare("mono") == 0) {
-    return MONO;
-  } else if (s.compare("swap") == 0 ||
-             s.compare("dleft") == 0 ||
-             s.compare("dright") == 0 ||
-             s.compare("other") == 0 ||
-             s.compare("nomono") == 0 ) {
-    return NOMONO;
-  } else {
-    cerr << "Illegal reordering type used: " << s << endl;
-    exit(1);
-  }
+  return (o == MONO) ? MONO : NOMONO;
 }
 
 
@@ -269,83 +259,69 @@ void ScorerLR::createConstSmoothing(double weight, vector<double>& smoothing) co
   }
 }
 
-void Model::score_fe(const string& f, const string& e)
+namespace
+{
+//appends the normalised, smoothed scores in the format of the table
+void appendScores(const Scorer& scorer, const vector<double>& counts,
+                  const vector<double>& smoothing, string& out)
+{
+  vector<double> scores;
+  scorer.score(counts, scores);
+  double sum = 0;
+  for(size_t i=0; i<scores.size(); ++i) {
+    scores[i] += smoothing[i];
+    sum += scores[i];
+  }
+  char buffer[64];
+  for(size_t i=0; i<scores.size(); ++i) {
+    snprintf(buffer, sizeof(buffer), "%f ", scores[i]/sum);
+    out += buffer;
+  }
+}
+}
+
+void Model::score_fe(const ModelScore& ms, const Field& f, const Field& e, string& out) const
 {
   if (!fe)    //Make sure we do not do anything if it is not a fe model
     return;
-  fprintf(file,"%s ||| %s ||| ",f.c_str(),e.c_str());
+  out.append(f.begin, f.size);
+  out += " ||| ";
+  out.append(e.begin, e.size);
+  out += " ||| ";
   //condition on the previous phrase
   if (previous) {
-    vector<double> scores;
-    scorer->score(modelscore->get_scores_fe_prev(), scores);
-    double sum = 0;
-    for(size_t i=0; i<scores.size(); ++i) {
-      scores[i] += smoothing_prev[i];
-      sum += scores[i];
-    }
-    for(size_t i=0; i<scores.size(); ++i) {
-      fprintf(file,"%f ",scores[i]/sum);
-    }
-    //fprintf(file, "||| ");
+    appendScores(*scorer, ms.get_scores_fe_prev(), smoothing_prev, out);
   }
   //condition on the next phrase
   if (next) {
-    vector<double> scores;
-    scorer->score(modelscore->get_scores_fe_next(), scores);
-    double sum = 0;
-    for(size_t i=0; i<scores.size(); ++i) {
-      scores[i] += smoothing_next[i];
-      sum += scores[i];
-    }
-    for(size_t i=0; i<scores.size(); ++i) {
-      fprintf(file, "%f ", scores[i]/sum);
-    }
+    appendScores(*scorer, ms.get_scores_fe_next(), smoothing_next, out);
   }
-  fprintf(file,"\n");
+  out += "\n";
 }
 
-void Model::score_f(const string& f)
+void Model::score_f(const ModelScore& ms, const Field& f, string& out) const
 {
   if (fe)      //Make sure we do not do anything if it is not a f model
     return;
-  fprintf(file, "%s ||| ", f.c_str());
+  out.append(f.begin, f.size);
+  out += " ||| ";
   //condition on the previous phrase
   if (previous) {
-    vector<double> scores;
-    scorer->score(modelscore->get_scores_f_prev(), scores);
-    double sum = 0;
-    for(size_t i=0; i<scores.size(); ++i) {
-      scores[i] += smoothing_prev[i];
-      sum += scores[i];
-    }
-    for(size_t i=0; i<scores.size(); ++i) {
-      fprintf(file, "%f ", scores[i]/sum);
-    }
-    //fprintf(file, "||| ");
+    appendScores(*scorer, ms.get_scores_f_prev(), smoothing_prev, out);
   }
   //condition on the next phrase
   if (next) {
-    vector<double> scores;
-    scorer->score(modelscore->get_scores_f_next(), scores);
-    double sum = 0;
-    for(size_t i=0; i<scores.size(); ++i) {
-      scores[i] += smoothing_next[i];
-      sum += scores[i];
-    }
-    for(size_t i=0; i<scores.size(); ++i) {
-      fprintf(file, "%f ", scores[i]/sum);
-    }
+    appendScores(*scorer, ms.get_scores_f_next(), smoothing_next, out);
   }
-  fprintf(file, "\n");
+  out += "\n";
 }
 
 Model::Model(ModelScore* ms, Scorer* sc, const string& dir, const string& lang, const string& fn)
-  : modelscore(ms), scorer(sc), filename(fn)
+  : modelscore(ms), scorer(sc), filename(fn), collector(&file)
 {
 
-  file = fopen(filename.c_str(),"w");
-  if (!file) {
-    cerr << "Could not open the model output file: " << filename << endl;
+  if (!file.Open(filename + ".gz")) {
+    cerr << "Could not open the model output file: " << filename << ".gz" << endl;
     exit(1);
   }
 
@@ -369,26 +345,27 @@ Model::Model(ModelScore* ms, Scorer* sc, const string& dir, const string& lang,
 
 Model::~Model()
 {
-  fclose(file);
   delete modelscore;
   delete scorer;
 }
 
-void Model::zipFile()
+void Model::write(int block, const string& out)
 {
-  fclose(file);
-  file = fopen(filename.c_str(), "rb");
-  gzFile gzfile = gzopen((filename+".gz").c_str(),"wb");
-  char inbuffer[128];
-  int num_read;
-  while ((num_read = fread(inbuffer, 1, sizeof(inbuffer), file)) > 0) {
-    gzwrite(gzfile, inbuffer, num_read);
-  }
-  fclose(file);
-  gzclose(gzfile);
+  collector.Write(block, out);
+}
+
+void Model::close()
+{
+  file.Close();
+}
 
-  //Remove the unzipped file
-  remove(filename.c_str());
+void Model::createBinary()
+{
+  Moses::InputFileStream in(filename + ".gz");
+  if (!Moses::LexicalReorderingTableTree::Create(in, filename)) {
+    cerr << "Could not create the binary reordering table " << filename << endl;
+    exit(1);
+  }
 }
 
 void Model::split_config(const string& config, string& dir, string& lang, string& orient)
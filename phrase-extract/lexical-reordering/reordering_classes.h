@@ -12,9 +12,28 @@
 #include <string>
 #include <fstream>
 
+#include "../OutputFileStream.h"
+#include "../../moses/src/OutputCollector.h"
+
 
 enum ORIENTATION {MONO, SWAP, DRIGHT, DLEFT, OTHER, NOMONO};
 
+//Reads an orientation as written by extract, exits on unknown ones
+ORIENTATION parseOrientation(const char* s, size_t length);
+
+//A phrase or column of a line of the extract file, pointing into the line
+struct Field {
+  const char* begin;
+  size_t size;
+
+  Field() : begin(0), size(0) {}
+  Field(const char* b, size_t s) : begin(b), size(s) {}
+  bool operator==(const Field& other) const;
+  bool operator!=(const Field& other) const {
+    return !(*this == other);
+  }
+};
+
 
 //Keeps the counts for the different reordering types
 //(Instantiated in 1-3 instances, one for each type of model (hier, phrase, wbe))
@@ -27,12 +46,14 @@ private:
   std::vector<double> count_f_next;
 
 protected:
-  virtual ORIENTATION getType(const std::string& s);
+  //maps the orientation found by extract to the one counted by the model
+  virtual ORIENTATION getType(ORIENTATION o);
 
 public:
   ModelScore();
   virtual ~ModelScore();
-  void add_example(const std::string& previous, std::string& next);
+  void add_example(ORIENTATION previous, ORIENTATION next);
+  void add_counts(const ModelScore& other);
   void reset_fe();
   void reset_f();
   const std::vector<double>& get_scores_fe_prev() const;
@@ -46,25 +67,25 @@ public:
 class ModelScoreMSLR : public ModelScore
 {
 protected:
-  virtual ORIENTATION getType(const std::string& s);
+  virtual ORIENTATION getType(ORIENTATION o);
 };
 
 class ModelScoreLR : public ModelScore
 {
 protected:
-  virtual ORIENTATION getType(const std::string& s);
+  virtual ORIENTATION getType(ORIENTATION o);
 };
 
 class ModelScoreMSD : public ModelScore
 {
 protected:
-  virtual ORIENTATION getType(const std::string& s);
+  virtual ORIENTATION getType(ORIENTATION o);
 };
 
 class ModelScoreMonotonicity : public ModelScore
 {
 protected:
-  virtual ORIENTATION getType(const std::string& s);
+  virtual ORIENTATION getType(ORIENTATION o);
 };
 
 //Class for calculating total counts, and to calculate smoothing
@@ -114,14 +135,18 @@ public:
 //Contains a modelscore and scorer (which can be of different model types (mslr, msd...)),
 //and file handling.
 //This class also keeps track of bidirectionality, and which language to condition on
+//Scores are computed from the counts of any ModelScore of the model's type,
+//so that blocks of the extract file can be scored independently, and are
+//written to the gzipped table in block order.
 class Model
 {
 private:
   ModelScore* modelscore;
   Scorer* scorer;
 
-  std::FILE* file;
   std::string filename;
+  Moses::OutputFileStream file;
+  Moses::OutputCollector collector;
 
   bool fe;
   bool previous;
@@ -139,8 +164,10 @@ public:
   static Model* createModel(ModelScore*, const std::string&, const std::string&);
   void createSmoothing(double w);
   void createConstSmoothing(double w);
-  void score_fe(const std::string& f, const std::string& e);
-  void score_f(const std::string& f);
-  void zipFile();
+  void score_fe(const ModelScore& ms, const Field& f, const Field& e, std::string& out) const;
+  void score_f(const ModelScore& ms, const Field& f, std::string& out) const;
+  void write(int block, const std::string& out);
+  void close();
+  void createBinary();
 };
 
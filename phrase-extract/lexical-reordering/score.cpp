@@ -13,14 +13,101 @@
 #include <sstream>
 #include <cstdlib>
 #include <cstring>
+#include <cctype>
+#include <algorithm>
 #include "InputFileStream.h"
+#include "../../moses/src/ThreadPool.h"
+
+#ifdef WITH_THREADS
+#include <boost/thread/mutex.hpp>
+#endif
 
 #include "reordering_classes.h"
 
 using namespace std;
 
-void split_line(const string& line, string& foreign, string& english, string& wbe, string& phrase, string& hier);
-void get_orientations(const string& pair, string& previous, string& next);
+namespace
+{
+
+//the columns of orientations in the extract file, after the phrases
+enum Column {WBE, PHRASE, HIER, NUM_COLUMNS};
+
+//The extract file is scored in blocks of about this many lines. Blocks only
+//end where the source phrase changes, so all counts of a phrase pair and of
+//a source phrase are in one block.
+const size_t BLOCK_LINES = 100000;
+
+#ifdef WITH_THREADS
+boost::mutex countMutex;
+#endif
+
+void split_line(const char* begin, const char* end, Field& foreign, Field& english, Field* columns);
+void get_orientations(const Field& pair, ORIENTATION& previous, ORIENTATION& next);
+
+//Reads the sorted extract file block by block
+class BlockReader
+{
+public:
+  BlockReader(istream& in) : m_in(in), m_pending(false) {}
+  bool Read(string& block);
+
+private:
+  istream& m_in;
+  string m_line;
+  bool m_pending;
+};
+
+//Counts the orientations of a block, for smoothing with the overall counts
+class CountTask : public Moses::Task
+{
+public:
+  CountTask(string* block, const string* types, ModelScore** totals)
+    : m_block(block), m_types(types), m_totals(totals) {}
+  ~CountTask() {
+    delete m_block;
+  }
+  void Run();
+
+private:
+  string* m_block;
+  const string* m_types;
+  ModelScore** m_totals;
+};
+
+//Scores the phrase pairs and source phrases of a block, for all models
+class ScoreTask : public Moses::Task
+{
+public:
+  ScoreTask(int id, string* block, const string* types,
+            const vector<Model*>& models, const vector<Column>& modelColumns)
+    : m_id(id), m_block(block), m_types(types),
+      m_models(models), m_modelColumns(modelColumns) {}
+  ~ScoreTask() {
+    delete m_block;
+  }
+  void Run();
+
+private:
+  int m_id;
+  string* m_block;
+  const string* m_types;
+  const vector<Model*>& m_models;
+  const vector<Column>& m_modelColumns;
+};
+
+void RunTask(Moses::Task* task, Moses::ThreadPool* pool)
+{
+#ifdef WITH_THREADS
+  if (pool != NULL) {
+    pool->Submit(task);
+    return;
+  }
+#endif
+  task->Run();
+  delete task;
+}
+
+}
 
 
 int main(int argc, char* argv[])
@@ -30,7 +117,11 @@ int main(int argc, char* argv[])
        << "scores lexical reordering models of several types (hierarchical, phrase-based and word-based-extraction\n";
 
   if (argc < 3) {
-    cerr << "syntax: score_reordering extractFile smoothingValue filepath (--model \"type max-orientation (specification-strings)\" )+\n";
+    cerr << "syntax: score_reordering extractFile smoothingValue filepath (--model \"type max-orientation (specification-strings)\" )+ [--SmoothWithCounts] [--Binary]"
+#ifdef WITH_THREADS
+         << " [--threads NUM]"
+#endif
+         << "\n";
     exit(1);
   }
 
@@ -45,19 +136,32 @@ int main(int argc, char* argv[])
   }
 
   bool smoothWithCounts = false;
-  map<string,ModelScore*> modelScores;
+  bool binary = false;
+  int thread_count = 1;
+  //the type of model (mslr, msd...) and overall counts of each column
+  string modelTypes[NUM_COLUMNS];
+  ModelScore* modelScores[NUM_COLUMNS] = {NULL, NULL, NULL};
   vector<Model*> models;
-  bool hier = false;
-  bool phrase = false;
-  bool wbe = false;
-
-  string e,f,w,p,h;
-  string prev, next;
+  vector<Column> modelColumns;
 
   int i = 4;
   while (i<argc) {
     if (strcmp(argv[i],"--SmoothWithCounts") == 0) {
       smoothWithCounts = true;
+    } else if (strcmp(argv[i],"--Binary") == 0) {
+      binary = true;
+#ifdef WITH_THREADS
+    } else if (strcmp(argv[i],"--threads") == 0) {
+      if (i+1 >= argc) {
+        cerr << "score: syntax error, no number of threads provided to the option " << argv[i] << endl;
+        exit(1);
+      }
+      thread_count = atoi(argv[++i]);
+      if (thread_count < 1) {
+        cerr << "score: number of threads must be at least 1" << endl;
+        exit(1);
+      }
+#endif
     } else if (strcmp(argv[i],"--model") == 0) {
       if (i+1 >= argc) {
         cerr << "score: syntax error, no model information provided to the option" << argv[i] << endl;
@@ -66,25 +170,25 @@ int main(int argc, char* argv[])
       istringstream is(argv[++i]);
       string m,t;
       is >> m >> t;
-      modelScores[m] = ModelScore::createModelScore(t);
+      Column column;
       if (m.compare("hier") == 0) {
-        hier = true;
+        column = HIER;
       } else if (m.compare("phrase") == 0) {
-        phrase = true;
-      }
-      if (m.compare("wbe") == 0) {
-        wbe = true;
-      }
-
-      if (!hier && !phrase && !wbe) {
+        column = PHRASE;
+      } else if (m.compare("wbe") == 0) {
+        column = WBE;
+      } else {
         cerr << "WARNING: No models specified for lexical reordering. No lexical reordering table will be trained.\n";
         return 0;
       }
+      modelScores[column] = ModelScore::createModelScore(t);
+      modelTypes[column] = t;
 
       string config;
       //Store all models
       while (is >> config) {
-        models.push_back(Model::createModel(modelScores[m],config,filepath));
+        models.push_back(Model::createModel(modelScores[column],config,filepath));
+        modelColumns.push_back(column);
       }
     } else {
       cerr << "illegal option given to lexical reordering model score\n";
@@ -93,25 +197,33 @@ int main(int argc, char* argv[])
     i++;
   }
 
+  Moses::ThreadPool* pool = NULL;
+#ifdef WITH_THREADS
+  if (thread_count > 1) {
+    pool = new Moses::ThreadPool(thread_count);
+    // each block in the queue holds a copy of its part of the extract file
+    pool->SetQueueLimit(2 * thread_count);
+  }
+#endif
+
   ////////////////////////////////////
   //calculate smoothing
   if (smoothWithCounts) {
-    string line;
-    while (getline(eFile,line)) {
-      split_line(line,e,f,w,p,h);
-      if (hier) {
-        get_orientations(h, prev, next);
-        modelScores["hier"]->add_example(prev,next);
-      }
-      if (phrase) {
-        get_orientations(p, prev, next);
-        modelScores["phrase"]->add_example(prev,next);
-      }
-      if (wbe) {
-        get_orientations(w, prev, next);
-        modelScores["wbe"]->add_example(prev,next);
-      }
+    BlockReader reader(eFile);
+    string* block = new string;
+    while (reader.Read(*block)) {
+      RunTask(new CountTask(block, modelTypes, modelScores), pool);
+      block = new string;
+    }
+    delete block;
+#ifdef WITH_THREADS
+    if (pool != NULL) {
+      pool->Stop(true);
+      delete pool;
+      pool = new Moses::ThreadPool(thread_count);
+      pool->SetQueueLimit(2 * thread_count);
     }
+#endif
 
     // calculate smoothing for each model
     for (size_t i=0; i<models.size(); ++i) {
@@ -130,33 +242,142 @@ int main(int argc, char* argv[])
 
   ////////////////////////////////////
   //calculate scores for reordering table
-  string line,f_current,e_current;
+  BlockReader reader(eFile);
+  string* block = new string;
+  int id = 0;
+  while (reader.Read(*block)) {
+    RunTask(new ScoreTask(id++, block, modelTypes, models, modelColumns), pool);
+    block = new string;
+  }
+  delete block;
+#ifdef WITH_THREADS
+  if (pool != NULL) {
+    pool->Stop(true);
+    delete pool;
+  }
+#endif
+
+  for (size_t i=0; i<models.size(); ++i) {
+    models[i]->close();
+  }
+
+  //The binary tables are built one after the other, as building them
+  //shares static state of the decoder's prefix tree
+  if (binary) {
+    for (size_t i=0; i<models.size(); ++i) {
+      models[i]->createBinary();
+    }
+  }
+
+  return 0;
+}
+
+
+namespace
+{
+
+bool BlockReader::Read(string& block)
+{
+  block.clear();
+  size_t lines = 0;
+  size_t lastLine = 0;
+  if (m_pending) {
+    block += m_line;
+    block += '\n';
+    ++lines;
+    m_pending = false;
+  }
+  while (getline(m_in, m_line)) {
+    if (lines >= BLOCK_LINES) {
+      const char* last = block.data() + lastLine;
+      size_t lastSource = block.find(" ||| ", lastLine) - lastLine;
+      size_t source = m_line.find(" ||| ");
+      if (Field(last, lastSource) != Field(m_line.data(), source)) {
+        m_pending = true;
+        return true;
+      }
+    }
+    lastLine = block.size();
+    block += m_line;
+    block += '\n';
+    ++lines;
+  }
+  return lines > 0;
+}
+
+void CountTask::Run()
+{
+  ModelScore* counts[NUM_COLUMNS];
+  for (int c=0; c<NUM_COLUMNS; ++c) {
+    counts[c] = m_types[c].empty() ? NULL : ModelScore::createModelScore(m_types[c]);
+  }
+
+  Field f, e, columns[NUM_COLUMNS];
+  ORIENTATION prev, next;
+  const char* end = m_block->data() + m_block->size();
+  for (const char* line = m_block->data(); line < end; ) {
+    const char* lineEnd = static_cast<const char*>(memchr(line, '\n', end - line));
+    split_line(line, lineEnd, f, e, columns);
+    for (int c=0; c<NUM_COLUMNS; ++c) {
+      if (counts[c]) {
+        get_orientations(columns[c], prev, next);
+        counts[c]->add_example(prev, next);
+      }
+    }
+    line = lineEnd + 1;
+  }
+
+#ifdef WITH_THREADS
+  boost::mutex::scoped_lock lock(countMutex);
+#endif
+  for (int c=0; c<NUM_COLUMNS; ++c) {
+    if (counts[c]) {
+      m_totals[c]->add_counts(*counts[c]);
+      delete counts[c];
+    }
+  }
+}
+
+void ScoreTask::Run()
+{
+  ModelScore* counts[NUM_COLUMNS];
+  for (int c=0; c<NUM_COLUMNS; ++c) {
+    counts[c] = m_types[c].empty() ? NULL : ModelScore::createModelScore(m_types[c]);
+  }
+  vector<string> out(m_models.size());
+
+  Field f, e, columns[NUM_COLUMNS];
+  Field f_current, e_current;
+  ORIENTATION prev, next;
   bool first = true;
-  while (getline(eFile, line)) {
-    split_line(line,f,e,w,p,h);
+  const char* end = m_block->data() + m_block->size();
+  for (const char* line = m_block->data(); line < end; ) {
+    const char* lineEnd = static_cast<const char*>(memchr(line, '\n', end - line));
+    split_line(line, lineEnd, f, e, columns);
+    line = lineEnd + 1;
 
     if (first) {
       f_current = f;
       e_current = e;
       first = false;
-    } else if (f.compare(f_current) != 0 || e.compare(e_current) != 0) {
+    } else if (f != f_current || e != e_current) {
       //fe - score
-      for (size_t i=0; i<models.size(); ++i) {
-        models[i]->score_fe(f_current,e_current);
+      for (size_t i=0; i<m_models.size(); ++i) {
+        m_models[i]->score_fe(*counts[m_modelColumns[i]], f_current, e_current, out[i]);
       }
       //reset
-      for(map<string,ModelScore*>::const_iterator it = modelScores.begin(); it != modelScores.end(); ++it) {
-        it->second->reset_fe();
+      for (int c=0; c<NUM_COLUMNS; ++c) {
+        if (counts[c]) counts[c]->reset_fe();
       }
 
-      if (f.compare(f_current) != 0) {
+      if (f != f_current) {
         //f - score
-        for (size_t i=0; i<models.size(); ++i) {
-          models[i]->score_f(f_current);
+        for (size_t i=0; i<m_models.size(); ++i) {
+          m_models[i]->score_f(*counts[m_modelColumns[i]], f_current, out[i]);
         }
         //reset
-        for(map<string,ModelScore*>::const_iterator it = modelScores.begin(); it != modelScores.end(); ++it) {
-          it->second->reset_f();
+        for (int c=0; c<NUM_COLUMNS; ++c) {
+          if (counts[c]) counts[c]->reset_f();
         }
       }
       f_current = f;
@@ -164,62 +385,71 @@ int main(int argc, char* argv[])
     }
 
     // uppdate counts
-    if (hier) {
-      get_orientations(h, prev, next);
-      modelScores["hier"]->add_example(prev,next);
-    }
-    if (phrase) {
-      get_orientations(p, prev, next);
-      modelScores["phrase"]->add_example(prev,next);
-    }
-    if (wbe) {
-      get_orientations(w, prev, next);
-      modelScores["wbe"]->add_example(prev,next);
+    for (int c=0; c<NUM_COLUMNS; ++c) {
+      if (counts[c]) {
+        get_orientations(columns[c], prev, next);
+        counts[c]->add_example(prev, next);
+      }
     }
   }
   //Score the last phrases
-  for (size_t i=0; i<models.size(); ++i) {
-    models[i]->score_fe(f,e);
+  for (size_t i=0; i<m_models.size(); ++i) {
+    m_models[i]->score_fe(*counts[m_modelColumns[i]], f, e, out[i]);
   }
-  for (size_t i=0; i<models.size(); ++i) {
-    models[i]->score_f(f);
+  for (size_t i=0; i<m_models.size(); ++i) {
+    m_models[i]->score_f(*counts[m_modelColumns[i]], f, out[i]);
   }
 
-  //Zip all files
-  for (size_t i=0; i<models.size(); ++i) {
-    models[i]->zipFile();
+  for (size_t i=0; i<m_models.size(); ++i) {
+    m_models[i]->write(m_id, out[i]);
+  }
+  for (int c=0; c<NUM_COLUMNS; ++c) {
+    delete counts[c];
   }
-
-  return 0;
 }
 
-
-
-void split_line(const string& line, string& foreign, string& english, string& wbe, string& phrase, string& hier)
+//the first occurence of separator in [begin, end), or end
+const char* find_separator(const char* begin, const char* end, const char* separator)
 {
+  return search(begin, end, separator, separator + strlen(separator));
+}
 
-  int begin = 0;
-  int end = line.find(" ||| ");
-  foreign = line.substr(begin, end - begin);
-
-  begin = end+5;
-  end = line.find(" ||| ", begin);
-  english = line.substr(begin, end - begin);
-
-  begin = end+5;
-  end = line.find(" | ", begin);
-  wbe = line.substr(begin, end - begin);
-
-  begin = end+3;
-  end = line.find(" | ", begin);
-  phrase = line.substr(begin, end - begin);
-
-  begin = end+3;
-  hier = line.substr(begin, line.size() - begin);
+//finds the fields of a line, without copying them
+void split_line(const char* begin, const char* end, Field& foreign, Field& english, Field* columns)
+{
+  const char* split = find_separator(begin, end, " ||| ");
+  foreign = Field(begin, split - begin);
+
+  begin = min(split + 5, end);
+  split = find_separator(begin, end, " ||| ");
+  english = Field(begin, split - begin);
+
+  begin = min(split + 5, end);
+  for (int c=0; c<NUM_COLUMNS; ++c) {
+    split = (c+1 < NUM_COLUMNS) ? find_separator(begin, end, " | ") : end;
+    columns[c] = Field(begin, split - begin);
+    begin = min(split + 3, end);
+  }
 }
 
-void get_orientations(const string& pair, string& previous, string& next)
+void get_orientations(const Field& pair, ORIENTATION& previous, ORIENTATION& next)
 {
-  istringstream is(pair);
-  is >> previous >> next;
+  const char* end = pair.begin + pair.size;
+  const char* token[2];
+  const char* tokenEnd[2];
+  const char* p = pair.begin;
+  for (int i=0; i<2; ++i) {
+    while (p < end && isspace(*p)) ++p;
+    token[i] = p;
+    while (p < end && !isspace(*p)) ++p;
+    tokenEnd[i] = p;
+    if (token[i] == tokenEnd[i]) {
+      cerr << "Missing reordering type in the extract file: " << string(pair.begin, pair.size) << endl;
+      exit(1);
+    }
+  }
+  previous = parseOrientation(token[0], tokenEnd[0] - token[0]);
+  next = parseOrientation(token[1], tokenEnd[1] - token[1]);
+}
+
 }
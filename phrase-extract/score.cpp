@@ -27,6 +27,8 @@
 #include <cstring>
 #include <set>
 
+#include <boost/unordered_map.hpp>
+
 #include "SafeGetline.h"
 #include "tables-core.h"
 #include "PhraseAlignment.h"
@@ -42,7 +44,9 @@ using namespace MosesTraining;
 namespace MosesTraining
 {
 LexicalTable lexTable;
+LexicalTable lexTableInverse;
 bool inverseFlag = false;
+bool jointFlag = false;
 bool hierarchicalFlag = false;
 bool pcfgFlag = false;
 bool unpairedExtractFormatFlag = false;
@@ -61,22 +65,52 @@ int countOfCounts[COC_MAX+1];
 int totalDistinct = 0;
 float minCountHierarchical = 0;
 
+// consolidation options, for --Joint
+bool onlyDirectFlag = false;
+bool phraseCountFlag = true;
+bool lowCountFlag = false;
+vector< int > countBin;
+
 Vocabulary vcbT;
 Vocabulary vcbS;
-  
+
+// counts of a target phrase over all source phrases, for --Joint
+struct TargetMarginal {
+  TargetMarginal() : count(0), distinct(0) {}
+  float count;
+  int distinct;
+};
+typedef boost::unordered_map< PHRASE, TargetMarginal > TargetMarginals;
+TargetMarginals targetMarginals;
+
+vector< float > goodTuringDiscount;
+float kneserNey_D1, kneserNey_D2, kneserNey_D3;
+
 } // namespace
 
 vector<string> tokenize( const char [] );
 
 void writeCountOfCounts( const string &fileNameCountOfCounts );
-void processPhrasePairs( vector< PhraseAlignment > & , ostream &phraseTableFile);
+void collectCountOfCounts( float count );
+void computeDiscounts();
+void scoreExtractFile( const char* fileNameExtract, ostream *phraseTableFile );
+void processPhrasePairs( vector< PhraseAlignment > & , ostream *phraseTableFile);
 PhraseAlignment* findBestAlignment(const PhraseAlignmentCollection &phrasePair );
+bool belowMinCountHierarchical( const PHRASE &phraseS, float count );
 void outputPhrasePair(const PhraseAlignmentCollection &phrasePair, float, int, ostream &phraseTableFile );
+void addTargetMarginal(const PhraseAlignmentCollection &phrasePair );
+void outputJointPhrasePair(const PhraseAlignmentCollection &phrasePair, float, int, ostream &phraseTableFile );
 double computeLexicalTranslation( const PHRASE &, const PHRASE &, PhraseAlignment * );
+double computeInverseLexicalTranslation( const PHRASE &, const PHRASE &, PhraseAlignment * );
 double computeUnalignedPenalty( const PHRASE &, const PHRASE &, PhraseAlignment * );
+double computeInverseUnalignedPenalty( PhraseAlignment * );
 set<string> functionWordList;
-void loadFunctionWords( const char* fileNameFunctionWords );
+set<string> functionWordListInverse;
+void loadFunctionWords( const char* fileNameFunctionWords, set<string> &wordList );
 double computeUnalignedFWPenalty( const PHRASE &, const PHRASE &, PhraseAlignment * );
+double computeInverseUnalignedFWPenalty( const PHRASE &, PhraseAlignment * );
+void outputLexicalScores( const PHRASE &, const PHRASE &, PhraseAlignment *, bool inverse, ostream & );
+void outputAlignment( const PHRASE &, PhraseAlignment *, ostream & );
 void calcNTLengthProb(const vector< PhraseAlignment* > &phrasePairs
                       , map<size_t, map<size_t, float> > &sourceProb
                       , map<size_t, map<size_t, float> > &targetProb);
@@ -89,14 +123,17 @@ int main(int argc, char* argv[])
        << "scoring methods for extracted rules\n";
 
   if (argc < 4) {
-    cerr << "syntax: score extract lex phrase-table [--Inverse] [--Hierarchical] [--LogProb] [--NegLogProb] [--NoLex] [--GoodTuring] [--KneserNey] [--WordAlignment] [--UnalignedPenalty] [--UnalignedFunctionWordPenalty function-word-file] [--MinCountHierarchical count] [--OutputNTLengths] [--PCFG] [--UnpairedExtractFormat] [--ConditionOnTargetLHS]\n";
+    cerr << "syntax: score extract lex phrase-table [--Inverse] [--Hierarchical] [--LogProb] [--NegLogProb] [--NoLex] [--GoodTuring] [--KneserNey] [--WordAlignment] [--UnalignedPenalty] [--UnalignedFunctionWordPenalty function-word-file] [--MinCountHierarchical count] [--OutputNTLengths] [--PCFG] [--UnpairedExtractFormat] [--ConditionOnTargetLHS]\n"
+         << "       score extract lex phrase-table --Joint inverse-lex [--InverseUnalignedFunctionWordPenalty source-function-word-file] [--OnlyDirect] [--NoPhraseCount] [--LowCountFeature] [--CountBinFeature counts...] [other options as above]\n";
     exit(1);
   }
   char* fileNameExtract = argv[1];
   char* fileNameLex = argv[2];
   char* fileNamePhraseTable = argv[3];
   string fileNameCountOfCounts;
-  char* fileNameFunctionWords;
+  char* fileNameFunctionWords = NULL;
+  char* fileNameLexInverse = NULL;
+  char* fileNameFunctionWordsInverse = NULL;
 
   for(int i=4; i<argc; i++) {
     if (strcmp(argv[i],"inverse") == 0 || strcmp(argv[i],"--Inverse") == 0) {
@@ -152,34 +189,82 @@ int main(int argc, char* argv[])
       minCountHierarchical -= 0.00001; // account for rounding
     } else if (strcmp(argv[i],"--OutputNTLengths") == 0) {
       outputNTLengths = true;
+    } else if (strcmp(argv[i],"--Joint") == 0) {
+      jointFlag = true;
+      if (i+1==argc) {
+        cerr << "ERROR: specify inverse lexical translation table for joint scoring!\n";
+        exit(1);
+      }
+      fileNameLexInverse = argv[++i];
+      cerr << "scoring both directions and consolidating\n";
+    } else if (strcmp(argv[i],"--InverseUnalignedFunctionWordPenalty") == 0) {
+      if (i+1==argc) {
+        cerr << "ERROR: specify source function word file for the inverse unaligned function word penalty!\n";
+        exit(1);
+      }
+      fileNameFunctionWordsInverse = argv[++i];
+    } else if (strcmp(argv[i],"--OnlyDirect") == 0) {
+      onlyDirectFlag = true;
+      cerr << "only including direct translation scores p(e|f)\n";
+    } else if (strcmp(argv[i],"--NoPhraseCount") == 0) {
+      phraseCountFlag = false;
+      cerr << "not including the phrase count feature\n";
+    } else if (strcmp(argv[i],"--LowCountFeature") == 0) {
+      lowCountFlag = true;
+      cerr << "including the low count feature\n";
+    } else if (strcmp(argv[i],"--CountBinFeature") == 0) {
+      cerr << "include count bin feature:";
+      int prev = 0;
+      while(i+1<argc && argv[i+1][0]>='0' && argv[i+1][0]<='9') {
+        int binCount = atoi(argv[++i]);
+        countBin.push_back( binCount );
+        if (prev+1 == binCount) {
+          cerr << " " << binCount;
+        } else {
+          cerr << " " << (prev+1) << "-" << binCount;
+        }
+        prev = binCount;
+      }
+      cerr << " " << (prev+1) << "+\n";
     } else {
       cerr << "ERROR: unknown option " << argv[i] << endl;
       exit(1);
     }
   }
 
+  if (jointFlag) {
+    if (inverseFlag || unpairedExtractFormatFlag || conditionOnTargetLhsFlag) {
+      cerr << "ERROR: --Joint cannot be combined with --Inverse, --UnpairedExtractFormat or --ConditionOnTargetLHS\n";
+      exit(1);
+    }
+    if (unalignedFWFlag && fileNameFunctionWordsInverse == NULL) {
+      cerr << "ERROR: --Joint with --UnalignedFunctionWordPenalty also needs --InverseUnalignedFunctionWordPenalty\n";
+      exit(1);
+    }
+  } else if (onlyDirectFlag || !phraseCountFlag || lowCountFlag || countBin.size() > 0 || fileNameFunctionWordsInverse != NULL) {
+    cerr << "ERROR: consolidation options are only used with --Joint\n";
+    exit(1);
+  }
+
   // lexical translation table
-  if (lexFlag)
+  if (lexFlag) {
     lexTable.load( fileNameLex );
+    if (jointFlag)
+      lexTableInverse.load( fileNameLexInverse, true );
+  }
 
   // function word list
-  if (unalignedFWFlag)
-    loadFunctionWords( fileNameFunctionWords );
+  if (unalignedFWFlag) {
+    loadFunctionWords( fileNameFunctionWords, functionWordList );
+    if (jointFlag)
+      loadFunctionWords( fileNameFunctionWordsInverse, functionWordListInverse );
+  }
 
   // compute count of counts for Good Turing discounting
   if (goodTuringFlag || kneserNeyFlag) {
     for(int i=1; i<=COC_MAX; i++) countOfCounts[i] = 0;
   }
 
-  // sorted phrase extraction file
-  Moses::InputFileStream extractFile(fileNameExtract);
-
-  if (extractFile.fail()) {
-    cerr << "ERROR: could not open extract file " << fileNameExtract << endl;
-    exit(1);
-  }
-  istream &extractFileP = extractFile;
-
   // output file: phrase translation table
 	ostream *phraseTableFile;
 
@@ -196,7 +281,41 @@ int main(int argc, char* argv[])
 		}
 		phraseTableFile = outputFile;
 	}
-	
+
+  if (jointFlag) {
+    // the first pass over the extract file collects the counts of the
+    // target phrases, the second writes out the consolidated table
+    cerr << "collecting target phrase counts\n";
+    scoreExtractFile( fileNameExtract, NULL );
+    cerr << endl;
+    if (goodTuringFlag || kneserNeyFlag)
+      computeDiscounts();
+  }
+  scoreExtractFile( fileNameExtract, phraseTableFile );
+
+	phraseTableFile->flush();
+	if (phraseTableFile != &cout) {
+		delete phraseTableFile;
+	}
+
+  // output count of count statistics
+  if ((goodTuringFlag || kneserNeyFlag) && !jointFlag) {
+    writeCountOfCounts( fileNameCountOfCounts );
+  }
+}
+
+// phraseTableFile is NULL in the first pass of --Joint
+void scoreExtractFile( const char* fileNameExtract, ostream *phraseTableFile )
+{
+  // sorted phrase extraction file
+  Moses::InputFileStream extractFile(fileNameExtract);
+
+  if (extractFile.fail()) {
+    cerr << "ERROR: could not open extract file " << fileNameExtract << endl;
+    exit(1);
+  }
+  istream &extractFileP = extractFile;
+
   // loop through all extracted phrase translations
   float lastCount = 0.0f;
   float lastPcfgSum = 0.0f;
@@ -235,7 +354,7 @@ int main(int argc, char* argv[])
     // if new source phrase, process last batch
     if (lastPhrasePair != NULL &&
         lastPhrasePair->GetSource() != phrasePair.GetSource()) {
-      processPhrasePairs( phrasePairsWithSameF, *phraseTableFile );
+      processPhrasePairs( phrasePairsWithSameF, phraseTableFile );
       phrasePairsWithSameF.clear();
       lastPhrasePair = NULL;
     }
@@ -244,17 +363,8 @@ int main(int argc, char* argv[])
     phrasePairsWithSameF.push_back( phrasePair );
     lastPhrasePair = &phrasePairsWithSameF.back();
   }
-  processPhrasePairs( phrasePairsWithSameF, *phraseTableFile );
-	
-	phraseTableFile->flush();
-	if (phraseTableFile != &cout) {
-		delete phraseTableFile;
-	}
-
-  // output count of count statistics
-  if (goodTuringFlag || kneserNeyFlag) {
-    writeCountOfCounts( fileNameCountOfCounts );
-  }
+  processPhrasePairs( phrasePairsWithSameF, phraseTableFile );
+  extractFile.Close();
 }
 
 void writeCountOfCounts( const string &fileNameCountOfCounts )
@@ -278,7 +388,46 @@ void writeCountOfCounts( const string &fileNameCountOfCounts )
 	countOfCountsFile.Close();
 }
 
-void processPhrasePairs( vector< PhraseAlignment > &phrasePair, ostream &phraseTableFile )
+void collectCountOfCounts( float count )
+{
+  totalDistinct++;
+  int countInt = count + 0.99999;
+  if(countInt <= COC_MAX)
+    countOfCounts[ countInt ]++;
+}
+
+// discounting as consolidate does it from the count-of-counts file
+void computeDiscounts()
+{
+  vector< float > coc;
+  coc.push_back(0.0);
+  for(int i=1; i<=COC_MAX; i++)
+    coc.push_back( countOfCounts[i] );
+
+  // compute Good Turing discounts
+  if (goodTuringFlag) {
+    goodTuringDiscount.push_back(0.01); // floor value
+    for( size_t i=1; i<coc.size()-1; i++ ) {
+      goodTuringDiscount.push_back(((float)i+1)/(float)i*((coc[i+1]+0.1) / ((float)coc[i]+0.1)));
+      if (goodTuringDiscount[i]>1)
+        goodTuringDiscount[i] = 1;
+      if (goodTuringDiscount[i]<goodTuringDiscount[i-1])
+        goodTuringDiscount[i] = goodTuringDiscount[i-1];
+    }
+  }
+
+  // compute Kneser Ney co-efficients [Chen&Goodman, 1998]
+  float Y = coc[1] / (coc[1] + 2*coc[2]);
+  kneserNey_D1 = 1 - 2*Y * coc[2] / coc[1];
+  kneserNey_D2 = 2 - 3*Y * coc[3] / coc[2];
+  kneserNey_D3 = 3 - 4*Y * coc[4] / coc[3];
+  // sanity constraints
+  if (kneserNey_D1 > 0.9) kneserNey_D1 = 0.9;
+  if (kneserNey_D2 > 1.9) kneserNey_D2 = 1.9;
+  if (kneserNey_D3 > 2.9) kneserNey_D3 = 2.9;
+}
+
+void processPhrasePairs( vector< PhraseAlignment > &phrasePair, ostream *phraseTableFile )
 {
   if (phrasePair.size() == 0) return;
 
@@ -319,7 +468,12 @@ void processPhrasePairs( vector< PhraseAlignment > &phrasePair, ostream &phraseT
   for(iter = sortedColl.begin(); iter != sortedColl.end(); ++iter) 
   {
     const PhraseAlignmentCollection &group = **iter;
-    outputPhrasePair( group, totalSource, phrasePairGroup.GetSize(), phraseTableFile );
+    if (phraseTableFile == NULL)
+      addTargetMarginal( group );
+    else if (jointFlag)
+      outputJointPhrasePair( group, totalSource, phrasePairGroup.GetSize(), *phraseTableFile );
+    else
+      outputPhrasePair( group, totalSource, phrasePairGroup.GetSize(), *phraseTableFile );
 
   }
   
@@ -328,7 +482,7 @@ void processPhrasePairs( vector< PhraseAlignment > &phrasePair, ostream &phraseT
 PhraseAlignment* findBestAlignment(const PhraseAlignmentCollection &phrasePair )
 {
   float bestAlignmentCount = -1;
-  PhraseAlignment* bestAlignment;
+  PhraseAlignment* bestAlignment = NULL;
   
   for(size_t i=0; i<phrasePair.size(); i++) {
     size_t alignInd;
@@ -349,6 +503,18 @@ PhraseAlignment* findBestAlignment(const PhraseAlignmentCollection &phrasePair )
   return bestAlignment;
 }
 
+// hierarchical rules below the count threshold are not written out
+bool belowMinCountHierarchical( const PHRASE &phraseS, float count )
+{
+  if (!hierarchicalFlag || count >= minCountHierarchical)
+    return false;
+  for(size_t j=0; j<phraseS.size()-1; j++) {
+    if (isNonTerminal(vcbS.getWord( phraseS[j] )))
+      return true;
+  }
+  return false;
+}
+
 
 void calcNTLengthProb(const map<size_t, map<size_t, size_t> > &lengths
                       , size_t total
@@ -451,10 +617,7 @@ void outputPhrasePair(const PhraseAlignmentCollection &phrasePair, float totalCo
 
   // collect count of count statistics
   if (goodTuringFlag || kneserNeyFlag) {
-    totalDistinct++;
-    int countInt = count + 0.99999;
-    if(countInt <= COC_MAX)
-      countOfCounts[ countInt ]++;
+    collectCountOfCounts( count );
   }
 
   // compute PCFG score
@@ -472,12 +635,8 @@ void outputPhrasePair(const PhraseAlignmentCollection &phrasePair, float totalCo
   const PHRASE &phraseT = phrasePair[0]->GetTarget();
 
   // do not output if hierarchical and count below threshold
-  if (hierarchicalFlag && count < minCountHierarchical) {
-    for(size_t j=0; j<phraseS.size()-1; j++) {
-      if (isNonTerminal(vcbS.getWord( phraseS[j] )))
-        return;
-    }
-  }
+  if (belowMinCountHierarchical( phraseS, count ))
+    return;
 
   // source phrase (unless inverse)
   if (! inverseFlag) {
@@ -495,23 +654,8 @@ void outputPhrasePair(const PhraseAlignmentCollection &phrasePair, float totalCo
     phraseTableFile << " ||| ";
   }
 
-  // lexical translation probability
-  if (lexFlag) {
-    double lexScore = computeLexicalTranslation( phraseS, phraseT, bestAlignment);
-    phraseTableFile << ( logProbFlag ? negLogProb*log(lexScore) : lexScore );
-  }
-
-  // unaligned word penalty
-  if (unalignedFlag) {
-    double penalty = computeUnalignedPenalty( phraseS, phraseT, bestAlignment);
-    phraseTableFile << " " << ( logProbFlag ? negLogProb*log(penalty) : penalty );
-  }
-
-  // unaligned function word penalty
-  if (unalignedFWFlag) {
-    double penalty = computeUnalignedFWPenalty( phraseS, phraseT, bestAlignment);
-    phraseTableFile << " " << ( logProbFlag ? negLogProb*log(penalty) : penalty );
-  }
+  // lexical translation probability and unaligned word penalties
+  outputLexicalScores( phraseS, phraseT, bestAlignment, false, phraseTableFile );
 
   // target-side PCFG score
   if (pcfgFlag && !inverseFlag) {
@@ -522,29 +666,7 @@ void outputPhrasePair(const PhraseAlignmentCollection &phrasePair, float totalCo
 
   // alignment info for non-terminals
   if (! inverseFlag) {
-    if (hierarchicalFlag) {
-      // always output alignment if hiero style, but only for non-terms
-      assert(phraseT.size() == bestAlignment->alignedToT.size() + 1);
-      for(size_t j = 0; j < phraseT.size() - 1; j++) {
-        if (isNonTerminal(vcbT.getWord( phraseT[j] ))) {
-          if (bestAlignment->alignedToT[ j ].size() != 1) {
-            cerr << "Error: unequal numbers of non-terminals. Make sure the text does not contain words in square brackets (like [xxx])." << endl;
-            phraseTableFile.flush();
-            assert(bestAlignment->alignedToT[ j ].size() == 1);
-          }
-          int sourcePos = *(bestAlignment->alignedToT[ j ].begin());
-          phraseTableFile << sourcePos << "-" << j << " ";
-        }
-      }
-    } else if (wordAlignmentFlag) {
-      // alignment info in pb model
-      for(size_t j=0; j<bestAlignment->alignedToT.size(); j++) {
-        const set< size_t > &aligned = bestAlignment->alignedToT[j];
-        for (set< size_t >::const_iterator p(aligned.begin()); p != aligned.end(); ++p) {
-          phraseTableFile << *p << "-" << j << " ";
-        }
-      }
-    }
+    outputAlignment( phraseT, bestAlignment, phraseTableFile );
   }
 
   // counts
@@ -573,6 +695,210 @@ void outputPhrasePair(const PhraseAlignmentCollection &phrasePair, float totalCo
   phraseTableFile << endl;
 }
 
+void outputLexicalScores( const PHRASE &phraseS, const PHRASE &phraseT, PhraseAlignment *bestAlignment, bool inverse, ostream &phraseTableFile )
+{
+  // lexical translation probability
+  if (lexFlag) {
+    double lexScore = inverse
+                      ? computeInverseLexicalTranslation( phraseS, phraseT, bestAlignment)
+                      : computeLexicalTranslation( phraseS, phraseT, bestAlignment);
+    phraseTableFile << ( logProbFlag ? negLogProb*log(lexScore) : lexScore );
+  }
+
+  // unaligned word penalty
+  if (unalignedFlag) {
+    double penalty = inverse
+                     ? computeInverseUnalignedPenalty( bestAlignment)
+                     : computeUnalignedPenalty( phraseS, phraseT, bestAlignment);
+    phraseTableFile << " " << ( logProbFlag ? negLogProb*log(penalty) : penalty );
+  }
+
+  // unaligned function word penalty
+  if (unalignedFWFlag) {
+    double penalty = inverse
+                     ? computeInverseUnalignedFWPenalty( phraseS, bestAlignment)
+                     : computeUnalignedFWPenalty( phraseS, phraseT, bestAlignment);
+    phraseTableFile << " " << ( logProbFlag ? negLogProb*log(penalty) : penalty );
+  }
+}
+
+void outputAlignment( const PHRASE &phraseT, PhraseAlignment *bestAlignment, ostream &phraseTableFile )
+{
+  if (hierarchicalFlag) {
+    // always output alignment if hiero style, but only for non-terms
+    assert(phraseT.size() == bestAlignment->alignedToT.size() + 1);
+    for(size_t j = 0; j < phraseT.size() - 1; j++) {
+      if (isNonTerminal(vcbT.getWord( phraseT[j] ))) {
+        if (bestAlignment->alignedToT[ j ].size() != 1) {
+          cerr << "Error: unequal numbers of non-terminals. Make sure the text does not contain words in square brackets (like [xxx])." << endl;
+          phraseTableFile.flush();
+          assert(bestAlignment->alignedToT[ j ].size() == 1);
+        }
+        int sourcePos = *(bestAlignment->alignedToT[ j ].begin());
+        phraseTableFile << sourcePos << "-" << j << " ";
+      }
+    }
+  } else if (wordAlignmentFlag) {
+    // alignment info in pb model
+    for(size_t j=0; j<bestAlignment->alignedToT.size(); j++) {
+      const set< size_t > &aligned = bestAlignment->alignedToT[j];
+      for (set< size_t >::const_iterator p(aligned.begin()); p != aligned.end(); ++p) {
+        phraseTableFile << *p << "-" << j << " ";
+      }
+    }
+  }
+}
+
+void addTargetMarginal(const PhraseAlignmentCollection &phrasePair )
+{
+  if (phrasePair.size() == 0) return;
+
+  float count = 0;
+  for(size_t i=0; i<phrasePair.size(); i++) {
+    count += phrasePair[i]->count;
+  }
+
+  // collect count of count statistics
+  if (goodTuringFlag || kneserNeyFlag) {
+    collectCountOfCounts( count );
+  }
+
+  TargetMarginal &marginal = targetMarginals[ phrasePair[0]->GetTarget() ];
+  marginal.count += count;
+  marginal.distinct++;
+}
+
+inline float maybeLogProb( float a )
+{
+  return logProbFlag ? negLogProb*log(a) : a;
+}
+
+// writes a line of the consolidated table, with the scores that score
+// --Inverse and consolidate would have given it
+void outputJointPhrasePair(const PhraseAlignmentCollection &phrasePair, float totalCount, int distinctCount, ostream &phraseTableFile )
+{
+  if (phrasePair.size() == 0) return;
+
+  PhraseAlignment *bestAlignment = findBestAlignment( phrasePair );
+
+  // compute count
+  float count = 0;
+  for(size_t i=0; i<phrasePair.size(); i++) {
+    count += phrasePair[i]->count;
+  }
+
+  // compute PCFG score
+  float pcfgScore;
+  if (pcfgFlag) {
+    float pcfgSum = 0;
+    for(size_t i=0; i<phrasePair.size(); ++i) {
+      pcfgSum += phrasePair[i]->pcfgSum;
+    }
+    pcfgScore = pcfgSum / count;
+  }
+
+  const PHRASE &phraseS = phrasePair[0]->GetSource();
+  const PHRASE &phraseT = phrasePair[0]->GetTarget();
+
+  // do not output if hierarchical and count below threshold
+  if (belowMinCountHierarchical( phraseS, count ))
+    return;
+
+  const TargetMarginal &marginal = targetMarginals.find( phraseT )->second;
+  float countF = totalCount;
+  float countE = marginal.count;
+
+  // Good Turing discounting
+  float adjustedCount = count;
+  if (goodTuringFlag && count+0.99999 < goodTuringDiscount.size()-1)
+    adjustedCount *= goodTuringDiscount[(int)(count+0.99998)];
+  float adjustedCountInverse = adjustedCount;
+
+  // Kneser Ney discounting [Foster et al, 2006]
+  if (kneserNeyFlag) {
+    float n1_F = distinctCount;
+    float n1_E = marginal.distinct;
+    float D = kneserNey_D3;
+    if (count < 2) D = kneserNey_D1;
+    if (count < 3) D = kneserNey_D2;
+    if (D > count) D = count - 0.01; // sanity constraint
+
+    float p_b_E = n1_E / (float)totalDistinct; // target phrase prob based on distinct
+    float alpha_F = D * n1_F / countF; // available mass
+    adjustedCount = count - D + countF * alpha_F * p_b_E;
+
+    // for inverse
+    float p_b_F = n1_F / (float)totalDistinct; // source phrase prob based on distinct
+    float alpha_E = D * n1_E / countE; // available mass
+    adjustedCountInverse = count - D + countE * alpha_E * p_b_F;
+  }
+
+  // phrases
+  printSourcePhrase(phraseS, phraseT, *bestAlignment, phraseTableFile);
+  phraseTableFile << " ||| ";
+  printTargetPhrase(phraseS, phraseT, *bestAlignment, phraseTableFile);
+  phraseTableFile << " |||";
+
+  // inverse scores
+  if (!onlyDirectFlag) {
+    phraseTableFile << " " << maybeLogProb(adjustedCountInverse/countE) << " ";
+    outputLexicalScores( phraseS, phraseT, bestAlignment, true, phraseTableFile );
+  }
+
+  // direct scores
+  phraseTableFile << " " << maybeLogProb(adjustedCount/countF) << " ";
+  outputLexicalScores( phraseS, phraseT, bestAlignment, false, phraseTableFile );
+  if (pcfgFlag) {
+    phraseTableFile << " " << pcfgScore;
+  }
+
+  // phrase count feature
+  if (phraseCountFlag) {
+    phraseTableFile << " " << maybeLogProb(2.718);
+  }
+
+  // low count feature
+  if (lowCountFlag) {
+    phraseTableFile << " " << maybeLogProb(exp(-1.0/count));
+  }
+
+  // count bin feature
+  if (countBin.size()>0) {
+    bool foundBin = false;
+    for(size_t i=0; i < countBin.size(); i++) {
+      if (!foundBin && count <= countBin[i]) {
+        phraseTableFile << " " << maybeLogProb(2.718);
+        foundBin = true;
+      } else {
+        phraseTableFile << " " << maybeLogProb(1);
+      }
+    }
+    phraseTableFile << " " << maybeLogProb( foundBin ? 1 : 2.718 );
+  }
+
+  // alignment
+  phraseTableFile << " ||| ";
+  outputAlignment( phraseT, bestAlignment, phraseTableFile );
+
+  // counts
+  phraseTableFile << "||| " << countE << " " << countF;
+
+  // nt lengths
+  if (outputNTLengths) {
+    phraseTableFile << " ||| ";
+
+    map<size_t, map<size_t, float> > sourceProb, targetProb;
+    // 1st sourcePos, 2nd = length, 3rd = prob
+
+    calcNTLengthProb(phrasePair, sourceProb, targetProb);
+
+    outputNTLengthProbs(phraseTableFile, sourceProb, "S");
+    outputNTLengthProbs(phraseTableFile, targetProb, "T");
+  }
+
+  phraseTableFile << endl;
+}
+
 double computeUnalignedPenalty( const PHRASE &phraseS, const PHRASE &phraseT, PhraseAlignment *alignment )
 {
   // unaligned word counter
@@ -587,6 +913,18 @@ double computeUnalignedPenalty( const PHRASE &phraseS, const PHRASE &phraseT, Ph
   return unaligned;
 }
 
+double computeInverseUnalignedPenalty( PhraseAlignment *alignment )
+{
+  // unaligned word counter, over the source words
+  double unaligned = 1.0;
+  for(size_t si=0; si<alignment->alignedToS.size(); si++) {
+    if (alignment->alignedToS[ si ].empty()) {
+      unaligned *= 2.718;
+    }
+  }
+  return unaligned;
+}
+
 double computeUnalignedFWPenalty( const PHRASE &phraseS, const PHRASE &phraseT, PhraseAlignment *alignment )
 {
   // unaligned word counter
@@ -601,7 +939,20 @@ double computeUnalignedFWPenalty( const PHRASE &phraseS, const PHRASE &phraseT,
   return unaligned;
 }
 
-void loadFunctionWords( const char *fileName )
+double computeInverseUnalignedFWPenalty( const PHRASE &phraseS, PhraseAlignment *alignment )
+{
+  // unaligned word counter, over the source words
+  double unaligned = 1.0;
+  for(size_t si=0; si<alignment->alignedToS.size(); si++) {
+    if (alignment->alignedToS[ si ].empty() &&
+        functionWordListInverse.find( vcbS.getWord( phraseS[ si ] ) ) != functionWordListInverse.end()) {
+      unaligned *= 2.718;
+    }
+  }
+  return unaligned;
+}
+
+void loadFunctionWords( const char *fileName, set<string> &wordList )
 {
   cerr << "Loading function word list from " << fileName;
   ifstream inFile;
@@ -618,11 +969,11 @@ void loadFunctionWords( const char *fileName )
     if (inFileP->eof()) break;
     vector<string> token = tokenize( line );
     if (token.size() > 0)
-      functionWordList.insert( token[0] );
+      wordList.insert( token[0] );
   }
   inFile.close();
 
-  cerr << " - read " << functionWordList.size() << " function words\n";
+  cerr << " - read " << wordList.size() << " function words\n";
   inFile.close();
 }
 
@@ -649,7 +1000,31 @@ double computeLexicalTranslation( const PHRASE &phraseS, const PHRASE &phraseT,
   return lexScore;
 }
 
-void LexicalTable::load( char *fileName )
+double computeInverseLexicalTranslation( const PHRASE &phraseS, const PHRASE &phraseT, PhraseAlignment *alignment )
+{
+  // lexical translation probability
+  double lexScore = 1.0;
+  int null = vcbT.getWordID("NULL");
+  // all source words have to be explained
+  for(size_t si=0; si<alignment->alignedToS.size(); si++) {
+    const set< size_t > & trgIndices = alignment->alignedToS[ si ];
+    if (trgIndices.empty()) {
+      // explain unaligned word by NULL
+      lexScore *= lexTableInverse.permissiveLookup( null, phraseS[ si ] );
+    } else {
+      // go through all the aligned words to compute average
+      double thisWordScore = 0;
+      for (set< size_t >::const_iterator p(trgIndices.begin()); p != trgIndices.end(); ++p) {
+        thisWordScore += lexTableInverse.permissiveLookup( phraseT[ *p ], phraseS[ si ] );
+      }
+      lexScore *= thisWordScore / (double)trgIndices.size();
+    }
+  }
+  return lexScore;
+}
+
+// the inverse table is indexed by target word first
+void LexicalTable::load( char *fileName, bool inverse )
 {
   cerr << "Loading lexical translation table from " << fileName;
   ifstream inFile;
@@ -678,9 +1053,15 @@ void LexicalTable::load( char *fileName )
     }
 
     double prob = atof( token[2].c_str() );
-    WORD_ID wordT = vcbT.storeIfNew( token[0] );
-    WORD_ID wordS = vcbS.storeIfNew( token[1] );
-    ltable[ wordS ][ wordT ] = prob;
+    if (inverse) {
+      WORD_ID wordS = vcbS.storeIfNew( token[0] );
+      WORD_ID wordT = vcbT.storeIfNew( token[1] );
+      ltable[ wordT ][ wordS ] = prob;
+    } else {
+      WORD_ID wordT = vcbT.storeIfNew( token[0] );
+      WORD_ID wordS = vcbS.storeIfNew( token[1] );
+      ltable[ wordS ][ wordT ] = prob;
+    }
   }
   cerr << endl;
 }
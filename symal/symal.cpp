@@ -13,11 +13,19 @@
 #include <cstring>
 #include "cmd.h"
 
+#ifdef WITH_THREADS
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/tss.hpp>
+#include "../moses/src/ThreadPool.h"
+#include "../moses/src/OutputCollector.h"
+#endif
+
 using namespace std;
 
 #define MAX_WORD 10000 // maximum lengthsource/target strings 
 #define MAX_M 400      // maximum length of source strings
 #define MAX_N 400      // maximum length of target strings 
+#define BLOCK_SIZE 10000 // alignment pairs per block in multithreaded mode
 
 #define UNION                      1
 #define INTERSECT                  2
@@ -57,17 +65,44 @@ static Enum_T BoolEnum [] = {
 
 // global variables and constants
 
-int* fa; //counters of covered foreign positions
-int* ea; //counters of covered english positions
-int** A; //alignment matrix with information symmetric/direct/inverse alignments
-
 int verbose=0;
 
-//read an alignment pair from the input stream.
+//scratch space for one symmetrization thread
+
+struct Scratch {
+  int a[MAX_M],b[MAX_N];
+  int* fa; //counters of covered foreign positions
+  int* ea; //counters of covered english positions
+  int** A; //alignment matrix with information symmetric/direct/inverse alignments
+
+  Scratch() {
+    fa=new int[MAX_M+1];
+    ea=new int[MAX_N+1];
+    A=new int *[MAX_N+1];
+    for (int i=1; i<=MAX_N; i++) A[i]=new int[MAX_M+1];
+  }
+
+  ~Scratch() {
+    delete [] fa;
+    delete [] ea;
+    for (int i=1; i<=MAX_N; i++) delete [] A[i];
+    delete [] A;
+  }
+};
 
-int lc = 0;
+//symmetrization heuristic and its options
 
-int getals(fstream& inp,int& m, int *a,int& n, int *b)
+struct Heuristic {
+  int alignment;
+  int diagonal;
+  int final;
+  int bothuncovered;
+};
+
+//read an alignment pair from the input stream.
+//lc counts the pairs read so far, for error messages
+
+int getals(istream& inp,int& m, int *a,int& n, int *b,int& lc)
 {
   char w[MAX_WORD], dummy[10];
   int i,j,freq;
@@ -121,7 +156,7 @@ int getals(fstream& inp,int& m, int *a,int& n, int *b)
 
 
 //compute union alignment
-int prunionalignment(fstream& out,int m,int *a,int n,int* b)
+int prunionalignment(ostream& out,int m,int *a,int n,int* b)
 {
 
   ostringstream sout;
@@ -150,7 +185,7 @@ int prunionalignment(fstream& out,int m,int *a,int n,int* b)
 
 //Compute intersection alignment
 
-int printersect(fstream& out,int m,int *a,int n,int* b)
+int printersect(ostream& out,int m,int *a,int n,int* b)
 {
 
   ostringstream sout;
@@ -174,7 +209,7 @@ int printersect(fstream& out,int m,int *a,int n,int* b)
 
 //Compute target-to-source alignment
 
-int printtgttosrc(fstream& out,int m,int *a,int n,int* b)
+int printtgttosrc(ostream& out,int m,int *a,int n,int* b)
 {
 
   ostringstream sout;
@@ -198,7 +233,7 @@ int printtgttosrc(fstream& out,int m,int *a,int n,int* b)
 
 //Compute source-to-target alignment
 
-int printsrctotgt(fstream& out,int m,int *a,int n,int* b)
+int printsrctotgt(ostream& out,int m,int *a,int n,int* b)
 {
 
   ostringstream sout;
@@ -226,9 +261,13 @@ int printsrctotgt(fstream& out,int m,int *a,int n,int* b)
 //to represent the grow alignment as the unionalignment of a
 //directed and inverted alignment
 
-int printgrow(fstream& out,int m,int *a,int n,int* b, bool diagonal=false,bool final=false,bool bothuncovered=false)
+int printgrow(ostream& out,Scratch& s,int m,int *a,int n,int* b, bool diagonal=false,bool final=false,bool bothuncovered=false)
 {
 
+  int* fa=s.fa;
+  int* ea=s.ea;
+  int** A=s.A;
+
   ostringstream sout;
 
   vector <pair <int,int> > neighbors; //neighbors
@@ -385,6 +424,114 @@ int printgrow(fstream& out,int m,int *a,int n,int* b, bool diagonal=false,bool f
 
 
 
+//symmetrize all alignment pairs in the input stream, returns their number
+
+int symmetrize(istream& inp,ostream& out,const Heuristic& h,Scratch& s,int& lc)
+{
+  int m,n,sents=0;
+  int *a=s.a,*b=s.b;
+
+  while(getals(inp,m,a,n,b,lc)) {
+    switch (h.alignment) {
+    case UNION:
+      prunionalignment(out,m,a,n,b);
+      break;
+    case INTERSECT:
+      printersect(out,m,a,n,b);
+      break;
+    case GROW:
+      printgrow(out,s,m,a,n,b,h.diagonal,h.final,h.bothuncovered);
+      break;
+    case TGTTOSRC:
+      printtgttosrc(out,m,a,n,b);
+      break;
+    case SRCTOTGT:
+      printsrctotgt(out,m,a,n,b);
+      break;
+    }
+    sents++;
+  }
+  return sents;
+}
+
+#ifdef WITH_THREADS
+
+//symmetrize one block of alignment pairs; blocks are written in input order
+
+class SymalTask : public Moses::Task
+{
+public:
+  SymalTask(int id,string* block,int lc,const Heuristic& h,
+            Moses::OutputCollector& collector,boost::mutex& mutex,int& sents)
+    : m_id(id), m_block(block), m_lc(lc), m_heuristic(h),
+      m_collector(collector), m_mutex(mutex), m_sents(sents) {}
+
+  ~SymalTask() {
+    delete m_block;
+  }
+
+  void Run() {
+    static boost::thread_specific_ptr<Scratch> scratch;
+    if (scratch.get() == NULL) scratch.reset(new Scratch);
+
+    istringstream inp(*m_block);
+    ostringstream out;
+    int sents=symmetrize(inp,out,m_heuristic,*scratch,m_lc);
+    m_collector.Write(m_id,out.str());
+
+    boost::mutex::scoped_lock lock(m_mutex);
+    m_sents+=sents;
+  }
+
+private:
+  int m_id;
+  string* m_block;
+  int m_lc;
+  Heuristic m_heuristic;
+  Moses::OutputCollector& m_collector;
+  boost::mutex& m_mutex;
+  int& m_sents;
+};
+
+//read the input in blocks of BLOCK_SIZE alignment pairs (three lines each,
+//as written by giza2bal.pl) and symmetrize them in parallel.  The number of
+//blocks queued or waiting to be written is bounded by the queue limit.
+
+int symmetrizeParallel(istream& inp,ostream& out,const Heuristic& h,int threads)
+{
+  Moses::ThreadPool pool(threads);
+  pool.SetQueueLimit(2*threads);
+  Moses::OutputCollector collector(&out);
+  boost::mutex mutex;
+  int sents=0;
+
+  string line;
+  int id=0,lc=0;
+  bool more=true;
+  while (more) {
+    string* block=new string;
+    int pairs=0,lines=0;
+    while (pairs<BLOCK_SIZE && (more=!getline(inp,line).fail())) {
+      //giza2bal.pl writes an empty line for each skipped pair
+      if (line.find_first_not_of(" \t\r")==string::npos) continue;
+      block->append(line);
+      block->push_back('\n');
+      if (++lines%3==0) pairs++;
+    }
+    if (block->empty()) {
+      delete block;
+      break;
+    }
+    pool.Submit(new SymalTask(id++,block,lc,h,collector,mutex,sents));
+    lc+=pairs;
+  }
+
+  pool.Stop(true);
+  return sents;
+}
+
+#endif
+
 //Main file here
 
 
@@ -397,6 +544,7 @@ int main(int argc, char** argv)
   int diagonal=false;
   int final=false;
   int bothuncovered=false;
+  int threads=1;
 
 
   DeclareParams("a", CMDENUMTYPE,  &alignment, AlignEnum,
@@ -411,13 +559,19 @@ int main(int argc, char** argv)
                 "o", CMDSTRINGTYPE, &output,
                 "v", CMDENUMTYPE,  &verbose, BoolEnum,
                 "verbose", CMDENUMTYPE,  &verbose, BoolEnum,
+                "t", CMDINTTYPE, &threads,
+                "threads", CMDINTTYPE, &threads,
                 
                 (char*)NULL);
 
   GetParams(&argc, &argv, (char*)NULL);
 
   if (alignment==0) {
-    cerr << "usage: symal [-i=<inputfile>] [-o=<outputfile>] -a=[u|i|g] -d=[yes|no] -b=[yes|no] -f=[yes|no] \n"
+    cerr << "usage: symal [-i=<inputfile>] [-o=<outputfile>] -a=[u|i|g] -d=[yes|no] -b=[yes|no] -f=[yes|no] "
+#ifdef WITH_THREADS
+         << "[-t=<threads>] "
+#endif
+         << "\n"
          << "Input file or std must be in .bal format (see script giza2bal.pl).\n";
 
     exit(1);
@@ -438,67 +592,49 @@ int main(int argc, char** argv)
   }
 
 
-  int a[MAX_M],b[MAX_N],m,n;
-  fa=new int[MAX_M+1];
-  ea=new int[MAX_N+1];
-
-
-  int sents = 0;
-  A=new int *[MAX_N+1];
-  for (int i=1; i<=MAX_N; i++) A[i]=new int[MAX_M+1];
+  Heuristic h;
+  h.alignment=alignment;
+  h.diagonal=diagonal;
+  h.final=final;
+  h.bothuncovered=bothuncovered;
 
   switch (alignment) {
   case UNION:
     cerr << "symal: computing union alignment\n";
-    while(getals(inp,m,a,n,b)) {
-      prunionalignment(out,m,a,n,b);
-      sents++;
-    }
-    cerr << "Sents: " << sents << endl;
     break;
   case INTERSECT:
     cerr << "symal: computing intersect alignment\n";
-    while(getals(inp,m,a,n,b)) {
-      printersect(out,m,a,n,b);
-      sents++;
-    }
-    cerr << "Sents: " << sents << endl;
     break;
   case GROW:
     cerr << "symal: computing grow alignment: diagonal ("
          << diagonal << ") final ("<< final << ")"
          <<  "both-uncovered (" << bothuncovered <<")\n";
-
-    while(getals(inp,m,a,n,b))
-      printgrow(out,m,a,n,b,diagonal,final,bothuncovered);
-
     break;
   case TGTTOSRC:
     cerr << "symal: computing target-to-source alignment\n";
-
-    while(getals(inp,m,a,n,b)) {
-      printtgttosrc(out,m,a,n,b);
-      sents++;
-    }
-    cerr << "Sents: " << sents << endl;
     break;
   case SRCTOTGT:
     cerr << "symal: computing source-to-target alignment\n";
-
-    while(getals(inp,m,a,n,b)) {
-      printsrctotgt(out,m,a,n,b);
-      sents++;
-    }
-    cerr << "Sents: " << sents << endl;
     break;
   default:
     exit(1);
   }
 
-  delete [] fa;
-  delete [] ea;
-  for (int i=1; i<=MAX_N; i++) delete [] A[i];
-  delete [] A;
+  int sents;
+#ifdef WITH_THREADS
+  if (threads>1)
+    sents=symmetrizeParallel(inp,out,h,threads);
+  else
+#endif
+  {
+    Scratch* scratch=new Scratch;
+    int lc=0;
+    sents=symmetrize(inp,out,h,*scratch,lc);
+    delete scratch;
+  }
+
+  if (alignment!=GROW)
+    cerr << "Sents: " << sents << endl;
 
   exit(0);
 }